@@ -4,7 +4,7 @@
 #include "MarketEntryCalculator.h"
 #include "MultiHorizonEngine.h"
 #include "Simulator.h"
-#include "CudaAccelerator.h"
+#include "CpuBatchSim.h"
 
 #include <vector>
 #include <map>
@@ -13,6 +13,7 @@
 #include <functional>
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 
 // ============================================================
 //  Chain Optimizer  BPTT parameter optimization (15.9, 16)
@@ -116,8 +117,10 @@ struct ChainParams
     std::string  symbol;
     PriceSeries  prices;
 
-    // GPU acceleration (requires QUANT_CUDA build + runtime GPU)
-    bool useCuda = false;
+    // Simulator-mode gradient probes: Sequential runs each through
+    // Simulator::run; Cpu / Cuda batch all 13 through BatchSim
+    // (the kernel's chain model; Cuda falls back to Cpu without a GPU)
+    BatchSim::Backend batchBackend = BatchSim::Backend::Sequential;
 
     bool hasPriceSeries() const
     {
@@ -273,18 +276,22 @@ class ChainOptimizer
             std::cout << "  [BPTT] " << objLabel(obj)
                       << " | step   J(?)              ?J               ||?J||           s         r         ?         fh        Rmax      s_save\n";
 
-        std::cout << std::fixed << std::setprecision(8)
-                  << "  [BPTT] " << std::setw(4) << step
-                  << "   " << std::setw(18) << grad.objective
-                  << "  " << std::setw(16) << sr.deltaJ
-                  << "  " << std::setw(14) << sr.gradNorm
-                  << "  " << std::setw(10) << cur.surplus
-                  << " " << std::setw(9) << cur.risk
-                  << " " << std::setw(9) << cur.steepness
-                  << " " << std::setw(9) << cur.feeHedging
-                  << " " << std::setw(9) << cur.maxRisk
-                  << " " << std::setw(9) << cur.savingsRate
-                  << "\n";
+        // Formatted apart and written whole: concurrent optimisations
+        // (WalkForward) share std::cout and its format state.
+        std::ostringstream line;
+        line << std::fixed << std::setprecision(8)
+             << "  [BPTT] " << std::setw(4) << step
+             << "   " << std::setw(18) << grad.objective
+             << "  " << std::setw(16) << sr.deltaJ
+             << "  " << std::setw(14) << sr.gradNorm
+             << "  " << std::setw(10) << cur.surplus
+             << " " << std::setw(9) << cur.risk
+             << " " << std::setw(9) << cur.steepness
+             << " " << std::setw(9) << cur.feeHedging
+             << " " << std::setw(9) << cur.maxRisk
+             << " " << std::setw(9) << cur.savingsRate
+             << "\n";
+        std::cout << line.str();
 
         if (onStep) onStep(sr);
     }
@@ -542,6 +549,8 @@ class ChainOptimizer
         cfg.autoRange       = p.autoRange;
         cfg.entryLevels     = p.levels;
         cfg.exitLevels      = p.exitLevels;
+        cfg.maxTradesPerMonth   = p.maxTradesPerMonth;
+        cfg.capitalPumpPerMonth = p.capitalPumpPerMonth;
 
         cfg.horizonParams.feeSpread             = p.feeSpread;
         cfg.horizonParams.feeHedgingCoefficient = p.feeHedging;
@@ -601,16 +610,7 @@ class ChainOptimizer
                 lr.buyFee     = t.buyFee;
                 lr.entryTime  = t.entryTime;
 
-                // Compute overhead and effective overhead (simulator uses entryCost as portfolioPump)
-                double entryCost = t.entryPrice * t.quantity;
-                lr.overhead = QuantMath::overhead(
-                    t.entryPrice, t.quantity,
-                    p.feeSpread, p.feeHedging, p.deltaTime,
-                    p.symbolCount, entryCost, p.coefficientK,
-                    p.futureTradeCount);
-                lr.effectiveOH = QuantMath::effectiveOverhead(
-                    lr.overhead, p.surplus, p.feeSpread,
-                    p.feeHedging, p.deltaTime);
+                lr.effectiveOH = effectiveOverhead(t, p, &lr.overhead);
 
                 // Default target TP from overhead formula
                 lr.tpPrice = t.entryPrice * (1.0 + lr.effectiveOH);
@@ -651,30 +651,119 @@ class ChainOptimizer
         return trace;
     }
 
+    // Overhead and effective overhead of a simulated entry (the
+    // simulator uses its entryCost as portfolioPump).
+    static double effectiveOverhead(const SimTrade& t, const ChainParams& p,
+                                    double* overhead = nullptr)
+    {
+        double entryCost = t.entryPrice * t.quantity;
+        double oh = QuantMath::overhead(
+            t.entryPrice, t.quantity,
+            p.feeSpread, p.feeHedging, p.deltaTime,
+            p.symbolCount, entryCost, p.coefficientK,
+            p.futureTradeCount);
+        if (overhead) *overhead = oh;
+        return QuantMath::effectiveOverhead(
+            oh, p.surplus, p.feeSpread,
+            p.feeHedging, p.deltaTime);
+    }
+
     // ---- Compute objective from a simulator run ----
+    // computeObjective(forwardSim(p)) without building the trace: the
+    // run goes through this thread's Simulator arena with no snapshots
+    // and J is summed off the result in the trace's order, so it is
+    // bit for bit the same and a warm arena allocates nothing.
     static double simObjective(const ChainParams& p, ChainObjective obj)
     {
-        auto trace = forwardSim(p);
-        return computeObjective(trace, p, obj);
+        struct Scratch
+        {
+            Simulator::Arena         arena;
+            std::vector<double>      cycleProfit;
+            std::vector<std::size_t> lastSell;
+        };
+        static thread_local Scratch scratch;
+
+        SimConfig cfg = toSimConfig(p);
+        cfg.snapshotPolicy = SnapshotPolicy::None;
+        const SimResult& result = Simulator::run(cfg, scratch.arena);
+
+        // The trace's cycles: 0 .. maxCycle-1, each with its sells' profit
+        int maxCycle = std::max(result.cyclesCompleted, 1);
+        for (const auto& s : result.sells)
+            maxCycle = std::max(maxCycle, s.cycle + 1);
+        std::vector<double>& cycleProfit = scratch.cycleProfit;
+        cycleProfit.assign(maxCycle, 0.0);
+        for (const auto& s : result.sells)
+            cycleProfit[s.cycle] += s.netProfit;
+
+        switch (obj)
+        {
+            case ChainObjective::MaxProfit:
+            case ChainObjective::MaxROI:
+            {
+                double s = 0;
+                for (double pc : cycleProfit) s += pc;
+                if (obj == ChainObjective::MaxProfit) return s;
+                return (p.capital > EPS) ? s / p.capital : 0;
+            }
+            case ChainObjective::MinSpread:
+            {
+                // A level's TP is its position's last sell, else the
+                // overhead target.  A run's trade ids are 1..n in fill
+                // order, and fills come in cycle order.
+                const std::size_t none = result.sells.size();
+                std::vector<std::size_t>& lastSell = scratch.lastSell;
+                lastSell.assign(result.trades.size(), none);
+                for (std::size_t k = 0; k < result.sells.size(); ++k)
+                {
+                    std::size_t ti = static_cast<std::size_t>(result.sells[k].buyId - 1);
+                    if (ti < lastSell.size()) lastSell[ti] = k;
+                }
+                double s = 0;
+                for (std::size_t i = 0; i < result.trades.size(); ++i)
+                {
+                    const SimTrade& t = result.trades[i];
+                    if (t.cycle < 0 || t.cycle >= maxCycle) continue;
+                    double tp = lastSell[i] != none
+                        ? result.sells[lastSell[i]].sellPrice
+                        : t.entryPrice * (1.0 + effectiveOverhead(t, p));
+                    double sp = (tp - t.entryPrice) / std::max(t.entryPrice, EPS);
+                    s -= sp * sp;
+                }
+                return s;
+            }
+            case ChainObjective::MaxChain:
+            case ChainObjective::MaxWealth:
+            {
+                double capital = p.capital, prod = 1.0, sv = 0;
+                for (double pc : cycleProfit)
+                {
+                    double saved = (pc > 0) ? pc * p.savingsRate : 0;
+                    prod *= (1.0 + pc * (1.0 - p.savingsRate) / std::max(capital, EPS));
+                    sv   += saved;
+                    capital = capital + pc - saved;
+                }
+                if (obj == ChainObjective::MaxChain) return prod;
+                return result.finalCapital + result.totalSavings + sv;
+            }
+        }
+        return 0;
     }
 
     // ---- End-to-end numerical gradients for simulator mode ----
     static ParamGradients simGradients(const ChainParams& p, ChainObjective obj)
     {
-#ifdef QUANT_CUDA
-        // Try GPU path first: all 13 probes run in parallel on the GPU
-        if (p.useCuda && CudaAccelerator::isAvailable())
+        // Batched path: all 13 probes in one BatchSim call
+        if (p.batchBackend != BatchSim::Backend::Sequential)
         {
             ParamGradients g;
-            if (cudaSimGradients(p, obj, g))
+            if (batchSimGradients(p, obj, g))
                 return g;
-            // GPU dispatch failed  fall through to CPU path
+            // Batch dispatch failed  fall through to the simulator
         }
-#endif
 
-        auto trace = forwardSim(p);
         ParamGradients g;
-        g.objective = computeObjective(trace, p, obj);
+        g.objective = simObjective(p, obj);
 
         // Create two scratch copies ONCE to avoid repeated PriceSeries deep-copies.
         // Each probe only mutates a single scalar field then restores it.
@@ -724,14 +813,13 @@ class ChainOptimizer
         return g;
     }
 
-#ifdef QUANT_CUDA
-    // GPU-accelerated gradient computation: runs all 13 probes in parallel
-    static bool cudaSimGradients(const ChainParams& p, ChainObjective obj,
-                                  ParamGradients& outGrad)
+    // Batched gradient computation: runs all 13 probes in one call
+    static bool batchSimGradients(const ChainParams& p, ChainObjective obj,
+                                   ParamGradients& outGrad)
     {
         if (!p.hasPriceSeries()) return false;
 
-        const auto& pts = p.prices.data().at(p.symbol);
+        PriceSpan pts = p.prices.series(p.symbol);
         int numPrices = static_cast<int>(pts.size());
         if (numPrices == 0) return false;
 
@@ -796,9 +884,9 @@ class ChainOptimizer
         configs[12] = mkp([](ChainParams& q) { q.savingsRate = QuantMath::clamp01(q.savingsRate - FD_SIM); });
 
         double results[13] = {};
-        bool ok = cudaGpuBatchSim(configs, 13,
-                                   timestamps.data(), priceVals.data(), numPrices,
-                                   static_cast<int>(obj), results);
+        bool ok = BatchSim::run(p.batchBackend, configs, 13,
+                                timestamps.data(), priceVals.data(), numPrices,
+                                static_cast<int>(obj), results);
         if (!ok) return false;
 
         outGrad.objective     = results[0];
@@ -821,7 +909,6 @@ class ChainOptimizer
         outGrad.dJ_dSavingsRate = clip(outGrad.dJ_dSavingsRate);
         return true;
     }
-#endif
 
 public:
 
@@ -1005,6 +1092,16 @@ public:
         return optimizeAnalytical(initial, obj, maxSteps, lr, onStep);
     }
 
+    // ---- Evaluate: objective of one simulator run, no gradients ----
+    // Price-series mode only; `out` receives the run's SimResult.
+    static double evaluate(const ChainParams& p, ChainObjective obj,
+                           SimResult* out = nullptr)
+    {
+        if (!out) return simObjective(p, obj);
+        auto trace = forwardSimFull(p, out);
+        return computeObjective(trace, p, obj);
+    }
+
 private:
 
     // ---- Simulator-driven optimisation (price series mode) ----
@@ -0,0 +1,673 @@
+#pragma once
+// ============================================================
+// CpuBatchSim.h - CPU backend for batched simulation
+//
+// cpuBatchSim() has the contract of cudaGpuBatchSim(): N
+// GpuSimParams configs run over one shared price array and
+// each writes one objective (OBJ_* codes below, default =
+// realized P&L).  The model, the capacity limits and the order
+// of every floating-point operation follow batchSimKernel in
+// CudaKernels.cu, so the two backends agree up to the device's
+// libm.  Like the kernel, this is the compact chain model, not
+// Simulator::run.
+//
+// Configs are stepped kLanes at a time over the price array.
+// Each lane keeps three trigger bounds in structure-of-arrays
+// form (highest unfilled limit entry, lowest unfilled breakout
+// entry, lowest open take-profit), so the per-tick "can any
+// lane fill?" test is one branch-free pass over the lanes; the
+// full entry/exit/chain step runs only for lanes whose bounds
+// were crossed, and for every lane on a month rollover.  Lane
+// groups are shared out over a persistent thread pool.
+//
+// BatchSim picks the backend at runtime: the GPU when built
+// with QUANT_CUDA and a device is present, otherwise this one.
+// ============================================================
+
+#include "CudaAccelerator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace CpuBatchSim {
+
+inline constexpr int kMaxLevels    = 32;
+inline constexpr int kMaxPositions = 64;
+inline constexpr int kMaxExits     = 16;
+inline constexpr int kMaxCycles    = 64;
+inline constexpr int kLanes        = 4;
+
+inline constexpr int OBJ_MAX_PROFIT = 1;
+inline constexpr int OBJ_MIN_SPREAD = 2;
+inline constexpr int OBJ_MAX_ROI    = 3;
+inline constexpr int OBJ_MAX_CHAIN  = 4;
+inline constexpr int OBJ_MAX_WEALTH = 5;
+
+inline constexpr double kSecsPerMonth = 2629746.0;   // 365.25 * 86400 / 12
+
+// ---- kernel math (CudaKernels.cu, "Device math") ----
+
+inline double sigmoid(double x) { return 1.0 / (1.0 + std::exp(-x)); }
+inline double clamp01(double v) { return std::fmin(std::fmax(v, 0.0), 1.0); }
+
+inline double sigmoidNorm(double t, double alpha)
+{
+    double s0 = sigmoid(-alpha * 0.5);
+    double s1 = sigmoid( alpha * 0.5);
+    double S  = s1 - s0;
+    if (S < 1e-15) return t;
+    return (sigmoid(alpha * (t - 0.5)) - s0) / S;
+}
+
+inline double overhead(double P, double q, double fs, double fh, double dt,
+                       int ns, double T, double K, int nf)
+{
+    double F     = fs * fh * dt;
+    double denom = (P / q) * T + K;
+    if (denom < 1e-15) return 0.0;
+    return F * ns * (1.0 + nf) / denom;
+}
+
+inline double effectiveOH(double oh, double s, double fs, double fh, double dt)
+{ return oh + (s + fs) * fh * dt; }
+
+inline double horizonFactor(double rawOH, double eo, double maxRisk, double steep, int i, int N)
+{
+    if (maxRisk > 0.0)
+    {
+        double lo = rawOH;
+        double hi = (maxRisk > lo) ? maxRisk : lo;
+        double s  = (steep > 0.0) ? steep : 0.01;
+        double t  = (N > 1) ? (double)i / (double)(N - 1) : 1.0;
+        return lo + sigmoidNorm(t, s) * (hi - lo);
+    }
+    return eo * (double)(i + 1);
+}
+
+inline double positionDelta(double P, double q, double T)
+{ return (T > 1e-15) ? (P * q) / T : 0.0; }
+
+inline double sigmoidBuffer(double delta, double lower, double upper, int count)
+{
+    if (count <= 0 || delta <= 0.0) return 1.0;
+    double t     = delta / (delta + 1.0);
+    double alpha = (delta > 0.1) ? delta : 0.1;
+    return 1.0 + count * (lower + sigmoidNorm(t, alpha) * (upper - lower));
+}
+
+// ---- level generators (gpu_generateEntries / gpu_generateExits) ----
+
+struct EntryLevel { double entryPrice, funding, qty; };
+struct ExitLevel  { double tpPrice, sellQty, grossProfit; };
+
+inline int generateEntries(const GpuSimParams& cfg, double currentPrice, double capital,
+                           EntryLevel* out)
+{
+    int N = cfg.levels;
+    if (N < 1) N = 1;
+    if (N > kMaxLevels) N = kMaxLevels;
+
+    double steep = std::fmax(cfg.entrySteepness, 0.1);
+    double risk  = clamp01(cfg.entryRisk);
+
+    double pLow, pHigh;
+    if (cfg.rangeAbove > 0 || cfg.rangeBelow > 0)
+    { pLow = std::fmax(currentPrice - cfg.rangeBelow, 1e-10); pHigh = currentPrice + cfg.rangeAbove; }
+    else if (cfg.autoRange)
+    {
+        double oh_r = overhead(currentPrice, 1.0, cfg.feeSpread, cfg.feeHedging,
+                               cfg.deltaTime, cfg.symbolCount, capital,
+                               cfg.coefficientK, cfg.futureTradeCount);
+        double eo_r = effectiveOH(oh_r, cfg.surplus, cfg.feeSpread,
+                                  cfg.feeHedging, cfg.deltaTime);
+        double band = eo_r * 3.0;
+        if (band < 0.01) band = 0.01;
+        if (band > 0.99) band = 0.99;
+        pLow  = std::fmax(currentPrice * (1.0 - band), 1e-10);
+        pHigh = currentPrice;
+    }
+    else
+    { pLow = 0.0; pHigh = currentPrice; }
+
+    double weights[kMaxLevels];
+    double totalW = 0.0;
+    for (int i = 0; i < N; ++i)
+    {
+        double t   = (N > 1) ? (double)i / (double)(N - 1) : 1.0;
+        double sig = sigmoidNorm(t, steep);
+        out[i].entryPrice = pLow + sig * (pHigh - pLow);
+        double w = (1.0 - risk) * sig + risk * (1.0 - sig);
+        weights[i] = w;  totalW += w;
+    }
+    if (totalW < 1e-15) totalW = 1.0;
+    for (int i = 0; i < N; ++i)
+    {
+        out[i].funding = capital * weights[i] / totalW;
+        out[i].qty = (out[i].entryPrice > 1e-15) ? out[i].funding / out[i].entryPrice : 0.0;
+    }
+    double minE = currentPrice * 0.01;
+    int kept = 0;
+    for (int i = 0; i < N; ++i)
+        if (out[i].entryPrice >= minE) { if (kept != i) out[kept] = out[i]; ++kept; }
+    return kept;
+}
+
+inline int generateExits(const GpuSimParams& cfg, double entryPrice, double qty,
+                         double entryCost, ExitLevel* out)
+{
+    int N = (cfg.exitLevels > 0) ? cfg.exitLevels : cfg.levels;
+    if (N < 1) N = 1;
+    if (N > kMaxExits) N = kMaxExits;
+
+    double frac     = clamp01(cfg.exitFraction);
+    double risk     = clamp01(cfg.exitRisk);
+    double steep    = std::fmax(cfg.exitSteepness, 0.01);
+    double sellable = qty * frac;
+
+    double oh = overhead(entryPrice, qty, cfg.feeSpread, cfg.feeHedging,
+                         cfg.deltaTime, cfg.symbolCount, entryCost,
+                         cfg.coefficientK, cfg.futureTradeCount);
+    double eo = effectiveOH(oh, cfg.surplus, cfg.feeSpread,
+                            cfg.feeHedging, cfg.deltaTime);
+
+    double cumSigma[kMaxExits + 1];
+    double center = risk * (double)(N - 1);
+    for (int i = 0; i <= N; ++i)
+        cumSigma[i] = sigmoid(steep * ((double)i - 0.5 - center));
+    double lo = cumSigma[0], hi = cumSigma[N];
+    for (int i = 0; i <= N; ++i)
+        cumSigma[i] = (hi > lo) ? (cumSigma[i] - lo) / (hi - lo)
+                                : (double)i / (double)N;
+
+    double delta = positionDelta(entryPrice, qty, entryCost);
+    double lower = cfg.minRisk;
+    double upper = (cfg.maxRisk > 0.0) ? cfg.maxRisk : eo;
+    if (upper < lower) upper = lower;
+    double dtBuf = (cfg.downtrendCount > 0)
+                 ? sigmoidBuffer(delta, lower, upper, cfg.downtrendCount) : 1.0;
+    double slFrac = clamp01(cfg.stopLossFraction);
+    double slBuf  = sigmoidBuffer(delta, lower * slFrac, upper * slFrac,
+                                  cfg.stopLossHedgeCount);
+    double combinedBuf = dtBuf * slBuf;
+
+    for (int i = 0; i < N; ++i)
+    {
+        double tp = entryPrice * (1.0 + horizonFactor(oh, eo, cfg.maxRisk, steep, i, N));
+        if (combinedBuf > 1.0) tp *= combinedBuf;
+        double sf = cumSigma[i + 1] - cumSigma[i];
+        double sq = sellable * sf;
+        out[i] = { tp, sq, (tp - entryPrice) * sq };
+    }
+    return N;
+}
+
+// ============================================================
+// Lane - the state of one batchSimKernel thread
+// ============================================================
+
+class Lane
+{
+public:
+    void start(const GpuSimParams& cfg, double firstPrice)
+    {
+        m_cfg = cfg;
+        m_capital = cfg.capital; m_realized = 0.0; m_savings = 0.0;
+        m_cycle = 0; m_maxCyc = 0; m_numPos = 0;
+        for (int i = 0; i < kMaxCycles; ++i) { m_cycCap[i] = 0; m_cycProf[i] = 0; }
+        m_cycCap[0] = m_capital;
+        m_curMonth = -1; m_tradesThisMonth = 0;
+        m_entryRefPrice = firstPrice;
+        m_numEntries = generateEntries(m_cfg, m_entryRefPrice, m_capital, m_entries);
+        for (int i = 0; i < m_numEntries; ++i) m_entryFilled[i] = false;
+    }
+
+    // Month boundary: the kernel's check ahead of the entries.
+    void rollover(int month)
+    {
+        if (m_curMonth >= 0 && m_cfg.capitalPumpPerMonth > 0.0)
+            m_capital += m_cfg.capitalPumpPerMonth;
+        m_curMonth = month;
+        m_tradesThisMonth = 0;
+    }
+
+    // One tick after the month check: entries, exits, chain.
+    void step(double price)
+    {
+        const int maxTPM = m_cfg.maxTradesPerMonth;
+        for (int ei = 0; ei < m_numEntries; ++ei)
+        {
+            if (m_entryFilled[ei]) continue;
+            if (maxTPM > 0 && m_tradesThisMonth >= maxTPM) break;
+            const EntryLevel& e = m_entries[ei];
+            bool belowRef = (e.entryPrice <= m_entryRefPrice);
+            if (belowRef) {
+                if (price >= e.entryPrice) continue;
+            } else {
+                if (price <= e.entryPrice) continue;
+            }
+            if (e.qty < 1e-15 || m_numPos >= kMaxPositions) continue;
+            double cost = e.entryPrice * e.qty;
+            double fee  = cost * m_cfg.buyFeeRate;
+            if (cost + fee > m_capital) continue;
+            m_capital -= (cost + fee);
+            Pos& p = m_positions[m_numPos];
+            p.entryPrice = e.entryPrice;
+            p.qty = e.qty; p.remaining = p.qty;
+            p.buyFee = fee; p.cycle = m_cycle;
+            p.numExits = generateExits(m_cfg, p.entryPrice, p.qty, cost, p.exits);
+            for (int x = 0; x < p.numExits; ++x) p.exitFilled[x] = false;
+            ++m_numPos;
+            m_entryFilled[ei] = true;
+            ++m_tradesThisMonth;
+        }
+
+        for (int j = 0; j < m_numPos; ++j)
+        {
+            Pos& p = m_positions[j];
+            if (p.remaining < 1e-15) continue;
+            for (int li = 0; li < p.numExits; ++li)
+            {
+                if (p.exitFilled[li] || p.exits[li].sellQty < 1e-15) continue;
+                if (price < p.exits[li].tpPrice || p.remaining < 1e-15) continue;
+                double sq  = std::fmin(p.exits[li].sellQty, p.remaining);
+                double sf  = p.exits[li].tpPrice * sq * m_cfg.sellFeeRate;
+                double net = (p.exits[li].tpPrice - p.entryPrice) * sq - sf;
+                p.remaining -= sq;
+                m_capital  += p.exits[li].tpPrice * sq - sf;
+                m_realized += net;
+                if (p.cycle < kMaxCycles) m_cycProf[p.cycle] += net;
+                p.exitFilled[li] = true;
+            }
+        }
+
+        if (m_cfg.chainCycles)
+        {
+            bool allClosed = true, hadPos = false, anyFilled = false;
+            for (int i = 0; i < m_numPos; ++i)
+                if (m_positions[i].cycle == m_cycle)
+                { hadPos = true; if (m_positions[i].remaining > 1e-15) { allClosed = false; break; } }
+            for (int i = 0; i < m_numEntries; ++i)
+                if (m_entryFilled[i]) { anyFilled = true; break; }
+            if (hadPos && allClosed && anyFilled && m_capital > 1e-15)
+            {
+                double cp = m_cycProf[m_cycle < kMaxCycles ? m_cycle : kMaxCycles - 1];
+                if (cp > 0 && m_cfg.savingsRate > 0)
+                { double sv = cp * m_cfg.savingsRate; m_savings += sv; m_capital -= sv; }
+                ++m_cycle;
+                if (m_cycle < kMaxCycles) m_cycCap[m_cycle] = m_capital;
+                if (m_cycle > m_maxCyc) m_maxCyc = m_cycle;
+                m_numEntries = generateEntries(m_cfg, price, m_capital, m_entries);
+                m_entryRefPrice = price;
+                for (int i = 0; i < m_numEntries; ++i) m_entryFilled[i] = false;
+            }
+        }
+    }
+
+    // Trigger bounds for the state left by the last step: while
+    //   price >= limitMax && price <= breakoutMin && price < exitMin
+    // a tick cannot fill anything, and the chain condition (which
+    // only changes with a fill or the capital) stays false.  Levels
+    // that cannot fill before the next step - month quota used up,
+    // unaffordable, no position slot - are left out; a NaN level
+    // always fires, which exitMin = -inf encodes.
+    void bounds(double& limitMax, double& breakoutMin, double& exitMin) const
+    {
+        const double inf = std::numeric_limits<double>::infinity();
+        limitMax = -inf; breakoutMin = inf; exitMin = inf;
+
+        const int maxTPM = m_cfg.maxTradesPerMonth;
+        bool canEnter = m_numPos < kMaxPositions
+                     && !(maxTPM > 0 && m_tradesThisMonth >= maxTPM);
+        for (int ei = 0; canEnter && ei < m_numEntries; ++ei)
+        {
+            const EntryLevel& e = m_entries[ei];
+            if (m_entryFilled[ei] || e.qty < 1e-15) continue;
+            double cost = e.entryPrice * e.qty;
+            if (cost + cost * m_cfg.buyFeeRate > m_capital) continue;
+            if (std::isnan(e.entryPrice)) { exitMin = -inf; return; }
+            if (e.entryPrice <= m_entryRefPrice) limitMax = std::max(limitMax, e.entryPrice);
+            else                                 breakoutMin = std::min(breakoutMin, e.entryPrice);
+        }
+
+        for (int j = 0; j < m_numPos; ++j)
+        {
+            const Pos& p = m_positions[j];
+            if (p.remaining < 1e-15) continue;
+            for (int li = 0; li < p.numExits; ++li)
+            {
+                if (p.exitFilled[li] || p.exits[li].sellQty < 1e-15) continue;
+                if (std::isnan(p.exits[li].tpPrice)) { exitMin = -inf; return; }
+                exitMin = std::min(exitMin, p.exits[li].tpPrice);
+            }
+        }
+    }
+
+    // Positions opened so far, in fill order: what each still holds
+    // and how many of its exit levels have sold.
+    int    positions() const      { return m_numPos; }
+    double remaining(int i) const { return m_positions[i].remaining; }
+    int    exitsFilled(int i) const
+    {
+        int n = 0;
+        for (int li = 0; li < m_positions[i].numExits; ++li) n += m_positions[i].exitFilled[li];
+        return n;
+    }
+
+    double objective(int objective) const
+    {
+        int nc = m_maxCyc + 1;
+        double obj = 0.0;
+        switch (objective)
+        {
+        case OBJ_MAX_PROFIT:
+            for (int c = 0; c < nc; ++c) obj += m_cycProf[c];
+            break;
+        case OBJ_MIN_SPREAD:
+            for (int i = 0; i < m_numPos; ++i)
+                for (int li = 0; li < m_positions[i].numExits; ++li)
+                    if (m_positions[i].exitFilled[li])
+                    { double sp = (m_positions[i].exits[li].tpPrice - m_positions[i].entryPrice)
+                                / std::fmax(m_positions[i].entryPrice, 1e-15); obj -= sp * sp; }
+            break;
+        case OBJ_MAX_ROI:
+            for (int c = 0; c < nc; ++c) obj += m_cycProf[c];
+            obj = (m_cfg.capital > 1e-15) ? obj / m_cfg.capital : 0;
+            break;
+        case OBJ_MAX_CHAIN:
+        { double prod = 1.0;
+            for (int c = 0; c < nc; ++c)
+                prod *= 1.0 + m_cycProf[c] * (1.0 - m_cfg.savingsRate) / std::fmax(m_cycCap[c], 1e-15);
+            obj = prod; } break;
+        case OBJ_MAX_WEALTH:
+            obj = m_capital + m_savings; break;
+        default: obj = m_realized; break;
+        }
+        return obj;
+    }
+
+private:
+    struct Pos
+    {
+        double    entryPrice, qty, remaining, buyFee;
+        int       cycle;
+        ExitLevel exits[kMaxExits];
+        bool      exitFilled[kMaxExits];
+        int       numExits;
+    };
+
+    GpuSimParams m_cfg{};
+    double       m_capital = 0, m_realized = 0, m_savings = 0;
+    int          m_cycle = 0, m_maxCyc = 0;
+
+    EntryLevel   m_entries[kMaxLevels];
+    bool         m_entryFilled[kMaxLevels];
+    int          m_numEntries = 0;
+    double       m_entryRefPrice = 0;
+
+    Pos          m_positions[kMaxPositions];
+    int          m_numPos = 0;
+
+    double       m_cycCap[kMaxCycles], m_cycProf[kMaxCycles];
+    int          m_curMonth = -1, m_tradesThisMonth = 0;
+};
+
+// ============================================================
+// Pool - persistent workers for forEach()
+// ============================================================
+
+class Pool
+{
+public:
+    static Pool& instance() { static Pool p; return p; }
+
+    ~Pool() { stop(); }
+
+    // Worker count including the calling thread; 0 = one per core.
+    void setThreads(int n)
+    {
+        std::lock_guard<std::mutex> run(m_run);
+        stop();
+        m_threads = n > 0 ? n : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_quit = false;
+        for (int i = 1; i < m_threads; ++i)
+            m_workers.emplace_back([this, seen = m_generation] { work(seen); });
+    }
+
+    int threads() const { return m_threads; }
+
+    // fn(i) for every i in [0, n), on the workers and the caller.
+    // Calls from several threads are served one after another.  If
+    // fn throws, the indices not yet started are skipped and the
+    // first exception is rethrown here once every worker is idle.
+    void forEach(int n, const std::function<void(int)>& fn)
+    {
+        if (n <= 0) return;
+        std::lock_guard<std::mutex> run(m_run);
+        if (m_workers.empty() || n == 1)
+        {
+            for (int i = 0; i < n; ++i) fn(i);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_fn = &fn; m_count = n; m_next = 0; m_busy = static_cast<int>(m_workers.size());
+            ++m_generation;
+        }
+        m_wake.notify_all();
+        drain();
+        std::exception_ptr error;
+        {
+            std::unique_lock<std::mutex> lk(m_mutex);
+            m_idle.wait(lk, [this] { return m_busy == 0; });
+            m_fn  = nullptr;
+            error = std::exchange(m_error, nullptr);
+        }
+        if (error) std::rethrow_exception(error);
+    }
+
+private:
+    Pool() { setThreads(0); }
+
+    void drain()
+    {
+        for (int i; (i = m_next.fetch_add(1)) < m_count; )
+        {
+            try { (*m_fn)(i); }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lk(m_mutex);
+                if (!m_error) m_error = std::current_exception();
+                m_next.store(m_count);
+            }
+        }
+    }
+
+    void work(unsigned long long seen)
+    {
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lk(m_mutex);
+                m_wake.wait(lk, [&] { return m_quit || m_generation != seen; });
+                if (m_quit) return;
+                seen = m_generation;
+            }
+            drain();
+            std::lock_guard<std::mutex> lk(m_mutex);
+            if (--m_busy == 0) m_idle.notify_one();
+        }
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_quit = true;
+        }
+        m_wake.notify_all();
+        for (auto& t : m_workers) t.join();
+        m_workers.clear();
+    }
+
+    std::mutex                        m_run;     // one forEach at a time
+    std::mutex                        m_mutex;
+    std::condition_variable           m_wake, m_idle;
+    std::vector<std::thread>          m_workers;
+    const std::function<void(int)>*   m_fn = nullptr;
+    int                               m_count = 0;
+    std::atomic<int>                  m_next{0};
+    int                               m_busy = 0;
+    std::exception_ptr                m_error;   // first throw of the batch
+    unsigned long long                m_generation = 0;
+    bool                              m_quit = false;
+    int                               m_threads = 1;
+};
+
+// Run the n <= kLanes configs at `configs` to the end of the series.
+inline void runLanes(const GpuSimParams* configs, int n,
+                     const double* timestamps, const double* prices, int numPrices,
+                     int objective, double* results)
+{
+    std::unique_ptr<Lane[]> lanes(new Lane[kLanes]);
+    const double inf = std::numeric_limits<double>::infinity();
+    alignas(32) double limitMax[kLanes], breakoutMin[kLanes], exitMin[kLanes];
+    for (int l = 0; l < kLanes; ++l) { limitMax[l] = -inf; breakoutMin[l] = inf; exitMin[l] = inf; }
+    const unsigned live = (1u << n) - 1u;
+
+    for (int l = 0; l < n; ++l)
+    {
+        lanes[l].start(configs[l], prices[0]);
+        lanes[l].bounds(limitMax[l], breakoutMin[l], exitMin[l]);
+    }
+
+    int curMonth = -1;
+    for (int pi = 0; pi < numPrices; ++pi)
+    {
+        double price = prices[pi];
+        double ts    = timestamps ? timestamps[pi] : 0.0;
+        int month = (ts > 0.0) ? (int)(ts / kSecsPerMonth) : -1;
+
+        unsigned fire;
+        if (month != curMonth && month >= 0)
+        {
+            curMonth = month;
+            for (int l = 0; l < n; ++l) lanes[l].rollover(month);
+            fire = live;
+        }
+        else
+        {
+            fire = 0;
+            for (int l = 0; l < kLanes; ++l)
+                fire |= unsigned(!(price >= limitMax[l] && price <= breakoutMin[l]
+                                   && price < exitMin[l])) << l;
+            fire &= live;
+        }
+
+        for (; fire; fire &= fire - 1)
+        {
+            int l = 0;
+            while (!(fire >> l & 1u)) ++l;
+            lanes[l].step(price);
+            lanes[l].bounds(limitMax[l], breakoutMin[l], exitMin[l]);
+        }
+    }
+
+    for (int l = 0; l < n; ++l) results[l] = lanes[l].objective(objective);
+}
+
+} // namespace CpuBatchSim
+
+// Same contract as cudaGpuBatchSim(); timestamps may be null (no
+// calendar, so no monthly cap or pump).
+inline bool cpuBatchSim(const GpuSimParams* configs, int numConfigs,
+                        const double* timestamps, const double* prices, int numPrices,
+                        int objective, double* results)
+{
+    using namespace CpuBatchSim;
+    if (numConfigs <= 0 || numPrices <= 0) return false;
+    int groups = (numConfigs + kLanes - 1) / kLanes;
+    Pool::instance().forEach(groups, [&](int g) {
+        int first = g * kLanes;
+        runLanes(configs + first, std::min(kLanes, numConfigs - first),
+                 timestamps, prices, numPrices, objective, results + first);
+    });
+    return true;
+}
+
+// ============================================================
+// BatchSim - runtime backend selection for batched simulation
+// ============================================================
+
+class BatchSim
+{
+public:
+    enum class Backend
+    {
+        Sequential = 0,   // no batching: the caller runs Simulator::run per config
+        Cpu        = 1,
+        Cuda       = 2
+    };
+
+    // Cuda when asked for and a GPU is present; Cpu in its place otherwise.
+    static Backend resolve(Backend want)
+    {
+        if (want == Backend::Cuda && !CudaAccelerator::isAvailable()) return Backend::Cpu;
+        return want;
+    }
+
+    static const char* name(Backend b)
+    {
+        switch (b)
+        {
+        case Backend::Cpu:  return "CPU batch";
+        case Backend::Cuda: return "CUDA GPU";
+        default:            return "Sequential";
+        }
+    }
+
+    static std::string deviceName(Backend b)
+    {
+        if (b == Backend::Cuda) return CudaAccelerator::deviceName();
+        if (b == Backend::Cpu)
+            return std::to_string(getThreads()) + " threads x "
+                 + std::to_string(CpuBatchSim::kLanes) + " lanes";
+        return "";
+    }
+
+    static void setThreads(int n) { CpuBatchSim::Pool::instance().setThreads(n); }
+    static int  getThreads()      { return CpuBatchSim::Pool::instance().threads(); }
+
+    // Run on `b` (after resolve()); false for Sequential or on failure.
+    static bool run(Backend b, const GpuSimParams* configs, int numConfigs,
+                    const double* timestamps, const double* prices, int numPrices,
+                    int objective, double* results)
+    {
+        switch (resolve(b))
+        {
+        case Backend::Cuda:
+#ifdef QUANT_CUDA
+            return cudaGpuBatchSim(configs, numConfigs, timestamps, prices, numPrices,
+                                   objective, results);
+#else
+            return false;
+#endif
+        case Backend::Cpu:
+            return cpuBatchSim(configs, numConfigs, timestamps, prices, numPrices,
+                               objective, results);
+        default:
+            return false;
+        }
+    }
+};
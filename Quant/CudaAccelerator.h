@@ -4,15 +4,11 @@
 //
 // QUANT_CUDA defined  -> real API, links to CudaKernels.cu
 // QUANT_CUDA absent   -> no-op stubs, CPU path used
+//
+// GpuSimParams is defined either way so the CPU batch backend
+// (CpuBatchSim.h) can take the same configs.
 // ============================================================
 
-#ifdef QUANT_CUDA
-
-#include "QuantMath.h"
-#include <string>
-#include <vector>
-#include <algorithm>
-
 // Must match the struct in CudaKernels.cu exactly
 struct GpuSimParams
 {
@@ -38,6 +34,13 @@ struct GpuSimParams
     int    autoRange;
 };
 
+#ifdef QUANT_CUDA
+
+#include "QuantMath.h"
+#include <string>
+#include <vector>
+#include <algorithm>
+
 // Host API (defined in CudaKernels.cu)
 extern "C" {
     bool        cudaGpuInit();
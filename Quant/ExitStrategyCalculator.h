@@ -47,6 +47,21 @@ public:
                                            double riskCoefficient = 0.0,
                                            double exitFraction = 1.0,
                                            double steepness = 4.0)
+    {
+        std::vector<ExitLevel> levels;
+        levels.reserve(p.horizonCount < 1 ? 1 : p.horizonCount);
+        appendTo(levels, trade, p, riskCoefficient, exitFraction, steepness);
+        return levels;
+    }
+
+    // generate(), appending the levels to `out` (for callers that
+    // keep every plan in one buffer).
+    static void appendTo(std::vector<ExitLevel>& out,
+                         const Trade& trade,
+                         const HorizonParams& p,
+                         double riskCoefficient = 0.0,
+                         double exitFraction = 1.0,
+                         double steepness = 4.0)
     {
         QuantMath::ExitParams ep;
         ep.entryPrice      = trade.value;
@@ -60,11 +75,7 @@ public:
         ep.exitFraction     = exitFraction;
         ep.steepness        = steepness;
 
-        auto plan = QuantMath::generateExitPlan(ep);
-
-        std::vector<ExitLevel> levels;
-        levels.reserve(plan.levels.size());
-        for (const auto& pl : plan.levels)
+        QuantMath::forEachExitLevel(ep, [&](const QuantMath::ExitPlanLevel& pl)
         {
             ExitLevel el;
             el.index        = pl.index;
@@ -78,9 +89,8 @@ public:
             el.levelSellFee = 0.0;
             el.netProfit    = pl.netProfit;
             el.cumNetProfit = pl.cumNetProfit;
-            levels.push_back(el);
-        }
-        return levels;
+            out.push_back(el);
+        });
     }
 
     // Recompute netProfit and cumNetProfit after per-level fees are updated.
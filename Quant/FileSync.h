@@ -0,0 +1,408 @@
+#pragma once
+
+// ============================================================
+// FileSync.h — durable file replacement and group-commit fsync
+//
+// replace(path, bytes) writes <path>.tmp, makes it durable,
+// renames it over <path> and makes the directory entry durable,
+// so a crash leaves either the old or the new file, never a
+// truncated one.
+//
+// Durability goes through a process-wide GroupCommit: writers
+// that ask for a sync while another flush is running (or within
+// the optional window) are served by a single leader that
+// fsyncs each distinct path once.  Two TradeDatabase instances
+// appending to the same journal, or renaming files in the same
+// directory, share one flush.
+//
+// Batch applies several replacements and appends as one commit:
+// either all of them land or, after a crash, none of them do.
+// ============================================================
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <string>
+#include <vector>
+#include <set>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+
+namespace FileSync {
+
+enum class Mode
+{
+    Off,        // rename only; the OS flushes when it likes
+    Immediate,  // every writer fsyncs on its own
+    Group       // concurrent writers share fsyncs (default)
+};
+
+// fsync an existing file or directory by path.  Directories are a
+// no-op on Windows, where NTFS journals the rename itself.
+inline bool syncPath(const std::string& path, bool isDir = false)
+{
+#ifdef _WIN32
+    if (isDir) return true;
+    int fd = _open(path.c_str(), _O_RDWR | _O_BINARY);
+    if (fd < 0) return false;
+    bool ok = _commit(fd) == 0;
+    _close(fd);
+    return ok;
+#else
+    int fd = ::open(path.c_str(), isDir ? (O_RDONLY | O_DIRECTORY) : O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#endif
+}
+
+// Identity of the file currently at `path` (inode / NTFS file index),
+// 0 if it cannot be read.  replace() always renames a new file in, so
+// a changed id catches a rewrite that kept the size and landed in the
+// same mtime tick.
+inline std::uint64_t fileId(const std::string& path)
+{
+#ifdef _WIN32
+    HANDLE h = CreateFileA(path.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                           nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return 0;
+    BY_HANDLE_FILE_INFORMATION info;
+    bool ok = GetFileInformationByHandle(h, &info) != 0;
+    CloseHandle(h);
+    if (!ok) return 0;
+    return (static_cast<std::uint64_t>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+#else
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) return 0;
+    return static_cast<std::uint64_t>(st.st_ino);
+#endif
+}
+
+class GroupCommit
+{
+public:
+    static GroupCommit& instance()
+    {
+        static GroupCommit g;
+        return g;
+    }
+
+    Mode mode() const { return m_mode.load(); }
+    void setMode(Mode m) { m_mode.store(m); }
+
+    // How long a leader waits for more writers before flushing.  With the
+    // default of 0 batches still form: whoever arrives while a flush is
+    // running joins the next one.
+    void setWindow(std::chrono::microseconds w) { m_windowUs.store(w.count()); }
+
+    // Block until `paths` are durable (per mode).
+    void sync(const std::vector<std::pair<std::string, bool>>& paths)
+    {
+        Mode m = m_mode.load();
+        if (m == Mode::Off || paths.empty()) return;
+        if (m == Mode::Immediate)
+        {
+            for (const auto& [p, dir] : paths)
+                if (!syncPath(p, dir)) throw std::runtime_error("fsync failed for " + p);
+            return;
+        }
+
+        std::unique_lock<std::mutex> lk(m_mx);
+        for (const auto& p : paths) m_pending.insert(p);
+        unsigned long long ticket = m_nextBatch;
+
+        // Someone else is flushing: our paths ride in the next batch.
+        while (m_flushing && m_doneBatch < ticket)
+            m_cv.wait(lk);
+        if (m_doneBatch >= ticket)
+            return rethrowFor(ticket);
+
+        // Leader: give concurrent writers a moment to join, then flush.
+        m_flushing = true;
+        long long windowUs = m_windowUs.load();
+        if (windowUs > 0)
+        {
+            lk.unlock();
+            std::this_thread::sleep_for(std::chrono::microseconds(windowUs));
+            lk.lock();
+        }
+        auto batch = std::move(m_pending);
+        m_pending.clear();
+        ++m_nextBatch;
+        lk.unlock();
+
+        std::string failed;
+        for (const auto& [p, dir] : batch)
+            if (!syncPath(p, dir) && failed.empty()) failed = p;
+
+        lk.lock();
+        m_doneBatch = ticket;
+        m_failedPath = failed;
+        m_flushing = false;
+        m_cv.notify_all();
+        rethrowFor(ticket);
+    }
+
+private:
+    GroupCommit() = default;
+
+    void rethrowFor(unsigned long long ticket) const
+    {
+        if (m_doneBatch == ticket && !m_failedPath.empty())
+            throw std::runtime_error("fsync failed for " + m_failedPath);
+    }
+
+    std::atomic<Mode>        m_mode{Mode::Group};
+    std::atomic<long long>   m_windowUs{0};
+
+    std::mutex               m_mx;
+    std::condition_variable  m_cv;
+    std::set<std::pair<std::string, bool>> m_pending;
+    unsigned long long       m_nextBatch = 1;   // batch new arrivals join
+    unsigned long long       m_doneBatch = 0;   // last batch made durable
+    bool                     m_flushing  = false;
+    std::string              m_failedPath;
+};
+
+inline std::string parentDir(const std::string& path)
+{
+    auto dir = std::filesystem::path(path).parent_path();
+    return dir.empty() ? std::string(".") : dir.string();
+}
+
+inline void writeAll(std::FILE* f, const std::string& path, const std::string& text)
+{
+    if (std::fwrite(text.data(), 1, text.size(), f) != text.size() || std::fflush(f) != 0)
+    {
+        std::fclose(f);
+        throw std::runtime_error("Write failed for " + path);
+    }
+    if (std::fclose(f) != 0) throw std::runtime_error("Close failed for " + path);
+}
+
+// Atomically replace `path` with `text`.
+inline void replace(const std::string& path, const std::string& text)
+{
+    std::string tmp = path + ".tmp";
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) throw std::runtime_error("Cannot open " + tmp);
+    writeAll(f, tmp, text);
+
+    auto& gc = GroupCommit::instance();
+    gc.sync({{tmp, false}});
+    std::filesystem::rename(tmp, path);
+    gc.sync({{parentDir(path), true}});
+}
+
+// Append `text` to `path` (created if missing) and make it durable.
+inline void append(const std::string& path, const std::string& text)
+{
+    bool created = !std::filesystem::exists(path);
+    std::FILE* f = std::fopen(path.c_str(), "ab");
+    if (!f) throw std::runtime_error("Cannot open " + path);
+    writeAll(f, path, text);
+
+    std::vector<std::pair<std::string, bool>> paths = {{path, false}};
+    if (created) paths.push_back({parentDir(path), true});
+    GroupCommit::instance().sync(paths);
+}
+
+// Multi-file commit.  Every replacement is written to <path>.tmp and
+// made durable first; then an intent file naming the renames (and
+// carrying the appended bytes with the offset they go at) is itself
+// committed with replace().  That rename is the commit point: the
+// steps are applied and the intent removed.  recover() finishes a
+// batch whose intent survived a crash -- every step is idempotent --
+// and without an intent any .tmp files are leftovers of a batch that
+// never committed, overwritten by the next write.  A batch of one
+// step skips the intent.
+class Batch
+{
+public:
+    void replace(const std::string& path, std::string text)
+    {
+        Step& s = step(path);
+        s.append = false;
+        s.text   = std::move(text);
+    }
+
+    void append(const std::string& path, const std::string& text)
+    {
+        step(path).text += text;
+    }
+
+    bool empty() const { return m_steps.empty(); }
+
+    void commit(const std::string& intentPath)
+    {
+        std::vector<Step> steps = std::move(m_steps);
+        m_steps.clear();
+        if (steps.empty()) return;
+        if (steps.size() == 1)
+        {
+            const Step& s = steps.front();
+            if (s.append) FileSync::append(s.path, s.text);
+            else          FileSync::replace(s.path, s.text);
+            return;
+        }
+
+        std::vector<std::pair<std::string, bool>> tmps;
+        std::string intent = kMagic;
+        for (Step& s : steps)
+        {
+            if (s.append)
+            {
+                std::error_code ec;
+                auto size = std::filesystem::file_size(s.path, ec);
+                s.offset = ec ? 0 : static_cast<std::uint64_t>(size);
+                intent += "A " + std::to_string(s.offset) + " " + std::to_string(s.text.size())
+                        + " " + s.path + "\n" + s.text;
+            }
+            else
+            {
+                std::string tmp = s.path + ".tmp";
+                std::FILE* f = std::fopen(tmp.c_str(), "wb");
+                if (!f) throw std::runtime_error("Cannot open " + tmp);
+                writeAll(f, tmp, s.text);
+                tmps.push_back({tmp, false});
+                intent += "R " + s.path + "\n";
+            }
+        }
+        GroupCommit::instance().sync(tmps);
+        FileSync::replace(intentPath, intent);
+        finish(intentPath, steps);
+    }
+
+    // Complete the batch recorded at `intentPath`, if any.  Returns
+    // whether there was one.
+    static bool recover(const std::string& intentPath)
+    {
+        std::FILE* f = std::fopen(intentPath.c_str(), "rb");
+        if (!f) return false;
+        std::string text;
+        char buf[65536];
+        for (std::size_t n; (n = std::fread(buf, 1, sizeof buf, f)) > 0; )
+            text.append(buf, n);
+        std::fclose(f);
+
+        std::size_t pos = std::string(kMagic).size();
+        if (text.compare(0, pos, kMagic) != 0)
+            throw std::runtime_error("Unrecognised commit intent " + intentPath);
+
+        std::vector<Step> steps;
+        while (pos < text.size())
+        {
+            std::size_t eol = text.find('\n', pos);
+            if (eol == std::string::npos || eol < pos + 2)
+                throw std::runtime_error("Corrupt commit intent " + intentPath);
+            Step s;
+            s.append = text[pos] == 'A';
+            std::string line = text.substr(pos + 2, eol - pos - 2);
+            pos = eol + 1;
+            if (s.append)
+            {
+                std::size_t a = line.find(' '), b = line.find(' ', a + 1);
+                if (a == std::string::npos || b == std::string::npos)
+                    throw std::runtime_error("Corrupt commit intent " + intentPath);
+                s.offset = std::stoull(line.substr(0, a));
+                std::size_t n = std::stoull(line.substr(a + 1, b - a - 1));
+                if (n > text.size() - pos)
+                    throw std::runtime_error("Corrupt commit intent " + intentPath);
+                s.path = line.substr(b + 1);
+                s.text = text.substr(pos, n);
+                pos += n;
+            }
+            else
+            {
+                s.path = line;
+            }
+            steps.push_back(std::move(s));
+        }
+        finish(intentPath, steps);
+        return true;
+    }
+
+private:
+    static constexpr const char* kMagic = "quant-commit 1\n";
+
+    struct Step
+    {
+        std::string   path;
+        bool          append = true;
+        std::string   text;     // whole file, or the bytes to append
+        std::uint64_t offset = 0;
+    };
+
+    // One step per path: a replacement supersedes anything queued
+    // before it, and appends after it extend its text.
+    Step& step(const std::string& path)
+    {
+        for (Step& s : m_steps)
+            if (s.path == path) return s;
+        Step s;
+        s.path = path;
+        m_steps.push_back(std::move(s));
+        return m_steps.back();
+    }
+
+    // Apply the steps behind a durable intent, then drop the intent.
+    // Appends cut the file back to their offset first, so replaying
+    // them after a partial apply does not duplicate rows.
+    static void finish(const std::string& intentPath, const std::vector<Step>& steps)
+    {
+        std::set<std::pair<std::string, bool>> durable;
+        for (const Step& s : steps)
+        {
+            if (s.append)
+            {
+                std::error_code ec;
+                auto size = std::filesystem::file_size(s.path, ec);
+                std::uint64_t have = ec ? 0 : static_cast<std::uint64_t>(size);
+                if (have < s.offset)
+                    throw std::runtime_error("Commit intent does not match " + s.path);
+                if (have > s.offset)
+                    std::filesystem::resize_file(s.path, s.offset);
+                std::FILE* f = std::fopen(s.path.c_str(), "ab");
+                if (!f) throw std::runtime_error("Cannot open " + s.path);
+                writeAll(f, s.path, s.text);
+                durable.insert({s.path, false});
+            }
+            else
+            {
+                std::string tmp = s.path + ".tmp";
+                if (std::filesystem::exists(tmp))
+                    std::filesystem::rename(tmp, s.path);
+            }
+            durable.insert({parentDir(s.path), true});
+        }
+        auto& gc = GroupCommit::instance();
+        gc.sync({durable.begin(), durable.end()});
+        std::filesystem::remove(intentPath);
+        gc.sync({{parentDir(intentPath), true}});
+    }
+
+    std::vector<Step> m_steps;
+};
+
+} // namespace FileSync
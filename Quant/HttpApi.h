@@ -38,6 +38,13 @@ inline void startHttpApi(TradeDatabase& db, int port, std::mutex& dbMutex)
     static SymbolRegistry  symbols;
     static PriceSeries     prices;
 
+    // Entered prices persist as tick files beside the default database
+    try { prices.open(db.baseDir() + "/prices"); }
+    catch (const std::exception& e)
+    {
+        std::cerr << "  [Prices] " << e.what() << " - prices will not persist\n";
+    }
+
     // Seed the symbol registry from existing trades
     {
         auto trades = db.loadTrades();
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <set>
+#include <map>
+#include <limits>
+#include <iterator>
 #include <stdexcept>
 
 // Generic ID allocator with lock/unlock semantics.
@@ -10,30 +13,42 @@
 // - release(id): frees a used or locked ID entirely.
 // - unlock(id) : releases a lock without committing (cancellation).
 //
+// Free IDs are kept as disjoint intervals [lo, hi] keyed by lo, so the
+// lowest free ID is the first key and every operation is O(log k) in the
+// number of gaps k (1 for a dense ledger), independent of how many IDs
+// are in use.
+//
 // IDs start at 1.  Callers are responsible for external synchronisation.
 
 class IdGenerator
 {
 public:
-    IdGenerator() = default;
+    IdGenerator() { m_free.emplace(1, kMaxId); }
 
     // Seed the generator with IDs already in use (e.g. loaded from disk).
     void seed(const std::set<int>& existingIds)
     {
-        m_used = existingIds;
+        m_free.clear();
+        m_free[1] = kMaxId;
+        m_lockedUsed.clear();
+        for (int id : existingIds)
+            seedSingle(id);
+        for (int id : m_locked)
+            take(id);
     }
 
     void seedSingle(int id)
     {
-        if (id > 0) m_used.insert(id);
+        if (id > 0 && m_locked.count(id)) m_lockedUsed.insert(id);
+        take(id);
     }
 
     // Find the lowest available ID, lock it, and return it.
     int acquire()
     {
-        int id = 1;
-        while (m_used.count(id) || m_locked.count(id))
-            ++id;
+        if (m_free.empty()) throw std::overflow_error("IdGenerator exhausted");
+        int id = m_free.begin()->first;
+        take(id);
         m_locked.insert(id);
         return id;
     }
@@ -42,34 +57,98 @@ public:
     void commit(int id)
     {
         m_locked.erase(id);
-        m_used.insert(id);
+        m_lockedUsed.erase(id);
+        take(id);
     }
 
     // Release an ID (whether used or locked) so it can be reused.
     void release(int id)
     {
-        m_used.erase(id);
         m_locked.erase(id);
+        m_lockedUsed.erase(id);
+        give(id);
     }
 
     // Cancel a lock without committing.
     void unlock(int id)
     {
-        m_locked.erase(id);
+        if (m_locked.erase(id) && !m_lockedUsed.erase(id))
+            give(id);
     }
 
     bool isAvailable(int id) const
     {
-        return !m_used.count(id) && !m_locked.count(id);
+        return id < 1 || isFree(id);
     }
 
-    bool isUsed(int id)    const { return m_used.count(id) > 0; }
+    bool isUsed(int id)    const { return id >= 1 && !isFree(id) && (!isLocked(id) || m_lockedUsed.count(id)); }
     bool isLocked(int id)  const { return m_locked.count(id) > 0; }
 
-    const std::set<int>& usedIds()   const { return m_used; }
+    std::set<int> usedIds() const
+    {
+        std::set<int> out;
+        int next = 1;
+        for (const auto& [lo, hi] : m_free)
+        {
+            for (int id = next; id < lo; ++id)
+                if (!m_locked.count(id) || m_lockedUsed.count(id)) out.insert(out.end(), id);
+            if (hi == kMaxId) return out;
+            next = hi + 1;
+        }
+        return out;
+    }
     const std::set<int>& lockedIds() const { return m_locked; }
 
 private:
-    std::set<int> m_used;
-    std::set<int> m_locked;
+    static constexpr int kMaxId = std::numeric_limits<int>::max();
+
+    // Interval containing `id`, or end().
+    std::map<int, int>::const_iterator findFree(int id) const
+    {
+        auto it = m_free.upper_bound(id);
+        if (it == m_free.begin()) return m_free.end();
+        --it;
+        return it->second >= id ? it : m_free.end();
+    }
+
+    bool isFree(int id) const { return findFree(id) != m_free.end(); }
+
+    // Remove `id` from the free intervals (no-op if already taken).
+    void take(int id)
+    {
+        if (id < 1) return;
+        auto c = findFree(id);
+        if (c == m_free.end()) return;
+        int lo = c->first, hi = c->second;
+        auto it = m_free.erase(c);
+        if (id < hi) it = m_free.emplace_hint(it, id + 1, hi);
+        if (lo < id) m_free.emplace_hint(it, lo, id - 1);
+    }
+
+    // Return `id` to the free intervals, merging with its neighbours.
+    void give(int id)
+    {
+        if (id < 1 || isFree(id)) return;
+        int lo = id, hi = id;
+        auto next = id < kMaxId ? m_free.find(id + 1) : m_free.end();
+        if (next != m_free.end())
+        {
+            hi = next->second;
+            next = m_free.erase(next);
+        }
+        if (next != m_free.begin())
+        {
+            auto prev = std::prev(next);
+            if (prev->second == id - 1)
+            {
+                lo = prev->first;
+                next = m_free.erase(prev);
+            }
+        }
+        m_free.emplace_hint(next, lo, hi);
+    }
+
+    std::map<int, int> m_free;        // lo -> hi, inclusive
+    std::set<int>      m_locked;
+    std::set<int>      m_lockedUsed;  // locked IDs that a seed also marked used
 };
@@ -60,6 +60,24 @@ public:
                                             double rangeAbove = 0.0,
                                             double rangeBelow = 0.0,
                                             bool   autoRange = false)
+    {
+        std::vector<EntryLevel> levels;
+        generateInto(levels, currentPrice, quantity, p, riskCoefficient,
+                     steepness, rangeAbove, rangeBelow, autoRange);
+        return levels;
+    }
+
+    // generate(), into `out` in place of its contents: a caller that
+    // regenerates levels over and over keeps one buffer's capacity.
+    static void generateInto(std::vector<EntryLevel>& out,
+                             double currentPrice,
+                             double quantity,
+                             const HorizonParams& p,
+                             double riskCoefficient = 0.0,
+                             double steepness = 6.0,
+                             double rangeAbove = 0.0,
+                             double rangeBelow = 0.0,
+                             bool   autoRange = false)
     {
         double oh = MultiHorizonEngine::computeOverhead(currentPrice, quantity, p);
 
@@ -69,8 +87,8 @@ public:
 
         double risk = QuantMath::clamp01(riskCoefficient);
 
-        // sigmoid helpers
-        auto norm = QuantMath::sigmoidNormN(N, steepness);
+        // sigmoid helpers, level by level (see QuantMath::sigmoidNormN)
+        QuantMath::SigmoidRange sr = QuantMath::sigmoidRange(steepness);
 
         // entry price range
         double priceLow, priceHigh;
@@ -101,32 +119,33 @@ public:
         //   risk=0   -> sigmoid weights (more funding near current price)
         //   risk=0.5 -> uniform
         //   risk=1   -> inverse sigmoid (more funding at deep discounts)
-        auto weights = QuantMath::riskWeights(norm, risk);
         double weightSum = 0.0;
-        for (double w : weights) weightSum += w;
+        for (int i = 0; i < N; ++i)
+            weightSum += QuantMath::riskWeight(QuantMath::sigmoidNormAt(i, N, steepness, sr), risk);
 
-        std::vector<EntryLevel> levels;
-        levels.reserve(N);
+        out.clear();
+        out.reserve(N);
 
         for (int i = 0; i < N; ++i)
         {
+            double norm   = QuantMath::sigmoidNormAt(i, N, steepness, sr);
+            double weight = QuantMath::riskWeight(norm, risk);
+
             EntryLevel el;
             el.index        = i;
             el.costCoverage = static_cast<double>(i + 1);
-            el.entryPrice   = QuantMath::lerp(priceLow, priceHigh, norm[i]);
+            el.entryPrice   = QuantMath::lerp(priceLow, priceHigh, norm);
             el.entryPrice   = QuantMath::floorEps(el.entryPrice);
 
             el.breakEven    = QuantMath::breakEven(el.entryPrice, oh);
 
-            el.fundingFraction = (weightSum != 0.0) ? weights[i] / weightSum : 0.0;
+            el.fundingFraction = (weightSum != 0.0) ? weight / weightSum : 0.0;
             el.funding         = p.portfolioPump * el.fundingFraction;
             el.fundingQty      = QuantMath::fundedQty(el.entryPrice, el.funding);
 
             el.potentialNet = QuantMath::grossProfit(el.entryPrice, currentPrice, el.fundingQty);
 
-            levels.push_back(el);
+            out.push_back(el);
         }
-
-        return levels;
     }
 };
@@ -0,0 +1,404 @@
+#pragma once
+// ============================================================
+// MonteCarlo.h - synthetic price paths and distributional
+// backtests
+//
+// Three path models, all in log-returns per tick:
+//
+//   Gbm        geometric Brownian motion, drift mu and vol sigma
+//              per tick: r = mu - sigma^2/2 + sigma*Z
+//   Bootstrap  circular block bootstrap of a historical series'
+//              returns: blocks of blockSize consecutive returns
+//              from random starts, so volatility clustering and
+//              short-range autocorrelation survive the shuffle
+//   Regime     Markov switching between regimes, each a Gbm with
+//              its own drift and vol and a per-tick probability of
+//              staying; a calm / crash pair reproduces the
+//              sustained bear markets and gap-downs of
+//              docs/failure-modes.md
+//
+// Path i draws from its own mt19937_64 stream seeded with
+// SplitMix64(seed, i), so a path is the same whichever worker
+// runs it and however many threads there are.
+//
+// run() pushes every path through Simulator::run with the
+// caller's strategy, shared out over CpuBatchSim::Pool in
+// batches like ParamSweep, and reports each path in path order
+// as its batch completes.  The summary holds the distributions
+// of final capital, equity (capital, savings and open positions
+// marked at the path's last price), cycles completed and fee
+// hedging coverage, plus how often equity ended below the
+// starting capital and how often the hedge did not cover the
+// fees it paid.
+// ============================================================
+
+#include "Simulator.h"
+#include "CpuBatchSim.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace MonteCarlo {
+
+enum class Model { Gbm, Bootstrap, Regime };
+
+inline const char* modelName(Model m)
+{
+    switch (m)
+    {
+    case Model::Bootstrap: return "bootstrap";
+    case Model::Regime:    return "regime";
+    default:               return "gbm";
+    }
+}
+
+inline bool parseModel(const std::string& s, Model& out)
+{
+    if      (s == "gbm")       out = Model::Gbm;
+    else if (s == "bootstrap") out = Model::Bootstrap;
+    else if (s == "regime")    out = Model::Regime;
+    else return false;
+    return true;
+}
+
+struct Regime
+{
+    double drift = 0.0;    // log drift per tick
+    double vol   = 0.02;   // log stdev per tick
+    double stay  = 0.99;   // probability of staying in this regime each tick
+};
+
+struct PathConfig
+{
+    Model     model      = Model::Gbm;
+    int       paths      = 1000;
+    int       steps      = 1000;     // ticks per path, including the start
+    double    startPrice = 100.0;
+    long long startTime  = 1704067200;   // 2024-01-01, so month quotas line up
+    long long interval   = 86400;    // seconds between ticks
+
+    double drift = 0.0;              // Gbm
+    double vol   = 0.02;
+
+    std::vector<double> history;     // Bootstrap: historical prices, oldest first
+    int blockSize = 20;
+
+    std::vector<Regime> regimes;     // Regime: starts in regimes[0]; a switch
+                                     // picks one of the others uniformly
+
+    std::uint64_t seed = 1;
+};
+
+// Per-tick log drift and vol of a price history (0, 0 if too short).
+inline void estimate(const std::vector<double>& prices, double& drift, double& vol)
+{
+    drift = vol = 0.0;
+    double n = 0, sum = 0, sq = 0;
+    for (std::size_t i = 1; i < prices.size(); ++i)
+    {
+        if (prices[i] <= 0 || prices[i - 1] <= 0) continue;
+        double r = std::log(prices[i] / prices[i - 1]);
+        ++n; sum += r; sq += r * r;
+    }
+    if (n < 2) return;
+    double mean = sum / n;
+    vol   = std::sqrt(std::max(0.0, (sq - n * mean * mean) / (n - 1)));
+    drift = mean + 0.5 * vol * vol;
+}
+
+// Fill what a history implies and the caller left unset: the start
+// price (last price), and Gbm drift and vol (both 0 = estimated).
+inline void applyHistory(PathConfig& c)
+{
+    if (c.history.empty()) return;
+    if (c.startPrice <= 0) c.startPrice = c.history.back();
+    if (c.drift == 0.0 && c.vol == 0.0) estimate(c.history, c.drift, c.vol);
+}
+
+// The default Regime pair: calm at (drift, vol), lasting about 100
+// ticks, and a crash drifting down half a calm sigma a tick at 2.5
+// times the vol, lasting about 20.
+inline std::vector<Regime> calmAndCrash(double drift, double vol)
+{
+    return { { drift, vol, 0.99 }, { -0.5 * vol, 2.5 * vol, 0.95 } };
+}
+
+inline std::uint64_t streamSeed(std::uint64_t seed, std::uint64_t path)
+{
+    std::uint64_t z = seed + 0x9E3779B97F4A7C15ull * (path + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+class Generator
+{
+public:
+    // Throws if the config cannot produce a path.
+    explicit Generator(PathConfig cfg) : m_cfg(std::move(cfg))
+    {
+        if (m_cfg.steps < 2)       throw std::runtime_error("A path needs at least 2 steps");
+        if (m_cfg.startPrice <= 0) throw std::runtime_error("Start price must be positive");
+        if (m_cfg.interval <= 0)   throw std::runtime_error("Interval must be positive");
+
+        if (m_cfg.model == Model::Bootstrap)
+        {
+            for (std::size_t i = 1; i < m_cfg.history.size(); ++i)
+                if (m_cfg.history[i] > 0 && m_cfg.history[i - 1] > 0)
+                    m_returns.push_back(std::log(m_cfg.history[i] / m_cfg.history[i - 1]));
+            if (m_returns.size() < 2)
+                throw std::runtime_error("Bootstrap needs a history of at least 3 prices");
+            m_cfg.blockSize = std::max(1, std::min(m_cfg.blockSize, static_cast<int>(m_returns.size())));
+        }
+        if (m_cfg.model == Model::Regime && m_cfg.regimes.empty())
+            throw std::runtime_error("Regime model needs at least one regime");
+    }
+
+    const PathConfig& config() const { return m_cfg; }
+
+    std::vector<PricePoint> path(int index) const
+    {
+        std::mt19937_64 rng(streamSeed(m_cfg.seed, static_cast<std::uint64_t>(index)));
+        std::normal_distribution<double>       z(0.0, 1.0);
+        std::uniform_real_distribution<double> u(0.0, 1.0);
+
+        std::vector<PricePoint> pts(m_cfg.steps);
+        double logP = std::log(m_cfg.startPrice);
+        int regime = 0;
+        std::size_t block = 0, left = 0;
+        for (int i = 0; i < m_cfg.steps; ++i)
+        {
+            if (i > 0)
+            {
+                double r = 0.0;
+                switch (m_cfg.model)
+                {
+                case Model::Bootstrap:
+                    if (left == 0)
+                    {
+                        block = static_cast<std::size_t>(u(rng) * m_returns.size()) % m_returns.size();
+                        left  = static_cast<std::size_t>(m_cfg.blockSize);
+                    }
+                    r = m_returns[block];
+                    block = (block + 1) % m_returns.size();
+                    --left;
+                    break;
+                case Model::Regime:
+                {
+                    int k = static_cast<int>(m_cfg.regimes.size());
+                    if (k > 1 && u(rng) >= m_cfg.regimes[regime].stay)
+                        regime = (regime + 1 + static_cast<int>(u(rng) * (k - 1)) % (k - 1)) % k;
+                    const Regime& g = m_cfg.regimes[regime];
+                    r = g.drift - 0.5 * g.vol * g.vol + g.vol * z(rng);
+                    break;
+                }
+                default:
+                    r = m_cfg.drift - 0.5 * m_cfg.vol * m_cfg.vol + m_cfg.vol * z(rng);
+                    break;
+                }
+                logP += r;
+            }
+            pts[i] = { m_cfg.startTime + i * m_cfg.interval, std::exp(logP) };
+        }
+        return pts;
+    }
+
+private:
+    PathConfig          m_cfg;
+    std::vector<double> m_returns;
+};
+
+// ---- Results ----
+
+struct PathResult
+{
+    int    path            = 0;
+    double finalPrice      = 0.0;
+    double finalCapital    = 0.0;
+    double totalRealized   = 0.0;
+    double totalFees       = 0.0;
+    double feeCoverage     = 0.0;    // SimResult::feeHedgingCoverage
+    double totalSavings    = 0.0;
+    double openValue       = 0.0;    // positions still held, at finalPrice
+    int    cyclesCompleted = 0;
+    int    tradesOpened    = 0;
+    int    tradesClosed    = 0;
+
+    double equity() const { return finalCapital + totalSavings + openValue; }
+};
+
+struct Distribution
+{
+    double mean = 0, stdev = 0, min = 0, p5 = 0, p25 = 0, p50 = 0, p75 = 0, p95 = 0, max = 0;
+};
+
+// Linear-interpolated quantiles of `v` (sorted in place).
+inline Distribution distribution(std::vector<double>& v)
+{
+    Distribution d;
+    if (v.empty()) return d;
+    std::sort(v.begin(), v.end());
+    double sum = 0, sq = 0;
+    for (double x : v) { sum += x; sq += x * x; }
+    double n = static_cast<double>(v.size());
+    d.mean  = sum / n;
+    d.stdev = v.size() > 1 ? std::sqrt(std::max(0.0, (sq - n * d.mean * d.mean) / (n - 1))) : 0.0;
+    auto q = [&](double p) {
+        double pos = p * (n - 1);
+        std::size_t lo = static_cast<std::size_t>(pos);
+        std::size_t hi = std::min(lo + 1, v.size() - 1);
+        return v[lo] + (v[hi] - v[lo]) * (pos - lo);
+    };
+    d.min = v.front(); d.max = v.back();
+    d.p5 = q(0.05); d.p25 = q(0.25); d.p50 = q(0.5); d.p75 = q(0.75); d.p95 = q(0.95);
+    return d;
+}
+
+struct Summary
+{
+    int          paths = 0;             // less than requested if onPath stopped the run
+    Distribution finalCapital;
+    Distribution equity;
+    Distribution cyclesCompleted;
+    Distribution feeCoverage;           // over paths that paid fees
+    double       lossProbability      = 0.0;   // equity < startingCapital
+    double       uncoveredProbability = 0.0;   // fees paid and coverage < 1
+    double       seconds = 0.0;
+};
+
+// Run `strategy` (prices and symbol are ignored) over every path.
+// onPath, if set, sees each path in order on the calling thread;
+// returning false stops after the current batch.
+inline Summary run(const SimConfig& strategy, const Generator& gen,
+                   const std::function<bool(const PathResult&)>& onPath = {})
+{
+    auto t0 = std::chrono::steady_clock::now();
+    CpuBatchSim::Pool& pool = CpuBatchSim::Pool::instance();
+    const int n = std::max(0, gen.config().paths);
+    const int batch = pool.threads() * 16;
+    const std::string symbol = strategy.symbol.empty() ? "MC" : strategy.symbol;
+
+    std::vector<double> capital, equity, cycles, coverage;
+    int losses = 0, uncovered = 0;
+    Summary out;
+
+    std::vector<PathResult> rows(std::min(batch, n));
+    bool more = true;
+    for (int lo = 0; lo < n && more; lo += batch)
+    {
+        int m = std::min(batch, n - lo);
+        pool.forEach(m, [&](int i) {
+            PriceSeries prices;
+            std::vector<PricePoint> pts = gen.path(lo + i);
+            double last = pts.back().price;
+            prices.setSeries(symbol, std::move(pts));
+
+            SimConfig cfg = strategy;
+            cfg.symbol = symbol;
+            cfg.prices = &prices;
+            cfg.ticks  = nullptr;
+            cfg.snapshotPolicy = SnapshotPolicy::None;   // totals only
+            static thread_local Simulator::Arena arena;
+            const SimResult& r = Simulator::run(cfg, arena);
+
+            PathResult& p = rows[i];
+            p = PathResult{};
+            p.path            = lo + i;
+            p.finalPrice      = last;
+            p.finalCapital    = r.finalCapital;
+            p.totalRealized   = r.totalRealized;
+            p.totalFees       = r.totalFees;
+            p.feeCoverage     = r.feeHedgingCoverage;
+            p.totalSavings    = r.totalSavings;
+            for (const SimTrade& t : r.trades) p.openValue += t.remaining * last;
+            p.cyclesCompleted = r.cyclesCompleted;
+            p.tradesOpened    = r.tradesOpened;
+            p.tradesClosed    = r.tradesClosed;
+        });
+
+        for (int i = 0; i < m; ++i)
+        {
+            const PathResult& p = rows[i];
+            if (more && onPath && !onPath(p)) more = false;
+            capital.push_back(p.finalCapital);
+            equity.push_back(p.equity());
+            cycles.push_back(p.cyclesCompleted);
+            if (p.totalFees > 0)
+            {
+                coverage.push_back(p.feeCoverage);
+                if (p.feeCoverage < 1.0) ++uncovered;
+            }
+            if (p.equity() < strategy.startingCapital) ++losses;
+        }
+        out.paths += m;
+    }
+
+    out.finalCapital    = distribution(capital);
+    out.equity          = distribution(equity);
+    out.cyclesCompleted = distribution(cycles);
+    out.feeCoverage     = distribution(coverage);
+    if (out.paths > 0)
+    {
+        out.lossProbability      = static_cast<double>(losses) / out.paths;
+        out.uncoveredProbability = static_cast<double>(uncovered) / out.paths;
+    }
+    out.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return out;
+}
+
+// ---- Output ----
+
+inline std::string jsonPath(const PathResult& p)
+{
+    std::ostringstream s;
+    s << std::setprecision(17)
+      << "{\"path\":"             << p.path
+      << ",\"finalPrice\":"       << p.finalPrice
+      << ",\"finalCapital\":"     << p.finalCapital
+      << ",\"equity\":"           << p.equity()
+      << ",\"totalRealized\":"    << p.totalRealized
+      << ",\"totalFees\":"        << p.totalFees
+      << ",\"feeCoverage\":"      << p.feeCoverage
+      << ",\"totalSavings\":"     << p.totalSavings
+      << ",\"openValue\":"        << p.openValue
+      << ",\"cyclesCompleted\":"  << p.cyclesCompleted
+      << ",\"tradesOpened\":"     << p.tradesOpened
+      << ",\"tradesClosed\":"     << p.tradesClosed << '}';
+    return s.str();
+}
+
+inline std::string jsonDistribution(const Distribution& d)
+{
+    std::ostringstream s;
+    s << std::setprecision(17)
+      << "{\"mean\":" << d.mean << ",\"stdev\":" << d.stdev << ",\"min\":" << d.min
+      << ",\"p5\":" << d.p5 << ",\"p25\":" << d.p25 << ",\"p50\":" << d.p50
+      << ",\"p75\":" << d.p75 << ",\"p95\":" << d.p95 << ",\"max\":" << d.max << '}';
+    return s.str();
+}
+
+inline std::string jsonSummary(const Summary& sum)
+{
+    std::ostringstream s;
+    s << std::setprecision(17)
+      << "{\"paths\":"                << sum.paths
+      << ",\"finalCapital\":"         << jsonDistribution(sum.finalCapital)
+      << ",\"equity\":"               << jsonDistribution(sum.equity)
+      << ",\"cyclesCompleted\":"      << jsonDistribution(sum.cyclesCompleted)
+      << ",\"feeCoverage\":"          << jsonDistribution(sum.feeCoverage)
+      << ",\"lossProbability\":"      << sum.lossProbability
+      << ",\"uncoveredProbability\":" << sum.uncoveredProbability
+      << ",\"seconds\":"              << sum.seconds << '}';
+    return s.str();
+}
+
+} // namespace MonteCarlo
@@ -0,0 +1,332 @@
+#pragma once
+// ============================================================
+// ParamSweep.h - grid search over SimConfig parameters
+//
+// A Sweep takes a SimConfig template and a list of axes, each a
+// parameter name (see params()) with the values to try.  Every
+// point of the Cartesian grid is one Simulator::run of the
+// template with those values set; grid index 0 is the first
+// value of every axis and the last axis varies fastest.
+//
+// All runs read the template's PriceSeries (or TickCodec
+// series) through the same const pointer, so the prices are
+// loaded once and never copied per config.  The grid is handed
+// out over CpuBatchSim::Pool in batches: within a batch each
+// worker claims the next unevaluated config from a shared
+// counter, so slow configs (long chains, many levels) never
+// leave other cores idle behind a fixed partition.  Between
+// batches the calling thread reports the batch's rows in grid
+// order and keeps the best topK by the chosen metric; only one
+// batch of rows is held at a time, and other pool users
+// (the optimizer's CPU batch backend) get a turn in between.
+//
+// The caller must keep the template's prices unchanged for
+// the duration of run().
+// ============================================================
+
+#include "Simulator.h"
+#include "CpuBatchSim.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ParamSweep {
+
+// ---- Parameters ----
+
+struct Param
+{
+    const char* name;
+    void (*set)(SimConfig&, double);
+    bool integer;
+};
+
+// The sweepable parameters, named as their SimConfig / HorizonParams
+// fields.  Settings the /simulator/run form derives from a parameter
+// (horizonCount from entryLevels, portfolioPump from startingCapital)
+// follow it here too.
+inline const std::vector<Param>& params()
+{
+    static const std::vector<Param> table = {
+        { "startingCapital",       [](SimConfig& c, double v) { c.startingCapital = v; c.horizonParams.portfolioPump = v; }, false },
+        { "entryRisk",             [](SimConfig& c, double v) { c.entryRisk = v; }, false },
+        { "entrySteepness",        [](SimConfig& c, double v) { c.entrySteepness = v; }, false },
+        { "entryRangeBelow",       [](SimConfig& c, double v) { c.entryRangeBelow = v; }, false },
+        { "entryRangeAbove",       [](SimConfig& c, double v) { c.entryRangeAbove = v; }, false },
+        { "entryLevels",           [](SimConfig& c, double v) { c.entryLevels = static_cast<int>(v); c.horizonParams.horizonCount = c.entryLevels; }, true },
+        { "exitLevels",            [](SimConfig& c, double v) { c.exitLevels = static_cast<int>(v); }, true },
+        { "exitRisk",              [](SimConfig& c, double v) { c.exitRisk = v; }, false },
+        { "exitFraction",          [](SimConfig& c, double v) { c.exitFraction = v; }, false },
+        { "exitSteepness",         [](SimConfig& c, double v) { c.exitSteepness = v; }, false },
+        { "buyFeeRate",            [](SimConfig& c, double v) { c.buyFeeRate = v; }, false },
+        { "sellFeeRate",           [](SimConfig& c, double v) { c.sellFeeRate = v; }, false },
+        { "downtrendCount",        [](SimConfig& c, double v) { c.downtrendCount = static_cast<int>(v); }, true },
+        { "savingsRate",           [](SimConfig& c, double v) { c.savingsRate = v; }, false },
+        { "maxTradesPerMonth",     [](SimConfig& c, double v) { c.maxTradesPerMonth = static_cast<int>(v); }, true },
+        { "capitalPumpPerMonth",   [](SimConfig& c, double v) { c.capitalPumpPerMonth = v; }, false },
+        { "surplusRate",           [](SimConfig& c, double v) { c.horizonParams.surplusRate = v; }, false },
+        { "feeSpread",             [](SimConfig& c, double v) { c.horizonParams.feeSpread = v; }, false },
+        { "feeHedgingCoefficient", [](SimConfig& c, double v) { c.horizonParams.feeHedgingCoefficient = v; }, false },
+        { "coefficientK",          [](SimConfig& c, double v) { c.horizonParams.coefficientK = v; }, false },
+        { "deltaTime",             [](SimConfig& c, double v) { c.horizonParams.deltaTime = v; }, false },
+        { "maxRisk",               [](SimConfig& c, double v) { c.horizonParams.maxRisk = v; }, false },
+        { "minRisk",               [](SimConfig& c, double v) { c.horizonParams.minRisk = v; }, false },
+        { "futureTradeCount",      [](SimConfig& c, double v) { c.horizonParams.futureTradeCount = static_cast<int>(v); }, true },
+        { "stopLossFraction",      [](SimConfig& c, double v) { c.horizonParams.stopLossFraction = v; }, false },
+        { "stopLossHedgeCount",    [](SimConfig& c, double v) { c.horizonParams.stopLossHedgeCount = static_cast<int>(v); }, true },
+    };
+    return table;
+}
+
+inline const Param* findParam(const std::string& name)
+{
+    for (const Param& p : params())
+        if (name == p.name) return &p;
+    return nullptr;
+}
+
+// ---- Axes ----
+
+struct Axis
+{
+    const Param*        param = nullptr;
+    std::vector<double> values;
+};
+
+// `steps` evenly spaced values from lo to hi inclusive; integer
+// parameters are rounded and repeats dropped.  Throws on an unknown
+// name.
+inline Axis linspace(const std::string& name, double lo, double hi, int steps)
+{
+    Axis a;
+    a.param = findParam(name);
+    if (!a.param) throw std::runtime_error("Unknown sweep parameter: " + name);
+    steps = std::max(1, steps);
+    for (int i = 0; i < steps; ++i)
+    {
+        double v = steps > 1 ? lo + (hi - lo) * i / (steps - 1) : lo;
+        if (a.param->integer) v = std::round(v);
+        if (a.values.empty() || v != a.values.back()) a.values.push_back(v);
+    }
+    return a;
+}
+
+// ---- Results ----
+
+struct Row
+{
+    std::size_t         index = 0;       // grid index
+    std::vector<double> values;          // one per axis
+    double finalCapital    = 0.0;
+    double totalRealized   = 0.0;
+    double totalFees       = 0.0;
+    double feeCoverage     = 0.0;        // SimResult::feeHedgingCoverage
+    double totalSavings    = 0.0;
+    int    cyclesCompleted = 0;
+    int    tradesOpened    = 0;
+    int    tradesClosed    = 0;
+    int    wins            = 0;
+    int    losses          = 0;
+};
+
+enum class Metric { FinalCapital, Realized, FeeCoverage, Cycles, Wealth };
+
+inline bool parseMetric(const std::string& s, Metric& out)
+{
+    if      (s == "finalCapital") out = Metric::FinalCapital;
+    else if (s == "realized")     out = Metric::Realized;
+    else if (s == "feeCoverage")  out = Metric::FeeCoverage;
+    else if (s == "cycles")       out = Metric::Cycles;
+    else if (s == "wealth")       out = Metric::Wealth;
+    else return false;
+    return true;
+}
+
+inline double metric(const Row& r, Metric m)
+{
+    switch (m)
+    {
+    case Metric::Realized:    return r.totalRealized;
+    case Metric::FeeCoverage: return r.feeCoverage;
+    case Metric::Cycles:      return r.cyclesCompleted;
+    case Metric::Wealth:      return r.finalCapital + r.totalSavings;
+    default:                  return r.finalCapital;
+    }
+}
+
+struct Options
+{
+    Metric      rankBy = Metric::FinalCapital;
+    std::size_t topK   = 10;
+    std::size_t batch  = 0;      // configs per batch; 0 = 64 per pool thread
+};
+
+struct Summary
+{
+    std::size_t      evaluated = 0;  // less than size() if onRow stopped the run
+    std::vector<Row> top;            // best first; ties keep the lower grid index
+    double           seconds   = 0.0;
+};
+
+// ---- Sweep ----
+
+class Sweep
+{
+public:
+    Sweep(const SimConfig& base, std::vector<Axis> axes)
+        : m_base(base), m_axes(std::move(axes)) {}
+
+    const std::vector<Axis>& axes() const { return m_axes; }
+
+    // Number of grid points (1 with no axes: the template alone).
+    std::size_t size() const
+    {
+        std::size_t n = 1;
+        for (const Axis& a : m_axes) n *= a.values.size();
+        return n;
+    }
+
+    // The template with grid point `index` applied.
+    SimConfig config(std::size_t index, std::vector<double>* values = nullptr) const
+    {
+        SimConfig c = m_base;
+        if (values) values->assign(m_axes.size(), 0.0);
+        for (std::size_t k = m_axes.size(); k-- > 0; )
+        {
+            const Axis& a = m_axes[k];
+            double v = a.values[index % a.values.size()];
+            index /= a.values.size();
+            a.param->set(c, v);
+            if (values) (*values)[k] = v;
+        }
+        return c;
+    }
+
+    Row evaluate(std::size_t index) const
+    {
+        Row row;
+        row.index = index;
+        // A row is totals only: no snapshots, and this thread's arena
+        // lends the previous run's buffers.
+        static thread_local Simulator::Arena arena;
+        SimConfig cfg = config(index, &row.values);
+        cfg.snapshotPolicy = SnapshotPolicy::None;
+        const SimResult& r = Simulator::run(cfg, arena);
+        row.finalCapital    = r.finalCapital;
+        row.totalRealized   = r.totalRealized;
+        row.totalFees       = r.totalFees;
+        row.feeCoverage     = r.feeHedgingCoverage;
+        row.totalSavings    = r.totalSavings;
+        row.cyclesCompleted = r.cyclesCompleted;
+        row.tradesOpened    = r.tradesOpened;
+        row.tradesClosed    = r.tradesClosed;
+        row.wins            = r.wins;
+        row.losses          = r.losses;
+        return row;
+    }
+
+    // Evaluate the grid.  onRow, if set, sees every row in grid order
+    // on the calling thread; returning false stops after the current
+    // batch.
+    Summary run(const Options& opt, const std::function<bool(const Row&)>& onRow = {}) const
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        CpuBatchSim::Pool& pool = CpuBatchSim::Pool::instance();
+        const std::size_t n = size();
+        const std::size_t batch = opt.batch > 0 ? opt.batch
+                                : static_cast<std::size_t>(pool.threads()) * 64;
+
+        // Min-heap on rank, so the weakest kept row is at the front.
+        auto better = [&](const Row& a, const Row& b) {
+            double ma = metric(a, opt.rankBy), mb = metric(b, opt.rankBy);
+            return ma != mb ? ma > mb : a.index < b.index;
+        };
+        Summary out;
+        out.top.reserve(opt.topK + 1);
+
+        std::vector<Row> rows(std::min(batch, n));
+        bool more = true;
+        for (std::size_t lo = 0; lo < n && more; lo += batch)
+        {
+            std::size_t m = std::min(batch, n - lo);
+            pool.forEach(static_cast<int>(m), [&](int i) { rows[i] = evaluate(lo + i); });
+
+            for (std::size_t i = 0; i < m; ++i)
+            {
+                if (more && onRow && !onRow(rows[i])) more = false;
+                if (opt.topK == 0) continue;
+                if (out.top.size() < opt.topK)
+                {
+                    out.top.push_back(std::move(rows[i]));
+                    std::push_heap(out.top.begin(), out.top.end(), better);
+                }
+                else if (better(rows[i], out.top.front()))
+                {
+                    std::pop_heap(out.top.begin(), out.top.end(), better);
+                    out.top.back() = std::move(rows[i]);
+                    std::push_heap(out.top.begin(), out.top.end(), better);
+                }
+            }
+            out.evaluated += m;
+        }
+        std::sort_heap(out.top.begin(), out.top.end(), better);
+
+        out.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        return out;
+    }
+
+private:
+    SimConfig         m_base;
+    std::vector<Axis> m_axes;
+};
+
+// ---- Output ----
+
+inline std::string csvHeader(const std::vector<Axis>& axes)
+{
+    std::string h = "index";
+    for (const Axis& a : axes) { h += ','; h += a.param->name; }
+    h += ",finalCapital,totalRealized,totalFees,feeCoverage,totalSavings,"
+         "cyclesCompleted,tradesOpened,tradesClosed,wins,losses\n";
+    return h;
+}
+
+inline std::string csvRow(const Row& r)
+{
+    std::ostringstream s;
+    s << std::setprecision(17) << r.index;
+    for (double v : r.values) s << ',' << v;
+    s << ',' << r.finalCapital << ',' << r.totalRealized << ',' << r.totalFees
+      << ',' << r.feeCoverage << ',' << r.totalSavings
+      << ',' << r.cyclesCompleted << ',' << r.tradesOpened << ',' << r.tradesClosed
+      << ',' << r.wins << ',' << r.losses << '\n';
+    return s.str();
+}
+
+inline std::string jsonRow(const std::vector<Axis>& axes, const Row& r)
+{
+    std::ostringstream s;
+    s << std::setprecision(17) << "{\"index\":" << r.index << ",\"params\":{";
+    for (std::size_t k = 0; k < axes.size(); ++k)
+        s << (k ? "," : "") << '"' << axes[k].param->name << "\":" << r.values[k];
+    s << "},\"finalCapital\":"    << r.finalCapital
+      << ",\"totalRealized\":"    << r.totalRealized
+      << ",\"totalFees\":"        << r.totalFees
+      << ",\"feeCoverage\":"      << r.feeCoverage
+      << ",\"totalSavings\":"     << r.totalSavings
+      << ",\"cyclesCompleted\":"  << r.cyclesCompleted
+      << ",\"tradesOpened\":"     << r.tradesOpened
+      << ",\"tradesClosed\":"     << r.tradesClosed
+      << ",\"wins\":"             << r.wins
+      << ",\"losses\":"           << r.losses << '}';
+    return s.str();
+}
+
+} // namespace ParamSweep
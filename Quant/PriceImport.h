@@ -0,0 +1,363 @@
+#pragma once
+
+// ============================================================
+// PriceImport.h — bulk parsing of price series text
+//
+// Accepts, with or without a UTF-8 BOM:
+//
+//   CSV          "timestamp,price" per line (',', ';' or tab;
+//                blank, header and malformed lines skipped)
+//   JSON pairs   [[timestamp, price], ...]
+//   JSON objects [{"ts": .., "price": ..}, ...] — the key
+//                names are matched case-insensitively, so the
+//                /api/prices output and monthly_gold_prices.json
+//                ({"Price", "Timestamp", "Date"}) both load; a
+//                record without a numeric timestamp falls back
+//                to a "YYYY-MM-DD[THH:MM:SS]" date (UTC)
+//
+// Numbers are read with std::from_chars straight from the
+// input, so no line is copied or allocated.  Inputs above
+// kChunkBytes are cut into chunks at record boundaries and
+// parsed on several threads; the chunks are joined in input
+// order, which keeps "last value wins" for repeated
+// timestamps when the result goes into PriceSeries::setSeries.
+// ============================================================
+
+#include "PriceSeries.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <thread>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <algorithm>
+
+namespace PriceImport {
+
+inline constexpr std::size_t kChunkBytes = 1 << 20;
+
+enum class Format
+{
+    Csv,
+    JsonPairs,
+    JsonObjects
+};
+
+struct Stats
+{
+    Format      format  = Format::Csv;
+    std::size_t points  = 0;   // records parsed
+    std::size_t skipped = 0;   // records (or non-empty lines) rejected
+    unsigned    threads = 1;
+};
+
+namespace detail {
+
+inline bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+inline const char* skipSpace(const char* p, const char* end)
+{
+    while (p < end && isSpace(*p)) ++p;
+    return p;
+}
+
+// Integer timestamp; a fractional part is accepted and dropped.
+inline const char* parseTime(const char* p, const char* end, long long& out)
+{
+    if (p < end && *p == '+') ++p;
+    auto [q, ec] = std::from_chars(p, end, out);
+    if (ec != std::errc() || q == p) return nullptr;
+    if (q < end && *q == '.')
+    {
+        ++q;
+        while (q < end && *q >= '0' && *q <= '9') ++q;
+    }
+    return q;
+}
+
+inline const char* parsePrice(const char* p, const char* end, double& out)
+{
+    if (p < end && *p == '+') ++p;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    auto [q, ec] = std::from_chars(p, end, out);
+    if (ec != std::errc() || q == p) return nullptr;
+    return q;
+#else
+    // strtod stops at the first byte that cannot continue a number, and
+    // every record is followed by a delimiter or the input's terminator.
+    char* q = nullptr;
+    out = std::strtod(p, &q);
+    if (q == p || q > end) return nullptr;
+    return q;
+#endif
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date.
+inline long long daysFromCivil(long long y, unsigned m, unsigned d)
+{
+    y -= m <= 2;
+    long long era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = static_cast<unsigned>(y - era * 400);
+    unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<long long>(doe) - 719468;
+}
+
+// "YYYY-MM-DD" with an optional "[T ]HH:MM[:SS]", as UTC seconds.
+inline bool parseDate(std::string_view s, long long& out)
+{
+    auto num = [&s](std::size_t at, std::size_t len, long long& v) {
+        if (at + len > s.size()) return false;
+        auto [q, ec] = std::from_chars(s.data() + at, s.data() + at + len, v);
+        return ec == std::errc() && q == s.data() + at + len;
+    };
+    long long y, m, d, hh = 0, mm = 0, ss = 0;
+    if (s.size() < 10 || s[4] != '-' || s[7] != '-' || !num(0, 4, y) || !num(5, 2, m) || !num(8, 2, d))
+        return false;
+    if (m < 1 || m > 12 || d < 1 || d > 31) return false;
+    if (s.size() >= 16 && (s[10] == 'T' || s[10] == ' ') && s[13] == ':')
+    {
+        if (!num(11, 2, hh) || !num(14, 2, mm)) return false;
+        if (s.size() >= 19 && s[16] == ':' && !num(17, 2, ss)) return false;
+    }
+    out = daysFromCivil(y, static_cast<unsigned>(m), static_cast<unsigned>(d)) * 86400 + hh * 3600 + mm * 60 + ss;
+    return true;
+}
+
+inline bool keyIs(std::string_view key, std::string_view name)
+{
+    if (key.size() != name.size()) return false;
+    for (std::size_t i = 0; i < key.size(); ++i)
+    {
+        char c = key[i];
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+        if (c != name[i]) return false;
+    }
+    return true;
+}
+
+// A JSON string starting at the opening quote; returns the position after
+// the closing quote and the raw (unescaped) contents.
+inline const char* parseString(const char* p, const char* end, std::string_view& out)
+{
+    const char* start = ++p;
+    while (p < end && *p != '"')
+        p += (*p == '\\' && p + 1 < end) ? 2 : 1;
+    if (p >= end) return nullptr;
+    out = std::string_view(start, static_cast<std::size_t>(p - start));
+    return p + 1;
+}
+
+// Skip a scalar JSON value (number or literal) up to the next delimiter.
+inline const char* skipScalar(const char* p, const char* end)
+{
+    while (p < end && *p != ',' && *p != '}' && *p != ']' && !isSpace(*p)) ++p;
+    return p;
+}
+
+inline void parseCsv(const char* p, const char* end, std::vector<PricePoint>& out, std::size_t& skipped)
+{
+    while (p < end)
+    {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+        if (!eol) eol = end;
+        const char* q = skipSpace(p, eol);
+        if (q < eol)
+        {
+            long long ts;
+            double px;
+            const char* r = parseTime(q, eol, ts);
+            if (r) r = skipSpace(r, eol);
+            if (r && r < eol && (*r == ',' || *r == ';' || *r == '\t'))
+                r = parsePrice(skipSpace(r + 1, eol), eol, px);
+            else
+                r = nullptr;
+            if (r) out.push_back({ ts, px });
+            else   ++skipped;
+        }
+        p = eol + 1;
+    }
+}
+
+// Records are flat: [ts, price] pairs or {"key": scalar-or-string, ...}
+// objects.  Anything between records (the outer brackets, commas) is
+// skipped.
+inline void parseJson(const char* p, const char* end, bool objects,
+                      std::vector<PricePoint>& out, std::size_t& skipped)
+{
+    const char open = objects ? '{' : '[';
+    while (p < end)
+    {
+        while (p < end && *p != open) ++p;
+        if (p >= end) break;
+        // The outer '[' of a pairs array is followed by another '['.
+        if (!objects)
+        {
+            const char* q = skipSpace(p + 1, end);
+            if (q < end && *q == '[') { p = q; continue; }
+        }
+        ++p;
+
+        long long ts = 0;
+        double    px = 0;
+        bool      haveTs = false, havePx = false, haveDate = false;
+        long long dateTs = 0;
+
+        if (!objects)
+        {
+            const char* q = parseTime(skipSpace(p, end), end, ts);
+            if (q) q = skipSpace(q, end);
+            if (q && q < end && *q == ',') q = parsePrice(skipSpace(q + 1, end), end, px);
+            else q = nullptr;
+            if (q) { haveTs = havePx = true; p = q; }
+        }
+        else
+        {
+            while (p < end)
+            {
+                p = skipSpace(p, end);
+                if (p >= end || *p == '}') break;
+                if (*p == ',') { ++p; continue; }
+                std::string_view key;
+                if (*p != '"' || !(p = parseString(p, end, key))) break;
+                p = skipSpace(p, end);
+                if (p >= end || *p != ':') break;
+                p = skipSpace(p + 1, end);
+                if (p >= end) break;
+
+                bool isTs = keyIs(key, "ts") || keyIs(key, "t") || keyIs(key, "time") || keyIs(key, "timestamp");
+                bool isPx = keyIs(key, "price") || keyIs(key, "p") || keyIs(key, "close") || keyIs(key, "value");
+                if (*p == '"')
+                {
+                    std::string_view val;
+                    if (!(p = parseString(p, end, val))) break;
+                    if (keyIs(key, "date") || isTs) haveDate = parseDate(val, dateTs) || haveDate;
+                    continue;
+                }
+                const char* q = nullptr;
+                if (isTs && !haveTs)      { q = parseTime(p, end, ts);  haveTs = q != nullptr; }
+                else if (isPx && !havePx) { q = parsePrice(p, end, px); havePx = q != nullptr; }
+                p = skipScalar(q ? q : p, end);
+            }
+            if (!p) break;
+        }
+
+        if (!haveTs && haveDate) { ts = dateTs; haveTs = true; }
+        if (haveTs && havePx) out.push_back({ ts, px });
+        else ++skipped;
+
+        const char close = objects ? '}' : ']';
+        while (p < end && *p != close) ++p;
+        if (p < end) ++p;
+    }
+}
+
+// Start of the first record at or after `at` (a line for CSV, an object
+// or pair that follows a comma for JSON), or `end`.
+inline const char* nextRecord(const char* at, const char* end, Format f)
+{
+    if (f == Format::Csv)
+    {
+        const char* nl = static_cast<const char*>(std::memchr(at, '\n', static_cast<std::size_t>(end - at)));
+        return nl ? nl + 1 : end;
+    }
+    const char open = f == Format::JsonObjects ? '{' : '[';
+    for (const char* p = at; p < end; ++p)
+    {
+        if (*p != ',') continue;
+        const char* q = skipSpace(p + 1, end);
+        if (q < end && *q == open) return q;
+    }
+    return end;
+}
+
+} // namespace detail
+
+inline Format detect(std::string_view text)
+{
+    const char* p = text.data();
+    const char* end = p + text.size();
+    p = detail::skipSpace(p, end);
+    if (p < end && *p == '{') return Format::JsonObjects;
+    if (p < end && *p == '[')
+    {
+        p = detail::skipSpace(p + 1, end);
+        return (p < end && *p == '{') ? Format::JsonObjects : Format::JsonPairs;
+    }
+    return Format::Csv;
+}
+
+// Parse every record of `text` in input order.  `threads` 0 picks one
+// per core for large inputs.
+inline std::vector<PricePoint> parse(std::string_view text, Stats* stats = nullptr, unsigned threads = 0)
+{
+    if (text.size() >= 3 && text.compare(0, 3, "\xEF\xBB\xBF") == 0) text.remove_prefix(3);
+    const Format f = detect(text);
+    const char* begin = text.data();
+    const char* end   = begin + text.size();
+
+    unsigned want = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+    std::size_t byChunk = text.size() / kChunkBytes + 1;
+    if (byChunk < want) want = static_cast<unsigned>(byChunk);
+
+    std::vector<const char*> cuts{ begin };
+    for (unsigned i = 1; i < want; ++i)
+    {
+        const char* at = begin + text.size() * i / want;
+        if (at < cuts.back()) at = cuts.back();
+        cuts.push_back(detail::nextRecord(at, end, f));
+    }
+    cuts.push_back(end);
+
+    auto run = [f](const char* a, const char* b, std::vector<PricePoint>& out, std::size_t& skipped) {
+        out.reserve(static_cast<std::size_t>(b - a) / 24);
+        if (f == Format::Csv) detail::parseCsv(a, b, out, skipped);
+        else                  detail::parseJson(a, b, f == Format::JsonObjects, out, skipped);
+    };
+
+    const std::size_t parts = cuts.size() - 1;
+    std::vector<std::vector<PricePoint>> chunks(parts);
+    std::vector<std::size_t> skipped(parts, 0);
+    if (parts == 1)
+        run(cuts[0], cuts[1], chunks[0], skipped[0]);
+    else
+    {
+        std::vector<std::thread> pool;
+        for (std::size_t i = 0; i < parts; ++i)
+            pool.emplace_back(run, cuts[i], cuts[i + 1], std::ref(chunks[i]), std::ref(skipped[i]));
+        for (auto& t : pool) t.join();
+    }
+
+    std::size_t total = 0;
+    for (const auto& c : chunks) total += c.size();
+    std::vector<PricePoint> out = std::move(chunks[0]);
+    out.reserve(total);
+    for (std::size_t i = 1; i < parts; ++i)
+        out.insert(out.end(), chunks[i].begin(), chunks[i].end());
+
+    if (stats)
+    {
+        stats->format  = f;
+        stats->points  = out.size();
+        stats->skipped = 0;
+        for (std::size_t s : skipped) stats->skipped += s;
+        stats->threads = static_cast<unsigned>(parts);
+    }
+    return out;
+}
+
+// Parse `text` and replace `symbol` in `ps` with the result (left
+// untouched when nothing parses).  Returns the number of points read.
+inline std::size_t importInto(PriceSeries& ps, const std::string& symbol, std::string_view text,
+                              Stats* stats = nullptr, unsigned threads = 0)
+{
+    std::vector<PricePoint> pts = parse(text, stats, threads);
+    std::size_t n = pts.size();
+    if (n > 0) ps.setSeries(symbol, std::move(pts));
+    return n;
+}
+
+} // namespace PriceImport
@@ -1,18 +1,51 @@
 #pragma once
 
-#include <map>
+#include "TickStore.h"
+#include "SymbolRegistry.h"
+
+#include <optional>
+#include <memory>
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <iterator>
+#include <limits>
+#include <cstddef>
+#include <cstdint>
 #include <cmath>
 
 // Time-series price data keyed by symbol.
 //
 // Stores (timestamp, price) pairs per symbol.  Provides:
-//   set()     insert or overwrite a data point
-//   at()      nearest-neighbour lookup at a given time
-//   latest()  most recent price for a symbol
-//   range()   all points in a time window
+//   set()        insert or overwrite a data point
+//   setSeries()  replace a symbol's data in one sort
+//   at()         nearest-neighbour lookup at a given time
+//   latest()     most recent price for a symbol
+//   range()      view of all points in a time window
+//   bars()       OHLC bars at a fixed resolution
+//
+// Each symbol is a PriceColumn: parallel timestamp and price
+// arrays kept sorted by time.  Appending at or after the last
+// timestamp is O(1) amortised; an out-of-order point is placed
+// by binary search.  Readers get PricePoint values by index or
+// a PriceSpan view over the raw columns, which stays valid until
+// the symbol is next modified.
+//
+// Each column can also keep a pyramid of OHLC bars at the
+// kBarResolutions (1m .. 1d).  It is built from the ticks the
+// first time bars are asked for and then kept current by set():
+// an appended tick updates the last bar of every level, any
+// other change recomputes just the bars covering its time.
+//
+// After open(dir) every symbol is backed by a TickStore file
+// in `dir` instead: writes go straight to disk and reads are
+// served from the file's mapping, so history survives restarts
+// and is never loaded into RAM as a whole.  Copies of an open
+// series share its files.
+//
+// Columns are indexed by SymbolId.  set(), at(), latest(), range(),
+// series() and hasSymbol() also take a SymbolId, which skips the
+// name lookup in loops over one symbol.
 //
 // Thread safety: callers must hold their own mutex.
 
@@ -22,63 +55,524 @@ struct PricePoint
     double    price     = 0.0;
 };
 
+// Read-only view of a contiguous run of one symbol's points.
+class PriceSpan
+{
+public:
+    class iterator
+    {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type        = PricePoint;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = void;
+        using reference         = PricePoint;
+
+        iterator() = default;
+        iterator(const long long* t, const double* p, std::size_t stride)
+            : m_t(t), m_p(p), m_s(static_cast<difference_type>(stride)) {}
+
+        PricePoint operator*() const { return { *m_t, *m_p }; }
+        PricePoint operator[](difference_type n) const { return { m_t[n * m_s], m_p[n * m_s] }; }
+
+        iterator& operator++()    { m_t += m_s; m_p += m_s; return *this; }
+        iterator  operator++(int) { iterator r = *this; ++*this; return r; }
+        iterator& operator--()    { m_t -= m_s; m_p -= m_s; return *this; }
+        iterator  operator--(int) { iterator r = *this; --*this; return r; }
+        iterator& operator+=(difference_type n) { m_t += n * m_s; m_p += n * m_s; return *this; }
+        iterator& operator-=(difference_type n) { m_t -= n * m_s; m_p -= n * m_s; return *this; }
+        iterator  operator+(difference_type n) const { iterator r = *this; return r += n; }
+        iterator  operator-(difference_type n) const { iterator r = *this; return r -= n; }
+        difference_type operator-(const iterator& o) const { return (m_t - o.m_t) / m_s; }
+
+        bool operator==(const iterator& o) const { return m_t == o.m_t; }
+        bool operator!=(const iterator& o) const { return m_t != o.m_t; }
+        bool operator<(const iterator& o)  const { return m_t < o.m_t; }
+
+    private:
+        const long long* m_t = nullptr;
+        const double*    m_p = nullptr;
+        difference_type  m_s = 1;
+    };
+
+    PriceSpan() = default;
+
+    // `stride` is the distance between consecutive points in elements:
+    // 1 for separate columns, 2 for interleaved tick-file records.
+    PriceSpan(const long long* t, const double* p, std::size_t n, std::size_t stride = 1)
+        : m_t(t), m_p(p), m_n(n), m_s(stride) {}
+
+    std::size_t size()  const { return m_n; }
+    bool        empty() const { return m_n == 0; }
+
+    long long  timestamp(std::size_t i) const { return m_t[i * m_s]; }
+    double     price(std::size_t i)     const { return m_p[i * m_s]; }
+
+    PricePoint operator[](std::size_t i) const { return { timestamp(i), price(i) }; }
+    PricePoint front() const { return (*this)[0]; }
+    PricePoint back()  const { return (*this)[m_n - 1]; }
+
+    iterator begin() const { return iterator(m_t, m_p, m_s); }
+    iterator end()   const { return iterator(m_t + m_n * m_s, m_p + m_n * m_s, m_s); }
+
+    // Index of the first point at or after `time`.
+    std::size_t lowerIndex(long long time) const
+    {
+        std::size_t lo = 0, hi = m_n;
+        while (lo < hi)
+        {
+            std::size_t mid = lo + (hi - lo) / 2;
+            if (timestamp(mid) < time) lo = mid + 1; else hi = mid;
+        }
+        return lo;
+    }
+
+    // Index of the first point after `time`.
+    std::size_t upperIndex(long long time) const
+    {
+        std::size_t lo = 0, hi = m_n;
+        while (lo < hi)
+        {
+            std::size_t mid = lo + (hi - lo) / 2;
+            if (timestamp(mid) <= time) lo = mid + 1; else hi = mid;
+        }
+        return lo;
+    }
+
+    PriceSpan slice(std::size_t from, std::size_t to) const
+    {
+        return PriceSpan(m_t + from * m_s, m_p + from * m_s, to - from, m_s);
+    }
+
+    std::vector<PricePoint> toVector() const { return std::vector<PricePoint>(begin(), end()); }
+
+private:
+    const long long* m_t = nullptr;
+    const double*    m_p = nullptr;
+    std::size_t      m_n = 0;
+    std::size_t      m_s = 1;
+};
+
+// One OHLC bar.  The series carries no traded volume, so `ticks`
+// (the number of points aggregated) stands in for it.
+struct PriceBar
+{
+    long long     start = 0;     // bar open time, a multiple of the resolution
+    double        open  = 0.0;
+    double        high  = 0.0;
+    double        low   = 0.0;
+    double        close = 0.0;
+    std::uint32_t ticks = 0;
+};
+
+// Bar sizes kept per symbol, in seconds.  Each divides the next, so a
+// coarser level is aggregated from the finer one.
+inline constexpr long long   kBarResolutions[] = { 60, 300, 900, 3600, 14400, 86400 };
+inline constexpr std::size_t kBarLevels = sizeof(kBarResolutions) / sizeof(kBarResolutions[0]);
+
+// "1m", "5m", "15m", "1h", "4h", "1d" or a number of seconds naming one
+// of those; "raw"/"tick" is 0.  Returns -1 for anything else.
+inline long long parseBarResolution(const std::string& s)
+{
+    if (s == "raw" || s == "tick") return 0;
+    long long n = 0, unit = 1;
+    std::size_t i = 0;
+    while (i < s.size() && s[i] >= '0' && s[i] <= '9' && n < 1000000000)
+        n = n * 10 + (s[i++] - '0');
+    if (i == 0) return -1;
+    std::string suffix = s.substr(i);
+    if      (suffix == "" || suffix == "s") unit = 1;
+    else if (suffix == "m")                 unit = 60;
+    else if (suffix == "h")                 unit = 3600;
+    else if (suffix == "d")                 unit = 86400;
+    else return -1;
+    for (long long r : kBarResolutions)
+        if (r == n * unit) return r;
+    return -1;
+}
+
+inline std::string barResolutionName(long long resolution)
+{
+    if (resolution <= 0) return "raw";
+    if (resolution % 86400 == 0) return std::to_string(resolution / 86400) + "d";
+    if (resolution % 3600 == 0)  return std::to_string(resolution / 3600) + "h";
+    if (resolution % 60 == 0)    return std::to_string(resolution / 60) + "m";
+    return std::to_string(resolution) + "s";
+}
+
+// Read-only view of consecutive bars of one level.
+class BarSpan
+{
+public:
+    BarSpan() = default;
+    BarSpan(const PriceBar* first, std::size_t n) : m_first(first), m_n(n) {}
+
+    std::size_t size()  const { return m_n; }
+    bool        empty() const { return m_n == 0; }
+
+    const PriceBar& operator[](std::size_t i) const { return m_first[i]; }
+    const PriceBar* begin() const { return m_first; }
+    const PriceBar* end()   const { return m_first + m_n; }
+
+private:
+    const PriceBar* m_first = nullptr;
+    std::size_t     m_n     = 0;
+};
+
+// The bar levels of one symbol.
+class BarPyramid
+{
+public:
+    static long long floorTo(long long t, long long res)
+    {
+        long long r = t % res;
+        return r < 0 ? t - r - res : t - r;
+    }
+
+    bool built() const { return m_built; }
+
+    void clear()
+    {
+        for (auto& l : m_levels) l.clear();
+        m_built = false;
+    }
+
+    const std::vector<PriceBar>& level(std::size_t i) const { return m_levels[i]; }
+
+    // Bars of level `i` overlapping [from, to].
+    BarSpan range(std::size_t i, long long from, long long to) const
+    {
+        const auto& bars = m_levels[i];
+        std::size_t b = firstBar(i, from);
+        std::size_t e = b;
+        while (e < bars.size() && bars[e].start <= to) ++e;
+        return BarSpan(bars.data() + b, e - b);
+    }
+
+    // Number of bars range() would return, in O(log n).
+    std::size_t count(std::size_t i, long long from, long long to) const
+    {
+        const auto& bars = m_levels[i];
+        std::size_t b = firstBar(i, from);
+        std::size_t e = to == std::numeric_limits<long long>::max() ? bars.size() : lowerIndex(bars, to + 1);
+        return e > b ? e - b : 0;
+    }
+
+    void build(const PriceSpan& pts)
+    {
+        clear();
+        for (std::size_t i = 0; i < pts.size(); ++i)
+            add(m_levels[0], kBarResolutions[0], pts.timestamp(i), pts.price(i));
+        for (std::size_t l = 1; l < kBarLevels; ++l)
+            for (const auto& bar : m_levels[l - 1])
+                fold(m_levels[l], kBarResolutions[l], bar);
+        m_built = true;
+    }
+
+    // A tick after every other one.
+    void append(long long time, double price)
+    {
+        for (std::size_t l = 0; l < kBarLevels; ++l)
+            add(m_levels[l], kBarResolutions[l], time, price);
+    }
+
+    // Any other change at `time`: recompute the bar covering it on each
+    // level, from the ticks for the finest and from the level below above.
+    void refresh(const PriceSpan& pts, long long time)
+    {
+        long long start = floorTo(time, kBarResolutions[0]);
+        std::vector<PriceBar> one;
+        PriceSpan in = pts.slice(pts.lowerIndex(start), pts.upperIndex(start + kBarResolutions[0] - 1));
+        for (std::size_t i = 0; i < in.size(); ++i)
+            add(one, kBarResolutions[0], in.timestamp(i), in.price(i));
+        put(m_levels[0], start, one);
+
+        for (std::size_t l = 1; l < kBarLevels; ++l)
+        {
+            long long res = kBarResolutions[l];
+            start = floorTo(time, res);
+            const auto& finer = m_levels[l - 1];
+            one.clear();
+            for (std::size_t i = lowerIndex(finer, start); i < finer.size() && finer[i].start < start + res; ++i)
+                fold(one, res, finer[i]);
+            put(m_levels[l], start, one);
+        }
+    }
+
+private:
+    // First bar of level `i` ending at or after `from`.
+    std::size_t firstBar(std::size_t i, long long from) const
+    {
+        long long res = kBarResolutions[i];
+        if (from < std::numeric_limits<long long>::min() + res) return 0;
+        return lowerIndex(m_levels[i], floorTo(from, res));
+    }
+
+    static std::size_t lowerIndex(const std::vector<PriceBar>& bars, long long start)
+    {
+        return static_cast<std::size_t>(std::lower_bound(bars.begin(), bars.end(), start,
+            [](const PriceBar& b, long long t) { return b.start < t; }) - bars.begin());
+    }
+
+    // Add a tick at or after the last bar's start.
+    static void add(std::vector<PriceBar>& bars, long long res, long long time, double price)
+    {
+        long long start = floorTo(time, res);
+        if (bars.empty() || bars.back().start != start)
+        {
+            bars.push_back({ start, price, price, price, price, 1 });
+            return;
+        }
+        PriceBar& b = bars.back();
+        b.high  = std::max(b.high, price);
+        b.low   = std::min(b.low, price);
+        b.close = price;
+        ++b.ticks;
+    }
+
+    // Merge a finer bar that starts at or after the last bar's start.
+    static void fold(std::vector<PriceBar>& bars, long long res, const PriceBar& in)
+    {
+        long long start = floorTo(in.start, res);
+        if (bars.empty() || bars.back().start != start)
+        {
+            PriceBar b = in;
+            b.start = start;
+            bars.push_back(b);
+            return;
+        }
+        PriceBar& b = bars.back();
+        b.high   = std::max(b.high, in.high);
+        b.low    = std::min(b.low, in.low);
+        b.close  = in.close;
+        b.ticks += in.ticks;
+    }
+
+    // Replace the bar at `start` with `one` (zero or one bars).
+    static void put(std::vector<PriceBar>& bars, long long start, const std::vector<PriceBar>& one)
+    {
+        std::size_t i = lowerIndex(bars, start);
+        bool present = i < bars.size() && bars[i].start == start;
+        if (one.empty())
+        {
+            if (present) bars.erase(bars.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+        else if (present)
+            bars[i] = one.front();
+        else
+            bars.insert(bars.begin() + static_cast<std::ptrdiff_t>(i), one.front());
+    }
+
+    std::vector<PriceBar> m_levels[kBarLevels];
+    bool                  m_built = false;
+};
+
+// One symbol's points as sorted, de-duplicated parallel columns, or
+// the records of its tick file when the series is persistent.
+class PriceColumn
+{
+public:
+    PriceColumn() = default;
+    explicit PriceColumn(std::shared_ptr<TickStore::File> file) : m_file(std::move(file)) {}
+
+    bool persistent() const { return m_file != nullptr; }
+
+    std::size_t size()  const { return m_file ? m_file->size() : m_ts.size(); }
+    bool        empty() const { return size() == 0; }
+
+    PricePoint operator[](std::size_t i) const { return span()[i]; }
+    PricePoint front() const { return span().front(); }
+    PricePoint back()  const { return span().back(); }
+
+    PriceSpan::iterator begin() const { return span().begin(); }
+    PriceSpan::iterator end()   const { return span().end(); }
+
+    PriceSpan span() const
+    {
+        if (!m_file) return PriceSpan(m_ts.data(), m_px.data(), m_ts.size());
+        const TickStore::Record* r = m_file->records();
+        if (!r) return PriceSpan();
+        return PriceSpan(reinterpret_cast<const long long*>(&r->timestamp), &r->price, m_file->size(), 2);
+    }
+
+    std::size_t lowerIndex(long long time) const { return span().lowerIndex(time); }
+    std::size_t upperIndex(long long time) const { return span().upperIndex(time); }
+
+    void set(long long time, double price)
+    {
+        bool tail = empty() || time > (m_file ? m_file->lastTime() : m_ts.back());
+        store(time, price);
+        if (!m_bars.built()) return;
+        if (tail) m_bars.append(time, price);
+        else      m_bars.refresh(span(), time);
+    }
+
+    // The bar levels, built from the ticks on first use.
+    const BarPyramid& bars() const
+    {
+        if (!m_bars.built()) m_bars.build(span());
+        return m_bars;
+    }
+
+    // Replace the contents; a later point wins over an earlier one with
+    // the same timestamp, as with repeated set().
+    void assign(std::vector<PricePoint> pts)
+    {
+        m_bars.clear();
+        auto byTime = [](const PricePoint& a, const PricePoint& b) { return a.timestamp < b.timestamp; };
+        if (!std::is_sorted(pts.begin(), pts.end(), byTime))
+            std::stable_sort(pts.begin(), pts.end(), byTime);
+
+        if (m_file)
+        {
+            std::vector<TickStore::Record> recs;
+            recs.reserve(pts.size());
+            for (const auto& p : pts)
+            {
+                if (!recs.empty() && recs.back().timestamp == p.timestamp)
+                    recs.back().price = p.price;
+                else
+                    recs.push_back({ p.timestamp, p.price });
+            }
+            m_file->assign(recs);
+            return;
+        }
+
+        m_ts.clear();
+        m_px.clear();
+        m_ts.reserve(pts.size());
+        m_px.reserve(pts.size());
+        for (const auto& p : pts)
+        {
+            if (!m_ts.empty() && m_ts.back() == p.timestamp)
+                m_px.back() = p.price;
+            else
+            {
+                m_ts.push_back(p.timestamp);
+                m_px.push_back(p.price);
+            }
+        }
+    }
+
+    void reserve(std::size_t n)
+    {
+        if (m_file) return;
+        m_ts.reserve(n);
+        m_px.reserve(n);
+    }
+
+    // Drop every point (deleting the tick file when persistent).
+    void erase()
+    {
+        m_bars.clear();
+        if (m_file) m_file->remove();
+        m_ts.clear();
+        m_px.clear();
+    }
+
+private:
+    void store(long long time, double price)
+    {
+        if (m_file) { m_file->set(time, price); return; }
+
+        if (m_ts.empty() || time > m_ts.back())
+        {
+            m_ts.push_back(time);
+            m_px.push_back(price);
+            return;
+        }
+        if (time == m_ts.back()) { m_px.back() = price; return; }
+
+        std::size_t i = lowerIndex(time);
+        if (m_ts[i] == time) { m_px[i] = price; return; }
+        m_ts.insert(m_ts.begin() + static_cast<std::ptrdiff_t>(i), time);
+        m_px.insert(m_px.begin() + static_cast<std::ptrdiff_t>(i), price);
+    }
+
+    std::vector<long long>           m_ts;
+    std::vector<double>              m_px;
+    std::shared_ptr<TickStore::File> m_file;
+    mutable BarPyramid               m_bars;
+};
+
 class PriceSeries
 {
 public:
     PriceSeries() = default;
 
-    // Insert or overwrite a price at the given time.
-    void set(const std::string& symbol, long long time, double price)
+    // Back the series with the tick files in `dir` (created if missing),
+    // replacing whatever it held in memory.  Throws if a tick file is
+    // unreadable.
+    void open(const std::string& dir)
     {
-        auto& pts = m_data[symbol];
-        // check for exact timestamp
-        for (auto& p : pts)
+        std::filesystem::create_directories(dir);
+        std::vector<std::optional<PriceColumn>> cols;
+        for (const auto& sym : TickStore::listSymbols(dir))
         {
-            if (p.timestamp == time) { p.price = price; return; }
+            SymbolId id = SymbolRegistry::intern(sym);
+            if (id >= cols.size()) cols.resize(id + 1);
+            cols[id].emplace(std::make_shared<TickStore::File>(TickStore::pathFor(dir, sym)));
         }
-        pts.push_back({ time, price });
-        std::sort(pts.begin(), pts.end(),
-                  [](const PricePoint& a, const PricePoint& b)
-                  { return a.timestamp < b.timestamp; });
+        m_columns = std::move(cols);
+        m_dir     = dir;
+    }
+
+    bool persistent() const { return !m_dir.empty(); }
+    const std::string& storeDir() const { return m_dir; }
+
+    // Insert or overwrite a price at the given time.
+    void set(const std::string& symbol, long long time, double price)
+    {
+        column(SymbolRegistry::intern(symbol)).set(time, price);
+    }
+
+    void set(SymbolId symbol, long long time, double price)
+    {
+        column(symbol).set(time, price);
     }
 
-    // Bulk-set a sorted series (replaces any existing data for that symbol).
+    // Bulk-set a series (replaces any existing data for that symbol).
+    // Sorts once, and not at all when the points are already in order.
     void setSeries(const std::string& symbol, std::vector<PricePoint> pts)
     {
-        std::sort(pts.begin(), pts.end(),
-                  [](const PricePoint& a, const PricePoint& b)
-                  { return a.timestamp < b.timestamp; });
-        m_data[symbol] = std::move(pts);
+        column(SymbolRegistry::intern(symbol)).assign(std::move(pts));
     }
 
     // Nearest-neighbour price at time t.
     // Returns 0 if no data exists for this symbol.
     double at(const std::string& symbol, long long time) const
     {
-        auto it = m_data.find(symbol);
-        if (it == m_data.end() || it->second.empty()) return 0.0;
-        const auto& pts = it->second;
+        return at(SymbolRegistry::lookup(symbol), time);
+    }
+
+    double at(SymbolId symbol, long long time) const
+    {
+        PriceSpan s = series(symbol);
+        if (s.empty()) return 0.0;
 
         // binary search for closest
-        auto lb = std::lower_bound(pts.begin(), pts.end(), time,
-            [](const PricePoint& p, long long t) { return p.timestamp < t; });
+        std::size_t lb = s.lowerIndex(time);
 
-        if (lb == pts.end())
-            return pts.back().price;
-        if (lb == pts.begin())
-            return lb->price;
+        if (lb == s.size())
+            return s.price(lb - 1);
+        if (lb == 0)
+            return s.price(0);
 
-        auto prev = lb - 1;
-        return (std::abs(lb->timestamp - time) < std::abs(prev->timestamp - time))
-             ? lb->price : prev->price;
+        std::size_t prev = lb - 1;
+        return (std::abs(s.timestamp(lb) - time) < std::abs(s.timestamp(prev) - time))
+             ? s.price(lb) : s.price(prev);
     }
 
     // Most recent price.
     double latest(const std::string& symbol) const
     {
-        auto it = m_data.find(symbol);
-        if (it == m_data.end() || it->second.empty()) return 0.0;
-        return it->second.back().price;
+        return latest(SymbolRegistry::lookup(symbol));
+    }
+
+    double latest(SymbolId symbol) const
+    {
+        PriceSpan s = series(symbol);
+        return s.empty() ? 0.0 : s.back().price;
     }
 
     // Earliest timestamp across all symbols (0 if empty).
@@ -86,9 +580,12 @@ public:
     {
         long long t = 0;
         bool first = true;
-        for (const auto& kv : m_data)
-            for (const auto& p : kv.second)
-                if (first || p.timestamp < t) { t = p.timestamp; first = false; }
+        for (const auto& col : m_columns)
+        {
+            if (!col || col->empty()) continue;
+            long long front = col->front().timestamp;
+            if (first || front < t) { t = front; first = false; }
+        }
         return t;
     }
 
@@ -96,48 +593,121 @@ public:
     long long latestTime() const
     {
         long long t = 0;
-        for (const auto& kv : m_data)
-            if (!kv.second.empty() && kv.second.back().timestamp > t)
-                t = kv.second.back().timestamp;
+        for (const auto& col : m_columns)
+            if (col && !col->empty() && col->back().timestamp > t)
+                t = col->back().timestamp;
         return t;
     }
 
-    // All points in [from, to] for a symbol.
-    std::vector<PricePoint> range(const std::string& symbol,
-                                  long long from, long long to) const
+    // All points in [from, to] for a symbol, as a view into the series.
+    PriceSpan range(const std::string& symbol,
+                    long long from, long long to) const
     {
-        std::vector<PricePoint> out;
-        auto it = m_data.find(symbol);
-        if (it == m_data.end()) return out;
-        for (const auto& p : it->second)
-            if (p.timestamp >= from && p.timestamp <= to)
-                out.push_back(p);
-        return out;
+        return range(SymbolRegistry::lookup(symbol), from, to);
+    }
+
+    PriceSpan range(SymbolId symbol, long long from, long long to) const
+    {
+        if (from > to) return PriceSpan();
+        PriceSpan s = series(symbol);
+        return s.slice(s.lowerIndex(from), s.upperIndex(to));
+    }
+
+    // Bars of `resolution` seconds (one of kBarResolutions) overlapping
+    // [from, to]; empty for an unknown symbol or resolution.
+    BarSpan bars(const std::string& symbol, long long resolution,
+                 long long from = std::numeric_limits<long long>::min(),
+                 long long to   = std::numeric_limits<long long>::max()) const
+    {
+        const PriceColumn* col = find(SymbolRegistry::lookup(symbol));
+        std::size_t level = barLevel(resolution);
+        if (!col || level == kBarLevels || from > to) return BarSpan();
+        return col->bars().range(level, from, to);
+    }
+
+    // The finest resolution (0 = raw ticks) that answers [from, to] in at
+    // most `maxPoints` points, else the coarsest level.
+    long long resolutionFor(const std::string& symbol, long long from, long long to,
+                            std::size_t maxPoints) const
+    {
+        const PriceColumn* col = find(SymbolRegistry::lookup(symbol));
+        if (!col || from > to) return 0;
+        PriceSpan s = col->span();
+        if (s.upperIndex(to) - s.lowerIndex(from) <= maxPoints) return 0;
+        const BarPyramid& pyr = col->bars();
+        for (std::size_t l = 0; l < kBarLevels; ++l)
+            if (pyr.count(l, from, to) <= maxPoints) return kBarResolutions[l];
+        return kBarResolutions[kBarLevels - 1];
+    }
+
+    // Every point of a symbol (empty view if none).
+    PriceSpan series(const std::string& symbol) const
+    {
+        return series(SymbolRegistry::lookup(symbol));
+    }
+
+    PriceSpan series(SymbolId symbol) const
+    {
+        const PriceColumn* col = find(symbol);
+        return col ? col->span() : PriceSpan();
     }
 
-    // All symbols that have data.
+    // All symbols that have data, by name.
     std::vector<std::string> symbols() const
     {
         std::vector<std::string> out;
-        for (const auto& kv : m_data)
-            if (!kv.second.empty())
-                out.push_back(kv.first);
+        for (SymbolId id = 0; id < m_columns.size(); ++id)
+            if (m_columns[id] && !m_columns[id]->empty())
+                out.push_back(SymbolRegistry::name(id));
+        std::sort(out.begin(), out.end());
         return out;
     }
 
     bool hasSymbol(const std::string& symbol) const
     {
-        auto it = m_data.find(symbol);
-        return it != m_data.end() && !it->second.empty();
+        return hasSymbol(SymbolRegistry::lookup(symbol));
     }
 
-    const std::map<std::string, std::vector<PricePoint>>& data() const
+    bool hasSymbol(SymbolId symbol) const
     {
-        return m_data;
+        const PriceColumn* col = find(symbol);
+        return col && !col->empty();
     }
 
-    void clear() { m_data.clear(); }
+    // Drop all data; a persistent series deletes its tick files.
+    void clear()
+    {
+        for (auto& col : m_columns)
+            if (col) col->erase();
+        m_columns.clear();
+    }
 
 private:
-    std::map<std::string, std::vector<PricePoint>> m_data;
+    static std::size_t barLevel(long long resolution)
+    {
+        std::size_t l = 0;
+        while (l < kBarLevels && kBarResolutions[l] != resolution) ++l;
+        return l;
+    }
+
+    const PriceColumn* find(SymbolId symbol) const
+    {
+        return symbol < m_columns.size() && m_columns[symbol] ? &*m_columns[symbol] : nullptr;
+    }
+
+    PriceColumn& column(SymbolId symbol)
+    {
+        if (symbol >= m_columns.size()) m_columns.resize(symbol + 1);
+        auto& col = m_columns[symbol];
+        if (!col)
+        {
+            if (m_dir.empty()) col.emplace();
+            else col.emplace(std::make_shared<TickStore::File>(
+                TickStore::pathFor(m_dir, SymbolRegistry::name(symbol))));
+        }
+        return *col;
+    }
+
+    std::vector<std::optional<PriceColumn>> m_columns;   // by SymbolId
+    std::string                             m_dir;       // tick store, empty when in-memory
 };
@@ -2264,39 +2264,10 @@ static void chainAdvance(TradeDatabase& db)
         return;
     }
 
-    auto members = db.loadChainMembers();
-    auto allEntries = db.loadEntryPoints();
-    auto allTrades = db.loadTrades();
-
-    bool anyTraded = false;
-    bool allSold = true;
-    double cyclePnl = 0;
-
-    for (const auto& m : members)
-    {
-        if (m.cycle != state.currentCycle) continue;
-        for (const auto& e : allEntries)
-        {
-            if (e.entryId != m.entryId) continue;
-            if (!e.traded || e.linkedTradeId < 0) continue;
-            anyTraded = true;
-            for (const auto& t : allTrades)
-            {
-                if (t.tradeId == e.linkedTradeId && t.type == TradeType::Buy)
-                {
-                    double sq = db.soldQuantityForParent(t.tradeId);
-                    if (sq < t.quantity - 1e-9) allSold = false;
-                    for (const auto& s : allTrades)
-                        if (s.type == TradeType::CoveredSell && s.parentTradeId == t.tradeId)
-                            cyclePnl += QuantMath::netProfit(
-                                QuantMath::grossProfit(t.value, s.value, s.quantity),
-                                0.0, s.sellFee);
-                    break;
-                }
-            }
-            break;
-        }
-    }
+    auto cs = db.chainCycleStatus(state.currentCycle);
+    bool anyTraded = cs.anyTraded;
+    bool allSold = cs.allTradedSold;
+    double cyclePnl = cs.realizedPnl;
 
     std::cout << std::fixed << std::setprecision(2);
     std::cout << "  Chain: " << state.symbol
@@ -2573,11 +2544,11 @@ static void priceSeriesMenu(TradeDatabase& db)
     if (c == 1)
     {
         auto sym = readSymbol("  Symbol (or * for all): ");
-        const auto& data = ps.data();
         if (sym == "*")
         {
-            for (const auto& [s, pts] : data)
+            for (const auto& s : ps.symbols())
             {
+                PriceSpan pts = ps.series(s);
                 std::cout << "  " << s << ": " << pts.size() << " points\n";
                 int show = std::min(static_cast<int>(pts.size()), 10);
                 for (int i = static_cast<int>(pts.size()) - show; i < static_cast<int>(pts.size()); ++i)
@@ -2586,10 +2557,9 @@ static void priceSeriesMenu(TradeDatabase& db)
         }
         else
         {
-            auto it = data.find(sym);
-            if (it == data.end()) { std::cout << "  (no data for " << sym << ")\n"; return; }
+            if (!ps.hasSymbol(sym)) { std::cout << "  (no data for " << sym << ")\n"; return; }
             std::cout << std::fixed << std::setprecision(2);
-            for (const auto& pt : it->second)
+            for (const auto& pt : ps.series(sym))
                 std::cout << "    ts=" << pt.timestamp << "  " << pt.price << "\n";
         }
     }
@@ -2620,12 +2590,23 @@ int main(int argc, char* argv[])
     std::mutex dbMutex;
 
     // Check for --server-only flag to skip interactive CLI
+    // --journal switches trade/P&L history to append-only journal storage
+    // --fsync=off|immediate overrides the default group-commit fsync
+    // --snapshot=binary|json converts the trade ledger (trades.bin <-> trades.json)
     bool serverOnly = false;
     for (int i = 1; i < argc; ++i) {
-        if (std::string(argv[i]) == "--server-only") {
+        if (std::string(argv[i]) == "--server-only")
             serverOnly = true;
-            break;
-        }
+        else if (std::string(argv[i]) == "--journal")
+            db.setStorageMode(TradeDatabase::StorageMode::Journal);
+        else if (std::string(argv[i]) == "--snapshot=binary")
+            db.setSnapshotFormat(TradeDatabase::SnapshotFormat::Binary);
+        else if (std::string(argv[i]) == "--snapshot=json")
+            db.setSnapshotFormat(TradeDatabase::SnapshotFormat::Json);
+        else if (std::string(argv[i]) == "--fsync=off")
+            FileSync::GroupCommit::instance().setMode(FileSync::Mode::Off);
+        else if (std::string(argv[i]) == "--fsync=immediate")
+            FileSync::GroupCommit::instance().setMode(FileSync::Mode::Immediate);
     }
 
     // Start HTTP API on a background thread
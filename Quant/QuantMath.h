@@ -79,14 +79,19 @@ public:
         SigmoidRange sr = sigmoidRange(steepness);
         std::vector<double> norm(N);
         for (int i = 0; i < N; ++i)
-        {
-            double t = (N > 1) ? static_cast<double>(i) / static_cast<double>(N - 1) : 1.0;
-            double sigVal = sigmoid(steepness * (t - 0.5));
-            norm[i] = (sigVal - sr.s0) / sr.range;
-        }
+            norm[i] = sigmoidNormAt(i, N, steepness, sr);
         return norm;
     }
 
+    // Level i of sigmoidNormN, for callers that keep no vector;
+    // sr is sigmoidRange(steepness).
+    static double sigmoidNormAt(int i, int N, double steepness, const SigmoidRange& sr)
+    {
+        double t = (N > 1) ? static_cast<double>(i) / static_cast<double>(N - 1) : 1.0;
+        double sigVal = sigmoid(steepness * (t - 0.5));
+        return (sigVal - sr.s0) / sr.range;
+    }
+
     // ?? Risk warp ???????????????????????????????????????????
 
     // Risk-warped interpolation between forward and inverse sigmoid.
@@ -104,10 +109,15 @@ public:
     {
         std::vector<double> w(norms.size());
         for (size_t i = 0; i < norms.size(); ++i)
-        {
-            w[i] = riskWarp(norms[i], risk);
-            if (w[i] < 1e-12) w[i] = 1e-12;
-        }
+            w[i] = riskWeight(norms[i], risk);
+        return w;
+    }
+
+    // One level of riskWeights.
+    static double riskWeight(double norm, double risk)
+    {
+        double w = riskWarp(norm, risk);
+        if (w < 1e-12) w = 1e-12;
         return w;
     }
 
@@ -944,6 +954,16 @@ public:
     static ExitPlan generateExitPlan(const ExitParams& ep)
     {
         ExitPlan plan;
+        plan.levels.reserve((ep.horizonCount < 1) ? 1 : ep.horizonCount);
+        forEachExitLevel(ep, [&](const ExitPlanLevel& el) { plan.levels.push_back(el); });
+        return plan;
+    }
+
+    // The levels of generateExitPlan, handed to emit(const ExitPlanLevel&)
+    // in order without building the plan.
+    template <typename Emit>
+    static void forEachExitLevel(const ExitParams& ep, Emit&& emit)
+    {
         int N = (ep.horizonCount < 1) ? 1 : ep.horizonCount;
         double frac  = clamp01(ep.exitFraction);
         double risk  = clamp01(ep.riskCoefficient);
@@ -951,31 +971,32 @@ public:
 
         double sellableQty = ep.quantity * frac;
 
-        // Cumulative sigmoid sell distribution (�6.2)
+        // Cumulative sigmoid sell distribution (�6.2), normalised to
+        // [0, 1] over i = 0..N and evaluated as the loop reaches it
         double center = risk * static_cast<double>(N - 1);
-        std::vector<double> cumSigma(N + 1);
-        for (int i = 0; i <= N; ++i)
-        {
+        auto rawSigma = [&](int i) {
             double x = static_cast<double>(i) - 0.5;
-            cumSigma[i] = sigmoid(steep * (x - center));
-        }
-        double lo = cumSigma[0], hi = cumSigma[N];
-        for (int i = 0; i <= N; ++i)
-            cumSigma[i] = (hi > lo) ? (cumSigma[i] - lo) / (hi - lo)
-                                    : static_cast<double>(i) / static_cast<double>(N);
+            return sigmoid(steep * (x - center));
+        };
+        double lo = rawSigma(0), hi = rawSigma(N);
+        auto cumSigma = [&](int i) {
+            return (hi > lo) ? (rawSigma(i) - lo) / (hi - lo)
+                             : static_cast<double>(i) / static_cast<double>(N);
+        };
 
-        plan.levels.reserve(N);
         double cumSold = 0.0;
         double cumNet  = 0.0;
+        double below   = cumSigma(0);
 
         for (int i = 0; i < N; ++i)
         {
             double factor = horizonFactor(ep.rawOH, ep.eo, ep.maxRisk, steep, i, N);
+            double above  = cumSigma(i + 1);
 
             ExitPlanLevel el;
             el.index        = i;
             el.tpPrice      = ep.entryPrice * (1.0 + factor);
-            el.sellFraction = cumSigma[i + 1] - cumSigma[i];
+            el.sellFraction = above - below;
             el.sellQty      = sellableQty * el.sellFraction;
             el.sellValue    = el.tpPrice * el.sellQty;
             el.grossProfit  = grossProfit(ep.entryPrice, el.tpPrice, el.sellQty);
@@ -987,10 +1008,9 @@ public:
             el.cumSold      = cumSold;
             el.cumNetProfit  = cumNet;
 
-            plan.levels.push_back(el);
+            emit(el);
+            below = above;
         }
-
-        return plan;
     }
 
     // ?? Profit (�8) ?????????????????????????????????????????
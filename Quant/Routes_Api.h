@@ -718,9 +718,31 @@ inline void registerApiRoutes(httplib::Server& svr, AppContext& ctx)
     });
 
     // ========== JSON API: GET /api/prices?symbol=BTC ==========
+    // Optional: from/to (unix seconds), resolution (raw, 1m, 5m, 15m, 1h,
+    // 4h, 1d) or maxPoints to let the server pick the finest level that
+    // fits.  Bars come back as {ts, price (= close), open, high, low,
+    // close, ticks}; the level used is in the X-Price-Resolution header.
     svr.Get("/api/prices", [&](const httplib::Request& req, httplib::Response& res) {
         std::lock_guard<std::mutex> lk(dbMutex);
         std::string sym = req.has_param("symbol") ? req.get_param_value("symbol") : "";
+        long long from = std::numeric_limits<long long>::min();
+        long long to   = std::numeric_limits<long long>::max();
+        long long maxPoints = 0;
+        if (req.has_param("from"))      try { from = std::stoll(req.get_param_value("from")); } catch (...) {}
+        if (req.has_param("to"))        try { to   = std::stoll(req.get_param_value("to")); } catch (...) {}
+        if (req.has_param("maxPoints")) try { maxPoints = std::stoll(req.get_param_value("maxPoints")); } catch (...) {}
+        long long resolution = 0;
+        if (req.has_param("resolution"))
+        {
+            resolution = parseBarResolution(req.get_param_value("resolution"));
+            if (resolution < 0)
+            {
+                res.set_content("{\"error\":\"resolution must be raw, 1m, 5m, 15m, 1h, 4h or 1d\"}", "application/json");
+                return;
+            }
+        }
+        else if (maxPoints > 0 && !sym.empty())
+            resolution = ctx.prices.resolutionFor(sym, from, to, static_cast<std::size_t>(maxPoints));
         std::ostringstream j;
         j << std::fixed << std::setprecision(17);
         if (sym.empty())
@@ -739,11 +761,22 @@ inline void registerApiRoutes(httplib::Server& svr, AppContext& ctx)
         else
         {
             j << "[";
-            auto pts = ctx.prices.data().find(sym);
-            if (pts != ctx.prices.data().end())
+            bool first = true;
+            if (resolution > 0)
+            {
+                for (const auto& b : ctx.prices.bars(sym, resolution, from, to))
+                {
+                    if (!first) j << ",";
+                    first = false;
+                    j << "{\"ts\":" << b.start << ",\"price\":" << b.close
+                      << ",\"open\":" << b.open << ",\"high\":" << b.high
+                      << ",\"low\":" << b.low << ",\"close\":" << b.close
+                      << ",\"ticks\":" << b.ticks << "}";
+                }
+            }
+            else
             {
-                bool first = true;
-                for (const auto& p : pts->second)
+                for (const auto& p : ctx.prices.range(sym, from, to))
                 {
                     if (!first) j << ",";
                     first = false;
@@ -751,6 +784,7 @@ inline void registerApiRoutes(httplib::Server& svr, AppContext& ctx)
                 }
             }
             j << "]";
+            res.set_header("X-Price-Resolution", barResolutionName(resolution));
         }
         res.set_header("Access-Control-Allow-Origin", "*");
         res.set_content(j.str(), "application/json");
@@ -800,80 +834,33 @@ inline void registerApiRoutes(httplib::Server& svr, AppContext& ctx)
             return;
         }
 
-        auto members = db.loadChainMembers();
-        auto allEntries = db.loadEntryPoints();
-        auto allTrades = db.loadTrades();
-
-        std::vector<int> cycleEids;
-        for (const auto& m : members)
-            if (m.cycle == state.currentCycle)
-                cycleEids.push_back(m.entryId);
-
-        double cyclePnl = 0;
-        int entryTotal = 0, entryDone = 0;
-        bool anyTraded = false;
-        bool allTradedSold = true;
+        auto cs = db.chainCycleStatus(state.currentCycle);
 
         j << ",\"cycleEntries\":[";
         bool first = true;
-        for (int eid : cycleEids)
+        for (const auto& es : cs.entries)
         {
-            const TradeDatabase::EntryPoint* ep = nullptr;
-            for (const auto& e : allEntries)
-                if (e.entryId == eid) { ep = &e; break; }
-            if (!ep) continue;
-
-            entryTotal++;
-            bool traded = ep->traded && ep->linkedTradeId >= 0;
-            bool fullySold = false;
-            double soldQty = 0;
-            double tradeQty = ep->fundingQty;
-
-            if (traded)
-            {
-                anyTraded = true;
-                for (const auto& t : allTrades)
-                {
-                    if (t.tradeId == ep->linkedTradeId && t.type == TradeType::Buy)
-                    {
-                        tradeQty = t.quantity;
-                        soldQty = db.soldQuantityForParent(t.tradeId);
-                        fullySold = (soldQty >= t.quantity - 1e-9);
-                        if (fullySold) entryDone++;
-                        else allTradedSold = false;
-                        for (const auto& s : allTrades)
-                            if (s.type == TradeType::CoveredSell && s.parentTradeId == t.tradeId)
-                                cyclePnl += QuantMath::netProfit(
-                                    QuantMath::grossProfit(t.value, s.value, s.quantity),
-                                    0.0, s.sellFee);
-                        break;
-                    }
-                }
-            }
-
+            const auto& ep = es.entry;
             if (!first) j << ",";
             first = false;
-            j << "{\"id\":" << ep->entryId
-              << ",\"level\":" << ep->levelIndex
-              << ",\"entry\":" << ep->entryPrice
-              << ",\"breakEven\":" << ep->breakEven
-              << ",\"tp\":" << ep->exitTakeProfit
-              << ",\"sl\":" << ep->exitStopLoss
-              << ",\"qty\":" << tradeQty
-              << ",\"funding\":" << ep->funding
-              << ",\"traded\":" << (traded ? "true" : "false")
-              << ",\"fullySold\":" << (fullySold ? "true" : "false")
-              << ",\"soldQty\":" << soldQty
+            j << "{\"id\":" << ep.entryId
+              << ",\"level\":" << ep.levelIndex
+              << ",\"entry\":" << ep.entryPrice
+              << ",\"breakEven\":" << ep.breakEven
+              << ",\"tp\":" << ep.exitTakeProfit
+              << ",\"sl\":" << ep.exitStopLoss
+              << ",\"qty\":" << es.tradeQty
+              << ",\"funding\":" << ep.funding
+              << ",\"traded\":" << (es.traded ? "true" : "false")
+              << ",\"fullySold\":" << (es.fullySold ? "true" : "false")
+              << ",\"soldQty\":" << es.soldQty
               << "}";
         }
         j << "]";
 
-        bool cycleComplete = anyTraded && allTradedSold;
-        double pct = entryTotal > 0 ? (static_cast<double>(entryDone) / entryTotal * 100) : 0;
-
-        j << ",\"cycleComplete\":" << (cycleComplete ? "true" : "false")
-          << ",\"cycleRealizedPnl\":" << cyclePnl
-          << ",\"completionPct\":" << pct
+        j << ",\"cycleComplete\":" << (cs.complete() ? "true" : "false")
+          << ",\"cycleRealizedPnl\":" << cs.realizedPnl
+          << ",\"completionPct\":" << cs.completionPct()
           << ",\"walletBalance\":" << db.loadWalletBalance()
           << "}";
 
@@ -927,41 +914,10 @@ inline void registerApiRoutes(httplib::Server& svr, AppContext& ctx)
         }
 
         // Verify cycle completion
-        auto members = db.loadChainMembers();
-        auto allEntries = db.loadEntryPoints();
-        auto allTrades = db.loadTrades();
-
-        bool anyTraded = false;
-        bool allSold = true;
-        double cyclePnl = 0;
-
-        for (const auto& m : members)
-        {
-            if (m.cycle != state.currentCycle) continue;
-            for (const auto& e : allEntries)
-            {
-                if (e.entryId != m.entryId) continue;
-                if (!e.traded || e.linkedTradeId < 0) continue;
-                anyTraded = true;
-                for (const auto& t : allTrades)
-                {
-                    if (t.tradeId == e.linkedTradeId && t.type == TradeType::Buy)
-                    {
-                        double sq = db.soldQuantityForParent(t.tradeId);
-                        if (sq < t.quantity - 1e-9) allSold = false;
-                        for (const auto& s : allTrades)
-                            if (s.type == TradeType::CoveredSell && s.parentTradeId == t.tradeId)
-                                cyclePnl += QuantMath::netProfit(
-                                    QuantMath::grossProfit(t.value, s.value, s.quantity),
-                                    0.0, s.sellFee);
-                        break;
-                    }
-                }
-                break;
-            }
-        }
+        auto cs = db.chainCycleStatus(state.currentCycle);
+        double cyclePnl = cs.realizedPnl;
 
-        if (!anyTraded || !allSold) {
+        if (!cs.complete()) {
             res.set_content("{\"error\":\"Cycle not complete\"}", "application/json");
             return;
         }
@@ -195,12 +195,7 @@ inline void registerChainManagerRoutes(httplib::Server& svr, AppContext& ctx)
         }
 
         // Get current price for progress check
-        double currentPrice = 0.0;
-        if (ctx.prices.hasSymbol(chain->symbol))
-        {
-            const auto& pts = ctx.prices.data().at(chain->symbol);
-            if (!pts.empty()) currentPrice = pts.back().price;
-        }
+        double currentPrice = ctx.prices.latest(chain->symbol);
 
         std::ostringstream h;
         h << std::fixed << std::setprecision(8);
@@ -3,9 +3,62 @@
 #include "AppContext.h"
 #include "HtmlHelpers.h"
 #include "ChainOptimizer.h"
+#include "WalkForward.h"
+#include "PriceImport.h"
 #include <mutex>
 #include <sstream>
 
+// The chain fields of the /optimizer form, price series included,
+// shared by /optimizer/run and /api/optimizer/walkforward.
+inline ChainParams chainParamsFromForm(const std::map<std::string, std::string>& f)
+{
+    ChainParams cp;
+    cp.price           = fd(f, "price", 100000);
+    cp.capital         = fd(f, "capital", 1000);
+    cp.cycles          = fi(f, "cycles", 5);
+    cp.levels          = fi(f, "levels", 4);
+    cp.exitLevels      = fi(f, "exitLevels", 0);
+    cp.surplus         = fd(f, "surplus", 0.02);
+    cp.risk            = fd(f, "risk", 0.5);
+    cp.steepness       = fd(f, "steepness", 6.0);
+    cp.feeHedging      = fd(f, "feeHedging", 1.0);
+    cp.maxRisk         = fd(f, "maxRisk");
+    cp.minRisk         = fd(f, "minRisk");
+    cp.savingsRate     = fd(f, "savingsRate", 0.05);
+
+    // Parse non-negotiable parameter bounds and freeze flags
+    cp.bSurplus     = { fd(f, "surplus_min", 0.0),     fd(f, "surplus_max", 1.0),     fv(f, "surplus_frozen") == "1" };
+    cp.bRisk        = { fd(f, "risk_min", 0.0),        fd(f, "risk_max", 1.0),        fv(f, "risk_frozen") == "1" };
+    cp.bSteepness   = { fd(f, "steepness_min", 0.1),   fd(f, "steepness_max", 50.0),  fv(f, "steepness_frozen") == "1" };
+    cp.bFeeHedging  = { fd(f, "feeHedging_min", 0.1),  fd(f, "feeHedging_max", 10.0), fv(f, "feeHedging_frozen") == "1" };
+    cp.bMaxRisk     = { fd(f, "maxRisk_min", 0.0),     fd(f, "maxRisk_max", 1.0),     fv(f, "maxRisk_frozen") == "1" };
+    cp.bSavingsRate = { fd(f, "savingsRate_min", 0.0),  fd(f, "savingsRate_max", 1.0), fv(f, "savingsRate_frozen") == "1" };
+    cp.feeSpread       = fd(f, "feeSpread", 0.001);
+    cp.deltaTime       = fd(f, "deltaTime", 1.0);
+    cp.symbolCount     = fi(f, "symbolCount", 1);
+    cp.coefficientK    = fd(f, "coefficientK");
+    cp.buyFeeRate      = fd(f, "buyFeeRate", 0.001);
+    cp.sellFeeRate     = fd(f, "sellFeeRate", 0.001);
+    cp.rangeAbove      = fd(f, "rangeAbove");
+    cp.rangeBelow      = fd(f, "rangeBelow");
+    cp.autoRange       = (fv(f, "autoRange") == "1");
+    cp.futureTradeCount   = fi(f, "futureTradeCount");
+    cp.stopLossFraction   = fd(f, "stopLossFraction", 1.0);
+    cp.stopLossHedgeCount = fi(f, "stopLossHedgeCount");
+    cp.exitRisk           = fd(f, "exitRisk", 0.5);
+    cp.exitFraction       = fd(f, "exitFraction", 1.0);
+    cp.exitSteepness      = fd(f, "exitSteepness", 4.0);
+    cp.downtrendCount     = fi(f, "downtrendCount", 1);
+    cp.maxTradesPerMonth  = fi(f, "maxTradesPerMonth", 0);
+    cp.capitalPumpPerMonth = fd(f, "capitalPumpPerMonth", 0.0);
+
+    // Parse symbol and price series
+    cp.symbol = normalizeSymbol(fv(f, "symbol"));
+    if (cp.symbol.empty()) cp.symbol = "BTC";
+    PriceImport::importInto(cp.prices, cp.symbol, fv(f, "priceSeries"));
+    return cp;
+}
+
 inline void registerOptimizerRoutes(httplib::Server& svr, AppContext& ctx)
 {
     auto& db      = ctx.defaultDb;
@@ -157,20 +210,26 @@ inline void registerOptimizerRoutes(httplib::Server& svr, AppContext& ctx)
              "<label>Meta-Chains</label>"
              "<input type='number' name='metaChains' value='1' min='1' max='100'><br>";
 
-        // GPU acceleration toggle (only show if CUDA is compiled in)
-        if (CudaAccelerator::isAvailable())
+        // Batch backend for simulator-mode gradients; the GPU options
+        // only show if CUDA is compiled in and a device was found
+        bool gpu = CudaAccelerator::isAvailable();
+        h << "<h3>Batch Simulation</h3>";
+        if (gpu)
+            h << "<div class='msg' style='border-color:#22c55e;'>"
+                 "&#x1F7E2; CUDA GPU detected: <strong>"
+              << html::esc(CudaAccelerator::deviceName())
+              << "</strong></div>";
+        h << "<label>Simulator-mode gradient probes</label>"
+             "<select name='batchBackend'>";
+        if (gpu)
+            h << "<option value='cuda' selected>CUDA GPU (batched)</option>";
+        h << "<option value='cpu'" << (gpu ? "" : " selected") << ">CPU batch ("
+          << html::esc(BatchSim::deviceName(BatchSim::Backend::Cpu)) << ")</option>"
+             "<option value='seq'>Sequential (full simulator per probe)</option>"
+             "</select><br>";
+        if (gpu)
         {
-            h << "<h3>GPU Acceleration</h3>"
-                  "<div class='msg' style='border-color:#22c55e;'>"
-                  "&#x1F7E2; CUDA GPU detected: <strong>"
-               << html::esc(CudaAccelerator::deviceName())
-               << "</strong></div>"
-                   "<label>Use CUDA for simulator-mode gradients</label>"
-                   "<select name='useCuda'>"
-                   "<option value='1' selected>Enabled</option>"
-                   "<option value='0'>Disabled (CPU)</option>"
-                   "</select><br>"
-                   "<label>GPU Throttle (% of SMs &mdash; lower = desktop stays responsive)</label>"
+            h << "<label>GPU Throttle (% of SMs &mdash; lower = desktop stays responsive)</label>"
                    "<input type='range' name='gpuThrottle' min='10' max='100' value='"
                 << CudaAccelerator::getThrottle()
                 << "' oninput='this.nextElementSibling.textContent=this.value+\"%\"'>"
@@ -195,67 +254,7 @@ inline void registerOptimizerRoutes(httplib::Server& svr, AppContext& ctx)
     svr.Post("/optimizer/run", [&](const httplib::Request& req, httplib::Response& res) {
         auto f = parseForm(req.body);
 
-        ChainParams cp;
-        cp.price           = fd(f, "price", 100000);
-        cp.capital         = fd(f, "capital", 1000);
-        cp.cycles          = fi(f, "cycles", 5);
-        cp.levels          = fi(f, "levels", 4);
-        cp.exitLevels      = fi(f, "exitLevels", 0);
-        cp.surplus         = fd(f, "surplus", 0.02);
-        cp.risk            = fd(f, "risk", 0.5);
-        cp.steepness       = fd(f, "steepness", 6.0);
-        cp.feeHedging      = fd(f, "feeHedging", 1.0);
-        cp.maxRisk         = fd(f, "maxRisk");
-        cp.minRisk         = fd(f, "minRisk");
-        cp.savingsRate     = fd(f, "savingsRate", 0.05);
-
-        // Parse non-negotiable parameter bounds and freeze flags
-        cp.bSurplus     = { fd(f, "surplus_min", 0.0),     fd(f, "surplus_max", 1.0),     fv(f, "surplus_frozen") == "1" };
-        cp.bRisk        = { fd(f, "risk_min", 0.0),        fd(f, "risk_max", 1.0),        fv(f, "risk_frozen") == "1" };
-        cp.bSteepness   = { fd(f, "steepness_min", 0.1),   fd(f, "steepness_max", 50.0),  fv(f, "steepness_frozen") == "1" };
-        cp.bFeeHedging  = { fd(f, "feeHedging_min", 0.1),  fd(f, "feeHedging_max", 10.0), fv(f, "feeHedging_frozen") == "1" };
-        cp.bMaxRisk     = { fd(f, "maxRisk_min", 0.0),     fd(f, "maxRisk_max", 1.0),     fv(f, "maxRisk_frozen") == "1" };
-        cp.bSavingsRate = { fd(f, "savingsRate_min", 0.0),  fd(f, "savingsRate_max", 1.0), fv(f, "savingsRate_frozen") == "1" };
-        cp.feeSpread       = fd(f, "feeSpread", 0.001);
-        cp.deltaTime       = fd(f, "deltaTime", 1.0);
-        cp.symbolCount     = fi(f, "symbolCount", 1);
-        cp.coefficientK    = fd(f, "coefficientK");
-        cp.buyFeeRate      = fd(f, "buyFeeRate", 0.001);
-        cp.sellFeeRate     = fd(f, "sellFeeRate", 0.001);
-        cp.rangeAbove      = fd(f, "rangeAbove");
-        cp.rangeBelow      = fd(f, "rangeBelow");
-        cp.autoRange       = (fv(f, "autoRange") == "1");
-        cp.futureTradeCount   = fi(f, "futureTradeCount");
-        cp.stopLossFraction   = fd(f, "stopLossFraction", 1.0);
-        cp.stopLossHedgeCount = fi(f, "stopLossHedgeCount");
-        cp.exitRisk           = fd(f, "exitRisk", 0.5);
-        cp.exitFraction       = fd(f, "exitFraction", 1.0);
-        cp.exitSteepness      = fd(f, "exitSteepness", 4.0);
-        cp.downtrendCount     = fi(f, "downtrendCount", 1);
-        cp.maxTradesPerMonth  = fi(f, "maxTradesPerMonth", 0);
-        cp.capitalPumpPerMonth = fd(f, "capitalPumpPerMonth", 0.0);
-
-        // Parse symbol and price series
-        cp.symbol = normalizeSymbol(fv(f, "symbol"));
-        if (cp.symbol.empty()) cp.symbol = "BTC";
-        {
-            std::string priceStr = fv(f, "priceSeries");
-            if (!priceStr.empty()) {
-                std::istringstream ss(priceStr);
-                std::string line;
-                while (std::getline(ss, line)) {
-                    if (line.empty()) continue;
-                    if (!line.empty() && line.back() == '\r') line.pop_back();
-                    auto comma = line.find(',');
-                    if (comma == std::string::npos) continue;
-                    try {
-                        long long ts = std::stoll(line.substr(0, comma));
-                        double px    = std::stod(line.substr(comma + 1));
-                        cp.prices.set(cp.symbol, ts, px);
-                    } catch (...) {}
-                }
-            }
-        }
+        ChainParams cp = chainParamsFromForm(f);
 
         int objInt = fi(f, "objective", 5);
         auto obj   = static_cast<ChainObjective>(
@@ -264,11 +263,15 @@ inline void registerOptimizerRoutes(httplib::Server& svr, AppContext& ctx)
         double lr       = fd(f, "learningRate", 0.001);
         int    maxSteps = fi(f, "maxSteps", 50);
         int    metaChains = std::max(1, std::min(100, fi(f, "metaChains", 1)));
-        bool   useCuda   = (fv(f, "useCuda") == "1") && CudaAccelerator::isAvailable();
-        cp.useCuda = useCuda;
+        std::string be   = fv(f, "batchBackend");
+        if (be.empty() && fv(f, "useCuda") == "1") be = "cuda";
+        auto backend = be == "cuda" ? BatchSim::resolve(BatchSim::Backend::Cuda)
+                     : be == "cpu"  ? BatchSim::Backend::Cpu
+                                    : BatchSim::Backend::Sequential;
+        cp.batchBackend = backend;
 
         // Apply GPU throttle and memory budget before the run
-        if (useCuda)
+        if (backend == BatchSim::Backend::Cuda)
         {
             CudaAccelerator::setThrottle(fi(f, "gpuThrottle", 100));
             CudaAccelerator::setMemBudget(fi(f, "gpuMemBudget", 50));
@@ -283,11 +286,11 @@ inline void registerOptimizerRoutes(httplib::Server& svr, AppContext& ctx)
         std::string objName = objNames[objInt];
         bool simMode = cp.hasPriceSeries();
         int priceCount = simMode
-            ? static_cast<int>(cp.prices.data().at(cp.symbol).size()) : 0;
+            ? static_cast<int>(cp.prices.series(cp.symbol).size()) : 0;
 
         // ---- Stream the response using chunked transfer ----
         res.set_chunked_content_provider("text/html",
-            [cp, obj, objName, lr, maxSteps, simMode, priceCount, metaChains, useCuda]
+            [cp, obj, objName, lr, maxSteps, simMode, priceCount, metaChains, backend]
             (size_t /*offset*/, httplib::DataSink& sink) {
 
             auto emit = [&](const std::string& s) {
@@ -308,7 +311,10 @@ inline void registerOptimizerRoutes(httplib::Server& svr, AppContext& ctx)
                     hdr << "<div class='msg'>Simulator mode &mdash; "
                         << priceCount << " price points for " << html::esc(cp.symbol)
                         << ". Gradients via end-to-end finite differences."
-                        << (useCuda ? " <strong style='color:#22c55e;'>&#x26A1; CUDA GPU</strong>" : "")
+                        << (backend != BatchSim::Backend::Sequential
+                            ? std::string(" <strong style='color:#22c55e;'>&#x26A1; ")
+                              + BatchSim::name(backend) + "</strong>"
+                            : std::string())
                         << "</div>";
                 else
                     hdr << "<div class='msg'>Analytical mode &mdash; all TPs assumed hit. "
@@ -708,7 +714,7 @@ window.addEventListener('resize',drawChart);
                     h << "<script>(function(){"
                           "var px=[";
                     {
-                        const auto& pts = curChainParams.prices.data().at(curChainParams.symbol);
+                        PriceSpan pts = curChainParams.prices.series(curChainParams.symbol);
                         for (size_t i = 0; i < pts.size(); ++i) {
                             if (i > 0) h << ',';
                             h << '[' << pts[i].timestamp << ',' << pts[i].price << ']';
@@ -930,4 +936,67 @@ cv.addEventListener('mouseleave',function(){tip.style.display='none';});
             return true;
         });
     });
+
+    // ========== POST /api/optimizer/walkforward  out-of-sample optimisation ==========
+    // The /optimizer form fields give the chain and its price series;
+    // trainTicks, testTicks, anchored, warmStart and chains cut the
+    // series into windows (see WalkForward.h).  Each window is
+    // streamed in order once all have been fitted, then the summary
+    // with the aggregate out-of-sample equity curve (curve=0 leaves
+    // the curve out).
+    svr.Post("/api/optimizer/walkforward", [&](const httplib::Request& req, httplib::Response& res) {
+        auto f = parseForm(req.body);
+        auto fail = [&](const std::string& msg) {
+            res.status = 400;
+            res.set_content("{\"error\":\"" + msg + "\"}", "application/json");
+        };
+
+        ChainParams cp = chainParamsFromForm(f);
+        if (!cp.hasPriceSeries()) return fail("Walk-forward needs a price series");
+        if (cp.capital <= 0)      return fail("Capital must be positive");
+        std::string be = fv(f, "batchBackend");
+        cp.batchBackend = be == "cuda" ? BatchSim::resolve(BatchSim::Backend::Cuda)
+                        : be == "cpu"  ? BatchSim::Backend::Cpu
+                                       : BatchSim::Backend::Sequential;
+
+        WalkForward::Config wc;
+        wc.trainTicks = fi(f, "trainTicks", wc.trainTicks);
+        wc.testTicks  = fi(f, "testTicks", wc.testTicks);
+        wc.anchored   = fv(f, "anchored") == "1";
+        wc.warmStart  = fv(f, "warmStart", "1") != "0";
+        wc.chains     = std::max(1, std::min(256, fi(f, "chains", wc.chains)));
+        wc.objective  = static_cast<ChainObjective>(std::max(1, std::min(5, fi(f, "objective", 5))));
+        wc.maxSteps   = std::max(0, std::min(10000, fi(f, "maxSteps", wc.maxSteps)));
+        wc.lr         = fd(f, "learningRate", wc.lr);
+        try { WalkForward::windows(cp.prices.series(cp.symbol).size(), wc); }
+        catch (const std::exception& ex) { return fail(ex.what()); }
+        bool curve = fv(f, "curve", "1") != "0";
+
+        auto shared = std::make_shared<ChainParams>(std::move(cp));
+        res.set_header("Access-Control-Allow-Origin", "*");
+        res.set_chunked_content_provider("application/json",
+            [shared, wc, curve](size_t, httplib::DataSink& sink) {
+            auto emit = [&](const std::string& s) { return sink.write(s.data(), s.size()); };
+            std::ostringstream hdr;
+            hdr << "{\"symbol\":\"" << shared->symbol << "\""
+                << ",\"trainTicks\":" << wc.trainTicks << ",\"testTicks\":" << wc.testTicks
+                << ",\"anchored\":" << (wc.anchored ? "true" : "false")
+                << ",\"warmStart\":" << (wc.warmStart ? "true" : "false")
+                << ",\"chains\":" << wc.chains
+                << ",\"objective\":" << static_cast<int>(wc.objective) << ",\"windows\":[";
+            emit(hdr.str());
+
+            bool first = true;
+            WalkForward::Summary sum = WalkForward::run(*shared, wc,
+                [&](const WalkForward::WindowResult& r) {
+                    bool ok = emit((first ? "" : ",") + WalkForward::jsonWindow(r));
+                    first = false;
+                    return ok;
+                });
+
+            emit("],\"summary\":" + WalkForward::jsonSummary(sum, curve) + "}");
+            sink.done();
+            return true;
+        });
+    });
 }
@@ -6,6 +6,25 @@
 #include <algorithm>
 #include <chrono>
 #include <map>
+#include <set>
+#include <cmath>
+
+// Distinct Buy symbols in first-seen order.
+inline std::vector<std::string> buySymbols(const std::vector<Trade>& trades)
+{
+    std::vector<std::string> out;
+    std::vector<char> seen;
+    for (const auto& t : trades)
+    {
+        if (t.type != TradeType::Buy) continue;
+        SymbolId id = SymbolRegistry::intern(t.symbol);
+        if (id >= seen.size()) seen.resize(id + 1, 0);
+        if (seen[id]) continue;
+        seen[id] = 1;
+        out.push_back(t.symbol);
+    }
+    return out;
+}
 
 inline void registerPriceCheckRoutes(httplib::Server& svr, AppContext& ctx)
 {
@@ -20,10 +39,7 @@ inline void registerPriceCheckRoutes(httplib::Server& svr, AppContext& ctx)
         h << html::msgBanner(req) << html::errBanner(req);
         h << "<h1>Price Check (TP/SL vs Market)</h1>";
         auto trades = db.loadTrades();
-        std::vector<std::string> symbols;
-        for (const auto& t : trades)
-            if (t.type == TradeType::Buy && std::find(symbols.begin(), symbols.end(), t.symbol) == symbols.end())
-                symbols.push_back(t.symbol);
+        std::vector<std::string> symbols = buySymbols(trades);
         if (symbols.empty()) { h << "<p class='empty'>(no Buy trades)</p>"; }
         else
         {
@@ -46,11 +62,15 @@ inline void registerPriceCheckRoutes(httplib::Server& svr, AppContext& ctx)
         std::lock_guard<std::mutex> lk(dbMutex);
         auto f = parseForm(req.body);
         auto trades = db.loadTrades();
-        std::vector<std::string> symbols;
-        for (const auto& t : trades)
-            if (t.type == TradeType::Buy && std::find(symbols.begin(), symbols.end(), t.symbol) == symbols.end())
-                symbols.push_back(t.symbol);
-        auto priceFor = [&](const std::string& sym) -> double { return fd(f, "price_" + sym, 0.0); };
+        std::vector<std::string> symbols = buySymbols(trades);
+        // Entered prices, read from the form once per symbol.
+        std::vector<double> market;
+        auto priceOf = [&](SymbolId id) -> double {
+            if (id >= market.size()) market.resize(id + 1, std::nan(""));
+            if (std::isnan(market[id])) market[id] = fd(f, "price_" + SymbolRegistry::name(id), 0.0);
+            return market[id];
+        };
+        auto priceFor = [&](const std::string& sym) { return priceOf(SymbolRegistry::intern(sym)); };
 
         // Persist entered prices into the shared PriceSeries
         {
@@ -72,8 +92,18 @@ inline void registerPriceCheckRoutes(httplib::Server& svr, AppContext& ctx)
         h << "<br><button>Check</button></form>";
         h << "<table><tr><th>ID</th><th>Symbol</th><th>Entry</th><th>Qty</th><th>Market</th><th>Gross P&amp;L</th><th>Net P&amp;L</th><th>ROI%</th>"
              "<th>TP Price</th><th>TP?</th><th>SL Price</th><th>SL?</th></tr>";
-        struct Trigger { int id; std::string sym; double price; double qty; std::string tag; double entryPrice; double buyFee; double totalQty; int levelIndex; };
-        std::vector<Trigger> triggers;
+        struct SellTrigger { int id; std::string sym; double price; double qty; std::string tag; double entryPrice; double buyFee; double totalQty; int levelIndex; int exitId; };
+        std::vector<SellTrigger> triggers;
+
+        // The display lists every level of an open Buy; group them once.
+        std::map<int, std::vector<HorizonLevel>> levelsOf;
+        for (const auto& [sym, tid, lv] : db.loadAllHorizons())
+            levelsOf[tid].push_back(lv);
+        std::map<int, std::vector<TradeDatabase::ExitPoint>> exitsOf;
+        for (const auto& xp : db.loadExitPoints())
+            exitsOf[xp.tradeId].push_back(xp);
+        std::map<int, const Trade*> buyOf;
+
         for (const auto& t : trades)
         {
             if (t.type != TradeType::Buy) continue;
@@ -93,8 +123,8 @@ inline void registerPriceCheckRoutes(httplib::Server& svr, AppContext& ctx)
               << "<td class='" << (roi >= 0 ? "buy" : "sell") << "'>" << roi << "</td>"
               << "<td>-</td><td>-</td>"
               << "<td>-</td><td>-</td></tr>";
-            auto levels = db.loadHorizonLevels(t.symbol, t.tradeId);
-            for (const auto& lv : levels)
+            buyOf[t.tradeId] = &t;
+            for (const auto& lv : levelsOf[t.tradeId])
             {
                 double htp = t.quantity > 0 ? lv.takeProfit / t.quantity : 0;
                 double hsl = (t.quantity > 0 && lv.stopLoss > 0) ? lv.stopLoss / t.quantity : 0;
@@ -108,9 +138,7 @@ inline void registerPriceCheckRoutes(httplib::Server& svr, AppContext& ctx)
                 else h << "-";
                 h << "</td></tr>";
             }
-            // Exit-point triggers: check saved exit points for this trade
-            auto exitPts = db.loadExitPointsForTrade(t.tradeId);
-            for (const auto& xp : exitPts)
+            for (const auto& xp : exitsOf[t.tradeId])
             {
                 if (xp.executed) continue;
                 bool xpTpHit = (xp.tpPrice > 0 && cur >= xp.tpPrice);
@@ -127,20 +155,42 @@ inline void registerPriceCheckRoutes(httplib::Server& svr, AppContext& ctx)
                 else if (xp.slPrice > 0) h << "OFF";
                 else h << "-";
                 h << "</td></tr>";
-                if (xpTpHit && xp.sellQty > 0)
-                    triggers.push_back({t.tradeId, t.symbol, xp.tpPrice, xp.sellQty, "X-TP", t.value, t.buyFee, t.quantity, xp.levelIndex});
-                if (xpSlHit && xp.sellQty > 0)
-                    triggers.push_back({t.tradeId, t.symbol, xp.slPrice, xp.sellQty, "X-SL", t.value, t.buyFee, t.quantity, xp.levelIndex});
             }
         }
         h << "</table>";
 
+        // What the entered prices crossed comes from the trigger book, one
+        // lookup per symbol; exit-point hits on open Buys become sells.
+        std::set<std::pair<TriggerSource, int>> hit;
+        std::vector<char> checked;
+        auto check = [&](const std::string& sym) {
+            SymbolId id = SymbolRegistry::intern(sym);
+            double p = priceOf(id);
+            if (id >= checked.size()) checked.resize(id + 1, 0);
+            if (p <= 0 || checked[id]) return;
+            checked[id] = 1;
+            for (const auto& tr : db.crossedTriggers(id, p))
+            {
+                hit.insert({tr.source(), tr.id});
+                if (tr.kind != TriggerKind::ExitTP && tr.kind != TriggerKind::ExitSL) continue;
+                auto b = buyOf.find(tr.tradeId);
+                if (b == buyOf.end() || tr.qty <= 0) continue;
+                const Trade& t = *b->second;
+                triggers.push_back({t.tradeId, t.symbol, tr.price, tr.qty, triggerTag(tr.kind), t.value, t.buyFee, t.quantity, tr.levelIndex, tr.id});
+            }
+        };
+        for (const auto& sym : symbols)
+            check(sym);
+
         auto pending = db.loadPendingExits();
         if (!pending.empty())
         {
             std::vector<TradeDatabase::PendingExit> peTriggered, peWaiting;
             for (const auto& pe : pending)
-            { double cur = priceFor(pe.symbol); if (cur > 0 && cur >= pe.triggerPrice) peTriggered.push_back(pe); else peWaiting.push_back(pe); }
+            {
+                check(pe.symbol);
+                (hit.count({TriggerSource::Pending, pe.orderId}) ? peTriggered : peWaiting).push_back(pe);
+            }
 
             h << "<h2>Pending Exits (" << pending.size() << " total, " << peTriggered.size() << " triggered)</h2>";
 
@@ -200,7 +250,8 @@ inline void registerPriceCheckRoutes(httplib::Server& svr, AppContext& ctx)
                   << "<input type='hidden' name='trigsym_" << i << "' value='" << html::esc(tr.sym) << "'>"
                   << "<input type='hidden' name='trigprice_" << i << "' value='" << tr.price << "'>"
                   << "<input type='hidden' name='trigqty_" << i << "' value='" << tr.qty << "'>"
-                  << "<input type='hidden' name='trigtag_" << i << "' value='" << tr.tag << "'>";
+                  << "<input type='hidden' name='trigtag_" << i << "' value='" << tr.tag << "'>"
+                  << "<input type='hidden' name='trigxid_" << i << "' value='" << tr.exitId << "'>";
             }
             h << "<input type='hidden' name='trigcount' value='" << triggers.size() << "'>";
             for (const auto& sym : symbols)
@@ -226,11 +277,11 @@ inline void registerPriceCheckRoutes(httplib::Server& svr, AppContext& ctx)
             {
                 if (ep.traded) continue;
                 double cur = priceFor(ep.symbol);
-                bool hit = false;
-                if (cur > 0) hit = ep.isShort ? (cur >= ep.entryPrice) : (cur <= ep.entryPrice);
+                check(ep.symbol);
+                bool epHit = hit.count({TriggerSource::Entry, ep.entryId}) > 0;
                 auto it = entryToCycle.find(ep.entryId);
                 int cycle = (it != entryToCycle.end()) ? it->second : -1;
-                if (hit)
+                if (epHit)
                 {
                     if (cycle >= 0 && chainState.active && cycle > chainState.currentCycle)
                         queuedEntries.push_back({ep.entryId, ep.symbol, ep.entryPrice, ep.fundingQty, cycle});
@@ -264,6 +315,8 @@ inline void registerPriceCheckRoutes(httplib::Server& svr, AppContext& ctx)
                       << "<input type='hidden' name='epid_" << te.entryId << "' value='1'></td>"
                       << "<td class='buy'>TRIGGERED</td></tr>";
                 }
+                for (const auto& sym : symbols)
+                    h << "<input type='hidden' name='price_" << html::esc(sym) << "' value='" << priceFor(sym) << "'>";
                 h << "</table><button>Execute Triggered Entries</button></form>";
             }
 
@@ -300,38 +353,10 @@ inline void registerPriceCheckRoutes(httplib::Server& svr, AppContext& ctx)
             // Chain cycle status & advance
             if (chainState.active)
             {
-                bool anyTraded = false;
-                bool allSold = true;
-                double cyclePnl = 0;
-                auto allTrades = db.loadTrades();
-
-                for (const auto& m : chainMembers)
-                {
-                    if (m.cycle != chainState.currentCycle) continue;
-                    for (const auto& e : entryPts)
-                    {
-                        if (e.entryId != m.entryId) continue;
-                        if (!e.traded || e.linkedTradeId < 0) continue;
-                        anyTraded = true;
-                        for (const auto& t : allTrades)
-                        {
-                            if (t.tradeId == e.linkedTradeId && t.type == TradeType::Buy)
-                            {
-                                double sq = db.soldQuantityForParent(t.tradeId);
-                                if (sq < t.quantity - 1e-9) allSold = false;
-                                for (const auto& s : allTrades)
-                                    if (s.type == TradeType::CoveredSell && s.parentTradeId == t.tradeId)
-                                        cyclePnl += QuantMath::netProfit(
-                                            QuantMath::grossProfit(t.value, s.value, s.quantity),
-                                            0.0, s.sellFee);
-                                break;
-                            }
-                        }
-                        break;
-                    }
-                }
-
-                bool cycleComplete = anyTraded && allSold;
+                auto cs = db.chainCycleStatus(chainState.currentCycle);
+                bool anyTraded = cs.anyTraded;
+                double cyclePnl = cs.realizedPnl;
+                bool cycleComplete = cs.complete();
                 h << "<h2>Chain Status</h2><div class='row'>"
                      "<div class='stat'><div class='lbl'>Symbol</div><div class='val'>" << html::esc(chainState.symbol) << "</div></div>"
                      "<div class='stat'><div class='lbl'>Cycle</div><div class='val'>" << chainState.currentCycle << "</div></div>"
@@ -388,15 +413,44 @@ inline void registerPriceCheckRoutes(httplib::Server& svr, AppContext& ctx)
         std::lock_guard<std::mutex> lk(dbMutex);
         auto f = parseForm(req.body);
         auto entryPts = db.loadEntryPoints();
+        std::map<int, std::size_t> entryAt;
+        for (std::size_t i = 0; i < entryPts.size(); ++i)
+            entryAt[entryPts[i].entryId] = i;
         std::ostringstream h;
         h << std::fixed << std::setprecision(17);
         h << "<h1>Entry Execution</h1>";
         int executed = 0, failed = 0;
+        std::vector<TradeDatabase::ExitPoint> newExits;
         h << "<table><tr><th>ID</th><th>Symbol</th><th>Entry</th><th>Qty</th><th>Fee</th><th>Trade</th><th>TP</th><th>SL</th><th>Status</th></tr>";
-        for (auto& ep : entryPts)
+        // Only the submitted entries are visited (epid_<id> fields), in
+        // entry_points.json order rather than the form's key order.
+        std::vector<std::size_t> submitted;
+        for (auto fit = f.lower_bound("epid_"); fit != f.end() && fit->first.compare(0, 5, "epid_") == 0; ++fit)
         {
-            if (ep.traded) continue;
-            if (fv(f, "epid_" + std::to_string(ep.entryId)).empty()) continue;
+            if (fit->second.empty()) continue;
+            auto at = entryAt.find(std::atoi(fit->first.c_str() + 5));
+            if (at != entryAt.end()) submitted.push_back(at->second);
+        }
+        std::sort(submitted.begin(), submitted.end());
+        for (std::size_t at : submitted)
+        {
+            auto& ep = entryPts[at];
+            if (!db.triggerLive(TriggerSource::Entry, ep.entryId)) continue;  // already traded
+            // With the market prices posted back, the level must still be crossed.
+            double market = fd(f, "price_" + ep.symbol);
+            if (market > 0)
+            {
+                bool crossed = false;
+                for (const auto& tr : db.crossedTriggers(ep.symbol, market))
+                    if (tr.source() == TriggerSource::Entry && tr.id == ep.entryId) { crossed = true; break; }
+                if (!crossed)
+                {
+                    h << "<tr><td>" << ep.entryId << "</td><td>" << html::esc(ep.symbol) << "</td><td>" << ep.entryPrice << "</td>"
+                      << "<td>" << ep.fundingQty << "</td><td>-</td><td>-</td><td>-</td><td>-</td>"
+                      << "<td class='sell'>NOT TRIGGERED at " << market << "</td></tr>";
+                    ++failed; continue;
+                }
+            }
             double buyFee = fd(f, "fee_" + std::to_string(ep.entryId));
             double cost = ep.entryPrice * ep.fundingQty + buyFee;
             double walBal = db.loadWalletBalance();
@@ -408,51 +462,32 @@ inline void registerPriceCheckRoutes(httplib::Server& svr, AppContext& ctx)
                 ++failed; continue;
             }
             int bid = db.executeBuy(ep.symbol, ep.entryPrice, ep.fundingQty, buyFee);
-            ep.traded = true; ep.linkedTradeId = bid;
+            db.markEntryTraded(ep.entryId, bid);
             h << "<tr><td>" << ep.entryId << "</td><td>" << html::esc(ep.symbol) << "</td><td>" << ep.entryPrice << "</td>"
               << "<td>" << ep.fundingQty << "</td><td>" << buyFee << "</td><td class='buy'>#" << bid << "</td>"
               << "<td>" << ep.exitTakeProfit << "</td><td>" << ep.exitStopLoss << "</td><td class='buy'>OK</td></tr>";
             ++executed;
-        }
-        h << "</table>";
-        if (executed > 0)
-        {
-            auto trades = db.loadTrades();
-            auto existingExits = db.loadExitPoints();
-            for (const auto& ep : entryPts)
+            // Create exit point for TP
+            if (ep.exitTakeProfit > 0)
             {
-                if (ep.linkedTradeId < 0) continue;
-                auto* tradePtr = db.findTradeById(trades, ep.linkedTradeId);
-                if (!tradePtr) continue;
-                // Create exit point for TP
-                if (ep.exitTakeProfit > 0)
-                {
-                    TradeDatabase::ExitPoint xp;
-                    xp.exitId       = db.nextExitId();
-                    xp.tradeId      = tradePtr->tradeId;
-                    xp.symbol       = ep.symbol;
-                    xp.levelIndex   = ep.levelIndex;
-                    xp.tpPrice      = ep.exitTakeProfit;
-                    xp.sellQty      = ep.fundingQty;
-                    xp.sellFraction = 1.0;
-                    xp.slPrice      = ep.exitStopLoss;
-                    xp.slActive     = (ep.stopLossFraction > 0.0);
-                    xp.executed     = false;
-                    xp.linkedSellId = -1;
-                    existingExits.push_back(xp);
-                }
-                // Set trade-level TP to first level (horizon compat)
-                tradePtr->takeProfit = ep.exitTakeProfit * tradePtr->quantity;
-                tradePtr->takeProfitFraction = (ep.exitTakeProfit > 0) ? 1.0 : 0.0;
-                tradePtr->takeProfitActive = (tradePtr->takeProfitFraction > 0.0);
-                tradePtr->stopLoss = ep.exitStopLoss * tradePtr->quantity;
-                tradePtr->stopLossFraction = ep.stopLossFraction;
-                tradePtr->stopLossActive = (ep.stopLossFraction > 0.0);
-                db.updateTrade(*tradePtr);
+                TradeDatabase::ExitPoint xp;
+                xp.exitId       = db.nextExitId();
+                xp.tradeId      = bid;
+                xp.symbol       = ep.symbol;
+                xp.levelIndex   = ep.levelIndex;
+                xp.tpPrice      = ep.exitTakeProfit;
+                xp.sellQty      = ep.fundingQty;
+                xp.sellFraction = 1.0;
+                xp.slPrice      = ep.exitStopLoss;
+                xp.slActive     = (ep.stopLossFraction > 0.0);
+                xp.executed     = false;
+                xp.linkedSellId = -1;
+                newExits.push_back(xp);
             }
-            db.saveExitPoints(existingExits);
         }
-        db.saveEntryPoints(entryPts);
+        h << "</table>";
+        if (!newExits.empty())
+            db.addExitPoints(newExits);
         h << "<div class='row'>"
              "<div class='stat'><div class='lbl'>Executed</div><div class='val'>" << executed << "</div></div>"
              "<div class='stat'><div class='lbl'>Failed</div><div class='val'>" << failed << "</div></div>"
@@ -471,8 +506,6 @@ inline void registerPriceCheckRoutes(httplib::Server& svr, AppContext& ctx)
         h << "<h1>TP/SL Sell Execution</h1>";
         int executed = 0, failed = 0;
         h << "<table><tr><th>Tag</th><th>Trade</th><th>Symbol</th><th>Qty</th><th>Price</th><th>Fee</th><th>Sell ID</th><th>Status</th></tr>";
-        struct ExecutedTrig { int tradeId; double price; double qty; std::string tag; int sellId; };
-        std::vector<ExecutedTrig> executedTrigs;
         for (int i = 0; i < count; ++i)
         {
             if (fv(f, "trig_" + std::to_string(i)).empty()) continue;
@@ -483,6 +516,28 @@ inline void registerPriceCheckRoutes(httplib::Server& svr, AppContext& ctx)
             double fee = fd(f, "trigfee_" + std::to_string(i));
             std::string tag = fv(f, "trigtag_" + std::to_string(i));
             bool isTP = (tag == "TP" || tag == "H-TP" || tag == "X-TP");
+            bool isExit = (tag == "X-TP" || tag == "X-SL");
+
+            // Exit-point sells fire once: the exit must still be in the book.
+            int exitId = fi(f, "trigxid_" + std::to_string(i), -1);
+            if (isExit && exitId < 0)
+            {
+                TriggerKind kind = (tag == "X-TP") ? TriggerKind::ExitTP : TriggerKind::ExitSL;
+                for (const auto& tr : db.crossedTriggers(sym, price))
+                    if (tr.kind == kind && tr.tradeId == tradeId
+                        && std::abs(tr.price - price) < 1e-9 && std::abs(tr.qty - qty) < 1e-9)
+                    { exitId = tr.id; break; }
+            }
+            if (isExit && (exitId < 0 || !db.triggerLive(TriggerSource::Exit, exitId)))
+            {
+                h << "<tr><td class='" << (isTP ? "buy" : "sell") << "'>" << tag << "</td>"
+                  << "<td>" << tradeId << "</td><td>" << html::esc(sym) << "</td>"
+                  << "<td>" << qty << "</td><td>" << price << "</td><td>" << fee << "</td>"
+                  << "<td>-</td><td class='sell'>ALREADY EXECUTED</td></tr>";
+                ++failed;
+                continue;
+            }
+
             int sid = db.executeSellForTrade(sym, price, qty, fee, tradeId);
             if (sid >= 0)
             {
@@ -490,7 +545,8 @@ inline void registerPriceCheckRoutes(httplib::Server& svr, AppContext& ctx)
                   << "<td>" << tradeId << "</td><td>" << html::esc(sym) << "</td>"
                   << "<td>" << qty << "</td><td>" << price << "</td><td>" << fee << "</td>"
                   << "<td class='buy'>#" << sid << "</td><td class='buy'>OK</td></tr>";
-                executedTrigs.push_back({tradeId, price, qty, tag, sid});
+                if (isExit)
+                    db.markExitExecuted(exitId, sid);
                 ++executed;
             }
             else
@@ -503,31 +559,6 @@ inline void registerPriceCheckRoutes(httplib::Server& svr, AppContext& ctx)
             }
         }
         h << "</table>";
-        // Mark exit points as executed
-        if (!executedTrigs.empty())
-        {
-            auto allExits = db.loadExitPoints();
-            bool changed = false;
-            for (const auto& et : executedTrigs)
-            {
-                if (et.tag != "X-TP" && et.tag != "X-SL") continue;
-                for (auto& xp : allExits)
-                {
-                    if (xp.executed) continue;
-                    if (xp.tradeId != et.tradeId) continue;
-                    bool match = (et.tag == "X-TP" && std::abs(xp.tpPrice - et.price) < 1e-9) ||
-                                 (et.tag == "X-SL" && std::abs(xp.slPrice - et.price) < 1e-9);
-                    if (match && std::abs(xp.sellQty - et.qty) < 1e-9)
-                    {
-                        xp.executed = true;
-                        xp.linkedSellId = et.sellId;
-                        changed = true;
-                        break;
-                    }
-                }
-            }
-            if (changed) db.saveExitPoints(allExits);
-        }
         h << "<div class='row'>"
              "<div class='stat'><div class='lbl'>Executed</div><div class='val'>" << executed << "</div></div>"
              "<div class='stat'><div class='lbl'>Failed</div><div class='val'>" << failed << "</div></div>"
@@ -594,41 +625,10 @@ inline void registerPriceCheckRoutes(httplib::Server& svr, AppContext& ctx)
         }
 
         // Verify cycle completion
-        auto members = db.loadChainMembers();
-        auto allEntries = db.loadEntryPoints();
-        auto allTrades = db.loadTrades();
-
-        bool anyTraded = false;
-        bool allSold = true;
-        double cyclePnl = 0;
-
-        for (const auto& m : members)
-        {
-            if (m.cycle != state.currentCycle) continue;
-            for (const auto& e : allEntries)
-            {
-                if (e.entryId != m.entryId) continue;
-                if (!e.traded || e.linkedTradeId < 0) continue;
-                anyTraded = true;
-                for (const auto& t : allTrades)
-                {
-                    if (t.tradeId == e.linkedTradeId && t.type == TradeType::Buy)
-                    {
-                        double sq = db.soldQuantityForParent(t.tradeId);
-                        if (sq < t.quantity - 1e-9) allSold = false;
-                        for (const auto& s : allTrades)
-                            if (s.type == TradeType::CoveredSell && s.parentTradeId == t.tradeId)
-                                cyclePnl += QuantMath::netProfit(
-                                    QuantMath::grossProfit(t.value, s.value, s.quantity),
-                                    0.0, s.sellFee);
-                        break;
-                    }
-                }
-                break;
-            }
-        }
+        auto cs = db.chainCycleStatus(state.currentCycle);
+        double cyclePnl = cs.realizedPnl;
 
-        if (!anyTraded || !allSold)
+        if (!cs.complete())
         {
             res.set_redirect("/price-check?err=Cycle+not+complete", 303);
             return;
@@ -3,9 +3,56 @@
 #include "AppContext.h"
 #include "HtmlHelpers.h"
 #include "Simulator.h"
+#include "PriceImport.h"
+#include "ParamSweep.h"
+#include "MonteCarlo.h"
 #include <mutex>
 #include <sstream>
 
+// The strategy fields of the /simulator form (everything but the
+// price series), shared by /simulator/run and /api/simulator/sweep.
+inline SimConfig simConfigFromForm(const std::map<std::string, std::string>& f,
+                                   const std::string& symbol)
+{
+    SimConfig cfg;
+    cfg.symbol           = symbol;
+    cfg.startingCapital  = fd(f, "capital");
+    cfg.entryRisk        = fd(f, "entryRisk", 0.5);
+    cfg.entrySteepness   = fd(f, "entrySteepness", 6.0);
+    cfg.entryRangeBelow  = fd(f, "rangeBelow");
+    cfg.entryRangeAbove  = fd(f, "rangeAbove");
+    cfg.exitRisk         = fd(f, "exitRisk", 0.5);
+    cfg.exitFraction     = fd(f, "exitFraction", 1.0);
+    cfg.exitSteepness    = fd(f, "exitSteepness", 4.0);
+    cfg.buyFeeRate       = fd(f, "buyFeeRate", 0.001);
+    cfg.sellFeeRate      = fd(f, "sellFeeRate", 0.001);
+
+    cfg.horizonParams.feeSpread              = fd(f, "feeSpread", 0.001);
+    cfg.horizonParams.feeHedgingCoefficient  = fd(f, "feeHedging", 1.0);
+    cfg.horizonParams.surplusRate             = fd(f, "surplusRate", 0.02);
+    cfg.horizonParams.symbolCount             = fi(f, "symbolCount", 1);
+    cfg.horizonParams.deltaTime               = fd(f, "deltaTime", 1.0);
+    cfg.horizonParams.coefficientK            = fd(f, "coefficientK");
+    cfg.horizonParams.maxRisk                 = fd(f, "maxRisk");
+    cfg.horizonParams.minRisk                 = fd(f, "minRisk");
+    cfg.entryLevels                           = fi(f, "entryLevels", 5);
+    cfg.exitLevels                            = fi(f, "exitLevels", 0);
+    cfg.horizonParams.horizonCount            = cfg.entryLevels;
+    cfg.horizonParams.portfolioPump           = cfg.startingCapital;
+    cfg.horizonParams.futureTradeCount        = fi(f, "futureTradeCount", 0);
+    cfg.horizonParams.stopLossFraction        = fd(f, "stopLossFraction", 1.0);
+    cfg.horizonParams.stopLossHedgeCount      = fi(f, "stopLossHedgeCount", 0);
+    cfg.downtrendCount                        = fi(f, "downtrendCount", 1);
+    cfg.chainCycles                             = (fv(f, "chainCycles") == "1");
+    cfg.savingsRate                             = fd(f, "savingsRate");
+    cfg.autoRange                               = (fv(f, "autoRange") == "1");
+    cfg.maxTradesPerMonth                       = fi(f, "maxTradesPerMonth", 0);
+    cfg.capitalPumpPerMonth                     = fd(f, "capitalPumpPerMonth", 0.0);
+    cfg.snapshotEvery                           = std::max(1, fi(f, "snapshotEvery", 1));
+    if (cfg.snapshotEvery > 1) cfg.snapshotPolicy = SnapshotPolicy::EveryN;   // thinner chart
+    return cfg;
+}
+
 inline void registerSimulatorRoutes(httplib::Server& svr, AppContext& ctx)
 {
     auto& db = ctx.defaultDb;
@@ -140,8 +187,7 @@ inline void registerSimulatorRoutes(httplib::Server& svr, AppContext& ctx)
         priceText << std::fixed << std::setprecision(8);
         for (const auto& sym : ps.symbols())
         {
-            const auto& pts = ps.data().at(sym);
-            for (const auto& pt : pts)
+            for (const auto& pt : ps.series(sym))
                 priceText << pt.timestamp << "," << pt.price << "\n";
         }
 
@@ -226,61 +272,11 @@ inline void registerSimulatorRoutes(httplib::Server& svr, AppContext& ctx)
         auto f = parseForm(req.body);
         std::string symbol = normalizeSymbol(fv(f, "symbol"));
 
-        SimConfig cfg;
-        cfg.symbol           = symbol;
-        cfg.startingCapital  = fd(f, "capital");
-        cfg.entryRisk        = fd(f, "entryRisk", 0.5);
-        cfg.entrySteepness   = fd(f, "entrySteepness", 6.0);
-        cfg.entryRangeBelow  = fd(f, "rangeBelow");
-        cfg.entryRangeAbove  = fd(f, "rangeAbove");
-        cfg.exitRisk         = fd(f, "exitRisk", 0.5);
-        cfg.exitFraction     = fd(f, "exitFraction", 1.0);
-        cfg.exitSteepness    = fd(f, "exitSteepness", 4.0);
-        cfg.buyFeeRate       = fd(f, "buyFeeRate", 0.001);
-        cfg.sellFeeRate      = fd(f, "sellFeeRate", 0.001);
-
-        cfg.horizonParams.feeSpread              = fd(f, "feeSpread", 0.001);
-        cfg.horizonParams.feeHedgingCoefficient  = fd(f, "feeHedging", 1.0);
-        cfg.horizonParams.surplusRate             = fd(f, "surplusRate", 0.02);
-        cfg.horizonParams.symbolCount             = fi(f, "symbolCount", 1);
-        cfg.horizonParams.deltaTime               = fd(f, "deltaTime", 1.0);
-        cfg.horizonParams.coefficientK            = fd(f, "coefficientK");
-        cfg.horizonParams.maxRisk                 = fd(f, "maxRisk");
-        cfg.horizonParams.minRisk                 = fd(f, "minRisk");
-        cfg.entryLevels                           = fi(f, "entryLevels", 5);
-        cfg.exitLevels                            = fi(f, "exitLevels", 0);
-        cfg.horizonParams.horizonCount            = cfg.entryLevels;
-        cfg.horizonParams.portfolioPump           = cfg.startingCapital;
-        cfg.horizonParams.futureTradeCount        = fi(f, "futureTradeCount", 0);
-        cfg.horizonParams.stopLossFraction        = fd(f, "stopLossFraction", 1.0);
-        cfg.horizonParams.stopLossHedgeCount      = fi(f, "stopLossHedgeCount", 0);
-        cfg.downtrendCount                        = fi(f, "downtrendCount", 1);
-        cfg.chainCycles                             = (fv(f, "chainCycles") == "1");
-        cfg.savingsRate                             = fd(f, "savingsRate");
-        cfg.autoRange                               = (fv(f, "autoRange") == "1");
+        SimConfig cfg = simConfigFromForm(f, symbol);
 
         // Parse price series into a local PriceSeries (SimConfig holds a pointer)
         PriceSeries localPrices;
-        std::string priceStr = fv(f, "priceSeries");
-        {
-            std::istringstream ss(priceStr);
-            std::string line;
-            while (std::getline(ss, line))
-            {
-                if (line.empty()) continue;
-                // strip CR
-                if (!line.empty() && line.back() == '\r') line.pop_back();
-                auto comma = line.find(',');
-                if (comma == std::string::npos) continue;
-                try
-                {
-                    long long ts = std::stoll(line.substr(0, comma));
-                    double px    = std::stod(line.substr(comma + 1));
-                    localPrices.set(symbol, ts, px);
-                }
-                catch (...) {}
-            }
-        }
+        PriceImport::importInto(localPrices, symbol, fv(f, "priceSeries"));
         cfg.prices = &localPrices;
 
         if (!localPrices.hasSymbol(symbol))
@@ -360,6 +356,9 @@ inline void registerSimulatorRoutes(httplib::Server& svr, AppContext& ctx)
               << (result.finalCapital + result.totalSavings) << "</div></div>"
                  "</div>";
         }
+        if (result.totalPumped > 0)
+            h << "<div class='msg'>Capital pump added " << result.totalPumped
+              << " over the run (" << cfg.capitalPumpPerMonth << " per month).</div>";
 
         // Trades table
         if (!result.trades.empty())
@@ -371,7 +370,7 @@ inline void registerSimulatorRoutes(httplib::Server& svr, AppContext& ctx)
             {
                 h << "<tr><td>" << t.id << "</td>"
                   << "<td>" << t.cycle << "</td>"
-                  << "<td>" << html::esc(t.symbol) << "</td>"
+                  << "<td>" << html::esc(SymbolRegistry::name(t.symbol)) << "</td>"
                   << "<td>" << t.entryPrice << "</td>"
                   << "<td>" << t.quantity << "</td>"
                   << "<td>" << t.buyFee << "</td>"
@@ -392,7 +391,7 @@ inline void registerSimulatorRoutes(httplib::Server& svr, AppContext& ctx)
             {
                 h << "<tr><td>" << s.buyId << "</td>"
                   << "<td>" << s.cycle << "</td>"
-                  << "<td>" << html::esc(s.symbol) << "</td>"
+                  << "<td>" << html::esc(SymbolRegistry::name(s.symbol)) << "</td>"
                   << "<td>" << s.entryPrice << "</td>"
                   << "<td>" << s.sellPrice << "</td>"
                   << "<td>" << s.quantity << "</td>"
@@ -452,7 +451,7 @@ inline void registerSimulatorRoutes(httplib::Server& svr, AppContext& ctx)
         // ============= INTERACTIVE CHARTS =============
         // Serialize data to JSON for the JavaScript charts
         {
-            const auto& pts = cfg.prices->data().at(symbol);
+            PriceSpan pts = cfg.prices->series(symbol);
 
             // Price series JSON
             h << "\n<script>\nvar simPrices=[";
@@ -899,4 +898,186 @@ resize();
              "<a class='btn' href='/'>Dashboard</a>";
         res.set_content(html::wrap("Simulation Results", h.str()), "text/html");
     });
+
+    // ========== POST /api/simulator/sweep  parameter grid search ==========
+    // The /simulator form fields give the template config and price
+    // series; `axes` lists the grid as name:lo:hi:steps entries
+    // separated by ';' (names as in ParamSweep::params()).  Rows are
+    // streamed in grid order as each batch completes, as CSV
+    // (format=csv) or as a JSON object whose "rows" are followed by
+    // the topK best by rankBy (finalCapital, realized, feeCoverage,
+    // cycles, wealth).
+    // rows=0 sends only the top list.
+    svr.Post("/api/simulator/sweep", [&](const httplib::Request& req, httplib::Response& res) {
+        auto f = parseForm(req.body);
+        std::string symbol = normalizeSymbol(fv(f, "symbol"));
+        auto fail = [&](const std::string& msg) {
+            res.status = 400;
+            res.set_content("{\"error\":\"" + msg + "\"}", "application/json");
+        };
+
+        auto prices = std::make_shared<PriceSeries>();
+        PriceImport::importInto(*prices, symbol, fv(f, "priceSeries"));
+        if (!prices->hasSymbol(symbol)) return fail("No valid price data entered");
+
+        SimConfig cfg = simConfigFromForm(f, symbol);
+        cfg.prices = prices.get();
+        if (cfg.startingCapital <= 0) return fail("Capital must be positive");
+
+        std::vector<ParamSweep::Axis> axes;
+        try
+        {
+            std::istringstream spec(fv(f, "axes"));
+            for (std::string item; std::getline(spec, item, ';'); )
+            {
+                if (item.find_first_not_of(" \t\r\n") == std::string::npos) continue;
+                std::istringstream in(item);
+                std::string name, lo, hi, steps;
+                std::getline(in, name, ':');
+                std::getline(in, lo, ':');
+                std::getline(in, hi, ':');
+                std::getline(in, steps);
+                name.erase(0, name.find_first_not_of(' '));
+                axes.push_back(ParamSweep::linspace(name, std::stod(lo),
+                    hi.empty() ? std::stod(lo) : std::stod(hi),
+                    steps.empty() ? 1 : std::stoi(steps)));
+            }
+        }
+        catch (const std::exception&)
+        {
+            return fail("axes must be name:lo:hi:steps entries separated by ';'");
+        }
+
+        ParamSweep::Options opt;
+        opt.topK = static_cast<std::size_t>(std::max(0, std::min(1000, fi(f, "topK", 10))));
+        std::string rank = fv(f, "rankBy", "finalCapital");
+        if (!ParamSweep::parseMetric(rank, opt.rankBy)) return fail("Unknown rankBy");
+
+        auto sweep = std::make_shared<ParamSweep::Sweep>(cfg, std::move(axes));
+        if (sweep->size() > 1000000) return fail("Grid is larger than 1000000 configs");
+        bool csv  = fv(f, "format") == "csv";
+        bool rows = fv(f, "rows", "1") != "0";
+
+        res.set_header("Access-Control-Allow-Origin", "*");
+        res.set_chunked_content_provider(csv ? "text/csv" : "application/json",
+            [sweep, prices, opt, csv, rows, rank](size_t, httplib::DataSink& sink) {
+            const auto& ax = sweep->axes();
+            auto emit = [&](const std::string& s) { return sink.write(s.data(), s.size()); };
+
+            if (csv) emit(ParamSweep::csvHeader(ax));
+            else
+            {
+                std::ostringstream hdr;
+                hdr << "{\"configs\":" << sweep->size() << ",\"rankBy\":\"" << rank << "\",\"axes\":[";
+                for (std::size_t k = 0; k < ax.size(); ++k)
+                    hdr << (k ? "," : "") << '"' << ax[k].param->name << '"';
+                hdr << "],\"rows\":[";
+                emit(hdr.str());
+            }
+
+            bool first = true;
+            std::function<bool(const ParamSweep::Row&)> onRow;
+            if (rows)
+                onRow = [&](const ParamSweep::Row& r) {
+                    bool ok = emit(csv ? ParamSweep::csvRow(r)
+                                       : (first ? "" : ",") + ParamSweep::jsonRow(ax, r));
+                    first = false;
+                    return ok;
+                };
+            ParamSweep::Summary sum = sweep->run(opt, onRow);
+
+            if (csv)
+            {
+                if (!rows)
+                    for (const auto& r : sum.top) emit(ParamSweep::csvRow(r));
+            }
+            else
+            {
+                std::ostringstream tail;
+                tail << "],\"top\":[";
+                for (std::size_t i = 0; i < sum.top.size(); ++i)
+                    tail << (i ? "," : "") << ParamSweep::jsonRow(ax, sum.top[i]);
+                tail << "],\"evaluated\":" << sum.evaluated
+                     << ",\"seconds\":" << sum.seconds
+                     << ",\"threads\":" << CpuBatchSim::Pool::instance().threads() << "}";
+                emit(tail.str());
+            }
+            sink.done();
+            return true;
+        });
+    });
+
+    // ========== POST /api/simulator/montecarlo  distributional backtest ==========
+    // The /simulator form fields give the strategy; model (gbm,
+    // bootstrap, regime), paths, steps, interval, startPrice, drift,
+    // vol, blockSize and seed shape the synthetic paths.  priceSeries,
+    // if given, is the history: bootstrap resamples its returns, and
+    // it supplies the start price and the Gbm drift and vol when those
+    // are left empty.  Paths are streamed in order as each batch
+    // completes ("rows", unless rows=0), then the summary.
+    svr.Post("/api/simulator/montecarlo", [&](const httplib::Request& req, httplib::Response& res) {
+        auto f = parseForm(req.body);
+        std::string symbol = normalizeSymbol(fv(f, "symbol"));
+        if (symbol.empty()) symbol = "MC";
+        auto fail = [&](const std::string& msg) {
+            res.status = 400;
+            res.set_content("{\"error\":\"" + msg + "\"}", "application/json");
+        };
+
+        SimConfig cfg = simConfigFromForm(f, symbol);
+        if (cfg.startingCapital <= 0) return fail("Capital must be positive");
+
+        MonteCarlo::PathConfig pc;
+        if (!MonteCarlo::parseModel(fv(f, "model", "gbm"), pc.model)) return fail("Unknown model");
+        pc.paths     = std::max(1, std::min(100000, fi(f, "paths", 1000)));
+        pc.steps     = std::max(2, std::min(1000000, fi(f, "steps", 365)));
+        pc.interval  = fi(f, "interval", 86400);
+        pc.blockSize = fi(f, "blockSize", 20);
+        pc.seed      = static_cast<std::uint64_t>(fi(f, "seed", 1));
+        {
+            PriceSeries hist;
+            PriceImport::importInto(hist, symbol, fv(f, "priceSeries"));
+            for (const PricePoint& pt : hist.series(symbol)) pc.history.push_back(pt.price);
+        }
+        bool fromHistory = !pc.history.empty();
+        pc.startPrice = fd(f, "startPrice", fromHistory ? 0.0 : 100.0);
+        pc.drift      = fd(f, "drift", 0.0);
+        pc.vol        = fd(f, "vol", fromHistory ? 0.0 : 0.02);
+        MonteCarlo::applyHistory(pc);
+        pc.regimes = MonteCarlo::calmAndCrash(pc.drift, pc.vol);
+
+        std::shared_ptr<MonteCarlo::Generator> gen;
+        try { gen = std::make_shared<MonteCarlo::Generator>(pc); }
+        catch (const std::exception& ex) { return fail(ex.what()); }
+        bool rows = fv(f, "rows", "1") != "0";
+
+        res.set_header("Access-Control-Allow-Origin", "*");
+        res.set_chunked_content_provider("application/json",
+            [cfg, gen, rows](size_t, httplib::DataSink& sink) {
+            auto emit = [&](const std::string& s) { return sink.write(s.data(), s.size()); };
+            const MonteCarlo::PathConfig& c = gen->config();
+            std::ostringstream hdr;
+            hdr << std::setprecision(17)
+                << "{\"model\":\"" << MonteCarlo::modelName(c.model) << "\""
+                << ",\"paths\":" << c.paths << ",\"steps\":" << c.steps
+                << ",\"startPrice\":" << c.startPrice
+                << ",\"drift\":" << c.drift << ",\"vol\":" << c.vol
+                << ",\"startingCapital\":" << cfg.startingCapital << ",\"rows\":[";
+            emit(hdr.str());
+
+            bool first = true;
+            std::function<bool(const MonteCarlo::PathResult&)> onPath;
+            if (rows)
+                onPath = [&](const MonteCarlo::PathResult& p) {
+                    bool ok = emit((first ? "" : ",") + MonteCarlo::jsonPath(p));
+                    first = false;
+                    return ok;
+                };
+            MonteCarlo::Summary sum = MonteCarlo::run(cfg, *gen, onPath);
+
+            emit("],\"summary\":" + MonteCarlo::jsonSummary(sum) + "}");
+            sink.done();
+            return true;
+        });
+    });
 }
@@ -1,8 +1,8 @@
 #pragma once
 
 #include "PriceSeries.h"
+#include "TickCodec.h"
 #include "SymbolRegistry.h"
-#include "IdGenerator.h"
 #include "Trade.h"
 #include "ProfitCalculator.h"
 #include "MultiHorizonEngine.h"
@@ -13,7 +13,11 @@
 #include <string>
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <ctime>
+#include <stdexcept>
+#include <type_traits>
 
 // ============================================================
 //  Simulator  forward simulation and historical backtesting
@@ -31,6 +35,30 @@
 //   The engine walks forward through the historical window,
 //   executing the same entry/exit logic.
 //
+// Portfolio mode:
+//   runPortfolio() steps several symbols' series, merged in time
+//   order, against one shared capital pool.  Each symbol chains its
+//   own cycles; results come back per symbol and in aggregate.
+//
+// Checkpoints:
+//   A Checkpoint is a single-symbol run paused after its last tick:
+//   capital, month clock, the current cycle's entry levels, every
+//   position with its exit plan, the hedge pool and the result so
+//   far.  advance() steps it over ticks it hasn't seen, so a live
+//   series extends in O(new ticks), and result() of a kept one
+//   costs one copy of the result; copying one forks a what-if
+//   branch without re-simulating.  save() / load() turn it into
+//   bytes and back.  Resuming reproduces run() exactly.
+//
+// Allocation:
+//   A run through an Arena borrows its buffers (the result's
+//   vectors, positions, exit plans, queues) and hands them back
+//   with their capacity, so a caller running config after config -
+//   an optimizer, a sweep - stops allocating once the arena has
+//   grown to fit.  Per-fill records name their symbol by SymbolId,
+//   and SimConfig::snapshotPolicy thins the per-tick snapshots (or
+//   drops them) when nobody draws the curve.
+//
 // Fee hedging verification:
 //   After a run, compare totalFees vs feeHedgingAmount to see
 //   whether the overhead formula covered all costs.
@@ -40,7 +68,7 @@ struct SimTrade
 {
     int         id          = 0;
     int         cycle       = 0;       // chain cycle this entry belongs to
-    std::string symbol;
+    SymbolId    symbol      = kNoSymbol;   // SymbolRegistry::name() for the string
     double      entryPrice  = 0.0;
     double      quantity    = 0.0;
     double      buyFee      = 0.0;
@@ -52,7 +80,7 @@ struct SimSell
 {
     int         buyId       = 0;
     int         cycle       = 0;
-    std::string symbol;
+    SymbolId    symbol      = kNoSymbol;
     double      entryPrice  = 0.0;
     double      sellPrice   = 0.0;
     double      quantity    = 0.0;
@@ -69,14 +97,27 @@ struct SimSnapshot
     double      deployed    = 0.0;
     double      realized    = 0.0;
     double      totalFees   = 0.0;
+    double      savings     = 0.0;
     int         openTrades  = 0;
 };
 
+// Which ticks of a run get a SimSnapshot.  Whatever the policy
+// (short of None), the last tick gets one, so the curve ends where
+// the run did.
+enum class SnapshotPolicy
+{
+    EveryTick,   // one per tick (the default)
+    EveryN,      // ticks 0, N, 2N, ... (SimConfig::snapshotEvery)
+    OnChange,    // the first tick, then whenever a snapshot value moved
+    None         // no snapshots at all
+};
+
 struct SimConfig
 {
     double startingCapital  = 0.0;
-    std::string symbol;            // single-symbol for now
+    std::string symbol;            // see PortfolioConfig for several
     const PriceSeries* prices = nullptr;  // non-owning pointer (avoids deep copies)
+    const TickCodec::Series* ticks = nullptr;  // if set, streamed instead of prices
 
     // Entry parameters
     HorizonParams horizonParams;
@@ -105,6 +146,15 @@ struct SimConfig
 
     // Entry range mode
     bool   autoRange        = false;  // false = [0, price]; true = EO-adaptive band
+
+    // Trade frequency & capital pump, per calendar month of the
+    // timestamps (see Simulator::MonthClock)
+    int    maxTradesPerMonth   = 0;     // entry fills per month; 0 = unlimited
+    double capitalPumpPerMonth = 0.0;   // added at each month rollover; 0 = disabled
+
+    // Snapshot density (see SnapshotPolicy)
+    SnapshotPolicy snapshotPolicy = SnapshotPolicy::EveryTick;
+    int            snapshotEvery  = 1;   // EveryN: the interval in ticks
 };
 
 // An entry level generated by the simulator (whether filled or not)
@@ -143,19 +193,41 @@ struct SimResult
     // Chain mode stats
     int    cyclesCompleted   = 0;
     double totalSavings      = 0.0;  // cumulative profit diverted to savings
+
+    double totalPumped       = 0.0;  // capital added by capitalPumpPerMonth
+};
+
+// A portfolio backtest: every symbol runs the `base` strategy from one
+// shared capital pool (see Simulator::runPortfolio).
+struct PortfolioConfig
+{
+    SimConfig                base;      // prices, starting capital, strategy; symbol/ticks unused
+    std::vector<std::string> symbols;
+    bool symbolSnapshots = false;       // per-symbol snapshots over that symbol's ticks,
+                                        // thinned by base.snapshotPolicy like the total
+};
+
+struct PortfolioResult
+{
+    SimResult              total;       // all symbols; snapshots per distinct timestamp
+    std::vector<SimResult> symbols;     // in PortfolioConfig::symbols order; capital
+                                        // fields are the shared pool's
 };
 
 class Simulator
 {
     static constexpr double EPS = 1e-15;
 
-    // Per-trade state: the open position + its pre-computed exit plan
+public:
+    // Per-trade state: the open position + where its pre-computed exit
+    // plan sits in the lane's exit buffer (one plan after another, in
+    // fill order, so a fill allocates no vector of its own)
     struct OpenPosition
     {
-        SimTrade            trade;
-        int                 cycle = 0;
-        std::vector<ExitLevel> exits;       // pre-computed once at entry
-        std::vector<bool>      exitFilled;  // which levels have executed
+        SimTrade    trade;
+        int         cycle     = 0;
+        std::size_t exitBegin = 0;   // first of its levels in the buffer
+        std::size_t exitCount = 0;
     };
 
     // Helper: generate entry levels for a given price and capital
@@ -166,117 +238,694 @@ class Simulator
         double                  referencePrice = 0.0;  // price at generation time
     };
 
-    static CycleEntries generateCycleEntries(double price, double capital,
-                                             const SimConfig& cfg)
+private:
+    // Fills `ce` in place, so its vectors keep their capacity from
+    // one cycle to the next.
+    static void generateCycleEntries(CycleEntries& ce, double price, double capital,
+                                     const SimConfig& cfg)
     {
-        CycleEntries ce;
         ce.referencePrice = price;
         HorizonParams ep = cfg.horizonParams;
         ep.portfolioPump = capital;
         if (cfg.entryLevels > 0)
             ep.horizonCount = cfg.entryLevels;
 
-        ce.levels = MarketEntryCalculator::generate(
-            price, 1.0, ep,
+        MarketEntryCalculator::generateInto(
+            ce.levels, price, 1.0, ep,
             cfg.entryRisk, cfg.entrySteepness,
             cfg.entryRangeAbove, cfg.entryRangeBelow,
             cfg.autoRange);
 
         double minEntry = price * 0.01;
-        std::erase_if(ce.levels, [minEntry](const EntryLevel& el) {
-            return el.entryPrice < minEntry;
-        });
+        ce.levels.erase(std::remove_if(ce.levels.begin(), ce.levels.end(),
+            [minEntry](const EntryLevel& el) { return el.entryPrice < minEntry; }),
+            ce.levels.end());
 
         ce.filled.assign(ce.levels.size(), false);
-        return ce;
     }
 
-public:
-    // Run a forward simulation stepping through the price series.
-    static SimResult run(const SimConfig& cfg)
+    // Point source over a PriceSpan, matching TickCodec::Cursor.
+    struct SpanCursor
     {
-        SimResult result;
-        if (!cfg.prices || !cfg.prices->hasSymbol(cfg.symbol)) return result;
+        PriceSpan   pts;
+        std::size_t i = 0;
+        bool next(PricePoint& out)
+        {
+            if (i == pts.size()) return false;
+            out = pts[i++];
+            return true;
+        }
+    };
 
-        const auto& pts = cfg.prices->data().at(cfg.symbol);
-        if (pts.empty()) return result;
+    // A vector of points as a PriceSpan over its interleaved fields.
+    static PriceSpan span(const std::vector<PricePoint>& v)
+    {
+        static_assert(sizeof(PricePoint) == 2 * sizeof(double) && sizeof(long long) == sizeof(double),
+                      "PricePoint must be two 8-byte fields");
+        return PriceSpan(&v[0].timestamp, &v[0].price, v.size(), 2);
+    }
 
-        double capital   = cfg.startingCapital;
-        double realized  = 0;
-        double totalFees = 0;
-        double hedgePool = 0;
-        double savings   = 0;
-        int    cycle     = 0;
-        IdGenerator idGen;
+    // k-way merge of per-symbol spans by timestamp, ties in span order:
+    // a binary min-heap of each span's next timestamp, sized once, so
+    // stepping allocates nothing and costs one sift per point.
+    class MergeCursor
+    {
+    public:
+        explicit MergeCursor(const std::vector<PriceSpan>& spans)
+            : m_spans(spans), m_pos(spans.size(), 0)
+        {
+            m_heap.reserve(spans.size());
+            for (std::size_t i = 0; i < spans.size(); ++i)
+                if (!spans[i].empty()) m_heap.push_back({ spans[i].timestamp(0), i });
+            std::make_heap(m_heap.begin(), m_heap.end(), Later{});
+        }
 
-        std::vector<OpenPosition> positions;
+        bool done() const { return m_heap.empty(); }
+        long long nextTime() const { return m_heap.front().time; }
 
-        // Helper: record all entry levels from a CycleEntries into the result
-        auto recordEntryLevels = [&](const CycleEntries& entries, int cyc, long long ts) {
-            for (size_t i = 0; i < entries.levels.size(); ++i)
+        bool next(std::size_t& lane, PricePoint& out)
+        {
+            if (m_heap.empty()) return false;
+            Head& top = m_heap.front();
+            lane = top.lane;
+            std::size_t i = m_pos[lane]++;
+            out = { top.time, m_spans[lane].price(i) };
+            if (i + 1 < m_spans[lane].size())
+                top.time = m_spans[lane].timestamp(i + 1);
+            else
             {
-                SimEntryLevel sel;
-                sel.cycle       = cyc;
-                sel.levelIndex  = static_cast<int>(i);
-                sel.entryPrice  = entries.levels[i].entryPrice;
-                sel.funding     = entries.levels[i].funding;
-                sel.generatedAt = ts;
-                sel.filled      = false;
-                sel.filledAt    = 0;
-                result.entryLevels.push_back(sel);
+                top = m_heap.back();
+                m_heap.pop_back();
+                if (m_heap.empty()) return true;
+            }
+            siftDown();
+            return true;
+        }
+
+    private:
+        struct Head
+        {
+            long long   time;
+            std::size_t lane;
+        };
+
+        struct Later
+        {
+            bool operator()(const Head& a, const Head& b) const
+            {
+                return (a.time > b.time) | ((a.time == b.time) & (a.lane > b.lane));
             }
         };
 
-        // Generate initial entry levels (cycle 0)
-        double firstPrice = pts.front().price;
-        auto ce = generateCycleEntries(firstPrice, capital, cfg);
-        recordEntryLevels(ce, 0, pts.front().timestamp);
+        void siftDown()
+        {
+            const std::size_t n = m_heap.size();
+            std::size_t i = 0;
+            Head h = m_heap[0];
+            for (;;)
+            {
+                std::size_t c = 2 * i + 1;
+                if (c >= n) break;
+                if (c + 1 < n) c += Later{}(m_heap[c], m_heap[c + 1]);
+                if (!Later{}(h, m_heap[c])) break;
+                m_heap[i] = m_heap[c];
+                i = c;
+            }
+            m_heap[i] = h;
+        }
+
+        const std::vector<PriceSpan>& m_spans;
+        std::vector<std::size_t>      m_pos;
+        std::vector<Head>             m_heap;
+    };
+
+    // Calendar months of one capital pool, counted as batchSimKernel
+    // counts them: month = timestamp / 2629746 s (365.25 * 86400 / 12),
+    // and no month at all for timestamps <= 0.  Every rollover after
+    // the first adds capitalPumpPerMonth to the pool and reopens the
+    // quota of maxTradesPerMonth entry fills.
+    struct MonthClock
+    {
+        static constexpr double kSecsPerMonth = 2629746.0;
+
+        int    month  = -1;
+        int    trades = 0;     // entry fills this month
+        double pumped = 0.0;
+
+        // Called ahead of the lanes' step at every tick.
+        void tick(long long ts, const SimConfig& cfg, double& capital)
+        {
+            int m = ts > 0 ? static_cast<int>(static_cast<double>(ts) / kSecsPerMonth) : -1;
+            if (m == month || m < 0) return;
+            if (month >= 0 && cfg.capitalPumpPerMonth > 0.0)
+            {
+                capital += cfg.capitalPumpPerMonth;
+                pumped  += cfg.capitalPumpPerMonth;
+            }
+            month  = m;
+            trades = 0;
+        }
+
+        bool quotaFull(const SimConfig& cfg) const
+        {
+            return cfg.maxTradesPerMonth > 0 && trades >= cfg.maxTradesPerMonth;
+        }
+    };
+
+    // Trade ids of one capital pool.  A run never gives an id back,
+    // so the lowest free id (what IdGenerator would hand out) is
+    // always the next one.
+    struct TradeIds
+    {
+        int next = 1;
+        int issue() { return next++; }
+    };
+
+    // SimConfig::snapshotPolicy over one run's ticks, offered in order.
+    struct SnapshotGate
+    {
+        long long   ticks = 0;       // ticks offered so far
+        bool        kept  = false;   // whether the latest one was kept
+        SimSnapshot last;            // the latest kept (for OnChange)
+
+        bool keep(const SimConfig& cfg, const SimSnapshot& s)
+        {
+            switch (cfg.snapshotPolicy)
+            {
+                case SnapshotPolicy::EveryTick: kept = true; break;
+                case SnapshotPolicy::EveryN:    kept = ticks % std::max(1, cfg.snapshotEvery) == 0; break;
+                case SnapshotPolicy::OnChange:  kept = ticks == 0 || moved(s); break;
+                case SnapshotPolicy::None:      kept = false; break;
+            }
+            ++ticks;
+            if (kept) last = s;
+            return kept;
+        }
+
+        // Whether the run's last tick still owes its snapshot.
+        bool owesLast(const SimConfig& cfg) const
+        {
+            return cfg.snapshotPolicy != SnapshotPolicy::None && ticks > 0 && !kept;
+        }
+
+        bool moved(const SimSnapshot& s) const
+        {
+            return s.capital != last.capital || s.deployed != last.deployed
+                || s.realized != last.realized || s.totalFees != last.totalFees
+                || s.savings != last.savings || s.openTrades != last.openTrades;
+        }
+    };
+
+    // A pending trigger: an entry level of the current cycle (pos
+    // unused) or one exit level of an open position.
+    struct Pending
+    {
+        double      price = 0.0;
+        std::size_t pos   = 0;
+        std::size_t level = 0;
+
+        bool operator<(const Pending& o) const
+        {
+            return pos != o.pos ? pos < o.pos : level < o.level;
+        }
+    };
+
+    // Unfilled entry levels of the current cycle.  Limit buys (at or
+    // below the reference price) sit in a max-heap and breakout buys
+    // in a min-heap, so the levels a tick crosses are popped off the
+    // tops.  A NaN entry price compares false against every tick, so
+    // it is crossed on each one and kept aside.
+    class EntryQueue
+    {
+    public:
+        void reset(const CycleEntries& ce)
+        {
+            m_ref = ce.referencePrice;
+            m_limit.clear();
+            m_breakout.clear();
+            m_always.clear();
+            for (std::size_t i = 0; i < ce.levels.size(); ++i)
+                if (!(ce.levels[i].fundingQty < EPS))   // else it can never fill
+                    restore({ ce.levels[i].entryPrice, 0, i });
+        }
+
+        // Remove the levels crossed at `price` into `out`, in level order.
+        void crossed(double price, std::vector<Pending>& out)
+        {
+            out.clear();
+            while (!m_limit.empty() && !(price >= m_limit.front().price))
+            {
+                std::pop_heap(m_limit.begin(), m_limit.end(), Below{});
+                out.push_back(m_limit.back());
+                m_limit.pop_back();
+            }
+            while (!m_breakout.empty() && !(price <= m_breakout.front().price))
+            {
+                std::pop_heap(m_breakout.begin(), m_breakout.end(), Above{});
+                out.push_back(m_breakout.back());
+                m_breakout.pop_back();
+            }
+            out.insert(out.end(), m_always.begin(), m_always.end());
+            m_always.clear();
+            if (out.size() > 1) std::sort(out.begin(), out.end());
+        }
+
+        // File (or re-file, when it was crossed but not affordable) a level.
+        void restore(const Pending& p)
+        {
+            if (std::isnan(p.price))
+                m_always.push_back(p);
+            else if (p.price <= m_ref)
+            {
+                m_limit.push_back(p);
+                std::push_heap(m_limit.begin(), m_limit.end(), Below{});
+            }
+            else
+            {
+                m_breakout.push_back(p);
+                std::push_heap(m_breakout.begin(), m_breakout.end(), Above{});
+            }
+        }
+
+        // Checkpoint I/O: the heaps are kept as they are.
+        template <typename A>
+        void visit(A& a) { a(m_ref); a(m_limit); a(m_breakout); a(m_always); }
+
+    private:
+        struct Below { bool operator()(const Pending& a, const Pending& b) const { return a.price < b.price; } };
+        struct Above { bool operator()(const Pending& a, const Pending& b) const { return a.price > b.price; } };
+
+        double               m_ref = 0.0;
+        std::vector<Pending> m_limit;      // max-heap by price
+        std::vector<Pending> m_breakout;   // min-heap by price
+        std::vector<Pending> m_always;
+    };
+
+    // Unfilled exit levels of every position in one min-heap by TP
+    // price.  A crossed level either sells or belongs to a position
+    // that is already closed, so nothing popped is filed again.
+    class ExitQueue
+    {
+    public:
+        void add(const Pending& p)
+        {
+            if (std::isnan(p.price)) { m_always.push_back(p); return; }
+            m_heap.push_back(p);
+            std::push_heap(m_heap.begin(), m_heap.end(), Above{});
+        }
+
+        // Remove the levels crossed at `price` into `out`, in
+        // (position, level) order.
+        void crossed(double price, std::vector<Pending>& out)
+        {
+            out.clear();
+            while (!m_heap.empty() && !(price < m_heap.front().price))
+            {
+                std::pop_heap(m_heap.begin(), m_heap.end(), Above{});
+                out.push_back(m_heap.back());
+                m_heap.pop_back();
+            }
+            out.insert(out.end(), m_always.begin(), m_always.end());
+            m_always.clear();
+            if (out.size() > 1) std::sort(out.begin(), out.end());
+        }
+
+        void clear()
+        {
+            m_heap.clear();
+            m_always.clear();
+        }
+
+        template <typename A>
+        void visit(A& a) { a(m_heap); a(m_always); }
+
+    private:
+        struct Above { bool operator()(const Pending& a, const Pending& b) const { return a.price > b.price; } };
+
+        std::vector<Pending> m_heap;   // min-heap by TP price
+        std::vector<Pending> m_always;
+    };
+
+public:
+    // Buffers for run(cfg, arena), one arena per thread.  A run borrows
+    // them emptied and gives them back still sized, so once an arena
+    // has seen a run as busy as the next one, that run allocates
+    // nothing (TickCodec sources aside: their cursor decodes into a
+    // block buffer of its own).
+    struct Arena
+    {
+        SimResult result;                       // the latest run's
+
+        // Lane scratch, lent out for the length of a run
+        CycleEntries              entries;
+        std::vector<OpenPosition> positions;
+        std::vector<ExitLevel>    exits;
+        std::vector<std::size_t>  open;
+        EntryQueue                entryQueue;
+        ExitQueue                 exitQueue;
+        std::vector<Pending>      hits;
+    };
+
+    // A single-symbol run paused after its last tick (see Checkpoints
+    // at the top).  The lane fields are Lane's own; the queues hold
+    // the levels still waiting to trigger.
+    struct Checkpoint
+    {
+        SimConfig   config;             // prices and ticks are not kept
+        bool        started  = false;   // false until the first tick
+        long long   lastTime = 0;       // timestamp of the last tick stepped
+        double      capital  = 0.0;
+        MonthClock  clock;
+        TradeIds    ids;
+
+        SimResult                 result;        // so far; result() closes the books
+        double                    realized  = 0.0;
+        double                    totalFees = 0.0;
+        double                    hedgePool = 0.0;
+        double                    savings   = 0.0;
+        int                       cycle     = 0;
+        CycleEntries              entries;       // the current cycle's levels
+        std::vector<OpenPosition> positions;     // every position, in fill order
+        std::vector<ExitLevel>    exits;         // their exit plans, back to back
+        std::vector<std::size_t>  open;          // positions with quantity left
+        EntryQueue                entryQueue;
+        ExitQueue                 exitQueue;
+        std::size_t               cycleLevels    = 0;
+        bool                      cycleFilled    = false;
+        int                       cyclePositions = 0;
+        int                       cycleOpen      = 0;
+        double                    cycleProfit    = 0.0;
+        double                    deployed       = 0.0;
+        int                       openCount      = 0;
+        SnapshotGate              snapshots;     // where snapshotPolicy stands
+
+        // Host byte order, as in TickStore: magic "QSIMCK01", u32 byte
+        // order, u32 version, then every field above.  Symbols go by
+        // name and are interned again on load.
+        std::string save() const
+        {
+            Save out;
+            out.bytes.assign(kCheckpointMagic, 8);
+            out(kCheckpointByteOrder);
+            out(kCheckpointVersion);
+            io(out, const_cast<Checkpoint&>(*this));
+            return std::move(out.bytes);
+        }
+
+        static Checkpoint load(const std::string& bytes)
+        {
+            if (bytes.size() < 8 || std::memcmp(bytes.data(), kCheckpointMagic, 8) != 0)
+                throw std::runtime_error("Not a simulator checkpoint");
+            Load in{ bytes, 8 };
+            std::uint32_t order = 0, version = 0;
+            in(order);
+            in(version);
+            if (order != kCheckpointByteOrder)
+                throw std::runtime_error("Simulator checkpoint has a foreign byte order");
+            if (version != kCheckpointVersion)
+                throw std::runtime_error("Unsupported simulator checkpoint version "
+                                         + std::to_string(version));
+            Checkpoint cp;
+            io(in, cp);
+            if (in.at != bytes.size()) throw std::runtime_error("Corrupt simulator checkpoint");
+            return cp;
+        }
+    };
+
+private:
+    static constexpr char          kCheckpointMagic[9]  = "QSIMCK01";
+    static constexpr std::uint32_t kCheckpointByteOrder = 0x01020304u;
+    static constexpr std::uint32_t kCheckpointVersion   = 2;
+
+    // Checkpoint bytes.  Scalars and enums are copied as they sit in
+    // memory (sizes as u64, bools as one byte), strings and vectors as
+    // a u64 count and then their elements, SymbolIds as their name.
+    // Save and Load walk the same io() field lists, so the two
+    // directions can't drift apart.
+    struct Save
+    {
+        std::string bytes;
+
+        template <typename T>
+        void operator()(const T& v)
+        {
+            if constexpr (std::is_same_v<T, std::size_t>) raw(static_cast<std::uint64_t>(v));
+            else if constexpr (std::is_same_v<T, bool>)   raw(static_cast<char>(v));
+            else if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) raw(v);
+            else io(*this, const_cast<T&>(v));
+        }
+        void symbol(SymbolId id) { (*this)(SymbolRegistry::name(id)); }
+        void operator()(const std::string& v)
+        {
+            (*this)(v.size());
+            bytes += v;
+        }
+        void operator()(const std::vector<bool>& v)
+        {
+            (*this)(v.size());
+            for (bool b : v) raw(static_cast<char>(b));
+        }
+        template <typename T>
+        void operator()(const std::vector<T>& v)
+        {
+            (*this)(v.size());
+            for (const T& x : v) (*this)(x);
+        }
+
+        template <typename T>
+        void raw(T v) { bytes.append(reinterpret_cast<const char*>(&v), sizeof v); }
+    };
+
+    struct Load
+    {
+        const std::string& bytes;
+        std::size_t        at = 0;
+
+        template <typename T>
+        void operator()(T& v)
+        {
+            if constexpr (std::is_same_v<T, std::size_t>)
+            {
+                std::uint64_t u = 0;
+                raw(u);
+                v = static_cast<std::size_t>(u);
+            }
+            else if constexpr (std::is_same_v<T, bool>)
+            {
+                char b = 0;
+                raw(b);
+                v = b != 0;
+            }
+            else if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) raw(v);
+            else io(*this, v);
+        }
+        void symbol(SymbolId& id)
+        {
+            std::string name;
+            (*this)(name);
+            id = name.empty() ? kNoSymbol : SymbolRegistry::intern(name);
+        }
+        void operator()(std::string& v)
+        {
+            std::size_t n = count();
+            v.assign(bytes, at, n);
+            at += n;
+        }
+        void operator()(std::vector<bool>& v)
+        {
+            v.assign(count(), false);
+            for (std::size_t i = 0; i < v.size(); ++i)
+            {
+                char b = 0;
+                raw(b);
+                v[i] = b != 0;
+            }
+        }
+        template <typename T>
+        void operator()(std::vector<T>& v)
+        {
+            v.resize(count());
+            for (T& x : v) (*this)(x);
+        }
+
+        // Every element takes at least a byte, so a count past the
+        // end means the bytes are corrupt (and saves a huge resize).
+        std::size_t count()
+        {
+            std::size_t n = 0;
+            (*this)(n);
+            if (n > bytes.size() - at) throw std::runtime_error("Corrupt simulator checkpoint");
+            return n;
+        }
+
+        template <typename T>
+        void raw(T& v)
+        {
+            if (bytes.size() - at < sizeof v) throw std::runtime_error("Truncated simulator checkpoint");
+            std::memcpy(&v, bytes.data() + at, sizeof v);
+            at += sizeof v;
+        }
+    };
+
+    template <typename A> static void io(A& a, HorizonParams& h)
+    {
+        a(h.feeHedgingCoefficient); a(h.portfolioPump);     a(h.symbolCount);
+        a(h.coefficientK);          a(h.feeSpread);         a(h.deltaTime);
+        a(h.surplusRate);           a(h.horizonCount);      a(h.generateStopLosses);
+        a(h.allowShortTrades);      a(h.maxRisk);           a(h.minRisk);
+        a(h.futureTradeCount);      a(h.stopLossFraction);  a(h.stopLossHedgeCount);
+    }
+
+    template <typename A> static void io(A& a, SimConfig& c)
+    {
+        a(c.startingCapital); a(c.symbol);        a(c.horizonParams);
+        a(c.entryLevels);     a(c.exitLevels);    a(c.entryRisk);       a(c.entrySteepness);
+        a(c.entryRangeBelow); a(c.entryRangeAbove);
+        a(c.exitRisk);        a(c.exitFraction);  a(c.exitSteepness);
+        a(c.buyFeeRate);      a(c.sellFeeRate);   a(c.downtrendCount);
+        a(c.chainCycles);     a(c.savingsRate);   a(c.autoRange);
+        a(c.maxTradesPerMonth); a(c.capitalPumpPerMonth);
+        a(c.snapshotPolicy);  a(c.snapshotEvery);
+    }
+
+    template <typename A> static void io(A& a, SimTrade& t)
+    {
+        a(t.id); a(t.cycle); a.symbol(t.symbol); a(t.entryPrice); a(t.quantity);
+        a(t.buyFee); a(t.remaining); a(t.entryTime);
+    }
+
+    template <typename A> static void io(A& a, SimSell& s)
+    {
+        a(s.buyId); a(s.cycle); a.symbol(s.symbol); a(s.entryPrice); a(s.sellPrice);
+        a(s.quantity); a(s.sellFee); a(s.grossProfit); a(s.netProfit); a(s.sellTime);
+    }
+
+    template <typename A> static void io(A& a, SimSnapshot& s)
+    {
+        a(s.timestamp); a(s.capital); a(s.deployed); a(s.realized);
+        a(s.totalFees); a(s.savings); a(s.openTrades);
+    }
+
+    template <typename A> static void io(A& a, SimEntryLevel& l)
+    {
+        a(l.cycle); a(l.levelIndex); a(l.entryPrice); a(l.funding);
+        a(l.generatedAt); a(l.filled); a(l.filledAt);
+    }
+
+    template <typename A> static void io(A& a, SimResult& r)
+    {
+        a(r.finalCapital);     a(r.totalRealized);      a(r.totalFees);
+        a(r.totalBuyFees);     a(r.totalSellFees);      a(r.feeHedgingAmount);
+        a(r.feeHedgingCoverage); a(r.tradesOpened);     a(r.tradesClosed);
+        a(r.wins);             a(r.losses);             a(r.bestTrade);
+        a(r.worstTrade);       a(r.trades);             a(r.sells);
+        a(r.snapshots);        a(r.entryLevels);        a(r.cyclesCompleted);
+        a(r.totalSavings);     a(r.totalPumped);
+    }
+
+    template <typename A> static void io(A& a, EntryLevel& l)
+    {
+        a(l.index); a(l.entryPrice); a(l.breakEven); a(l.costCoverage);
+        a(l.potentialNet); a(l.funding); a(l.fundingFraction); a(l.fundingQty);
+    }
+
+    template <typename A> static void io(A& a, ExitLevel& l)
+    {
+        a(l.index); a(l.tpPrice); a(l.sellQty); a(l.sellFraction); a(l.sellValue);
+        a(l.grossProfit); a(l.cumSold); a(l.levelBuyFee); a(l.levelSellFee);
+        a(l.netProfit); a(l.cumNetProfit);
+    }
+
+    template <typename A> static void io(A& a, CycleEntries& ce)   { a(ce.levels); a(ce.filled); a(ce.referencePrice); }
+    template <typename A> static void io(A& a, OpenPosition& p)    { a(p.trade); a(p.cycle); a(p.exitBegin); a(p.exitCount); }
+    template <typename A> static void io(A& a, Pending& p)         { a(p.price); a(p.pos); a(p.level); }
+    template <typename A> static void io(A& a, MonthClock& c)      { a(c.month); a(c.trades); a(c.pumped); }
+    template <typename A> static void io(A& a, TradeIds& ids)      { a(ids.next); }
+    template <typename A> static void io(A& a, SnapshotGate& g)    { a(g.ticks); a(g.kept); a(g.last); }
+    template <typename A> static void io(A& a, EntryQueue& q)      { q.visit(a); }
+    template <typename A> static void io(A& a, ExitQueue& q)       { q.visit(a); }
+
+    template <typename A> static void io(A& a, Checkpoint& cp)
+    {
+        a(cp.config);         a(cp.started);        a(cp.lastTime);      a(cp.capital);
+        a(cp.clock);          a(cp.ids);            a(cp.result);        a(cp.realized);
+        a(cp.totalFees);      a(cp.hedgePool);      a(cp.savings);       a(cp.cycle);
+        a(cp.entries);        a(cp.positions);      a(cp.exits);         a(cp.open);
+        a(cp.entryQueue);     a(cp.exitQueue);      a(cp.cycleLevels);   a(cp.cycleFilled);
+        a(cp.cyclePositions); a(cp.cycleOpen);      a(cp.cycleProfit);   a(cp.deployed);
+        a(cp.openCount);      a(cp.snapshots);
+    }
+
+    // One symbol's simulation: its entry cycles, open positions and
+    // result, stepped tick by tick against a capital pool that other
+    // lanes may share.
+    //
+    // Entry and exit levels wait in EntryQueue / ExitQueue, so a tick
+    // costs O(log n) per level it crosses instead of a scan of every
+    // level of every position.  Crossed levels are still processed in
+    // the order the full scan visited them (entry levels by index,
+    // exits by position then level), which keeps capital, fills and
+    // every floating-point sum identical to it.
+    class Lane
+    {
+    public:
+        // Cycles are planned with capital / `planShares` of the pool;
+        // `ids` and `clock` are the pool's, shared by all of its lanes.
+        // cfg must outlive the lane.
+        Lane(const SimConfig& cfg, TradeIds& ids, MonthClock& clock, int planShares = 1)
+            : m_cfg(cfg), m_ids(ids), m_clock(clock), m_shares(planShares),
+              m_symbol(SymbolRegistry::intern(cfg.symbol)) {}
+
+        // Plan cycle 0 at the first tick.
+        void start(const PricePoint& pt, double capital)
+        {
+            generateCycleEntries(m_ce, pt.price, capital / m_shares, m_cfg);
+            recordEntryLevels(m_ce, 0, pt.timestamp);
+        }
 
-        for (size_t pi = 0; pi < pts.size(); ++pi)
+        // Fill entries, sell exits and roll the chain at one tick.
+        // True if a position opened or sold.
+        bool step(const PricePoint& pt, double& capital)
         {
-            long long now   = pts[pi].timestamp;
-            double    price = pts[pi].price;
+            const SimConfig& cfg = m_cfg;
+            SimResult& result = m_result;
+            long long now   = pt.timestamp;
+            double    price = pt.price;
+            bool      changed = false;
 
             // --- Check entries ---
             // Limit buys (at or below reference): fill when price drops below entry.
             // Breakout buys (above reference): fill when price rises above entry.
-            for (size_t ei = 0; ei < ce.levels.size(); ++ei)
+            // Once the month's quota is used up, crossed levels wait.
+            if (m_clock.quotaFull(cfg)) m_hits.clear();
+            else                        m_entryQueue.crossed(price, m_hits);
+            for (const Pending& hit : m_hits)
             {
-                if (ce.filled[ei]) continue;
+                if (m_clock.quotaFull(cfg)) { m_entryQueue.restore(hit); continue; }
 
-                bool belowRef = (ce.levels[ei].entryPrice <= ce.referencePrice);
-                if (belowRef) {
-                    if (price >= ce.levels[ei].entryPrice) continue;  // limit: wait for drop
-                } else {
-                    if (price <= ce.levels[ei].entryPrice) continue;  // breakout: wait for rise
-                }
-
-                double qty   = ce.levels[ei].fundingQty;
-                if (qty < EPS) continue;
-                double entryCost = QuantMath::cost(ce.levels[ei].entryPrice, qty);
+                std::size_t ei = hit.level;
+                double qty   = m_ce.levels[ei].fundingQty;
+                double entryCost = QuantMath::cost(m_ce.levels[ei].entryPrice, qty);
                 double fee   = QuantMath::feeFromRate(entryCost, cfg.buyFeeRate);
 
-                if (entryCost + fee > capital) continue;
-
-                int tid = idGen.acquire();
-                idGen.commit(tid);
+                if (entryCost + fee > capital) { m_entryQueue.restore(hit); continue; }
 
                 SimTrade st;
-                st.id         = tid;
-                st.cycle      = cycle;
-                st.symbol     = cfg.symbol;
-                st.entryPrice = ce.levels[ei].entryPrice;
+                st.id         = m_ids.issue();
+                st.cycle      = m_cycle;
+                st.symbol     = m_symbol;
+                st.entryPrice = m_ce.levels[ei].entryPrice;
                 st.quantity   = qty;
                 st.buyFee     = fee;
                 st.remaining  = qty;
                 st.entryTime  = now;
 
-                capital   -= (entryCost + fee);
-                totalFees += fee;
+                capital     -= (entryCost + fee);
+                m_totalFees += fee;
+                m_clock.trades++;
 
                 // Pre-compute exit levels for this position ONCE
                 Trade tmpTrade;
-                tmpTrade.symbol   = st.symbol;
                 tmpTrade.type     = TradeType::Buy;
                 tmpTrade.value    = st.entryPrice;
                 tmpTrade.quantity = st.quantity;
@@ -289,14 +938,17 @@ public:
                 if (cfg.exitLevels > 0)
                     exitParams.horizonCount = cfg.exitLevels;
 
-                auto exitLevels = ExitStrategyCalculator::generate(
-                    tmpTrade, exitParams,
+                std::size_t exitBegin = m_exits.size();
+                ExitStrategyCalculator::appendTo(
+                    m_exits, tmpTrade, exitParams,
                     cfg.exitRisk, cfg.exitFraction, cfg.exitSteepness);
+                ExitLevel*  exitLevels = m_exits.data() + exitBegin;
+                std::size_t exitCount  = m_exits.size() - exitBegin;
 
                 // Fee hedging: the sum of gross profits from exit levels
                 // represents the overhead budget built into the TP targets
-                for (const auto& el : exitLevels)
-                    hedgePool += el.grossProfit;
+                for (std::size_t li = 0; li < exitCount; ++li)
+                    m_hedgePool += exitLevels[li].grossProfit;
 
                 // Apply downtrend buffer and SL hedge buffer to exit TP prices
                 {
@@ -323,171 +975,610 @@ public:
                     double combinedBuf = dtBuf * slBuf;
                     if (combinedBuf > 1.0)
                     {
-                        for (auto& el : exitLevels)
-                            el.tpPrice *= combinedBuf;
+                        for (std::size_t li = 0; li < exitCount; ++li)
+                            exitLevels[li].tpPrice *= combinedBuf;
                     }
                 }
 
+                std::size_t pi = m_positions.size();
+                for (std::size_t li = 0; li < exitCount; ++li)
+                    if (!(exitLevels[li].sellQty < EPS))   // else it never sells
+                        m_exitQueue.add({ exitLevels[li].tpPrice, pi, li });
+
                 OpenPosition pos;
-                pos.trade      = st;
-                pos.cycle      = cycle;
-                pos.exits      = std::move(exitLevels);
-                pos.exitFilled.assign(pos.exits.size(), false);
-                positions.push_back(std::move(pos));
+                pos.trade     = st;
+                pos.cycle     = m_cycle;
+                pos.exitBegin = exitBegin;
+                pos.exitCount = exitCount;
+                m_positions.push_back(pos);
+                m_open.push_back(pi);
 
                 result.trades.push_back(st);
                 result.tradesOpened++;
-                ce.filled[ei] = true;
+                m_ce.filled[ei] = true;
+                m_cycleFilled   = true;
+                m_cyclePositions++;
+                if (st.remaining > EPS) m_cycleOpen++;
+                changed = true;
 
                 // Mark the corresponding SimEntryLevel as filled
-                for (auto& sel : result.entryLevels)
-                {
-                    if (sel.cycle == cycle && sel.levelIndex == static_cast<int>(ei) && !sel.filled)
-                    {
-                        sel.filled   = true;
-                        sel.filledAt = now;
-                        break;
-                    }
-                }
+                SimEntryLevel& sel = result.entryLevels[m_cycleLevels + ei];
+                sel.filled   = true;
+                sel.filledAt = now;
             }
 
             // --- Check exits: sell when price rises to TP level ---
-            for (auto& pos : positions)
+            m_exitQueue.crossed(price, m_hits);
+            for (const Pending& hit : m_hits)
             {
+                OpenPosition& pos = m_positions[hit.pos];
                 if (pos.trade.remaining < EPS) continue;
 
-                for (size_t li = 0; li < pos.exits.size(); ++li)
+                const ExitLevel& el = m_exits[pos.exitBegin + hit.level];
+                double sellQty = std::min(el.sellQty, pos.trade.remaining);
+                if (sellQty < EPS) continue;
+
+                double sellFee = QuantMath::feeFromRate(QuantMath::cost(el.tpPrice, sellQty), cfg.sellFeeRate);
+                double gross   = QuantMath::grossProfit(pos.trade.entryPrice, el.tpPrice, sellQty);
+                double net     = QuantMath::netProfit(gross, 0.0, sellFee);
+
+                SimSell ss;
+                ss.buyId       = pos.trade.id;
+                ss.cycle       = pos.cycle;
+                ss.symbol      = pos.trade.symbol;
+                ss.entryPrice  = pos.trade.entryPrice;
+                ss.sellPrice   = el.tpPrice;
+                ss.quantity    = sellQty;
+                ss.sellFee     = sellFee;
+                ss.grossProfit = gross;
+                ss.netProfit   = net;
+                ss.sellTime    = now;
+
+                bool wasOpen = pos.trade.remaining > EPS;
+                pos.trade.remaining -= sellQty;
+                capital             += QuantMath::proceeds(el.tpPrice, sellQty, sellFee);
+                m_realized          += net;
+                m_totalFees         += sellFee;
+                if (pos.cycle == m_cycle)
                 {
-                    if (pos.exitFilled[li]) continue;
-
-                    const auto& el = pos.exits[li];
-                    if (el.sellQty < EPS) continue;
-                    if (price < el.tpPrice) continue;
-                    if (pos.trade.remaining < EPS) break;
-
-                    double sellQty = std::min(el.sellQty, pos.trade.remaining);
-                    if (sellQty < EPS) { pos.exitFilled[li] = true; continue; }
-
-                    double sellFee = QuantMath::feeFromRate(QuantMath::cost(el.tpPrice, sellQty), cfg.sellFeeRate);
-                    double gross   = QuantMath::grossProfit(pos.trade.entryPrice, el.tpPrice, sellQty);
-                    double net     = QuantMath::netProfit(gross, 0.0, sellFee);
-
-                    SimSell ss;
-                    ss.buyId       = pos.trade.id;
-                    ss.cycle       = pos.cycle;
-                    ss.symbol      = pos.trade.symbol;
-                    ss.entryPrice  = pos.trade.entryPrice;
-                    ss.sellPrice   = el.tpPrice;
-                    ss.quantity    = sellQty;
-                    ss.sellFee     = sellFee;
-                    ss.grossProfit = gross;
-                    ss.netProfit   = net;
-                    ss.sellTime    = now;
-
-                    pos.trade.remaining -= sellQty;
-                    capital             += QuantMath::proceeds(el.tpPrice, sellQty, sellFee);
-                    realized            += net;
-                    totalFees           += sellFee;
-
-                    result.sells.push_back(ss);
-                    result.tradesClosed++;
-                    if (net >= 0) result.wins++;
-                    else          result.losses++;
-                    if (net > result.bestTrade)  result.bestTrade  = net;
-                    if (net < result.worstTrade) result.worstTrade = net;
-
-                    pos.exitFilled[li] = true;
+                    m_cycleProfit += net;
+                    if (wasOpen && !(pos.trade.remaining > EPS)) m_cycleOpen--;
                 }
+                changed = true;
+
+                result.sells.push_back(ss);
+                result.tradesClosed++;
+                if (net >= 0) result.wins++;
+                else          result.losses++;
+                if (net > result.bestTrade)  result.bestTrade  = net;
+                if (net < result.worstTrade) result.worstTrade = net;
             }
 
             // --- Chain mode: when all positions from current cycle are closed,
             //     divert savings and regenerate entries at current price ---
             if (cfg.chainCycles)
             {
-                bool allClosed = true;
-                bool hadPositions = false;
-                for (const auto& pos : positions)
-                {
-                    if (pos.cycle == cycle)
-                    {
-                        hadPositions = true;
-                        if (pos.trade.remaining > EPS)
-                        {
-                            allClosed = false;
-                            break;
-                        }
-                    }
-                }
-
-                // Also require at least one entry to have been filled this cycle
-                bool anyFilled = false;
-                for (size_t ei = 0; ei < ce.filled.size(); ++ei)
-                    if (ce.filled[ei]) { anyFilled = true; break; }
+                bool hadPositions = m_cyclePositions > 0;
+                bool allClosed    = m_cycleOpen == 0;
 
-                if (hadPositions && allClosed && anyFilled && capital > EPS)
+                if (hadPositions && allClosed && m_cycleFilled && capital > EPS)
                 {
                     // Divert savings: fraction of cycle's realised profit
-                    double cycleProfit = 0;
-                    for (const auto& s : result.sells)
-                        if (s.cycle == cycle) cycleProfit += s.netProfit;
-
-                    if (cycleProfit > 0 && cfg.savingsRate > 0)
+                    if (m_cycleProfit > 0 && cfg.savingsRate > 0)
                     {
-                        double saved = QuantMath::savings(cycleProfit, cfg.savingsRate);
-                        savings += saved;
-                        capital -= saved;
+                        double saved = QuantMath::savings(m_cycleProfit, cfg.savingsRate);
+                        m_savings += saved;
+                        capital   -= saved;
                     }
 
                     result.cyclesCompleted++;
-                    cycle++;
+                    m_cycle++;
+                    m_cycleFilled    = false;
+                    m_cyclePositions = 0;
+                    m_cycleOpen      = 0;
+                    m_cycleProfit    = 0;
 
                     // Regenerate entries at current price with updated capital
-                    ce = generateCycleEntries(price, capital, cfg);
-                    recordEntryLevels(ce, cycle, now);
+                    generateCycleEntries(m_ce, price, capital / m_shares, cfg);
+                    recordEntryLevels(m_ce, m_cycle, now);
                 }
             }
 
-            // --- Snapshot ---
-            double deployed = 0;
-            int openCount = 0;
-            for (const auto& pos : positions)
+            // The snapshot's deployed / open totals, summed again only
+            // on ticks where a position opened or sold.
+            if (changed)
             {
-                if (pos.trade.remaining > EPS)
+                m_deployed  = 0;
+                m_openCount = 0;
+                std::size_t kept = 0;
+                for (std::size_t pi : m_open)
                 {
-                    deployed += pos.trade.entryPrice * pos.trade.remaining;
-                    ++openCount;
+                    const SimTrade& t = m_positions[pi].trade;
+                    if (t.remaining > EPS)
+                    {
+                        m_deployed += t.entryPrice * t.remaining;
+                        ++m_openCount;
+                        m_open[kept++] = pi;
+                    }
                 }
+                m_open.resize(kept);
             }
+            return changed;
+        }
 
+        SimSnapshot snapshot(long long now, double capital) const
+        {
             SimSnapshot snap;
             snap.timestamp  = now;
             snap.capital    = capital;
-            snap.deployed   = deployed;
-            snap.realized   = realized;
-            snap.totalFees  = totalFees;
-            snap.openTrades = openCount;
-            result.snapshots.push_back(snap);
-        }
-
-        // Also update final remaining in result.trades from positions
-        for (auto& pos : positions)
-            for (auto& rt : result.trades)
-                if (rt.id == pos.trade.id)
-                    rt.remaining = pos.trade.remaining;
-
-        result.finalCapital       = capital;
-        result.totalRealized      = realized;
-        result.totalFees          = totalFees;
-        result.totalBuyFees       = 0;
-        result.totalSellFees      = 0;
-        for (const auto& t : result.trades) result.totalBuyFees  += t.buyFee;
-        for (const auto& s : result.sells)  result.totalSellFees += s.sellFee;
-        result.feeHedgingAmount   = hedgePool;
-        result.feeHedgingCoverage = QuantMath::feeHedgingCoverage(hedgePool, totalFees);
-        result.totalSavings       = savings;
-        if (cfg.chainCycles && cycle > 0)
-            result.cyclesCompleted = cycle;
-
-        return result;
+            snap.deployed   = m_deployed;
+            snap.realized   = m_realized;
+            snap.totalFees  = m_totalFees;
+            snap.savings    = m_savings;
+            snap.openTrades = m_openCount;
+            return snap;
+        }
+
+        // The tick's snapshot, if cfg.snapshotPolicy keeps it.
+        void tickSnapshot(long long now, double capital)
+        {
+            m_lastTime = now;
+            SimSnapshot snap = snapshot(now, capital);
+            if (m_gate.keep(m_cfg, snap)) m_result.snapshots.push_back(snap);
+        }
+
+        // Close the books with the pool's final capital.
+        SimResult finish(double capital)
+        {
+            closeBooks(m_result, m_positions, capital);
+            return std::move(m_result);
+        }
+
+        // Last snapshot, remaining quantities and totals into `result`:
+        // m_result, or a copy of a checkpoint's with its positions.
+        void closeBooks(SimResult& result, const std::vector<OpenPosition>& positions,
+                        double capital) const
+        {
+            if (m_gate.owesLast(m_cfg))
+                result.snapshots.push_back(snapshot(m_lastTime, capital));
+
+            // Also update final remaining in result.trades from positions
+            // (one trade per position, in the same order)
+            for (std::size_t i = 0; i < positions.size(); ++i)
+                result.trades[i].remaining = positions[i].trade.remaining;
+
+            result.finalCapital       = capital;
+            result.totalRealized      = m_realized;
+            result.totalFees          = m_totalFees;
+            result.totalBuyFees       = 0;
+            result.totalSellFees      = 0;
+            for (const auto& t : result.trades) result.totalBuyFees  += t.buyFee;
+            for (const auto& s : result.sells)  result.totalSellFees += s.sellFee;
+            result.feeHedgingAmount   = m_hedgePool;
+            result.feeHedgingCoverage = QuantMath::feeHedgingCoverage(m_hedgePool, m_totalFees);
+            result.totalSavings       = m_savings;
+            result.totalPumped        = m_clock.pumped;
+            if (m_cfg.chainCycles && m_cycle > 0)
+                result.cyclesCompleted = m_cycle;
+        }
+
+        double deployed()  const { return m_deployed; }
+        int    openCount() const { return m_openCount; }
+        double realized()  const { return m_realized; }
+        double totalFees() const { return m_totalFees; }
+        double savings()   const { return m_savings; }
+
+        // Take over a checkpoint's state, or hand it back.  Both move,
+        // so neither copies the run's history.
+        void load(Checkpoint& cp)
+        {
+            loadTotals(cp);
+            m_result         = std::move(cp.result);
+            m_ce             = std::move(cp.entries);
+            m_positions      = std::move(cp.positions);
+            m_exits          = std::move(cp.exits);
+            m_open           = std::move(cp.open);
+            m_entryQueue     = std::move(cp.entryQueue);
+            m_exitQueue      = std::move(cp.exitQueue);
+        }
+
+        // Just the scalars, enough for closeBooks().
+        void loadTotals(const Checkpoint& cp)
+        {
+            m_realized       = cp.realized;
+            m_totalFees      = cp.totalFees;
+            m_hedgePool      = cp.hedgePool;
+            m_savings        = cp.savings;
+            m_cycle          = cp.cycle;
+            m_cycleLevels    = cp.cycleLevels;
+            m_cycleFilled    = cp.cycleFilled;
+            m_cyclePositions = cp.cyclePositions;
+            m_cycleOpen      = cp.cycleOpen;
+            m_cycleProfit    = cp.cycleProfit;
+            m_deployed       = cp.deployed;
+            m_openCount      = cp.openCount;
+            m_gate           = cp.snapshots;
+            m_lastTime       = cp.lastTime;
+        }
+
+        void save(Checkpoint& cp)
+        {
+            cp.result         = std::move(m_result);
+            cp.realized       = m_realized;
+            cp.totalFees      = m_totalFees;
+            cp.hedgePool      = m_hedgePool;
+            cp.savings        = m_savings;
+            cp.cycle          = m_cycle;
+            cp.entries        = std::move(m_ce);
+            cp.positions      = std::move(m_positions);
+            cp.exits          = std::move(m_exits);
+            cp.open           = std::move(m_open);
+            cp.entryQueue     = std::move(m_entryQueue);
+            cp.exitQueue      = std::move(m_exitQueue);
+            cp.cycleLevels    = m_cycleLevels;
+            cp.cycleFilled    = m_cycleFilled;
+            cp.cyclePositions = m_cyclePositions;
+            cp.cycleOpen      = m_cycleOpen;
+            cp.cycleProfit    = m_cycleProfit;
+            cp.deployed       = m_deployed;
+            cp.openCount      = m_openCount;
+            cp.snapshots      = m_gate;
+        }
+
+        // Run on an arena's buffers, emptied but keeping their capacity.
+        // finish() moves the result out; giveBack() returns the rest.
+        void borrow(Arena& a)
+        {
+            reuse(m_result.trades,      a.result.trades);
+            reuse(m_result.sells,       a.result.sells);
+            reuse(m_result.snapshots,   a.result.snapshots);
+            reuse(m_result.entryLevels, a.result.entryLevels);
+            reuse(m_ce.levels,          a.entries.levels);
+            reuse(m_ce.filled,          a.entries.filled);
+            reuse(m_positions,          a.positions);
+            reuse(m_exits,              a.exits);
+            reuse(m_open,               a.open);
+            reuse(m_hits,               a.hits);
+            std::swap(m_entryQueue, a.entryQueue);   // start() resets it
+            std::swap(m_exitQueue,  a.exitQueue);
+            m_exitQueue.clear();
+        }
+
+        void giveBack(Arena& a)
+        {
+            m_ce.levels.swap(a.entries.levels);
+            m_ce.filled.swap(a.entries.filled);
+            m_positions.swap(a.positions);
+            m_exits.swap(a.exits);
+            m_open.swap(a.open);
+            m_hits.swap(a.hits);
+            std::swap(m_entryQueue, a.entryQueue);
+            std::swap(m_exitQueue,  a.exitQueue);
+        }
+
+    private:
+        template <typename T>
+        static void reuse(std::vector<T>& mine, std::vector<T>& lent)
+        {
+            mine.swap(lent);
+            mine.clear();
+        }
+
+        // Record all entry levels from a CycleEntries into the result
+        void recordEntryLevels(const CycleEntries& entries, int cyc, long long ts)
+        {
+            m_cycleLevels = m_result.entryLevels.size();
+            for (size_t i = 0; i < entries.levels.size(); ++i)
+            {
+                SimEntryLevel sel;
+                sel.cycle       = cyc;
+                sel.levelIndex  = static_cast<int>(i);
+                sel.entryPrice  = entries.levels[i].entryPrice;
+                sel.funding     = entries.levels[i].funding;
+                sel.generatedAt = ts;
+                sel.filled      = false;
+                sel.filledAt    = 0;
+                m_result.entryLevels.push_back(sel);
+            }
+            m_entryQueue.reset(entries);
+        }
+
+        const SimConfig& m_cfg;
+        TradeIds&        m_ids;
+        MonthClock&      m_clock;
+        int              m_shares;
+        SymbolId         m_symbol;
+        SimResult        m_result;
+
+        double m_realized  = 0;
+        double m_totalFees = 0;
+        double m_hedgePool = 0;
+        double m_savings   = 0;
+        int    m_cycle     = 0;
+
+        CycleEntries              m_ce;
+        std::vector<OpenPosition> m_positions;
+        std::vector<ExitLevel>    m_exits;  // every position's plan, back to back
+        std::vector<std::size_t>  m_open;   // positions with remaining > EPS, in order
+        EntryQueue                m_entryQueue;
+        ExitQueue                 m_exitQueue;
+        std::vector<Pending>      m_hits;
+
+        // Current cycle: where its levels start in entryLevels, whether
+        // any filled, its positions (total / still open) and the
+        // realised profit of its sells.
+        std::size_t m_cycleLevels    = 0;
+        bool        m_cycleFilled    = false;
+        int         m_cyclePositions = 0;
+        int         m_cycleOpen      = 0;
+        double      m_cycleProfit    = 0;
+
+        double m_deployed  = 0;
+        int    m_openCount = 0;
+
+        SnapshotGate m_gate;
+        long long    m_lastTime = 0;   // the latest tick's, for finish()
+    };
+
+public:
+    // Run a forward simulation stepping through the price series, or
+    // decoding cfg.ticks block by block when it is set.
+    static SimResult run(const SimConfig& cfg)
+    {
+        return runFrom(cfg, nullptr);
+    }
+
+    // run() on an arena's buffers.  The result lives in arena.result
+    // until the arena's next run; a caller that only wants the totals
+    // (an objective, a sweep row) should also set snapshotPolicy to
+    // None, and then repeated runs allocate nothing.
+    static const SimResult& run(const SimConfig& cfg, Arena& arena)
+    {
+        arena.result = runFrom(cfg, &arena);
+        return arena.result;
+    }
+
+    // ---- Checkpoints (single symbol) ----
+
+    // cfg before its first tick.  prices and ticks are dropped: the
+    // ticks are handed to advance().
+    static Checkpoint checkpoint(const SimConfig& cfg)
+    {
+        Checkpoint cp;
+        cp.config        = cfg;
+        cp.config.prices = nullptr;
+        cp.config.ticks  = nullptr;
+        cp.capital       = cfg.startingCapital;
+        return cp;
+    }
+
+    // Step cp over the ticks after its last one.  `ticks` is in time
+    // order and may start anywhere before that, e.g. a symbol's whole
+    // series: the ticks already seen are skipped by binary search.
+    static void advance(Checkpoint& cp, PriceSpan ticks)
+    {
+        std::size_t i = cp.started ? ticks.upperIndex(cp.lastTime) : 0;
+        if (i == ticks.size()) return;
+
+        Lane lane(cp.config, cp.ids, cp.clock);
+        lane.load(cp);
+        double capital = cp.capital;
+        if (!cp.started) lane.start(ticks[i], capital);
+        for (; i < ticks.size(); ++i)
+        {
+            PricePoint pt = ticks[i];
+            cp.clock.tick(pt.timestamp, cp.config, capital);
+            lane.step(pt, capital);
+            lane.tickSnapshot(pt.timestamp, capital);
+            cp.lastTime = pt.timestamp;
+        }
+        lane.save(cp);
+        cp.capital = capital;
+        cp.started = true;
+    }
+
+    static void advance(Checkpoint& cp, const std::vector<PricePoint>& ticks)
+    {
+        if (!ticks.empty()) advance(cp, span(ticks));
+    }
+
+    // The SimResult run() gives for the ticks cp has seen.  Only the
+    // result is copied (the rest of cp is read in place); std::move
+    // cp in when it is no longer needed and nothing is.
+    static SimResult result(const Checkpoint& cp)
+    {
+        if (!cp.started) return SimResult();
+        TradeIds   ids   = cp.ids;
+        MonthClock clock = cp.clock;
+        Lane lane(cp.config, ids, clock);
+        lane.loadTotals(cp);
+        SimResult r = cp.result;
+        lane.closeBooks(r, cp.positions, cp.capital);
+        return r;
+    }
+
+    static SimResult result(Checkpoint&& cp)
+    {
+        if (!cp.started) return SimResult();
+        Lane lane(cp.config, cp.ids, cp.clock);
+        lane.load(cp);
+        return lane.finish(cp.capital);
+    }
+
+    // Extend `from` over `ticks` and close its books; `next`, if set,
+    // receives the extended checkpoint.  Pass a checkpoint to keep by
+    // copy, so several what-if branches can share it, or std::move the
+    // live one in with `next` pointing back at it:
+    //   SimResult r = Simulator::resume(std::move(cp), ticks, &cp);
+    // costs the new ticks plus one copy of the result.
+    static SimResult resume(Checkpoint from, PriceSpan ticks, Checkpoint* next = nullptr)
+    {
+        advance(from, ticks);
+        if (!next) return result(std::move(from));
+        *next = std::move(from);
+        return result(*next);
+    }
+
+    static SimResult resume(Checkpoint from, const std::vector<PricePoint>& ticks,
+                            Checkpoint* next = nullptr)
+    {
+        return resume(std::move(from), ticks.empty() ? PriceSpan() : span(ticks), next);
+    }
+
+    // Run every symbol of cfg.symbols over one capital pool, stepping
+    // the ticks of all series in time order (ties in symbol order).
+    // Each symbol chains its own cycles and plans each one with an
+    // equal share of the pool as it stands; fills draw on the whole
+    // pool.  horizonParams.symbolCount is set to the number of symbols.
+    static PortfolioResult runPortfolio(const PortfolioConfig& cfg)
+    {
+        PortfolioResult out;
+        if (!cfg.base.prices || cfg.symbols.empty()) return out;
+
+        const std::size_t k = cfg.symbols.size();
+        std::vector<PriceSpan> spans;
+        spans.reserve(k);
+        std::size_t longest = 0;
+        for (const auto& sym : cfg.symbols)
+        {
+            spans.push_back(cfg.base.prices->series(sym));
+            longest = std::max(longest, spans.back().size());
+        }
+        MergeCursor src(spans);
+        if (cfg.base.snapshotPolicy == SnapshotPolicy::EveryTick)
+            out.total.snapshots.reserve(longest);   // exact when the series are aligned
+
+        TradeIds   ids;
+        MonthClock clock;
+        std::vector<SimConfig> configs;   // the lanes keep references
+        std::vector<Lane> lanes;
+        configs.reserve(k);
+        lanes.reserve(k);
+        for (const auto& sym : cfg.symbols)
+        {
+            SimConfig c = cfg.base;
+            c.symbol = sym;
+            c.ticks  = nullptr;
+            c.horizonParams.symbolCount = static_cast<int>(k);
+            if (!cfg.symbolSnapshots) c.snapshotPolicy = SnapshotPolicy::None;
+            configs.push_back(std::move(c));
+            lanes.emplace_back(configs.back(), ids, clock, static_cast<int>(k));
+        }
+        std::vector<char> started(k, 0);
+
+        double capital = cfg.base.startingCapital;
+        SimSnapshot agg;        // lane totals, summed again after a fill or sale
+        SnapshotGate gate;
+        bool changed = false;
+        std::size_t lane;
+        PricePoint pt;
+        while (src.next(lane, pt))
+        {
+            Lane& ln = lanes[lane];
+            clock.tick(pt.timestamp, cfg.base, capital);
+            if (!started[lane]) { ln.start(pt, capital); started[lane] = 1; }
+            changed |= ln.step(pt, capital);
+            ln.tickSnapshot(pt.timestamp, capital);
+
+            // One aggregate snapshot per distinct timestamp.
+            if (src.done() || src.nextTime() != pt.timestamp)
+            {
+                if (changed)
+                {
+                    agg = SimSnapshot();
+                    for (const Lane& l : lanes)
+                    {
+                        agg.deployed   += l.deployed();
+                        agg.realized   += l.realized();
+                        agg.totalFees  += l.totalFees();
+                        agg.savings    += l.savings();
+                        agg.openTrades += l.openCount();
+                    }
+                    changed = false;
+                }
+                agg.timestamp = pt.timestamp;
+                agg.capital   = capital;
+                if (gate.keep(cfg.base, agg)) out.total.snapshots.push_back(agg);
+            }
+        }
+        if (gate.owesLast(cfg.base)) out.total.snapshots.push_back(agg);
+
+        SimResult& total = out.total;
+        double hedge = 0;
+        for (std::size_t i = 0; i < k; ++i)
+        {
+            SimResult r = lanes[i].finish(capital);
+            total.totalRealized  += r.totalRealized;
+            total.totalFees      += r.totalFees;
+            total.totalBuyFees   += r.totalBuyFees;
+            total.totalSellFees  += r.totalSellFees;
+            total.tradesOpened   += r.tradesOpened;
+            total.tradesClosed   += r.tradesClosed;
+            total.wins           += r.wins;
+            total.losses         += r.losses;
+            total.bestTrade       = std::max(total.bestTrade, r.bestTrade);
+            total.worstTrade      = std::min(total.worstTrade, r.worstTrade);
+            total.cyclesCompleted += r.cyclesCompleted;
+            total.totalSavings   += r.totalSavings;
+            hedge                += r.feeHedgingAmount;
+            total.trades.insert(total.trades.end(), r.trades.begin(), r.trades.end());
+            total.sells.insert(total.sells.end(), r.sells.begin(), r.sells.end());
+            total.entryLevels.insert(total.entryLevels.end(), r.entryLevels.begin(), r.entryLevels.end());
+            out.symbols.push_back(std::move(r));
+        }
+        total.finalCapital       = capital;
+        total.totalPumped        = clock.pumped;
+        total.feeHedgingAmount   = hedge;
+        total.feeHedgingCoverage = QuantMath::feeHedgingCoverage(hedge, total.totalFees);
+
+        // Trade ids come from one generator, so id order is fill order.
+        std::sort(total.trades.begin(), total.trades.end(),
+                  [](const SimTrade& a, const SimTrade& b) { return a.id < b.id; });
+        std::stable_sort(total.sells.begin(), total.sells.end(),
+                  [](const SimSell& a, const SimSell& b) { return a.sellTime < b.sellTime; });
+        std::stable_sort(total.entryLevels.begin(), total.entryLevels.end(),
+                  [](const SimEntryLevel& a, const SimEntryLevel& b) { return a.generatedAt < b.generatedAt; });
+        return out;
+    }
+
+private:
+    // run() over cfg's price series, or decoding cfg.ticks block by
+    // block when it is set; on the arena's buffers if there is one.
+    static SimResult runFrom(const SimConfig& cfg, Arena* arena)
+    {
+        if (cfg.ticks)
+        {
+            TickCodec::Cursor src(*cfg.ticks);
+            return runOver(cfg, src, arena);
+        }
+        if (!cfg.prices) return SimResult();
+        SpanCursor src{ cfg.prices->series(cfg.symbol) };
+        return runOver(cfg, src, arena);
+    }
+
+    // The single-symbol simulation, over any source with
+    // bool next(PricePoint&).
+    template <typename Source>
+    static SimResult runOver(const SimConfig& cfg, Source& src, Arena* arena)
+    {
+        PricePoint pt;
+        if (!src.next(pt)) return SimResult();
+
+        TradeIds   ids;
+        MonthClock clock;
+        Lane lane(cfg, ids, clock);
+        if (arena) lane.borrow(*arena);
+        double capital = cfg.startingCapital;
+        lane.start(pt, capital);
+        do
+        {
+            clock.tick(pt.timestamp, cfg, capital);
+            lane.step(pt, capital);
+            lane.tickSnapshot(pt.timestamp, capital);
+        }
+        while (src.next(pt));
+        SimResult r = lane.finish(capital);
+        if (arena) lane.giveBack(*arena);
+        return r;
     }
 };
@@ -2,9 +2,14 @@
 
 #include "IdGenerator.h"
 #include <string>
+#include <string_view>
 #include <vector>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
 #include <algorithm>
 #include <cctype>
+#include <cstdint>
 
 // Central symbol registry.
 //
@@ -13,6 +18,16 @@
 // renames, merges, and cross-referencing work cleanly.
 //
 // Thread safety: callers must hold their own mutex.
+//
+// Separately, intern() issues a process-wide SymbolId for any exact
+// symbol string.  Ids are dense (0, 1, 2, ...) and never reused, so
+// in-memory indexes (positions, trigger ladders, price columns) keep
+// per-symbol state in arrays indexed by id, and only compare strings
+// where a name crosses an I/O boundary.  SymbolIds are never
+// persisted; intern() and name() are safe from any thread.
+
+using SymbolId = std::uint32_t;
+inline constexpr SymbolId kNoSymbol = ~SymbolId(0);
 
 struct SymbolInfo
 {
@@ -25,21 +40,63 @@ class SymbolRegistry
 public:
     SymbolRegistry() = default;
 
+    // ---- Interning ----
+
+    // The SymbolId of `name` (exact, case-sensitive), issuing the next
+    // one on first sight.
+    static SymbolId intern(std::string_view name)
+    {
+        Interned& in = interned();
+        std::lock_guard<std::mutex> lk(in.mutex);
+        auto it = in.ids.find(name);
+        if (it != in.ids.end()) return it->second;
+        SymbolId id = static_cast<SymbolId>(in.names.size());
+        in.names.emplace_back(name);
+        in.ids.emplace(in.names.back(), id);
+        return id;
+    }
+
+    // The SymbolId of `name` if it was ever interned, else kNoSymbol.
+    // Queries use this so unknown names do not grow the table.
+    static SymbolId lookup(std::string_view name)
+    {
+        Interned& in = interned();
+        std::lock_guard<std::mutex> lk(in.mutex);
+        auto it = in.ids.find(name);
+        return it != in.ids.end() ? it->second : kNoSymbol;
+    }
+
+    // The string an id was interned from (empty for kNoSymbol).
+    static const std::string& name(SymbolId id)
+    {
+        static const std::string none;
+        Interned& in = interned();
+        std::lock_guard<std::mutex> lk(in.mutex);
+        return id < in.names.size() ? in.names[id] : none;
+    }
+
+    // One past the largest id issued so far.
+    static std::size_t internedCount()
+    {
+        Interned& in = interned();
+        std::lock_guard<std::mutex> lk(in.mutex);
+        return in.names.size();
+    }
+
+    // ---- Registry ----
+
     // Look up by name.  Returns nullptr if not registered.
     const SymbolInfo* find(const std::string& name) const
     {
-        std::string n = normalize(name);
-        for (const auto& s : m_symbols)
-            if (s.name == n) return &s;
-        return nullptr;
+        auto it = m_byName.find(normalize(name));
+        return it != m_byName.end() ? &m_symbols[it->second] : nullptr;
     }
 
     // Look up by ID.
     const SymbolInfo* find(int id) const
     {
-        for (const auto& s : m_symbols)
-            if (s.id == id) return &s;
-        return nullptr;
+        auto it = m_byId.find(id);
+        return it != m_byId.end() ? &m_symbols[it->second] : nullptr;
     }
 
     // Get-or-create: returns the existing ID or registers a new one.
@@ -50,6 +107,8 @@ public:
         if (existing) return existing->id;
         int id = m_idGen.acquire();
         m_idGen.commit(id);
+        m_byName.emplace(n, m_symbols.size());
+        m_byId.emplace(id, m_symbols.size());
         m_symbols.push_back({ id, n });
         return id;
     }
@@ -82,6 +141,22 @@ private:
         return out;
     }
 
-    std::vector<SymbolInfo> m_symbols;
-    IdGenerator             m_idGen;
+    // Names live in a deque so the string_view keys never dangle.
+    struct Interned
+    {
+        std::mutex                                     mutex;
+        std::deque<std::string>                        names;
+        std::unordered_map<std::string_view, SymbolId> ids;
+    };
+
+    static Interned& interned()
+    {
+        static Interned in;
+        return in;
+    }
+
+    std::vector<SymbolInfo>                      m_symbols;
+    std::unordered_map<std::string, std::size_t> m_byName;
+    std::unordered_map<int, std::size_t>         m_byId;
+    IdGenerator                                  m_idGen;
 };
@@ -0,0 +1,536 @@
+#pragma once
+
+// ============================================================
+// TickCodec.h — Gorilla-style block compression for tick data
+//
+// A Series holds one symbol's points in blocks of up to
+// kBlockPoints, each starting on a 64-bit word boundary with
+// the first timestamp raw (64 bits) and a 4-bit price mode.
+//
+//   timestamps  delta of deltas in a prefix-coded bucket:
+//                 '0'                 dod == 0
+//                 '10'   +  7 bits    [-64, 63]
+//                 '110'  +  9 bits    [-256, 255]
+//                 '1110' + 12 bits    [-2048, 2047]
+//                 '1111' + 64 bits    anything else
+//   prices      mode 0 (Gorilla): first value raw, then the
+//               XOR with the previous value's bits:
+//                 '0'                 identical
+//                 '10' + bits         fits the previous window
+//                 '11' + 5 bits leading zeros + 6 bits length
+//                      + bits         new window
+//               mode d+1 (decimal): every price in the block
+//               is an exact multiple of 10^-d, so the scaled
+//               integers are stored as a 6-bit step width w,
+//               the first raw, then per point '0' + w-bit step
+//               or '1' + 64-bit step.
+//
+// Quoted prices have few decimals but noisy mantissas, which
+// XOR coding handles poorly; the decimal mode is chosen per
+// block whenever it round-trips exactly, and Gorilla XOR is
+// the fallback.  Points are interleaved (timestamp, price) so
+// a block decodes in one forward pass.  Every block records
+// its first and last timestamp, which lets a Cursor start at
+// the block covering a time without touching the ones before
+// it.  Decoding is exact: the doubles come back bit for bit.
+// ============================================================
+
+#include "PriceSeries.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace TickCodec {
+
+inline constexpr std::size_t   kBlockPoints = 1024;
+inline constexpr char          kMagic[8]    = {'Q','G','O','R','I','L','0','1'};
+inline constexpr std::uint32_t kByteOrder   = 0x01020304u;
+inline constexpr std::uint32_t kVersion     = 1;
+inline constexpr int           kMaxDecimals = 9;
+
+inline constexpr double kPow10[kMaxDecimals + 1] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9
+};
+
+inline int leadingZeros(std::uint64_t v)
+{
+    if (v == 0) return 64;
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanReverse64(&i, v);
+    return 63 - static_cast<int>(i);
+#else
+    return __builtin_clzll(v);
+#endif
+}
+
+inline int trailingZeros(std::uint64_t v)
+{
+    if (v == 0) return 64;
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanForward64(&i, v);
+    return static_cast<int>(i);
+#else
+    return __builtin_ctzll(v);
+#endif
+}
+
+inline std::uint64_t toBits(double d)
+{
+    std::uint64_t u;
+    std::memcpy(&u, &d, sizeof(u));
+    return u;
+}
+
+inline double fromBits(std::uint64_t u)
+{
+    double d;
+    std::memcpy(&d, &u, sizeof(d));
+    return d;
+}
+
+struct BlockIndex
+{
+    std::int64_t  minTs;    // first timestamp in the block
+    std::int64_t  maxTs;    // last timestamp in the block
+    std::uint64_t word;     // offset of the block's first word
+    std::uint32_t count;    // points in the block
+    std::uint32_t reserved;
+};
+
+static_assert(sizeof(BlockIndex) == 32, "block index entries must stay 32 bytes");
+
+class Series
+{
+public:
+    std::size_t size()  const { return m_count; }
+    bool        empty() const { return m_count == 0; }
+
+    const std::vector<BlockIndex>& blocks() const { return m_blocks; }
+
+    // Encoded footprint: bit stream plus block index.
+    std::size_t compressedBytes() const
+    {
+        return m_words.size() * sizeof(std::uint64_t) + m_blocks.size() * sizeof(BlockIndex);
+    }
+
+    // First block whose last timestamp is at or after `time`
+    // (blocks().size() if none).
+    std::size_t blockFor(long long time) const
+    {
+        std::size_t lo = 0, hi = m_blocks.size();
+        while (lo < hi)
+        {
+            std::size_t mid = lo + (hi - lo) / 2;
+            if (m_blocks[mid].maxTs < time) lo = mid + 1; else hi = mid;
+        }
+        return lo;
+    }
+
+    std::vector<PricePoint> decode() const;
+
+    // Self-describing byte image:
+    //   magic "QGORIL01", u32 byteOrder, u32 version,
+    //   u64 points, u64 blocks, u64 words, BlockIndex[blocks],
+    //   u64 words[words]
+    std::string toBytes() const
+    {
+        std::string out;
+        out.append(kMagic, sizeof(kMagic));
+        auto put = [&out](const void* p, std::size_t n) { out.append(static_cast<const char*>(p), n); };
+        put(&kByteOrder, 4);
+        put(&kVersion, 4);
+        std::uint64_t counts[3] = { m_count, m_blocks.size(), m_words.size() };
+        put(counts, sizeof(counts));
+        put(m_blocks.data(), m_blocks.size() * sizeof(BlockIndex));
+        put(m_words.data(), m_words.size() * sizeof(std::uint64_t));
+        return out;
+    }
+
+    static Series fromBytes(std::string_view b)
+    {
+        const std::size_t head = sizeof(kMagic) + 8 + 24;
+        if (b.size() < head || std::memcmp(b.data(), kMagic, sizeof(kMagic)) != 0)
+            throw std::runtime_error("Not a compressed tick series");
+        std::uint32_t order, version;
+        std::memcpy(&order,   b.data() + 8,  4);
+        std::memcpy(&version, b.data() + 12, 4);
+        if (order != kByteOrder) throw std::runtime_error("Compressed tick series has foreign byte order");
+        if (version != kVersion) throw std::runtime_error("Unsupported compressed tick series version");
+        std::uint64_t counts[3];
+        std::memcpy(counts, b.data() + 16, sizeof(counts));
+        if (counts[1] > b.size() / sizeof(BlockIndex) || counts[2] > b.size() / sizeof(std::uint64_t)
+            || b.size() != head + counts[1] * sizeof(BlockIndex) + counts[2] * sizeof(std::uint64_t))
+            throw std::runtime_error("Truncated compressed tick series");
+
+        Series s;
+        s.m_count = static_cast<std::size_t>(counts[0]);
+        s.m_blocks.resize(static_cast<std::size_t>(counts[1]));
+        s.m_words.resize(static_cast<std::size_t>(counts[2]));
+        if (!s.m_blocks.empty())
+            std::memcpy(s.m_blocks.data(), b.data() + head, s.m_blocks.size() * sizeof(BlockIndex));
+        if (!s.m_words.empty())
+            std::memcpy(s.m_words.data(), b.data() + head + s.m_blocks.size() * sizeof(BlockIndex),
+                        s.m_words.size() * sizeof(std::uint64_t));
+        return s;
+    }
+
+private:
+    friend class Encoder;
+    friend class Cursor;
+
+    std::vector<std::uint64_t> m_words;
+    std::vector<BlockIndex>    m_blocks;
+    std::size_t                m_count = 0;
+};
+
+// Appends points (ascending by timestamp) to a Series, a block at a time.
+class Encoder
+{
+public:
+    void add(long long time, double price)
+    {
+        m_block.push_back({ time, price });
+        if (m_block.size() == kBlockPoints) flush();
+    }
+
+    Series finish()
+    {
+        flush();
+        Series s = std::move(m_out);
+        *this = Encoder();
+        return s;
+    }
+
+private:
+    void flush()
+    {
+        if (m_block.empty()) return;
+        m_out.m_blocks.push_back({ m_block.front().timestamp, m_block.back().timestamp,
+                                   m_out.m_words.size(),
+                                   static_cast<std::uint32_t>(m_block.size()), 0 });
+        m_bit = 64;   // every block starts on a fresh word
+        put(static_cast<std::uint64_t>(m_block.front().timestamp), 64);
+
+        int decimals = decimalPlaces();
+        put(static_cast<std::uint64_t>(decimals + 1), 4);
+        if (decimals < 0) putXorPrices();
+        else              putDecimalPrices(decimals);
+
+        m_out.m_count += m_block.size();
+        m_block.clear();
+    }
+
+    // Fewest decimals at which every price in the block round-trips
+    // exactly through an integer count of 10^-d, or -1 if none up to
+    // kMaxDecimals (NaN, infinities and -0.0 always take XOR mode).
+    int decimalPlaces() const
+    {
+        for (int d = 0; d <= kMaxDecimals; ++d)
+        {
+            bool exact = true;
+            for (const auto& p : m_block)
+            {
+                double scaled = p.price * kPow10[d];
+                if (!(std::fabs(scaled) < 9007199254740992.0)
+                    || toBits(static_cast<double>(static_cast<std::int64_t>(std::round(scaled))) / kPow10[d])
+                       != toBits(p.price))
+                {
+                    exact = false;
+                    break;
+                }
+            }
+            if (exact) return d;
+        }
+        return -1;
+    }
+
+    void putTimestamps(std::size_t i, std::int64_t& delta)
+    {
+        std::int64_t d = static_cast<std::int64_t>(static_cast<std::uint64_t>(m_block[i].timestamp)
+                                                 - static_cast<std::uint64_t>(m_block[i - 1].timestamp));
+        std::int64_t dod = static_cast<std::int64_t>(static_cast<std::uint64_t>(d) - static_cast<std::uint64_t>(delta));
+        if (dod == 0)                        put(0b0, 1);
+        else if (dod >= -64   && dod < 64)   { put(0b10, 2);   put(static_cast<std::uint64_t>(dod), 7); }
+        else if (dod >= -256  && dod < 256)  { put(0b110, 3);  put(static_cast<std::uint64_t>(dod), 9); }
+        else if (dod >= -2048 && dod < 2048) { put(0b1110, 4); put(static_cast<std::uint64_t>(dod), 12); }
+        else                                 { put(0b1111, 4); put(static_cast<std::uint64_t>(dod), 64); }
+        delta = d;
+    }
+
+    void putXorPrices()
+    {
+        std::uint64_t prev = toBits(m_block.front().price);
+        put(prev, 64);
+        std::int64_t delta = 0;
+        int prevLeading = -1, prevTrailing = 0;
+        for (std::size_t i = 1; i < m_block.size(); ++i)
+        {
+            putTimestamps(i, delta);
+            std::uint64_t bits = toBits(m_block[i].price);
+            std::uint64_t x = bits ^ prev;
+            prev = bits;
+            if (x == 0) { put(0b0, 1); continue; }
+            int leading  = leadingZeros(x);
+            int trailing = trailingZeros(x);
+            if (leading > 31) leading = 31;
+            if (prevLeading >= 0 && leading >= prevLeading && trailing >= prevTrailing)
+            {
+                put(0b10, 2);
+                put(x >> prevTrailing, 64 - prevLeading - prevTrailing);
+                continue;
+            }
+            int meaningful = 64 - leading - trailing;
+            put(0b11, 2);
+            put(static_cast<std::uint64_t>(leading), 5);
+            put(static_cast<std::uint64_t>(meaningful - 1), 6);
+            put(x >> trailing, meaningful);
+            prevLeading  = leading;
+            prevTrailing = trailing;
+        }
+    }
+
+    void putDecimalPrices(int decimals)
+    {
+        std::vector<std::int64_t> steps(m_block.size());
+        std::int64_t prev = 0;
+        std::size_t widthCount[65] = {};
+        for (std::size_t i = 0; i < m_block.size(); ++i)
+        {
+            auto v = static_cast<std::int64_t>(std::round(m_block[i].price * kPow10[decimals]));
+            steps[i] = static_cast<std::int64_t>(static_cast<std::uint64_t>(v) - static_cast<std::uint64_t>(prev));
+            prev = v;
+            if (i > 0) ++widthCount[signedWidth(steps[i])];
+        }
+
+        // One width for the block: steps that fit cost 1 + w bits, the
+        // rest 1 + 64.  Pick the cheapest.
+        int width = 64;
+        std::uint64_t best = ~std::uint64_t(0), fit = 0, n = m_block.size() - 1;
+        for (int w = 1; w <= 64; ++w)
+        {
+            fit += widthCount[w];
+            std::uint64_t cost = fit * (1 + w) + (n - fit) * 65;
+            if (cost < best) { best = cost; width = w; }
+        }
+
+        put(static_cast<std::uint64_t>(width - 1), 6);
+        put(static_cast<std::uint64_t>(steps[0]), 64);
+        std::int64_t delta = 0;
+        for (std::size_t i = 1; i < m_block.size(); ++i)
+        {
+            putTimestamps(i, delta);
+            if (signedWidth(steps[i]) <= width) { put(0b0, 1); put(static_cast<std::uint64_t>(steps[i]), width); }
+            else                                { put(0b1, 1); put(static_cast<std::uint64_t>(steps[i]), 64); }
+        }
+    }
+
+    static int signedWidth(std::int64_t v)
+    {
+        std::uint64_t u = static_cast<std::uint64_t>(v);
+        return 65 - leadingZeros(u ^ static_cast<std::uint64_t>(v >> 63));
+    }
+
+    void put(std::uint64_t v, int n)
+    {
+        if (n < 64) v &= (std::uint64_t(1) << n) - 1;
+        while (n > 0)
+        {
+            if (m_bit == 64)
+            {
+                m_out.m_words.push_back(0);
+                m_bit = 0;
+            }
+            int room = 64 - m_bit;
+            int take = n < room ? n : room;
+            std::uint64_t chunk = take == 64 ? v : (v >> (n - take)) & ((std::uint64_t(1) << take) - 1);
+            m_out.m_words.back() |= chunk << (room - take);
+            m_bit += take;
+            n -= take;
+        }
+    }
+
+    Series                  m_out;
+    std::vector<PricePoint> m_block;
+    int                     m_bit = 64;
+};
+
+inline Series encode(const PriceSpan& pts)
+{
+    Encoder enc;
+    for (std::size_t i = 0; i < pts.size(); ++i)
+        enc.add(pts.timestamp(i), pts.price(i));
+    return enc.finish();
+}
+
+// Streaming decoder over the points of a Series with timestamps in
+// [from, to], skipping straight to the first block that can hold `from`.
+// The Series must outlive the cursor.
+class Cursor
+{
+public:
+    explicit Cursor(const Series& s,
+                    long long from = std::numeric_limits<long long>::min(),
+                    long long to   = std::numeric_limits<long long>::max())
+        : m_s(&s), m_to(to), m_block(s.blockFor(from))
+    {
+        while (advance(m_held))
+        {
+            if (m_held.timestamp >= from) { m_pending = true; break; }
+        }
+    }
+
+    // Next point in time order; false once past `to` or the end.
+    bool next(PricePoint& out)
+    {
+        if (m_pending)
+        {
+            m_pending = false;
+            out = m_held;
+            return true;
+        }
+        return advance(out);
+    }
+
+private:
+    bool advance(PricePoint& out)
+    {
+        if (m_left == 0)
+        {
+            if (m_block >= m_s->m_blocks.size()) return false;
+            const BlockIndex& b = m_s->m_blocks[m_block++];
+            if (b.minTs > m_to) { m_block = m_s->m_blocks.size(); return false; }
+            m_word  = static_cast<std::size_t>(b.word);
+            m_bit   = 0;
+            m_left  = b.count - 1;
+            m_ts    = static_cast<long long>(get(64));
+            m_delta = 0;
+            m_mode  = static_cast<int>(get(4));
+            if (m_mode == 0)
+            {
+                m_bits     = get(64);
+                m_leading  = 0;
+                m_trailing = 0;
+                m_price    = fromBits(m_bits);
+            }
+            else
+            {
+                m_width = static_cast<int>(get(6)) + 1;
+                m_int   = static_cast<std::int64_t>(get(64));
+                m_price = static_cast<double>(m_int) / kPow10[m_mode - 1];
+            }
+        }
+        else
+        {
+            --m_left;
+            m_delta = static_cast<std::int64_t>(static_cast<std::uint64_t>(m_delta) + static_cast<std::uint64_t>(getTimestampDod()));
+            m_ts    = static_cast<long long>(static_cast<std::uint64_t>(m_ts) + static_cast<std::uint64_t>(m_delta));
+            if (m_mode == 0)
+            {
+                m_bits ^= getPriceXor();
+                m_price = fromBits(m_bits);
+            }
+            else
+            {
+                std::uint64_t step = get(1) == 0 ? static_cast<std::uint64_t>(signExtend(get(m_width), m_width)) : get(64);
+                m_int   = static_cast<std::int64_t>(static_cast<std::uint64_t>(m_int) + step);
+                m_price = static_cast<double>(m_int) / kPow10[m_mode - 1];
+            }
+        }
+        if (m_ts > m_to)
+        {
+            m_left  = 0;
+            m_block = m_s->m_blocks.size();
+            return false;
+        }
+        out.timestamp = m_ts;
+        out.price     = m_price;
+        return true;
+    }
+
+    std::uint64_t get(int n)
+    {
+        std::uint64_t v = 0;
+        while (n > 0)
+        {
+            int room = 64 - m_bit;
+            int take = n < room ? n : room;
+            std::uint64_t w = m_s->m_words[m_word];
+            std::uint64_t chunk = take == 64 ? w : (w >> (room - take)) & ((std::uint64_t(1) << take) - 1);
+            v = take == 64 ? chunk : (v << take) | chunk;
+            m_bit += take;
+            n -= take;
+            if (m_bit == 64) { m_bit = 0; ++m_word; }
+        }
+        return v;
+    }
+
+    static std::int64_t signExtend(std::uint64_t v, int n)
+    {
+        if (n == 64) return static_cast<std::int64_t>(v);
+        std::uint64_t sign = std::uint64_t(1) << (n - 1);
+        return static_cast<std::int64_t>((v ^ sign) - sign);
+    }
+
+    std::int64_t getTimestampDod()
+    {
+        if (get(1) == 0) return 0;
+        if (get(1) == 0) return signExtend(get(7), 7);
+        if (get(1) == 0) return signExtend(get(9), 9);
+        if (get(1) == 0) return signExtend(get(12), 12);
+        return static_cast<std::int64_t>(get(64));
+    }
+
+    std::uint64_t getPriceXor()
+    {
+        if (get(1) == 0) return 0;
+        if (get(1) == 1)
+        {
+            m_leading  = static_cast<int>(get(5));
+            int meaningful = static_cast<int>(get(6)) + 1;
+            m_trailing = 64 - m_leading - meaningful;
+        }
+        return get(64 - m_leading - m_trailing) << m_trailing;
+    }
+
+    const Series* m_s;
+    long long     m_to;
+    std::size_t   m_block;
+    std::size_t   m_word  = 0;
+    int           m_bit   = 0;
+    std::size_t   m_left  = 0;     // points still to decode in the block
+    long long     m_ts    = 0;
+    std::int64_t  m_delta = 0;
+    int           m_mode  = 0;     // 0 = XOR floats, else decimals + 1
+    double        m_price = 0.0;
+    std::uint64_t m_bits  = 0;     // XOR mode
+    int           m_leading  = 0;
+    int           m_trailing = 0;
+    std::int64_t  m_int   = 0;     // decimal mode
+    int           m_width = 64;
+    PricePoint    m_held;
+    bool          m_pending = false;
+};
+
+inline std::vector<PricePoint> Series::decode() const
+{
+    std::vector<PricePoint> out;
+    out.reserve(m_count);
+    Cursor c(*this);
+    PricePoint p;
+    while (c.next(p)) out.push_back(p);
+    return out;
+}
+
+} // namespace TickCodec
@@ -0,0 +1,254 @@
+#pragma once
+
+// ============================================================
+// TickStore.h — persistent per-symbol tick files
+//
+// Each symbol lives in <dir>/<symbol>.ticks:
+//
+//   Header     magic "QTICKS01", u32 byteOrder (0x01020304),
+//              u32 version
+//   Records    { i64 timestamp, f64 price }, strictly ascending
+//              by timestamp, 16 bytes each
+//
+// New ticks after the last timestamp are appended; a tick
+// at an existing timestamp patches that record's price in
+// place.  Only a tick that lands between two stored timestamps
+// rewrites the file (atomically, through FileSync::replace).
+// Reads go through a read-only mapping that is refreshed on
+// the first read after a write, so a series far larger than
+// RAM can be searched without loading it.  A torn trailing
+// record left by a crash is dropped when the file is opened.
+// ============================================================
+
+#include "FileSync.h"
+#include "TradeSnapshot.h"
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace TickStore {
+
+inline constexpr char          kMagic[8]  = {'Q','T','I','C','K','S','0','1'};
+inline constexpr std::uint32_t kByteOrder = 0x01020304u;
+inline constexpr std::uint32_t kVersion   = 1;
+inline constexpr const char*   kExtension = ".ticks";
+
+struct Header
+{
+    char          magic[8];
+    std::uint32_t byteOrder;
+    std::uint32_t version;
+};
+
+struct Record
+{
+    std::int64_t timestamp;
+    double       price;
+};
+
+static_assert(sizeof(Header) == 16, "tick header must stay 16 bytes");
+static_assert(sizeof(Record) == 16, "tick record must stay 16 bytes");
+
+// Symbols become file names with anything outside [A-Za-z0-9_-]
+// escaped as %XX, so "BTC/USD" is stored as "BTC%2FUSD.ticks".
+inline std::string encodeSymbol(const std::string& symbol)
+{
+    static const char* hex = "0123456789ABCDEF";
+    std::string out;
+    for (unsigned char c : symbol)
+    {
+        if (std::isalnum(c) || c == '_' || c == '-')
+            out += static_cast<char>(c);
+        else
+        {
+            out += '%';
+            out += hex[c >> 4];
+            out += hex[c & 15];
+        }
+    }
+    return out;
+}
+
+inline std::string decodeSymbol(const std::string& name)
+{
+    auto nibble = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    };
+    std::string out;
+    for (std::size_t i = 0; i < name.size(); ++i)
+    {
+        if (name[i] == '%' && i + 2 < name.size()
+            && nibble(name[i + 1]) >= 0 && nibble(name[i + 2]) >= 0)
+        {
+            out += static_cast<char>(nibble(name[i + 1]) * 16 + nibble(name[i + 2]));
+            i += 2;
+        }
+        else
+            out += name[i];
+    }
+    return out;
+}
+
+// One symbol's tick file.  Not thread-safe; PriceSeries callers hold
+// their own mutex.
+class File
+{
+public:
+    explicit File(std::string path) : m_path(std::move(path))
+    {
+        if (!std::filesystem::exists(m_path)) return;
+        refresh();
+        std::string_view b = m_map.bytes();
+        Header h{};
+        if (b.size() < sizeof(Header)) throw std::runtime_error("Truncated tick file " + m_path);
+        std::memcpy(&h, b.data(), sizeof(Header));
+        if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0 || h.byteOrder != kByteOrder)
+            throw std::runtime_error("Not a tick file: " + m_path);
+        if (h.version != kVersion)
+            throw std::runtime_error("Unsupported tick file version in " + m_path);
+
+        std::size_t body = b.size() - sizeof(Header);
+        m_count = body / sizeof(Record);
+        if (body % sizeof(Record) != 0)
+        {
+            m_map.close();
+            std::filesystem::resize_file(m_path, sizeof(Header) + m_count * sizeof(Record));
+            m_stale = true;
+        }
+        if (m_count > 0) m_last = records()[m_count - 1].timestamp;
+    }
+
+    const std::string& path() const { return m_path; }
+    std::size_t size() const { return m_count; }
+    long long lastTime() const { return m_last; }   // 0 when empty
+
+    // The mapped records; valid until the next write.
+    const Record* records() const
+    {
+        if (m_count == 0) return nullptr;
+        if (m_stale) refresh();
+        return reinterpret_cast<const Record*>(m_map.bytes().data() + sizeof(Header));
+    }
+
+    void set(long long time, double price)
+    {
+        if (m_count == 0 || time > m_last)
+        {
+            std::string bytes;
+            if (!std::filesystem::exists(m_path)) bytes = header();
+            Record r{ time, price };
+            bytes.append(reinterpret_cast<const char*>(&r), sizeof(r));
+            FileSync::append(m_path, bytes);
+            ++m_count;
+            m_last = time;
+            m_stale = true;
+            return;
+        }
+
+        const Record* rs = records();
+        const Record* it = std::lower_bound(rs, rs + m_count, time,
+            [](const Record& r, long long t) { return r.timestamp < t; });
+        if (it->timestamp == time)
+        {
+            patchPrice(static_cast<std::size_t>(it - rs), price);
+            return;
+        }
+
+        std::vector<Record> all(rs, rs + m_count);
+        all.insert(all.begin() + (it - rs), Record{ time, price });
+        assign(all);
+    }
+
+    // Replace the file with `recs`, which must be strictly ascending.
+    void assign(const std::vector<Record>& recs)
+    {
+        std::string bytes = header();
+        bytes.append(reinterpret_cast<const char*>(recs.data()), recs.size() * sizeof(Record));
+        m_map.close();
+        FileSync::replace(m_path, bytes);
+        m_count = recs.size();
+        m_last  = m_count > 0 ? recs.back().timestamp : 0;
+        m_stale = true;
+    }
+
+    // Delete the file.
+    void remove()
+    {
+        m_map.close();
+        std::error_code ec;
+        std::filesystem::remove(m_path, ec);
+        m_count = 0;
+        m_last  = 0;
+        m_stale = false;
+    }
+
+private:
+    static std::string header()
+    {
+        Header h{};
+        std::memcpy(h.magic, kMagic, sizeof(kMagic));
+        h.byteOrder = kByteOrder;
+        h.version   = kVersion;
+        return std::string(reinterpret_cast<const char*>(&h), sizeof(h));
+    }
+
+    void refresh() const
+    {
+        m_map.open(m_path);
+        m_stale = false;
+    }
+
+    void patchPrice(std::size_t index, double price)
+    {
+        m_map.close();
+        std::FILE* f = std::fopen(m_path.c_str(), "r+b");
+        if (!f) throw std::runtime_error("Cannot open " + m_path);
+        long off = static_cast<long>(sizeof(Header) + index * sizeof(Record) + offsetof(Record, price));
+        if (std::fseek(f, off, SEEK_SET) != 0)
+        {
+            std::fclose(f);
+            throw std::runtime_error("Seek failed for " + m_path);
+        }
+        FileSync::writeAll(f, m_path, std::string(reinterpret_cast<const char*>(&price), sizeof(price)));
+        FileSync::GroupCommit::instance().sync({{m_path, false}});
+        m_stale = true;
+    }
+
+    std::string                          m_path;
+    mutable TradeSnapshot::Mapping       m_map;
+    mutable bool                         m_stale = true;
+    std::size_t                          m_count = 0;
+    long long                            m_last  = 0;
+};
+
+// Symbols with a tick file in `dir`.
+inline std::vector<std::string> listSymbols(const std::string& dir)
+{
+    std::vector<std::string> out;
+    std::error_code ec;
+    for (const auto& e : std::filesystem::directory_iterator(dir, ec))
+    {
+        if (!e.is_regular_file() || e.path().extension() != kExtension) continue;
+        out.push_back(decodeSymbol(e.path().stem().string()));
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+inline std::string pathFor(const std::string& dir, const std::string& symbol)
+{
+    return dir + "/" + encodeSymbol(symbol) + kExtension;
+}
+
+} // namespace TickStore
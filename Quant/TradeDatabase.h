@@ -6,17 +6,43 @@
 #include "IdGenerator.h"
 #include "PriceSeries.h"
 #include "json.h"
+#include "FileSync.h"
+#include "TradeSnapshot.h"
+#include "TriggerBook.h"
 
 #include <string>
 #include <vector>
 #include <fstream>
 #include <sstream>
+#include <iostream>
 #include <filesystem>
 #include <stdexcept>
 #include <iomanip>
 #include <algorithm>
 #include <chrono>
 #include <ctime>
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+#include <tuple>
+#include <set>
+#include <unordered_map>
+
+// JSON-backed ledger.
+//
+// Every file under the database directory is parsed once into a resident
+// typed collection and served from memory afterwards.  Mutators edit the
+// resident copy, mark it dirty and flush() rewrites only the dirty files,
+// so the on-disk layout is unchanged.  Files are replaced via temp +
+// fsync + rename (FileSync.h), so a crash never leaves a truncated file,
+// and a transaction commits all its files through one FileSync::Batch.
+//
+// In journal mode the append-mostly histories (trades, P&L, profit and
+// parameter snapshots) also keep an NDJSON journal beside their snapshot:
+// an append costs one line instead of a whole-file rewrite, and the
+// journal is folded back into the snapshot once it outgrows it.
+//
+// Thread safety: callers must hold their own mutex.
 
 class TradeDatabase
 {
@@ -25,7 +51,7 @@ public:
         : m_dir(directory)
     {
         std::filesystem::create_directories(m_dir);
-        seedIdGenerators();
+        FileSync::Batch::recover(intentPath());
     }
 
     // Diagnostic helpers so routes can report which on-disk DB is in use.
@@ -39,74 +65,47 @@ public:
     std::string tradesFilePath() const
     {
         std::error_code ec;
-        auto p = std::filesystem::absolute(tradesPath(), ec);
-        if (ec) return tradesPath();
+        auto p = std::filesystem::absolute(pathOf(m_trades), ec);
+        if (ec) return pathOf(m_trades);
         return p.lexically_normal().string();
     }
 
-    // Populate ID generators from existing data on disk so that
-    // acquire() finds the lowest free ID (gap-filling reuse).
+    // ID generators are seeded from the resident rows on first allocation
+    // (acquire() then finds the lowest free ID, gap-filling reuse), so
+    // opening a database reads nothing.  This forgets the current seeds.
     void seedIdGenerators()
     {
-        {
-            std::set<int> used;
-            for (const auto& t : loadTrades())
-                if (t.tradeId > 0) used.insert(t.tradeId);
-            m_tradeIdGen.seed(used);
-        }
-        {
-            std::set<int> used;
-            for (const auto& o : loadPendingExits())
-                if (o.orderId > 0) used.insert(o.orderId);
-            m_pendingIdGen.seed(used);
-        }
-        {
-            std::set<int> used;
-            for (const auto& ep : loadEntryPoints())
-                if (ep.entryId > 0) used.insert(ep.entryId);
-            m_entryIdGen.seed(used);
-        }
-        {
-            std::set<int> used;
-            for (const auto& ep : loadExitPoints())
-                if (ep.exitId > 0) used.insert(ep.exitId);
-            m_exitIdGen.seed(used);
-        }
+        m_tradeIds   = IdSource{};
+        m_pendingIds = IdSource{};
+        m_entryIds   = IdSource{};
+        m_exitIds    = IdSource{};
     }
 
     // ---- Trades ----
 
     void saveTrades(const std::vector<Trade>& trades)
     {
-        njs3::js_array arr;
+        auto& rows = edit(m_trades);
+        rows.clear();
+        rows.reserve(trades.size());
         for (const auto& t : trades)
-        {
-            njs3::json j(njs3::js_object{});
-            j["symbol"] = JStr(t.symbol);
-            j["tradeId"] = JI(t.tradeId);
-            j["type"] = JI(static_cast<int>(t.type));
-            j["value"] = JD(t.value);
-            j["quantity"] = JD(t.quantity);
-            j["parentTradeId"] = JI(t.parentTradeId);
-            j["shortEnabled"] = JB(t.shortEnabled);
-            j["buyFee"] = JD(t.buyFee);
-            j["sellFee"] = JD(t.sellFee);
-            j["timestamp"] = JLL(t.timestamp);
-            arr.push_back(std::move(j));
-        }
-        writeJson(tradesPath(), njs3::json(std::move(arr)));
+            rows.push_back(persisted(t));
+        m_positions.valid = false;
+        m_triggers.valid  = false;
+        flush();
     }
 
     void addTrade(const Trade& t)
     {
-        auto all = loadTrades();
-        all.push_back(t);
-        saveTrades(all);
+        append(m_trades, persisted(t));
+        if (positionsCurrent())
+            applyTrade(m_positions, m_trades.value.back(), +1.0);
+        flush();
     }
 
     void removeTrade(int tradeId)
     {
-        auto all = loadTrades();
+        auto& all = edit(m_trades);
 
         // cascade: if this is a parent Buy, also remove its CoveredSell children
         std::vector<int> idsToRemove = { tradeId };
@@ -114,58 +113,49 @@ public:
             if (t.parentTradeId == tradeId)
                 idsToRemove.push_back(t.tradeId);
 
+        bool indexed = positionsCurrent();
         all.erase(std::remove_if(all.begin(), all.end(), [&](const Trade& t) {
-            return std::find(idsToRemove.begin(), idsToRemove.end(), t.tradeId) != idsToRemove.end();
+            bool drop = std::find(idsToRemove.begin(), idsToRemove.end(), t.tradeId) != idsToRemove.end();
+            if (drop && indexed) applyTrade(m_positions, t, -1.0);
+            return drop;
         }), all.end());
-        saveTrades(all);
 
         // Release IDs back to the pool
         for (int id : idsToRemove)
-            m_tradeIdGen.release(id);
+            tradeIds().release(id);
 
-        auto hl = loadAllHorizons();
+        auto& hl = edit(m_horizons);
         hl.erase(std::remove_if(hl.begin(), hl.end(), [&](const std::tuple<std::string, int, HorizonLevel>& e) {
             return std::find(idsToRemove.begin(), idsToRemove.end(), std::get<1>(e)) != idsToRemove.end();
         }), hl.end());
-        saveAllHorizons(hl);
+        if (triggersCurrent())
+            for (int id : idsToRemove)
+                m_triggers.book.removeOwner(TriggerSource::Horizon, id);
+        flush();
     }
 
     void updateTrade(const Trade& updated)
     {
-        auto all = loadTrades();
-        for (auto& t : all)
+        bool indexed = positionsCurrent();
+        for (auto& t : edit(m_trades))
         {
             if (t.tradeId == updated.tradeId)
             {
-                t = updated;
+                if (indexed) applyTrade(m_positions, t, -1.0);
+                t = persisted(updated);
+                if (indexed) applyTrade(m_positions, t, +1.0);
                 break;
             }
         }
-        saveTrades(all);
+        // Horizon triggers are per unit of the Buy's quantity.
+        if (triggersCurrent())
+            refileHorizons(updated.tradeId);
+        flush();
     }
 
     std::vector<Trade> loadTrades() const
     {
-        std::vector<Trade> out;
-        auto j = readJsonArr(tradesPath());
-        const auto* a = j.as_array();
-        if (!a) return out;
-        for (const auto& item : *a)
-        {
-            Trade t;
-            t.symbol        = gs(item, "symbol");
-            t.tradeId       = gi(item, "tradeId");
-            t.type          = static_cast<TradeType>(gi(item, "type"));
-            t.value         = gd(item, "value");
-            t.quantity      = gd(item, "quantity");
-            t.parentTradeId = gi(item, "parentTradeId");
-            t.shortEnabled  = gb(item, "shortEnabled");
-            t.buyFee        = gd(item, "buyFee");
-            t.sellFee       = gd(item, "sellFee");
-            t.timestamp     = gll(item, "timestamp");
-            out.push_back(t);
-        }
-        return out;
+        return view(m_trades);
     }
 
     Trade* findTrade(std::vector<Trade>& trades,
@@ -187,68 +177,78 @@ public:
 
     double soldQuantityForParent(int parentId) const
     {
-        double sold = 0.0;
-        for (const auto& t : loadTrades())
-            if (t.type == TradeType::CoveredSell && t.parentTradeId == parentId)
-                sold += t.quantity;
-        return sold;
+        const Position* p = findPosition(parentId);
+        return p ? p->sold : 0.0;
+    }
+
+    // Quantity of a Buy still held: bought - sold - released.
+    double remainingForTrade(int tradeId) const
+    {
+        const Position* p = findPosition(tradeId);
+        return p ? p->remaining() : 0.0;
     }
 
     // Acquire the next available trade ID (gap-filling via IdGenerator).
     int nextTradeId()
     {
-        int id = m_tradeIdGen.acquire();
-        m_tradeIdGen.commit(id);
+        IdGenerator& gen = tradeIds();
+        int id = gen.acquire();
+        gen.commit(id);
         return id;
     }
 
     // Release a trade ID back to the pool (e.g. after deletion).
-    void releaseTradeId(int id) { m_tradeIdGen.release(id); }
+    void releaseTradeId(int id) { tradeIds().release(id); }
 
-    IdGenerator&       tradeIdGen()       { return m_tradeIdGen; }
-    const IdGenerator& tradeIdGen() const { return m_tradeIdGen; }
+    IdGenerator&       tradeIdGen()       { return tradeIds(); }
+    const IdGenerator& tradeIdGen() const { return tradeIds(); }
 
     // ---- Horizon Levels ----
 
     void saveHorizonLevels(const std::string& symbol, int tradeId,
                            const std::vector<HorizonLevel>& levels)
     {
-        auto all = loadAllHorizons();
+        auto& all = edit(m_horizons);
         all.erase(std::remove_if(all.begin(), all.end(), [&](const std::tuple<std::string, int, HorizonLevel>& e) {
-            return std::get<0>(e) == symbol && std::get<1>(e) == tradeId;
+            return std::get<1>(e) == tradeId && std::get<0>(e) == symbol;
         }), all.end());
         for (const auto& lv : levels)
             all.emplace_back(symbol, tradeId, lv);
-        saveAllHorizons(all);
+        if (triggersCurrent())
+            refileHorizons(tradeId);
+        flush();
     }
 
     std::vector<HorizonLevel> loadHorizonLevels(const std::string& symbol,
                                                  int tradeId) const
     {
         std::vector<HorizonLevel> out;
-        for (const auto& [sym, tid, lv] : loadAllHorizons())
-            if (sym == symbol && tid == tradeId)
+        for (const auto& [sym, tid, lv] : view(m_horizons))
+            if (tid == tradeId && sym == symbol)
                 out.push_back(lv);
         return out;
     }
 
+    // Every (symbol, tradeId, level) row, for callers that group them.
+    std::vector<std::tuple<std::string, int, HorizonLevel>> loadAllHorizons() const
+    {
+        return view(m_horizons);
+    }
+
     // ---- Profit Snapshots ----
 
     void saveProfitSnapshot(const std::string& symbol, int tradeId,
                             double currentPrice, const ProfitResult& r)
     {
-        auto j = readJsonArr(profitsPath());
-        auto* a = j.as_array();
-        if (!a) { j = njs3::json(njs3::js_array{}); a = j.as_array(); }
-        njs3::json row(njs3::js_object{});
-        row["symbol"] = JStr(symbol);
-        row["tradeId"] = JI(tradeId);
-        row["currentPrice"] = JD(currentPrice);
-        row["grossProfit"] = JD(r.grossProfit);
-        row["netProfit"] = JD(r.netProfit);
-        row["roi"] = JD(r.roi);
-        a->push_back(std::move(row));
-        writeJson(profitsPath(), j);
+        ProfitRow row;
+        row.symbol       = symbol;
+        row.tradeId      = tradeId;
+        row.currentPrice = currentPrice;
+        row.grossProfit  = r.grossProfit;
+        row.netProfit    = r.netProfit;
+        row.roi          = r.roi;
+        append(m_profits, row);
+        flush();
     }
 
     struct ProfitRow
@@ -263,22 +263,7 @@ public:
 
     std::vector<ProfitRow> loadProfitHistory() const
     {
-        std::vector<ProfitRow> out;
-        auto j = readJsonArr(profitsPath());
-        const auto* a = j.as_array();
-        if (!a) return out;
-        for (const auto& item : *a)
-        {
-            ProfitRow r;
-            r.symbol       = gs(item, "symbol");
-            r.tradeId      = gi(item, "tradeId");
-            r.currentPrice = gd(item, "currentPrice");
-            r.grossProfit  = gd(item, "grossProfit");
-            r.netProfit    = gd(item, "netProfit");
-            r.roi          = gd(item, "roi");
-            out.push_back(r);
-        }
-        return out;
+        return view(m_profits);
     }
 
     // ---- Parameter Snapshots ----
@@ -353,64 +338,13 @@ public:
 
     void saveParamsSnapshot(const ParamsRow& r)
     {
-        auto j = readJsonArr(paramsPath());
-        auto* a = j.as_array();
-        if (!a) { j = njs3::json(njs3::js_array{}); a = j.as_array(); }
-        njs3::json row(njs3::js_object{});
-        row["calcType"] = JStr(r.calcType);
-        row["symbol"] = JStr(r.symbol);
-        row["tradeId"] = JI(r.tradeId);
-        row["currentPrice"] = JD(r.currentPrice);
-        row["quantity"] = JD(r.quantity);
-        row["buyFees"] = JD(r.buyFees);
-        row["sellFees"] = JD(r.sellFees);
-        row["feeHedgingCoefficient"] = JD(r.feeHedgingCoefficient);
-        row["portfolioPump"] = JD(r.portfolioPump);
-        row["symbolCount"] = JI(r.symbolCount);
-        row["coefficientK"] = JD(r.coefficientK);
-        row["feeSpread"] = JD(r.feeSpread);
-        row["deltaTime"] = JD(r.deltaTime);
-        row["surplusRate"] = JD(r.surplusRate);
-        row["horizonCount"] = JI(r.horizonCount);
-        row["generateStopLosses"] = JB(r.generateStopLosses);
-        row["riskCoefficient"] = JD(r.riskCoefficient);
-        row["maxRisk"] = JD(r.maxRisk);
-        row["minRisk"] = JD(r.minRisk);
-        a->push_back(std::move(row));
-        writeJson(paramsPath(), j);
+        append(m_params, r);
+        flush();
     }
 
     std::vector<ParamsRow> loadParamsHistory() const
     {
-        std::vector<ParamsRow> out;
-        auto j = readJsonArr(paramsPath());
-        const auto* a = j.as_array();
-        if (!a) return out;
-        for (const auto& item : *a)
-        {
-            ParamsRow r;
-            r.calcType              = gs(item, "calcType");
-            r.symbol                = gs(item, "symbol");
-            r.tradeId               = gi(item, "tradeId");
-            r.currentPrice          = gd(item, "currentPrice");
-            r.quantity              = gd(item, "quantity");
-            r.buyFees               = gd(item, "buyFees");
-            r.sellFees              = gd(item, "sellFees");
-            r.feeHedgingCoefficient = gd(item, "feeHedgingCoefficient");
-            r.portfolioPump         = gd(item, "portfolioPump");
-            r.symbolCount           = gi(item, "symbolCount");
-            r.coefficientK          = gd(item, "coefficientK");
-            r.feeSpread             = gd(item, "feeSpread");
-            r.deltaTime             = gd(item, "deltaTime");
-            r.surplusRate           = gd(item, "surplusRate");
-            r.horizonCount          = gi(item, "horizonCount");
-            r.generateStopLosses    = gb(item, "generateStopLosses");
-            r.riskCoefficient       = gd(item, "riskCoefficient");
-            r.maxRisk               = gd(item, "maxRisk");
-            r.minRisk               = gd(item, "minRisk");
-            out.push_back(r);
-        }
-        return out;
+        return view(m_params);
     }
 
     // ---- Pending Exits ----
@@ -427,67 +361,53 @@ public:
 
     void savePendingExits(const std::vector<PendingExit>& orders)
     {
-        njs3::js_array arr;
-        for (const auto& o : orders)
+        edit(m_pendingExits) = orders;
+        if (triggersCurrent())
         {
-            njs3::json j(njs3::js_object{});
-            j["symbol"] = JStr(o.symbol);
-            j["orderId"] = JI(o.orderId);
-            j["tradeId"] = JI(o.tradeId);
-            j["triggerPrice"] = JD(o.triggerPrice);
-            j["sellQty"] = JD(o.sellQty);
-            j["levelIndex"] = JI(o.levelIndex);
-            arr.push_back(std::move(j));
+            m_triggers.book.removeSource(TriggerSource::Pending);
+            for (const auto& o : orders)
+                filePending(m_triggers.book, o);
         }
-        writeJson(pendingExitsPath(), njs3::json(std::move(arr)));
+        flush();
     }
 
     std::vector<PendingExit> loadPendingExits() const
     {
-        std::vector<PendingExit> out;
-        auto j = readJsonArr(pendingExitsPath());
-        const auto* a = j.as_array();
-        if (!a) return out;
-        for (const auto& item : *a)
-        {
-            PendingExit o;
-            o.symbol       = gs(item, "symbol");
-            o.orderId      = gi(item, "orderId");
-            o.tradeId      = gi(item, "tradeId");
-            o.triggerPrice = gd(item, "triggerPrice");
-            o.sellQty      = gd(item, "sellQty");
-            o.levelIndex   = gi(item, "levelIndex");
-            out.push_back(o);
-        }
-        return out;
+        return view(m_pendingExits);
     }
 
     void addPendingExits(const std::vector<PendingExit>& orders)
     {
-        auto all = loadPendingExits();
-        for (const auto& o : orders) all.push_back(o);
-        savePendingExits(all);
+        auto& all = edit(m_pendingExits);
+        all.insert(all.end(), orders.begin(), orders.end());
+        if (triggersCurrent())
+            for (const auto& o : orders)
+                filePending(m_triggers.book, o);
+        flush();
     }
 
     void removePendingExit(int orderId)
     {
-        auto all = loadPendingExits();
+        auto& all = edit(m_pendingExits);
         all.erase(std::remove_if(all.begin(), all.end(), [orderId](const PendingExit& o) { return o.orderId == orderId; }), all.end());
-        savePendingExits(all);
-        m_pendingIdGen.release(orderId);
+        if (triggersCurrent())
+            m_triggers.book.removeOwner(TriggerSource::Pending, orderId);
+        flush();
+        pendingIds().release(orderId);
     }
 
     int nextPendingId()
     {
-        int id = m_pendingIdGen.acquire();
-        m_pendingIdGen.commit(id);
+        IdGenerator& gen = pendingIds();
+        int id = gen.acquire();
+        gen.commit(id);
         return id;
     }
 
-    void releasePendingId(int id) { m_pendingIdGen.release(id); }
+    void releasePendingId(int id) { pendingIds().release(id); }
 
-    IdGenerator&       pendingIdGen()       { return m_pendingIdGen; }
-    const IdGenerator& pendingIdGen() const { return m_pendingIdGen; }
+    IdGenerator&       pendingIdGen()       { return pendingIds(); }
+    const IdGenerator& pendingIdGen() const { return pendingIds(); }
 
     // ---- Exit Points ----
 
@@ -508,70 +428,66 @@ public:
 
     void saveExitPoints(const std::vector<ExitPoint>& points)
     {
-        njs3::js_array arr;
-        for (const auto& ep : points)
+        edit(m_exitPoints) = points;
+        if (triggersCurrent())
         {
-            njs3::json j(njs3::js_object{});
-            j["exitId"] = JI(ep.exitId);
-            j["tradeId"] = JI(ep.tradeId);
-            j["symbol"] = JStr(ep.symbol);
-            j["levelIndex"] = JI(ep.levelIndex);
-            j["tpPrice"] = JD(ep.tpPrice);
-            j["slPrice"] = JD(ep.slPrice);
-            j["sellQty"] = JD(ep.sellQty);
-            j["sellFraction"] = JD(ep.sellFraction);
-            j["slActive"] = JB(ep.slActive);
-            j["executed"] = JB(ep.executed);
-            j["linkedSellId"] = JI(ep.linkedSellId);
-            arr.push_back(std::move(j));
+            m_triggers.book.removeSource(TriggerSource::Exit);
+            for (const auto& xp : points)
+                fileExit(m_triggers.book, xp);
         }
-        writeJson(exitPointsPath(), njs3::json(std::move(arr)));
+        flush();
+    }
+
+    void addExitPoints(const std::vector<ExitPoint>& points)
+    {
+        auto& all = edit(m_exitPoints);
+        all.insert(all.end(), points.begin(), points.end());
+        if (triggersCurrent())
+            for (const auto& xp : points)
+                fileExit(m_triggers.book, xp);
+        flush();
+    }
+
+    // Mark an unexecuted exit point as filled by sell `linkedSellId`.
+    bool markExitExecuted(int exitId, int linkedSellId)
+    {
+        const auto& rows = view(m_exitPoints);
+        auto it = std::find_if(rows.begin(), rows.end(), [exitId](const ExitPoint& xp) { return xp.exitId == exitId; });
+        if (it == rows.end() || it->executed) return false;
+        auto& xp = edit(m_exitPoints)[static_cast<std::size_t>(it - rows.begin())];
+        xp.executed     = true;
+        xp.linkedSellId = linkedSellId;
+        if (triggersCurrent())
+            m_triggers.book.removeOwner(TriggerSource::Exit, exitId);
+        flush();
+        return true;
     }
 
     std::vector<ExitPoint> loadExitPoints() const
     {
-        std::vector<ExitPoint> out;
-        auto j = readJsonArr(exitPointsPath());
-        const auto* a = j.as_array();
-        if (!a) return out;
-        for (const auto& item : *a)
-        {
-            ExitPoint ep;
-            ep.exitId        = gi(item, "exitId");
-            ep.tradeId       = gi(item, "tradeId");
-            ep.symbol        = gs(item, "symbol");
-            ep.levelIndex    = gi(item, "levelIndex");
-            ep.tpPrice       = gd(item, "tpPrice");
-            ep.slPrice       = gd(item, "slPrice");
-            ep.sellQty       = gd(item, "sellQty");
-            ep.sellFraction  = gd(item, "sellFraction");
-            ep.slActive      = gb(item, "slActive");
-            ep.executed      = gb(item, "executed");
-            ep.linkedSellId  = gi(item, "linkedSellId");
-            out.push_back(ep);
-        }
-        return out;
+        return view(m_exitPoints);
     }
 
     std::vector<ExitPoint> loadExitPointsForTrade(int tradeId) const
     {
         std::vector<ExitPoint> out;
-        for (const auto& ep : loadExitPoints())
+        for (const auto& ep : view(m_exitPoints))
             if (ep.tradeId == tradeId) out.push_back(ep);
         return out;
     }
 
     int nextExitId()
     {
-        int id = m_exitIdGen.acquire();
-        m_exitIdGen.commit(id);
+        IdGenerator& gen = exitIds();
+        int id = gen.acquire();
+        gen.commit(id);
         return id;
     }
 
-    void releaseExitId(int id) { m_exitIdGen.release(id); }
+    void releaseExitId(int id) { exitIds().release(id); }
 
-    IdGenerator&       exitIdGen()       { return m_exitIdGen; }
-    const IdGenerator& exitIdGen() const { return m_exitIdGen; }
+    IdGenerator&       exitIdGen()       { return exitIds(); }
+    const IdGenerator& exitIdGen() const { return exitIds(); }
 
     // ---- Entry Points ----
 
@@ -596,84 +512,88 @@ public:
 
     void saveEntryPoints(const std::vector<EntryPoint>& points)
     {
-        njs3::js_array arr;
-        for (const auto& ep : points)
+        auto& rows = edit(m_entryPoints);
+        rows = points;
+        // stopLossActive is derived from the fraction on load
+        for (auto& ep : rows)
+            ep.stopLossActive = (ep.stopLossFraction > 0.0);
+        if (triggersCurrent())
         {
-            njs3::json j(njs3::js_object{});
-            j["symbol"] = JStr(ep.symbol);
-            j["entryId"] = JI(ep.entryId);
-            j["levelIndex"] = JI(ep.levelIndex);
-            j["entryPrice"] = JD(ep.entryPrice);
-            j["breakEven"] = JD(ep.breakEven);
-            j["funding"] = JD(ep.funding);
-            j["fundingQty"] = JD(ep.fundingQty);
-            j["effectiveOverhead"] = JD(ep.effectiveOverhead);
-            j["isShort"] = JB(ep.isShort);
-            j["traded"] = JB(ep.traded);
-            j["linkedTradeId"] = JI(ep.linkedTradeId);
-            j["exitTakeProfit"] = JD(ep.exitTakeProfit);
-            j["exitStopLoss"] = JD(ep.exitStopLoss);
-            j["stopLossFraction"] = JD(ep.stopLossFraction);
-            j["stopLossActive"] = JB(ep.stopLossActive);
-            arr.push_back(std::move(j));
+            m_triggers.book.removeSource(TriggerSource::Entry);
+            for (const auto& ep : rows)
+                fileEntry(m_triggers.book, ep);
         }
-        writeJson(entryPointsPath(), njs3::json(std::move(arr)));
+        flush();
     }
 
     std::vector<EntryPoint> loadEntryPoints() const
     {
-        std::vector<EntryPoint> out;
-        auto j = readJsonArr(entryPointsPath());
-        const auto* a = j.as_array();
-        if (!a) return out;
-        for (const auto& item : *a)
-        {
-            EntryPoint ep;
-            ep.symbol            = gs(item, "symbol");
-            ep.entryId           = gi(item, "entryId");
-            ep.levelIndex        = gi(item, "levelIndex");
-            ep.entryPrice        = gd(item, "entryPrice");
-            ep.breakEven         = gd(item, "breakEven");
-            ep.funding           = gd(item, "funding");
-            ep.fundingQty        = gd(item, "fundingQty");
-            ep.effectiveOverhead = gd(item, "effectiveOverhead");
-            ep.isShort           = gb(item, "isShort");
-            ep.traded            = gb(item, "traded");
-            ep.linkedTradeId     = gi(item, "linkedTradeId");
-            ep.exitTakeProfit    = gd(item, "exitTakeProfit");
-            ep.exitStopLoss      = gd(item, "exitStopLoss");
-            ep.stopLossFraction  = gd(item, "stopLossFraction");
-            ep.stopLossActive    = (ep.stopLossFraction > 0.0);
-            out.push_back(ep);
-        }
-        return out;
+        return view(m_entryPoints);
+    }
+
+    // Mark an untraded entry point as filled by Buy `linkedTradeId`.
+    bool markEntryTraded(int entryId, int linkedTradeId)
+    {
+        const auto& rows = view(m_entryPoints);
+        auto it = std::find_if(rows.begin(), rows.end(), [entryId](const EntryPoint& ep) { return ep.entryId == entryId; });
+        if (it == rows.end() || it->traded) return false;
+        auto& ep = edit(m_entryPoints)[static_cast<std::size_t>(it - rows.begin())];
+        ep.traded        = true;
+        ep.linkedTradeId = linkedTradeId;
+        if (triggersCurrent())
+            m_triggers.book.removeOwner(TriggerSource::Entry, entryId);
+        flush();
+        return true;
     }
 
     int nextEntryId()
     {
-        int id = m_entryIdGen.acquire();
-        m_entryIdGen.commit(id);
+        IdGenerator& gen = entryIds();
+        int id = gen.acquire();
+        gen.commit(id);
         return id;
     }
 
-    void releaseEntryId(int id) { m_entryIdGen.release(id); }
+    void releaseEntryId(int id) { entryIds().release(id); }
+
+    IdGenerator&       entryIdGen()       { return entryIds(); }
+    const IdGenerator& entryIdGen() const { return entryIds(); }
+
+    // ---- Triggers ----
+
+    // Live triggers on `symbol` that a market price of `price` has crossed:
+    // take-profits, pending exits and short entries at or below it, then
+    // stop-losses and long entries at or above it.  Horizon levels are
+    // scaled to per-unit prices of their Buy; executed exit points and
+    // traded entry points are not in the book.
+    std::vector<Trigger> crossedTriggers(const std::string& symbol, double price) const
+    {
+        return triggers().crossed(symbol, price);
+    }
+
+    std::vector<Trigger> crossedTriggers(SymbolId symbol, double price) const
+    {
+        return triggers().crossed(symbol, price);
+    }
 
-    IdGenerator&       entryIdGen()       { return m_entryIdGen; }
-    const IdGenerator& entryIdGen() const { return m_entryIdGen; }
+    // True while the row still has a live trigger: exit point not
+    // executed, entry point not traded, pending exit not removed.
+    bool triggerLive(TriggerSource source, int id) const
+    {
+        return triggers().hasOwner(source, id);
+    }
 
     // ---- Wallet ----
 
     double loadWalletBalance() const
     {
-        auto j = readJsonObj(walletPath());
-        return static_cast<double>(j["balance"]->get_number_or(0.0L));
+        return view(m_wallet);
     }
 
     void saveWalletBalance(double balance)
     {
-        njs3::json j(njs3::js_object{});
-        j["balance"] = JD(balance);
-        writeJson(walletPath(), j);
+        edit(m_wallet) = balance;
+        flush();
     }
 
     void deposit(double amount)
@@ -688,13 +608,13 @@ public:
 
     double deployedCapital() const
     {
+        const auto& pos = positions();
         double deployed = 0.0;
-        for (const auto& t : loadTrades())
+        for (const auto& t : view(m_trades))
         {
             if (t.type != TradeType::Buy) continue;
-            double sold = soldQuantityForParent(t.tradeId);
-            double released = releasedForTrade(t.tradeId);
-            double remaining = t.quantity - sold - released;
+            const Position& p = pos.byTrade.at(t.tradeId);
+            double remaining = t.quantity - p.sold - p.released;
             if (remaining <= 0) continue;
             double remainFrac = t.quantity > 0 ? remaining / t.quantity : 0.0;
             deployed += QuantMath::cost(t.value, remaining) + t.buyFee * remainFrac;
@@ -706,22 +626,15 @@ public:
 
     double releasedForTrade(int tradeId) const
     {
-        double total = 0.0;
-        auto j = readJsonArr(releasedPath());
-        const auto* a = j.as_array();
-        if (!a) return 0.0;
-        for (const auto& item : *a)
-        {
-            if (gi(item, "tradeId") == tradeId)
-                total += gd(item, "qty");
-        }
-        return total;
+        const Position* p = findPosition(tradeId);
+        return p ? p->released : 0.0;
     }
 
     bool releaseFromTrade(int tradeId, double qty)
     {
-        auto trades = loadTrades();
-        auto* t = findTradeById(trades, tradeId);
+        const Trade* t = nullptr;
+        for (const auto& x : view(m_trades))
+            if (x.tradeId == tradeId) { t = &x; break; }
         if (!t || t->type != TradeType::Buy) return false;
 
         double sold = soldQuantityForParent(tradeId);
@@ -730,43 +643,37 @@ public:
         if (qty > allocated + 1e-9) return false;
         if (qty > allocated) qty = allocated;
 
-        auto j = readJsonArr(releasedPath());
-        auto* a = j.as_array();
-        if (!a) { j = njs3::json(njs3::js_array{}); a = j.as_array(); }
-        njs3::json row(njs3::js_object{});
-        row["symbol"] = JStr(t->symbol);
-        row["tradeId"] = JI(tradeId);
-        row["qty"] = JD(qty);
-        a->push_back(std::move(row));
-        writeJson(releasedPath(), j);
+        ReleasedRow row;
+        row.symbol  = t->symbol;
+        row.tradeId = tradeId;
+        row.qty     = qty;
+        append(m_released, row);
+        if (positionsCurrent())
+            m_positions.byTrade[tradeId].released += qty;
+        flush();
         return true;
     }
 
     bool hasBuyTrades() const
     {
-        for (const auto& t : loadTrades())
-            if (t.type == TradeType::Buy) return true;
-        return false;
+        return positions().buyCount > 0;
     }
 
     bool hasAnyHorizons() const
     {
-        return !loadAllHorizons().empty();
+        return !view(m_horizons).empty();
     }
 
     // Compute net holdings for a symbol (total bought - total sold).
     double holdingsForSymbol(const std::string& symbol) const
     {
-        double holdings = 0.0;
-        for (const auto& t : loadTrades())
-        {
-            if (t.symbol != symbol) continue;
-            if (t.type == TradeType::Buy)
-                holdings += t.quantity;
-            else
-                holdings -= t.quantity;
-        }
-        return holdings;
+        return holdingsForSymbol(SymbolRegistry::lookup(symbol));
+    }
+
+    double holdingsForSymbol(SymbolId symbol) const
+    {
+        const SymbolPositions* sp = positions().of(symbol);
+        return sp ? sp->holdings : 0.0;
     }
 
     // Execute a sell: deduct from the symbol's holdings, credit wallet with (proceeds - sellFee).
@@ -775,27 +682,26 @@ public:
     {
         if (symbol.empty()) return -1;
 
+        // One write per touched file, and nothing written if a lot fails.
+        Transaction txn(*this);
+
         // Build FIFO buy lots with currently available quantity so sells can be linked
         // to parent buys. This keeps sold/remaining and deployed accounting correct.
-        auto allTrades = loadTrades();
+        const auto& pos = positions();
         struct BuyLot { int tradeId; double available; };
         std::vector<BuyLot> lots;
-        lots.reserve(allTrades.size());
 
-        for (const auto& t : allTrades)
+        if (const SymbolPositions* sp = pos.of(SymbolRegistry::lookup(symbol)))
         {
-            if (t.type != TradeType::Buy || t.symbol != symbol) continue;
-            double sold = soldQuantityForParent(t.tradeId);
-            double released = releasedForTrade(t.tradeId);
-            double available = t.quantity - sold - released;
-            if (available > 1e-9)
-                lots.push_back({t.tradeId, available});
+            lots.reserve(sp->buys.size());
+            for (int id : sp->buys)  // ascending trade id
+            {
+                double available = pos.byTrade.at(id).remaining();
+                if (available > 1e-9)
+                    lots.push_back({id, available});
+            }
         }
 
-        std::sort(lots.begin(), lots.end(), [](const BuyLot& a, const BuyLot& b) {
-            return a.tradeId < b.tradeId;
-        });
-
         double totalAvailable = 0.0;
         for (const auto& lot : lots) totalAvailable += lot.available;
         if (sellQty > totalAvailable + 1e-9) return -1;
@@ -831,6 +737,7 @@ public:
         double proceeds = sellPrice * sellQty - sellFee;
         deposit(proceeds);
 
+        txn.commit();
         return firstSellId;
     }
 
@@ -841,10 +748,11 @@ public:
     {
         if (symbol.empty()) return -1;
 
-        auto trades = loadTrades();
-        Trade* parent = nullptr;
-        for (auto& t : trades)
-            if (t.tradeId == parentTradeId) { parent = &t; break; }
+        // Copy the parent: addTrade() below may reallocate the resident rows.
+        Trade parentRow;
+        const Trade* parent = nullptr;
+        for (const auto& t : view(m_trades))
+            if (t.tradeId == parentTradeId) { parentRow = t; parent = &parentRow; break; }
         if (!parent || parent->type != TradeType::Buy || parent->symbol != symbol)
             return -1;
 
@@ -853,6 +761,8 @@ public:
         if (sellQty > remaining + 1e-9) return -1;
         if (sellQty > remaining) sellQty = remaining;
 
+        Transaction txn(*this);
+
         Trade sell;
         sell.tradeId       = nextTradeId();
         sell.symbol        = symbol;
@@ -873,6 +783,7 @@ public:
         recordPnl(symbol, sell.tradeId, parentTradeId,
                   parent->value, sellPrice, sellQty, gp, np);
 
+        txn.commit();
         return sell.tradeId;
     }
 
@@ -880,6 +791,8 @@ public:
     // Returns the new trade ID.
     int executeBuy(const std::string& symbol, double price, double qty, double buyFee = 0.0)
     {
+        Transaction txn(*this);
+
         Trade buy;
         buy.tradeId    = nextTradeId();
         buy.symbol     = symbol;
@@ -893,6 +806,7 @@ public:
         double buyCost = QuantMath::cost(price, qty) + buyFee;
         withdraw(buyCost);
 
+        txn.commit();
         return buy.tradeId;
     }
 
@@ -902,7 +816,7 @@ public:
     // Useful for backtesting: trades become historical data points.
     void seedPriceSeries(PriceSeries& ps) const
     {
-        for (const auto& t : loadTrades())
+        for (const auto& t : view(m_trades))
         {
             if (t.timestamp > 0 && t.value > 0.0)
                 ps.set(t.symbol, t.timestamp, t.value);
@@ -1169,89 +1083,29 @@ tr:nth-child(even){background:#0f1b2d}
 
     void saveParamModels(const std::vector<ParamModel>& models)
     {
-        njs3::js_array arr;
-        for (const auto& m : models)
-        {
-            njs3::json j(njs3::js_object{});
-            j["name"] = JStr(m.name);
-            j["levels"] = JI(m.levels);
-            j["risk"] = JD(m.risk);
-            j["steepness"] = JD(m.steepness);
-            j["feeHedgingCoefficient"] = JD(m.feeHedgingCoefficient);
-            j["portfolioPump"] = JD(m.portfolioPump);
-            j["symbolCount"] = JI(m.symbolCount);
-            j["coefficientK"] = JD(m.coefficientK);
-            j["feeSpread"] = JD(m.feeSpread);
-            j["deltaTime"] = JD(m.deltaTime);
-            j["surplusRate"] = JD(m.surplusRate);
-            j["maxRisk"] = JD(m.maxRisk);
-            j["minRisk"] = JD(m.minRisk);
-            j["isShort"] = JB(m.isShort);
-            j["fundMode"] = JI(m.fundMode);
-            j["generateStopLosses"] = JB(m.generateStopLosses);
-            j["rangeAbove"] = JD(m.rangeAbove);
-            j["rangeBelow"] = JD(m.rangeBelow);
-            j["rangeAbovePerDt"] = JD(m.rangeAbovePerDt);
-            j["rangeBelowPerDt"] = JD(m.rangeBelowPerDt);
-            j["futureTradeCount"] = JI(m.futureTradeCount);
-            j["stopLossFraction"] = JD(m.stopLossFraction);
-            j["stopLossHedgeCount"] = JI(m.stopLossHedgeCount);
-            arr.push_back(std::move(j));
-        }
-        writeJson(paramModelsPath(), njs3::json(std::move(arr)));
+        edit(m_paramModels) = models;
+        flush();
     }
 
     std::vector<ParamModel> loadParamModels() const
     {
-        std::vector<ParamModel> out;
-        auto j = readJsonArr(paramModelsPath());
-        const auto* a = j.as_array();
-        if (!a) return out;
-        for (const auto& item : *a)
-        {
-            ParamModel m;
-            m.name                  = gs(item, "name");
-            m.levels                = gi(item, "levels");
-            m.risk                  = gd(item, "risk");
-            m.steepness             = gd(item, "steepness");
-            m.feeHedgingCoefficient = gd(item, "feeHedgingCoefficient");
-            m.portfolioPump         = gd(item, "portfolioPump");
-            m.symbolCount           = gi(item, "symbolCount");
-            m.coefficientK          = gd(item, "coefficientK");
-            m.feeSpread             = gd(item, "feeSpread");
-            m.deltaTime             = gd(item, "deltaTime");
-            m.surplusRate           = gd(item, "surplusRate");
-            m.maxRisk               = gd(item, "maxRisk");
-            m.minRisk               = gd(item, "minRisk");
-            m.isShort               = gb(item, "isShort");
-            m.fundMode              = gi(item, "fundMode");
-            m.generateStopLosses    = gb(item, "generateStopLosses");
-            m.rangeAbove            = gd(item, "rangeAbove");
-            m.rangeBelow            = gd(item, "rangeBelow");
-            m.rangeAbovePerDt       = gd(item, "rangeAbovePerDt");
-            m.rangeBelowPerDt       = gd(item, "rangeBelowPerDt");
-            m.futureTradeCount      = gi(item, "futureTradeCount");
-            m.stopLossFraction      = gd(item, "stopLossFraction");
-            m.stopLossHedgeCount    = gi(item, "stopLossHedgeCount");
-            out.push_back(m);
-        }
-        return out;
+        return view(m_paramModels);
     }
 
     void addParamModel(const ParamModel& model)
     {
-        auto all = loadParamModels();
+        auto& all = edit(m_paramModels);
         // overwrite if name already exists
         all.erase(std::remove_if(all.begin(), all.end(), [&](const ParamModel& m) { return m.name == model.name; }), all.end());
         all.push_back(model);
-        saveParamModels(all);
+        flush();
     }
 
     void removeParamModel(const std::string& name)
     {
-        auto all = loadParamModels();
+        auto& all = edit(m_paramModels);
         all.erase(std::remove_if(all.begin(), all.end(), [&](const ParamModel& m) { return m.name == name; }), all.end());
-        saveParamModels(all);
+        flush();
     }
 
     const ParamModel* findParamModel(const std::vector<ParamModel>& models,
@@ -1282,7 +1136,7 @@ tr:nth-child(even){background:#0f1b2d}
                    double entryPrice, double sellPrice, double qty,
                    double grossProfit, double netProfit)
     {
-        auto history = loadPnl();
+        const auto& history = view(m_pnl);
         double cum = history.empty() ? 0.0 : history.back().cumProfit;
         cum += netProfit;
 
@@ -1290,46 +1144,24 @@ tr:nth-child(even){background:#0f1b2d}
         long long ts = std::chrono::duration_cast<std::chrono::seconds>(
             now.time_since_epoch()).count();
 
-        auto j = readJsonArr(pnlPath());
-        auto* a = j.as_array();
-        if (!a) { j = njs3::json(njs3::js_array{}); a = j.as_array(); }
-        njs3::json row(njs3::js_object{});
-        row["timestamp"] = JLL(ts);
-        row["symbol"] = JStr(symbol);
-        row["sellTradeId"] = JI(sellId);
-        row["parentTradeId"] = JI(parentId);
-        row["entryPrice"] = JD(entryPrice);
-        row["sellPrice"] = JD(sellPrice);
-        row["quantity"] = JD(qty);
-        row["grossProfit"] = JD(grossProfit);
-        row["netProfit"] = JD(netProfit);
-        row["cumProfit"] = JD(cum);
-        a->push_back(std::move(row));
-        writeJson(pnlPath(), j);
+        PnlEntry e;
+        e.timestamp     = ts;
+        e.symbol        = symbol;
+        e.sellTradeId   = sellId;
+        e.parentTradeId = parentId;
+        e.entryPrice    = entryPrice;
+        e.sellPrice     = sellPrice;
+        e.quantity      = qty;
+        e.grossProfit   = grossProfit;
+        e.netProfit     = netProfit;
+        e.cumProfit     = cum;
+        append(m_pnl, e);
+        flush();
     }
 
     std::vector<PnlEntry> loadPnl() const
     {
-        std::vector<PnlEntry> out;
-        auto j = readJsonArr(pnlPath());
-        const auto* a = j.as_array();
-        if (!a) return out;
-        for (const auto& item : *a)
-        {
-            PnlEntry e;
-            e.timestamp     = gll(item, "timestamp");
-            e.symbol        = gs(item, "symbol");
-            e.sellTradeId   = gi(item, "sellTradeId");
-            e.parentTradeId = gi(item, "parentTradeId");
-            e.entryPrice    = gd(item, "entryPrice");
-            e.sellPrice     = gd(item, "sellPrice");
-            e.quantity      = gd(item, "quantity");
-            e.grossProfit   = gd(item, "grossProfit");
-            e.netProfit     = gd(item, "netProfit");
-            e.cumProfit     = gd(item, "cumProfit");
-            out.push_back(e);
-        }
-        return out;
+        return view(m_pnl);
     }
 
     // ---- Chain Execution State ----
@@ -1351,60 +1183,29 @@ tr:nth-child(even){background:#0f1b2d}
 
     void saveChainState(const ChainState& state)
     {
-        njs3::json j(njs3::js_object{});
-        j["symbol"] = JStr(state.symbol);
-        j["currentCycle"] = JI(state.currentCycle);
-        j["totalSavings"] = JD(state.totalSavings);
-        j["savingsRate"] = JD(state.savingsRate);
-        j["active"] = JB(state.active);
-        writeJson(chainStatePath(), j);
+        edit(m_chainState) = state;
+        flush();
     }
 
     ChainState loadChainState() const
     {
-        ChainState state;
-        auto j = readJsonObj(chainStatePath());
-        if (!j->is_object()) return state;
-        state.symbol       = gs(j, "symbol");
-        state.currentCycle = gi(j, "currentCycle");
-        state.totalSavings = gd(j, "totalSavings");
-        state.savingsRate  = gd(j, "savingsRate");
-        state.active       = gb(j, "active");
-        return state;
+        return view(m_chainState);
     }
 
     void saveChainMembers(const std::vector<ChainMember>& members)
     {
-        njs3::js_array arr;
-        for (const auto& m : members)
-        {
-            njs3::json j(njs3::js_object{});
-            j["cycle"] = JI(m.cycle);
-            j["entryId"] = JI(m.entryId);
-            arr.push_back(std::move(j));
-        }
-        writeJson(chainMembersPath(), njs3::json(std::move(arr)));
+        edit(m_chainMembers) = members;
+        flush();
     }
 
     std::vector<ChainMember> loadChainMembers() const
     {
-        std::vector<ChainMember> out;
-        auto j = readJsonArr(chainMembersPath());
-        const auto* a = j.as_array();
-        if (!a) return out;
-        for (const auto& item : *a)
-        {
-            ChainMember m;
-            m.cycle   = gi(item, "cycle");
-            m.entryId = gi(item, "entryId");
-            out.push_back(m);
-        }
-        return out;
+        return view(m_chainMembers);
     }
 
     void addChainMembers(int cycle, const std::vector<int>& entryIds)
     {
-        auto all = loadChainMembers();
+        auto& all = edit(m_chainMembers);
         for (int id : entryIds)
         {
             ChainMember m;
@@ -1412,7 +1213,108 @@ tr:nth-child(even){background:#0f1b2d}
             m.entryId = id;
             all.push_back(m);
         }
-        saveChainMembers(all);
+        flush();
+    }
+
+    // ---- Chain Cycle Status ----
+
+    struct ChainEntryStatus
+    {
+        EntryPoint entry;
+        bool   traded    = false;  // filled and linked to a trade
+        bool   fullySold = false;
+        double soldQty   = 0.0;
+        double tradeQty  = 0.0;    // Buy quantity, else the planned fundingQty
+    };
+
+    struct ChainCycleStatus
+    {
+        int    cycle         = 0;
+        std::vector<ChainEntryStatus> entries;  // member order
+        int    entryDone     = 0;
+        bool   anyTraded     = false;
+        bool   allTradedSold = true;
+        double realizedPnl   = 0.0;  // net P&L of the linked Buys' covered sells
+
+        bool   complete() const { return anyTraded && allTradedSold; }
+        double completionPct() const
+        {
+            return entries.empty() ? 0 : (static_cast<double>(entryDone) / entries.size() * 100);
+        }
+    };
+
+    // Members of `cycle` joined to their entry points, linked Buys and
+    // covered sells through hash indexes.  The result is cached until
+    // chain members, entry points or trades change.
+    ChainCycleStatus chainCycleStatus(int cycle) const
+    {
+        view(m_trades);
+        view(m_entryPoints);
+        view(m_chainMembers);
+        auto& cache = m_chainStatus;
+        if (cache.valid && cache.status.cycle == cycle
+            && cache.tradesGen  == m_trades.generation
+            && cache.entriesGen == m_entryPoints.generation
+            && cache.membersGen == m_chainMembers.generation)
+            return cache.status;
+
+        // Take the position index first: nothing below re-reads trades,
+        // so the row pointers stay valid.
+        const PositionIndex& pos = positions();
+        std::unordered_map<int, const EntryPoint*> entryById;
+        for (const auto& e : view(m_entryPoints))
+            entryById.emplace(e.entryId, &e);
+        std::unordered_map<int, const Trade*> buyById;
+        std::unordered_map<int, std::vector<const Trade*>> sellsOf;
+        for (const auto& t : view(m_trades))
+        {
+            if (t.type == TradeType::Buy)
+                buyById.emplace(t.tradeId, &t);
+            else if (t.type == TradeType::CoveredSell)
+                sellsOf[t.parentTradeId].push_back(&t);
+        }
+
+        ChainCycleStatus st;
+        st.cycle = cycle;
+        for (const auto& m : view(m_chainMembers))
+        {
+            if (m.cycle != cycle) continue;
+            auto e = entryById.find(m.entryId);
+            if (e == entryById.end()) continue;
+            ChainEntryStatus es;
+            es.entry    = *e->second;
+            es.traded   = es.entry.traded && es.entry.linkedTradeId >= 0;
+            es.tradeQty = es.entry.fundingQty;
+            if (es.traded)
+            {
+                st.anyTraded = true;
+                auto b = buyById.find(es.entry.linkedTradeId);
+                if (b != buyById.end())
+                {
+                    const Trade& t = *b->second;
+                    es.tradeQty  = t.quantity;
+                    auto p = pos.byTrade.find(t.tradeId);
+                    es.soldQty   = p != pos.byTrade.end() ? p->second.sold : 0.0;
+                    es.fullySold = (es.soldQty >= t.quantity - 1e-9);
+                    if (es.fullySold) st.entryDone++;
+                    else st.allTradedSold = false;
+                    auto s = sellsOf.find(t.tradeId);
+                    if (s != sellsOf.end())
+                        for (const Trade* sell : s->second)
+                            st.realizedPnl += QuantMath::netProfit(
+                                QuantMath::grossProfit(t.value, sell->value, sell->quantity),
+                                0.0, sell->sellFee);
+                }
+            }
+            st.entries.push_back(std::move(es));
+        }
+
+        cache.status     = st;
+        cache.tradesGen  = m_trades.generation;
+        cache.entriesGen = m_entryPoints.generation;
+        cache.membersGen = m_chainMembers.generation;
+        cache.valid      = true;
+        return st;
     }
 
     // ---- Multi-Chain Manager ----
@@ -1438,90 +1340,170 @@ tr:nth-child(even){background:#0f1b2d}
 
     void saveManagedChains(const std::vector<ManagedChain>& chains)
     {
-        njs3::js_array arr;
-        for (const auto& c : chains)
-        {
-            njs3::json j(njs3::js_object{});
-            j["chainId"]      = JI(c.chainId);
-            j["name"]         = JStr(c.name);
-            j["symbol"]       = JStr(c.symbol);
-            j["active"]       = JB(c.active);
-            j["theoretical"]  = JB(c.theoretical);
-            j["currentCycle"] = JI(c.currentCycle);
-            j["capital"]      = JD(c.capital);
-            j["totalSavings"] = JD(c.totalSavings);
-            j["savingsRate"]  = JD(c.savingsRate);
-            j["createdAt"]    = JStr(c.createdAt);
-            j["notes"]        = JStr(c.notes);
-
-            njs3::js_array cyArr;
-            for (const auto& cy : c.cycles)
-            {
-                njs3::json cj(njs3::js_object{});
-                cj["cycle"] = JI(cy.cycle);
-                njs3::js_array ids;
-                for (int id : cy.entryIds)
-                    ids.push_back(JI(id));
-                cj["entryIds"] = njs3::json(std::move(ids));
-                cyArr.push_back(std::move(cj));
-            }
-            j["cycles"] = njs3::json(std::move(cyArr));
-            arr.push_back(std::move(j));
-        }
-        writeJson(managedChainsPath(), njs3::json(std::move(arr)));
+        edit(m_managedChains) = chains;
+        flush();
     }
 
     std::vector<ManagedChain> loadManagedChains() const
     {
-        std::vector<ManagedChain> out;
-        auto j = readJsonArr(managedChainsPath());
-        const auto* a = j.as_array();
-        if (!a) return out;
-        for (const auto& item : *a)
-        {
-            ManagedChain c;
-            c.chainId      = gi(item, "chainId");
-            c.name         = gs(item, "name");
-            c.symbol       = gs(item, "symbol");
-            c.active       = gb(item, "active");
-            c.theoretical  = gb(item, "theoretical");
-            c.currentCycle = gi(item, "currentCycle");
-            c.capital      = gd(item, "capital");
-            c.totalSavings = gd(item, "totalSavings");
-            c.savingsRate  = gd(item, "savingsRate");
-            c.createdAt    = gs(item, "createdAt");
-            c.notes        = gs(item, "notes");
-
-            const auto* cyArr = item["cycles"]->as_array();
-            if (cyArr)
-                for (const auto& cy : *cyArr)
-                {
-                    ManagedChain::CycleEntries ce;
-                    ce.cycle = gi(cy, "cycle");
-                    const auto* ids = cy["entryIds"]->as_array();
-                    if (ids)
-                        for (const auto& id : *ids)
-                            ce.entryIds.push_back(static_cast<int>(id.get_integer_or(0LL)));
-                    c.cycles.push_back(ce);
-                }
-            out.push_back(c);
-        }
-        return out;
+        return view(m_managedChains);
     }
 
     int nextChainId()
     {
-        auto chains = loadManagedChains();
         int maxId = 0;
-        for (const auto& c : chains)
+        for (const auto& c : view(m_managedChains))
             if (c.chainId > maxId) maxId = c.chainId;
         return maxId + 1;
     }
 
+    // ---- Storage mode ----
+    //
+    // Snapshot: every mutation rewrites the affected JSON file (default).
+    // Journal:  trades, P&L, profit and parameter history append to
+    //           <name>.journal and compact into <name>.json periodically.
+    //
+    // The mode lives on disk (the journal files), so every TradeDatabase
+    // opened on the same directory reads and writes it consistently.
+
+    enum class StorageMode { Snapshot, Journal };
+
+    StorageMode storageMode() const
+    {
+        return std::filesystem::exists(journalPathOf(m_trades))
+            ? StorageMode::Journal : StorageMode::Snapshot;
+    }
+
+    void setStorageMode(StorageMode mode)
+    {
+        if (m_txnDepth > 0) throw std::runtime_error("setStorageMode inside a transaction");
+        bool on = (mode == StorageMode::Journal);
+        setJournaled(m_trades, on);
+        setJournaled(m_pnl, on);
+        setJournaled(m_profits, on);
+        setJournaled(m_params, on);
+    }
+
+    // ---- Snapshot format ----
+    //
+    // The trade ledger snapshot is either trades.json or the binary
+    // columnar trades.bin (TradeSnapshot.h), which is memory-mapped and
+    // decoded column by column instead of parsed.  Whichever file exists
+    // wins (trades.bin if both do), so switching is visible to every
+    // TradeDatabase on the directory.  Switching rewrites the ledger in
+    // the new format and removes the old file; both directions are
+    // lossless, so this doubles as the JSON <-> binary converter.
+
+    enum class SnapshotFormat { Json, Binary };
+
+    SnapshotFormat snapshotFormat() const
+    {
+        return binaryOn(m_trades) ? SnapshotFormat::Binary : SnapshotFormat::Json;
+    }
+
+    void setSnapshotFormat(SnapshotFormat format)
+    {
+        if (m_txnDepth > 0) throw std::runtime_error("setSnapshotFormat inside a transaction");
+        bool bin = (format == SnapshotFormat::Binary);
+        if (bin == binaryOn(m_trades)) return;
+        view(m_trades);
+        writeSnapshot(m_trades, bin);
+        std::filesystem::remove(pathOf(m_trades, !bin));
+    }
+
+    // ---- Transactions ----
+    //
+    // Between beginTransaction() and commitTransaction() mutators only
+    // stage their changes in the resident collections; commit writes each
+    // touched file once, all of them as one FileSync::Batch behind a
+    // commit intent, so the files on disk hold the whole transaction or
+    // none of it.  abortTransaction() puts the resident state and ID
+    // generators back to where begin found them.  Transactions nest:
+    // inner commits are no-ops, and an inner abort makes the outermost
+    // commit roll back and return false.
+    //
+    // A commit whose writes fail rethrows with nothing applied, and the
+    // resident state is reloaded from disk.  If the failure comes after
+    // the intent landed, the commit is finished on the spot and counts
+    // as committed; should that fail too, the intent stays behind and
+    // the next TradeDatabase opened on the directory finishes it.
+
+    void beginTransaction()
+    {
+        if (m_txnDepth++ > 0) return;
+        m_txnFailed = false;
+        m_txnIds = { m_tradeIds, m_pendingIds, m_entryIds, m_exitIds };
+    }
+
+    bool commitTransaction()
+    {
+        if (m_txnDepth == 0) return false;
+        if (--m_txnDepth > 0) return !m_txnFailed;
+        if (m_txnFailed)
+        {
+            rollback();
+            return false;
+        }
+        try
+        {
+            FileSync::Batch batch;
+            m_batch = &batch;
+            flush();
+            m_batch = nullptr;
+            batch.commit(intentPath());
+        }
+        catch (...)
+        {
+            // Nothing is applied unless the intent landed; then finish it.
+            m_batch = nullptr;
+            endTransaction();
+            resync();
+            bool landed = false;
+            try { landed = FileSync::Batch::recover(intentPath()); }
+            catch (...) {}
+            if (!landed) throw;
+            return true;
+        }
+        forEachCollection([this](auto& c) { restamp(c); });
+        endTransaction();
+        return true;
+    }
+
+    void abortTransaction()
+    {
+        if (m_txnDepth == 0) return;
+        if (--m_txnDepth > 0) { m_txnFailed = true; return; }
+        rollback();
+    }
+
+    bool inTransaction() const { return m_txnDepth > 0; }
+
+    // Scoped transaction: aborts unless commit() was called.
+    class Transaction
+    {
+    public:
+        explicit Transaction(TradeDatabase& db) : m_db(db) { m_db.beginTransaction(); }
+        ~Transaction() { if (!m_done) m_db.abortTransaction(); }
+        Transaction(const Transaction&) = delete;
+        Transaction& operator=(const Transaction&) = delete;
+
+        bool commit() { m_done = true; return m_db.commitTransaction(); }
+        void abort()  { m_done = true; m_db.abortTransaction(); }
+
+    private:
+        TradeDatabase& m_db;
+        bool m_done = false;
+    };
+
     void clearAll()
     {
+        StorageMode mode = storageMode();
+        SnapshotFormat format = snapshotFormat();
+        m_positions = PositionIndex{};
+        m_triggers  = TriggerIndex{};
         // Remove JSON files
         std::filesystem::remove(tradesPath());
+        std::filesystem::remove(pathOf(m_trades, true));
         std::filesystem::remove(horizonsPath());
         std::filesystem::remove(profitsPath());
         std::filesystem::remove(paramsPath());
@@ -1543,60 +1525,827 @@ tr:nth-child(even){background:#0f1b2d}
                 "param_models", "pnl", "chain_state", "chain_members", "exit_points"})
                 std::filesystem::remove(m_dir + "/" + name + ext);
         }
+        for (const char* name : {"trades", "profits", "params", "pnl"})
+            std::filesystem::remove(m_dir + "/" + name + ".journal");
+        invalidateAll();
+        if (format == SnapshotFormat::Binary)
+            setSnapshotFormat(format);
+        if (mode == StorageMode::Journal)
+            setStorageMode(mode);
         seedIdGenerators();
     }
 
 private:
-std::string  m_dir;
-IdGenerator  m_tradeIdGen;
-IdGenerator  m_pendingIdGen;
-IdGenerator  m_entryIdGen;
-IdGenerator  m_exitIdGen;
+    struct ReleasedRow
+    {
+        std::string symbol;
+        int    tradeId = 0;
+        double qty     = 0.0;
+    };
 
-    std::string tradesPath()       const { return m_dir + "/trades.json"; }
-    std::string horizonsPath()     const { return m_dir + "/horizons.json"; }
-    std::string profitsPath()      const { return m_dir + "/profits.json"; }
-    std::string paramsPath()       const { return m_dir + "/params.json"; }
-    std::string walletPath()       const { return m_dir + "/wallet.json"; }
-    std::string pendingExitsPath() const { return m_dir + "/pending_exits.json"; }
-    std::string entryPointsPath()  const { return m_dir + "/entry_points.json"; }
-    std::string releasedPath()     const { return m_dir + "/released.json"; }
-    std::string paramModelsPath()  const { return m_dir + "/param_models.json"; }
-    std::string pnlPath()          const { return m_dir + "/pnl.json"; }
-    std::string chainStatePath()   const { return m_dir + "/chain_state.json"; }
-    std::string chainMembersPath() const { return m_dir + "/chain_members.json"; }
-    std::string exitPointsPath()   const { return m_dir + "/exit_points.json"; }
-    std::string managedChainsPath() const { return m_dir + "/managed_chains.json"; }
+    using HorizonRow = std::tuple<std::string, int, HorizonLevel>;
 
-    // ---- JSON I/O helpers ----
-    static njs3::json readJsonArr(const std::string& path)
+    // ---- Position index ----
+    //
+    // Per-trade sold/released quantities and, per SymbolId, Buy ids and
+    // net holdings, derived from trades + released.  Built on first use, kept
+    // current by the mutators and rebuilt when either collection is
+    // re-read from disk (another TradeDatabase wrote it).
+
+    struct Position
     {
-        std::ifstream f(path);
-        if (!f) return njs3::json(njs3::js_array{});
-        std::string c((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
-        if (c.empty()) return njs3::json(njs3::js_array{});
-        try { return njs3::parse_json(c); }
-        catch (...) { return njs3::json(njs3::js_array{}); }
-    }
-    static njs3::json readJsonObj(const std::string& path)
+        // Buy row fields; zero for ids that are not (or no longer) a Buy.
+        double quantity = 0.0;
+        double price    = 0.0;
+        double buyFee   = 0.0;
+
+        double sold     = 0.0;  // sum of CoveredSell children
+        double released = 0.0;  // sum of released.json rows
+
+        double remaining() const { return quantity - sold - released; }
+    };
+
+    struct SymbolPositions
     {
-        std::ifstream f(path);
-        if (!f) return njs3::json(njs3::js_object{});
-        std::string c((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
-        if (c.empty()) return njs3::json(njs3::js_object{});
-        try { return njs3::parse_json(c); }
-        catch (...) { return njs3::json(njs3::js_object{}); }
-    }
-    static void writeJson(const std::string& path, const njs3::json& j)
+        std::set<int> buys;             // Buy trade ids, ascending
+        double        holdings = 0.0;   // bought - sold
+    };
+
+    struct PositionIndex
     {
-        std::ofstream f(path, std::ios::trunc);
-        if (!f) throw std::runtime_error("Cannot open " + path);
-        f << njs3::serialize_json(j, njs3::json_serialize_option::pretty,
-            njs3::json_floating_format_options{std::chars_format::general, 17});
-        f.flush();
-        if (!f.good()) throw std::runtime_error("Write failed for " + path);
-        f.close();
-        if (f.fail()) throw std::runtime_error("Close failed for " + path);
+        std::unordered_map<int, Position> byTrade;
+        std::vector<SymbolPositions>      bySymbol;   // by SymbolId
+        std::size_t   buyCount     = 0;
+        std::uint64_t tradesLoad   = 0;
+        std::uint64_t releasedLoad = 0;
+        bool          valid        = false;
+
+        const SymbolPositions* of(SymbolId id) const
+        {
+            return id < bySymbol.size() ? &bySymbol[id] : nullptr;
+        }
+
+        SymbolPositions& at(SymbolId id)
+        {
+            if (id >= bySymbol.size()) bySymbol.resize(id + 1);
+            return bySymbol[id];
+        }
+    };
+
+    // ---- Trigger index ----
+    //
+    // TriggerBook over horizons, exit points, pending exits and entry
+    // points.  Like the position index it is built on first use, patched
+    // by the mutators and rebuilt when a source collection (or trades,
+    // which scale horizon levels to per-unit prices) is re-read from disk.
+
+    struct TriggerIndex
+    {
+        TriggerBook   book;
+        std::uint64_t tradesLoad   = 0;
+        std::uint64_t horizonsLoad = 0;
+        std::uint64_t exitsLoad    = 0;
+        std::uint64_t pendingLoad  = 0;
+        std::uint64_t entriesLoad  = 0;
+        bool          valid        = false;
+    };
+
+    // ---- Resident collections ----
+    //
+    // A collection is parsed on first use and re-parsed only when its
+    // file's (size, mtime, file id) stamp changes underneath us, i.e. when
+    // another TradeDatabase on the same directory (MCP engine, per-user
+    // cache) wrote it.  The file id matters: a rewrite of the same length
+    // inside one coarse mtime tick differs only there.  A dirty collection
+    // is authoritative until flushed.
+    //
+    // Journal layout: the first line is a header binding the journal to
+    // the exact snapshot it extends ({"snapshotBytes":N,"snapshotHash":H});
+    // every further line is one encoded row.  A header that does not match
+    // the snapshot means a compaction was interrupted after the snapshot
+    // was replaced, so the rows are already in it and the journal is reset.
+    // A torn last line (crash mid-append) is truncated away.
+
+    struct FileStamp
+    {
+        bool exists = false;
+        std::uintmax_t size = 0;
+        std::filesystem::file_time_type mtime{};
+        std::uint64_t id = 0;   // inode; a replace() always changes it
+
+        bool operator==(const FileStamp& o) const
+        {
+            return exists == o.exists && size == o.size && mtime == o.mtime && id == o.id;
+        }
+        bool operator!=(const FileStamp& o) const { return !(*this == o); }
+    };
+
+    template <typename T>
+    struct Cached
+    {
+        const char* file;
+        T          (*decode)(const njs3::json&);
+        njs3::json (*encode)(const T&);
+        bool        isObject  = false;
+        bool        journaled = false;  // eligible for journal mode
+
+        // Optional binary snapshot, used instead of `file` when it exists.
+        const char*  binFile = nullptr;
+        std::string (*encodeBin)(const T&) = nullptr;
+        T           (*decodeBin)(std::string_view) = nullptr;
+
+        T           value{};
+        FileStamp   stamp{};
+        bool        loaded = false;
+        bool        dirty  = false;     // needs a full snapshot rewrite
+        std::uint64_t loads = 0;        // bumped on every parse from disk
+        std::uint64_t generation = 0;   // bumped whenever `value` may change
+
+        bool        journalOn   = false;  // <name>.journal exists
+        FileStamp   journalStamp{};
+        std::size_t journalRows = 0;      // rows on disk in the journal
+        std::size_t appended    = 0;      // resident rows not yet on disk
+        bool        restamp     = false;  // written through a batch not yet committed
+
+        // State at the first touch inside a transaction.  Pure appends
+        // roll back by truncating to txnSize; anything else keeps a copy.
+        bool        txnTouched  = false;
+        bool        txnCopied   = false;
+        bool        txnDirty    = false;
+        std::size_t txnAppended = 0;
+        std::size_t txnSize     = 0;
+        T           txnValue{};
+    };
+
+    // Fold the journal into the snapshot once it holds this many rows and
+    // at least as many as the snapshot itself.
+    static constexpr std::size_t kJournalCompactRows = 1024;
+
+std::string  m_dir;
+
+    struct IdSource
+    {
+        IdGenerator   gen;
+        std::uint64_t syncedLoad = 0;  // Cached::loads last merged into gen
+    };
+
+    mutable IdSource m_tradeIds;
+    mutable IdSource m_pendingIds;
+    mutable IdSource m_entryIds;
+    mutable IdSource m_exitIds;
+
+    mutable PositionIndex m_positions;
+    mutable TriggerIndex  m_triggers;
+
+    struct ChainStatusCache
+    {
+        ChainCycleStatus status;
+        std::uint64_t    tradesGen  = 0;
+        std::uint64_t    entriesGen = 0;
+        std::uint64_t    membersGen = 0;
+        bool             valid      = false;
+    };
+    mutable ChainStatusCache m_chainStatus;
+
+    int  m_txnDepth  = 0;
+    bool m_txnFailed = false;
+    std::vector<IdSource> m_txnIds;
+    FileSync::Batch* m_batch = nullptr;  // set while a commit collects its writes
+
+    mutable Cached<std::vector<Trade>>        m_trades        { "trades.json",         &decodeTrades,        &encodeTrades,        false, true,
+                                                                "trades.bin", &TradeSnapshot::encode, &TradeSnapshot::decode };
+    mutable Cached<std::vector<HorizonRow>>   m_horizons      { "horizons.json",       &decodeHorizons,      &encodeHorizons };
+    mutable Cached<std::vector<ProfitRow>>    m_profits       { "profits.json",        &decodeProfits,       &encodeProfits,       false, true };
+    mutable Cached<std::vector<ParamsRow>>    m_params        { "params.json",         &decodeParams,        &encodeParams,        false, true };
+    mutable Cached<double>                    m_wallet        { "wallet.json",         &decodeWallet,        &encodeWallet, true };
+    mutable Cached<std::vector<PendingExit>>  m_pendingExits  { "pending_exits.json",  &decodePendingExits,  &encodePendingExits };
+    mutable Cached<std::vector<EntryPoint>>   m_entryPoints   { "entry_points.json",   &decodeEntryPoints,   &encodeEntryPoints };
+    mutable Cached<std::vector<ReleasedRow>>  m_released      { "released.json",       &decodeReleased,      &encodeReleased };
+    mutable Cached<std::vector<ParamModel>>   m_paramModels   { "param_models.json",   &decodeParamModels,   &encodeParamModels };
+    mutable Cached<std::vector<PnlEntry>>     m_pnl           { "pnl.json",            &decodePnl,           &encodePnl,           false, true };
+    mutable Cached<ChainState>                m_chainState    { "chain_state.json",    &decodeChainState,    &encodeChainState, true };
+    mutable Cached<std::vector<ChainMember>>  m_chainMembers  { "chain_members.json",  &decodeChainMembers,  &encodeChainMembers };
+    mutable Cached<std::vector<ExitPoint>>    m_exitPoints    { "exit_points.json",    &decodeExitPoints,    &encodeExitPoints };
+    mutable Cached<std::vector<ManagedChain>> m_managedChains { "managed_chains.json", &decodeManagedChains, &encodeManagedChains };
+
+    static FileStamp stampOf(const std::string& path)
+    {
+        FileStamp s;
+        std::error_code ec;
+        auto size = std::filesystem::file_size(path, ec);
+        if (ec) return s;
+        auto mtime = std::filesystem::last_write_time(path, ec);
+        if (ec) return s;
+        s.exists = true;
+        s.size   = size;
+        s.mtime  = mtime;
+        s.id     = FileSync::fileId(path);
+        return s;
+    }
+
+    template <typename T>
+    std::string pathOf(const Cached<T>& c, bool bin) const { return m_dir + "/" + (bin ? c.binFile : c.file); }
+
+    template <typename T>
+    bool binaryOn(const Cached<T>& c) const { return c.binFile && std::filesystem::exists(pathOf(c, true)); }
+
+    template <typename T>
+    std::string pathOf(const Cached<T>& c) const { return pathOf(c, binaryOn(c)); }
+
+    template <typename T>
+    std::string journalPathOf(const Cached<T>& c) const
+    {
+        return std::filesystem::path(pathOf(c, false)).replace_extension(".journal").string();
+    }
+
+    // Resident value, (re)loaded from disk if missing or stale.
+    template <typename T>
+    const T& view(Cached<T>& c) const
+    {
+        if (c.dirty || c.appended) return c.value;
+        bool bin = binaryOn(c);
+        std::string path = pathOf(c, bin);
+        FileStamp st = stampOf(path);
+        FileStamp jst = c.journaled ? stampOf(journalPathOf(c)) : FileStamp{};
+        if (!c.loaded || st != c.stamp || jst != c.journalStamp)
+        {
+            TradeSnapshot::Mapping map;
+            std::string text;
+            std::string_view bytes;
+            if (bin) { map.open(path); bytes = map.bytes(); }
+            else     { text = readText(path); bytes = text; }
+
+            c.value       = decodeSnapshot(c, bin, bytes, path);
+            c.stamp       = st;
+            c.journalOn   = jst.exists;
+            c.journalRows = 0;
+            if (jst.exists)
+                replayJournal(c, bytes);
+            c.journalStamp = stampOf(journalPathOf(c));
+            c.loaded = true;
+            ++c.loads;
+            ++c.generation;
+        }
+        return c.value;
+    }
+
+    // Append one row; in journal mode flush() writes just that row.
+    template <typename Row>
+    void append(Cached<std::vector<Row>>& c, Row row)
+    {
+        view(c);
+        stage(c, true);
+        c.value.push_back(std::move(row));
+        ++c.appended;
+        ++c.generation;
+    }
+
+    template <typename Row>
+    void replayJournal(Cached<std::vector<Row>>& c, std::string_view snapshot) const
+    {
+        std::string jpath = journalPathOf(c);
+        std::string text = readText(jpath);
+
+        std::size_t eol = text.find('\n');
+        bool current = false;
+        if (eol != std::string::npos)
+        {
+            try
+            {
+                auto h = njs3::parse_json(std::string_view(text).substr(0, eol));
+                current = gll(h, "snapshotBytes") == static_cast<long long>(snapshot.size())
+                       && gs(h, "snapshotHash") == contentHash(snapshot);
+            }
+            catch (...) {}
+        }
+        if (!current)
+        {
+            FileSync::replace(jpath, journalHeader(snapshot));
+            return;
+        }
+
+        njs3::json rows = njs3::json(njs3::js_array{});
+        std::size_t good = eol + 1;
+        while (good < text.size())
+        {
+            std::size_t end = text.find('\n', good);
+            if (end == std::string::npos) break;  // torn tail: no newline yet
+            try { rows.as_array()->push_back(njs3::parse_json(std::string_view(text).substr(good, end - good))); }
+            catch (...) { break; }
+            good = end + 1;
+        }
+        if (good < text.size())
+            std::filesystem::resize_file(jpath, good);
+
+        auto tail = c.decode(rows);
+        c.journalRows = tail.size();
+        c.value.insert(c.value.end(),
+            std::make_move_iterator(tail.begin()), std::make_move_iterator(tail.end()));
+    }
+
+    template <typename T>
+    void replayJournal(Cached<T>&, std::string_view) const {}
+
+    // Full rewrite of the snapshot; in journal mode the journal is reset to
+    // an empty one bound to the new snapshot.  Snapshot first, so a crash in
+    // between leaves a stale header and replay discards the old rows.
+    template <typename T>
+    void writeSnapshot(Cached<T>& c) { writeSnapshot(c, binaryOn(c)); }
+
+    void replaceFile(const std::string& path, const std::string& text)
+    {
+        if (m_batch) m_batch->replace(path, text);
+        else         FileSync::replace(path, text);
+    }
+
+    // Stamps of a collection written through a batch, once it committed.
+    template <typename T>
+    void restamp(Cached<T>& c)
+    {
+        if (!c.restamp) return;
+        c.stamp        = stampOf(pathOf(c));
+        c.journalStamp = stampOf(journalPathOf(c));
+        c.restamp      = false;
+    }
+
+    template <typename T>
+    void writeSnapshot(Cached<T>& c, bool bin)
+    {
+        std::string path = pathOf(c, bin);
+        std::string text = bin ? c.encodeBin(c.value) : serialize(c.encode(c.value));
+        replaceFile(path, text);
+        if (c.journalOn)
+            replaceFile(journalPathOf(c), journalHeader(text));
+        if (m_batch)
+            c.restamp = true;
+        else
+        {
+            c.stamp        = stampOf(path);
+            c.journalStamp = stampOf(journalPathOf(c));
+        }
+        c.journalRows  = 0;
+        c.appended     = 0;
+        c.dirty        = false;
+    }
+
+    template <typename Row>
+    void appendJournal(Cached<std::vector<Row>>& c)
+    {
+        std::vector<Row> tail(c.value.end() - c.appended, c.value.end());
+        njs3::json rows = c.encode(tail);
+        std::string lines;
+        for (const auto& row : *rows.as_array())
+        {
+            lines += njs3::serialize_json<std::string>(row,
+                njs3::json_serialize_option::default_option, kFloatFormat);
+            lines += '\n';
+        }
+        if (m_batch)
+        {
+            m_batch->append(journalPathOf(c), lines);
+            c.restamp = true;
+        }
+        else
+        {
+            FileSync::append(journalPathOf(c), lines);
+            c.journalStamp = stampOf(journalPathOf(c));
+        }
+        c.journalRows += c.appended;
+        c.appended     = 0;
+
+        if (c.journalRows >= std::max(kJournalCompactRows, c.value.size() - c.journalRows))
+            writeSnapshot(c);
+    }
+
+    template <typename T>
+    void appendJournal(Cached<T>& c) { writeSnapshot(c); }
+
+    template <typename T>
+    void setJournaled(Cached<T>& c, bool on)
+    {
+        view(c);  // fold any existing journal into the resident copy
+        bool was = c.journalOn;
+        if (!was && !on) return;
+        c.journalOn = on;
+        writeSnapshot(c);
+        if (was && !on)
+        {
+            std::filesystem::remove(journalPathOf(c));
+            c.journalStamp = FileStamp{};
+        }
+    }
+
+    // Mutable resident value; the collection is written on the next flush().
+    template <typename T>
+    T& edit(Cached<T>& c)
+    {
+        view(c);
+        stage(c, false);
+        c.dirty = true;
+        ++c.generation;
+        return c.value;
+    }
+
+    template <typename Row>
+    static std::size_t rowCount(const std::vector<Row>& v) { return v.size(); }
+    template <typename T>
+    static std::size_t rowCount(const T&) { return 0; }
+
+    template <typename Row>
+    static void truncateRows(std::vector<Row>& v, std::size_t n) { v.erase(v.begin() + std::min(n, v.size()), v.end()); }
+    template <typename T>
+    static void truncateRows(T&, std::size_t) {}
+
+    // Remember the pre-transaction state of a collection about to change.
+    template <typename T>
+    void stage(Cached<T>& c, bool appendOnly)
+    {
+        if (m_txnDepth == 0) return;
+        if (!c.txnTouched)
+        {
+            c.txnTouched  = true;
+            c.txnCopied   = false;
+            c.txnDirty    = c.dirty;
+            c.txnAppended = c.appended;
+            c.txnSize     = rowCount(c.value);
+        }
+        if (!appendOnly && !c.txnCopied)
+        {
+            c.txnValue = c.value;
+            truncateRows(c.txnValue, c.txnSize);
+            c.txnCopied = true;
+        }
+    }
+
+    template <typename T>
+    static void restore(Cached<T>& c)
+    {
+        if (!c.txnTouched) return;
+        if (c.txnCopied) c.value = std::move(c.txnValue);
+        else             truncateRows(c.value, c.txnSize);
+        c.dirty    = c.txnDirty;
+        c.appended = c.txnAppended;
+        ++c.generation;
+        endStage(c);
+    }
+
+    template <typename T>
+    static void endStage(Cached<T>& c)
+    {
+        c.txnTouched = c.txnCopied = false;
+        c.txnValue   = T{};
+    }
+
+    void rollback()
+    {
+        forEachCollection([](auto& c) { restore(c); });
+        m_tradeIds   = m_txnIds[0];
+        m_pendingIds = m_txnIds[1];
+        m_entryIds   = m_txnIds[2];
+        m_exitIds    = m_txnIds[3];
+        m_txnIds.clear();
+        m_positions.valid = false;
+        m_triggers.valid  = false;
+        m_txnDepth  = 0;
+        m_txnFailed = false;
+    }
+
+    // Drop every resident collection after a failed commit; the next
+    // reader loads whatever the files hold.
+    void resync()
+    {
+        invalidateAll();
+        m_positions.valid = false;
+        m_triggers.valid  = false;
+        seedIdGenerators();
+    }
+
+    void endTransaction()
+    {
+        forEachCollection([](auto& c) { endStage(c); });
+        m_txnIds.clear();
+        m_txnDepth  = 0;
+        m_txnFailed = false;
+    }
+
+    template <typename T>
+    void flushOne(Cached<T>& c)
+    {
+        if (c.dirty)
+            writeSnapshot(c);
+        else if (c.appended && c.journalOn)
+            appendJournal(c);
+        else if (c.appended)
+            writeSnapshot(c);
+    }
+
+    template <typename F>
+    void forEachCollection(F&& f)
+    {
+        f(m_trades);
+        f(m_horizons);
+        f(m_profits);
+        f(m_params);
+        f(m_wallet);
+        f(m_pendingExits);
+        f(m_entryPoints);
+        f(m_released);
+        f(m_paramModels);
+        f(m_pnl);
+        f(m_chainState);
+        f(m_chainMembers);
+        f(m_exitPoints);
+        f(m_managedChains);
+    }
+
+    // Write every dirty collection back to its JSON file (deferred to
+    // commit while a transaction is open).
+    void flush()
+    {
+        if (m_txnDepth > 0) return;
+        forEachCollection([this](auto& c) { flushOne(c); });
+    }
+
+    template <typename T>
+    static void invalidate(Cached<T>& c)
+    {
+        c.value  = T{};
+        c.stamp  = FileStamp{};
+        c.loaded = false;
+        c.dirty  = false;
+        c.journalOn    = false;
+        c.journalStamp = FileStamp{};
+        c.journalRows  = 0;
+        c.appended     = 0;
+        c.restamp      = false;
+    }
+
+    void invalidateAll()
+    {
+        forEachCollection([](auto& c) { invalidate(c); });
+    }
+
+    // Seed `src` from the resident rows on first use; after a reload (rows
+    // written by another TradeDatabase) merge their IDs in as used, so two
+    // instances on one directory never hand out the same ID.
+    template <typename Row, typename IdOf>
+    IdGenerator& syncIds(IdSource& src, Cached<std::vector<Row>>& c, IdOf idOf) const
+    {
+        const auto& rows = view(c);
+        if (src.syncedLoad == c.loads) return src.gen;
+        if (src.syncedLoad == 0)
+        {
+            std::set<int> used;
+            for (const auto& r : rows)
+                if (idOf(r) > 0) used.insert(idOf(r));
+            src.gen.seed(used);
+        }
+        else
+        {
+            for (const auto& r : rows)
+                src.gen.seedSingle(idOf(r));
+        }
+        src.syncedLoad = c.loads;
+        return src.gen;
+    }
+
+    IdGenerator& tradeIds()   const { return syncIds(m_tradeIds,   m_trades,       [](const Trade& t)       { return t.tradeId; }); }
+    IdGenerator& pendingIds() const { return syncIds(m_pendingIds, m_pendingExits, [](const PendingExit& o) { return o.orderId; }); }
+    IdGenerator& entryIds()   const { return syncIds(m_entryIds,   m_entryPoints,  [](const EntryPoint& e)  { return e.entryId; }); }
+    IdGenerator& exitIds()    const { return syncIds(m_exitIds,    m_exitPoints,   [](const ExitPoint& e)   { return e.exitId; }); }
+
+    // True when m_positions reflects the resident trades/released rows, so
+    // a mutator may patch it instead of letting the next reader rebuild it.
+    bool positionsCurrent() const
+    {
+        view(m_trades);
+        view(m_released);
+        return m_positions.valid
+            && m_positions.tradesLoad   == m_trades.loads
+            && m_positions.releasedLoad == m_released.loads;
+    }
+
+    const PositionIndex& positions() const
+    {
+        if (positionsCurrent()) return m_positions;
+        PositionIndex ix;
+        for (const auto& t : view(m_trades))
+            applyTrade(ix, t, +1.0);
+        for (const auto& r : view(m_released))
+            ix.byTrade[r.tradeId].released += r.qty;
+        ix.tradesLoad   = m_trades.loads;
+        ix.releasedLoad = m_released.loads;
+        ix.valid        = true;
+        m_positions = std::move(ix);
+        return m_positions;
+    }
+
+    const Position* findPosition(int tradeId) const
+    {
+        const auto& pos = positions();
+        auto it = pos.byTrade.find(tradeId);
+        return it != pos.byTrade.end() ? &it->second : nullptr;
+    }
+
+    // True when m_triggers reflects the resident source rows.
+    bool triggersCurrent() const
+    {
+        view(m_trades);
+        view(m_horizons);
+        view(m_exitPoints);
+        view(m_pendingExits);
+        view(m_entryPoints);
+        return m_triggers.valid
+            && m_triggers.tradesLoad   == m_trades.loads
+            && m_triggers.horizonsLoad == m_horizons.loads
+            && m_triggers.exitsLoad    == m_exitPoints.loads
+            && m_triggers.pendingLoad  == m_pendingExits.loads
+            && m_triggers.entriesLoad  == m_entryPoints.loads;
+    }
+
+    const TriggerBook& triggers() const
+    {
+        if (triggersCurrent()) return m_triggers.book;
+        TriggerIndex ix;
+        for (const auto& [sym, tid, lv] : view(m_horizons))
+            fileHorizon(ix.book, sym, tid, lv);
+        for (const auto& xp : view(m_exitPoints))
+            fileExit(ix.book, xp);
+        for (const auto& o : view(m_pendingExits))
+            filePending(ix.book, o);
+        for (const auto& ep : view(m_entryPoints))
+            fileEntry(ix.book, ep);
+        ix.tradesLoad   = m_trades.loads;
+        ix.horizonsLoad = m_horizons.loads;
+        ix.exitsLoad    = m_exitPoints.loads;
+        ix.pendingLoad  = m_pendingExits.loads;
+        ix.entriesLoad  = m_entryPoints.loads;
+        ix.valid        = true;
+        m_triggers = std::move(ix);
+        return m_triggers.book;
+    }
+
+    // Horizon levels hold position totals; they trigger per unit of the
+    // Buy they belong to (same symbol), as /price-check has always shown.
+    void fileHorizon(TriggerBook& book, const std::string& symbol, int tradeId, const HorizonLevel& lv) const
+    {
+        const auto& pos = positions();
+        const SymbolPositions* sp = pos.of(SymbolRegistry::lookup(symbol));
+        if (!sp || !sp->buys.count(tradeId)) return;
+        double qty = pos.byTrade.at(tradeId).quantity;
+        if (qty <= 0) return;
+        if (lv.takeProfit > 0)
+            book.add({TriggerKind::HorizonTP, symbol, tradeId, tradeId, lv.index, lv.takeProfit / qty, 0.0});
+        if (lv.stopLossActive && lv.stopLoss > 0)
+            book.add({TriggerKind::HorizonSL, symbol, tradeId, tradeId, lv.index, lv.stopLoss / qty, 0.0});
+    }
+
+    void refileHorizons(int tradeId)
+    {
+        m_triggers.book.removeOwner(TriggerSource::Horizon, tradeId);
+        for (const auto& [sym, tid, lv] : view(m_horizons))
+            if (tid == tradeId)
+                fileHorizon(m_triggers.book, sym, tid, lv);
+    }
+
+    static void fileExit(TriggerBook& book, const ExitPoint& xp)
+    {
+        if (xp.executed) return;
+        if (xp.tpPrice > 0)
+            book.add({TriggerKind::ExitTP, xp.symbol, xp.exitId, xp.tradeId, xp.levelIndex, xp.tpPrice, xp.sellQty});
+        if (xp.slActive && xp.slPrice > 0)
+            book.add({TriggerKind::ExitSL, xp.symbol, xp.exitId, xp.tradeId, xp.levelIndex, xp.slPrice, xp.sellQty});
+    }
+
+    static void filePending(TriggerBook& book, const PendingExit& o)
+    {
+        book.add({TriggerKind::PendingExit, o.symbol, o.orderId, o.tradeId, o.levelIndex, o.triggerPrice, o.sellQty});
+    }
+
+    static void fileEntry(TriggerBook& book, const EntryPoint& ep)
+    {
+        if (ep.traded) return;
+        book.add({ep.isShort ? TriggerKind::EntryShort : TriggerKind::EntryLong,
+                  ep.symbol, ep.entryId, -1, ep.levelIndex, ep.entryPrice, ep.fundingQty});
+    }
+
+    // Add (sign = +1) or retract (sign = -1) one trade row's contribution.
+    static void applyTrade(PositionIndex& ix, const Trade& t, double sign)
+    {
+        SymbolPositions& sp = ix.at(SymbolRegistry::intern(t.symbol));
+        if (t.type == TradeType::Buy)
+        {
+            Position& p = ix.byTrade[t.tradeId];
+            if (sign > 0)
+            {
+                p.quantity = t.quantity;
+                p.price    = t.value;
+                p.buyFee   = t.buyFee;
+                sp.buys.insert(t.tradeId);
+                ++ix.buyCount;
+            }
+            else
+            {
+                p.quantity = p.price = p.buyFee = 0.0;
+                sp.buys.erase(t.tradeId);
+                --ix.buyCount;
+            }
+            sp.holdings += sign * t.quantity;
+        }
+        else
+        {
+            if (t.type == TradeType::CoveredSell)
+                ix.byTrade[t.parentTradeId].sold += sign * t.quantity;
+            sp.holdings -= sign * t.quantity;
+        }
+    }
+
+    // Only the fields written by encodeTrades survive a reload; keep the
+    // resident copy identical to what a fresh parse would produce.
+    static Trade persisted(const Trade& t)
+    {
+        Trade p;
+        p.symbol        = t.symbol;
+        p.tradeId       = t.tradeId;
+        p.type          = t.type;
+        p.value         = t.value;
+        p.quantity      = t.quantity;
+        p.parentTradeId = t.parentTradeId;
+        p.shortEnabled  = t.shortEnabled;
+        p.buyFee        = t.buyFee;
+        p.sellFee       = t.sellFee;
+        p.timestamp     = t.timestamp;
+        return p;
+    }
+
+    std::string tradesPath()       const { return m_dir + "/trades.json"; }
+    std::string horizonsPath()     const { return m_dir + "/horizons.json"; }
+    std::string profitsPath()      const { return m_dir + "/profits.json"; }
+    std::string paramsPath()       const { return m_dir + "/params.json"; }
+    std::string walletPath()       const { return m_dir + "/wallet.json"; }
+    std::string pendingExitsPath() const { return m_dir + "/pending_exits.json"; }
+    std::string entryPointsPath()  const { return m_dir + "/entry_points.json"; }
+    std::string releasedPath()     const { return m_dir + "/released.json"; }
+    std::string paramModelsPath()  const { return m_dir + "/param_models.json"; }
+    std::string pnlPath()          const { return m_dir + "/pnl.json"; }
+    std::string chainStatePath()   const { return m_dir + "/chain_state.json"; }
+    std::string chainMembersPath() const { return m_dir + "/chain_members.json"; }
+    std::string exitPointsPath()   const { return m_dir + "/exit_points.json"; }
+    std::string managedChainsPath() const { return m_dir + "/managed_chains.json"; }
+    std::string intentPath()       const { return m_dir + "/commit.intent"; }
+
+    // ---- JSON I/O helpers ----
+    static constexpr njs3::json_floating_format_options kFloatFormat{std::chars_format::general, 17};
+
+    static std::string readText(const std::string& path)
+    {
+        std::ifstream f(path, std::ios::binary);
+        if (!f) return {};
+        return std::string((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    }
+    // Missing, empty or corrupt documents read as an empty collection.
+    // A corrupt file is copied to <path>.corrupt first so the next write
+    // does not silently destroy whatever was in it.
+    template <typename T>
+    static T decodeSnapshot(const Cached<T>& c, bool bin, std::string_view bytes, const std::string& path)
+    {
+        auto empty = [&]() {
+            return bin ? T{} : c.decode(c.isObject ? njs3::json(njs3::js_object{}) : njs3::json(njs3::js_array{}));
+        };
+        if (bytes.empty()) return empty();
+        try
+        {
+            return bin ? c.decodeBin(bytes) : c.decode(njs3::parse_json(bytes));
+        }
+        catch (...)
+        {
+            std::error_code ec;
+            std::filesystem::copy_file(path, path + ".corrupt",
+                std::filesystem::copy_options::overwrite_existing, ec);
+            std::cerr << "  [DB] " << path << " is unreadable; saved a copy as "
+                      << path << ".corrupt\n";
+            return empty();
+        }
+    }
+    static std::string serialize(const njs3::json& j)
+    {
+        return njs3::serialize_json<std::string>(j, njs3::json_serialize_option::pretty, kFloatFormat);
+    }
+    // FNV-1a 64, hex.  Identifies the snapshot a journal extends.
+    static std::string contentHash(std::string_view text)
+    {
+        std::uint64_t h = 14695981039346656037ull;
+        for (unsigned char ch : text) { h ^= ch; h *= 1099511628211ull; }
+        char buf[17];
+        std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(h));
+        return buf;
+    }
+    static std::string journalHeader(std::string_view snapshot)
+    {
+        njs3::json h = njs3::json(njs3::js_object{});
+        h["snapshotBytes"] = JLL(static_cast<long long>(snapshot.size()));
+        h["snapshotHash"]  = JStr(contentHash(snapshot));
+        return njs3::serialize_json<std::string>(h) + "\n";
     }
     // Value constructors
     static njs3::json JI(int v)                { return njs3::json(static_cast<njs3::js_integer>(v)); }
@@ -1608,44 +2357,603 @@ IdGenerator  m_exitIdGen;
     static int         gi(const njs3::json& j, const char* k) { return static_cast<int>(j[k]->get_integer_or(0LL)); }
     static double      gd(const njs3::json& j, const char* k) { return static_cast<double>(j[k]->get_number_or(0.0L)); }
     static long long  gll(const njs3::json& j, const char* k) { return j[k]->get_integer_or(0LL); }
-    static bool        gb(const njs3::json& j, const char* k) { return j[k]->get_boolean_or(false); }
+    // JB() values are serialized as 0/1, so accept the integer form too.
+    static bool        gb(const njs3::json& j, const char* k) { return j[k]->get_boolean_or(j[k]->get_integer_or(0LL) != 0); }
     static std::string gs(const njs3::json& j, const char* k) { return j[k]->get_string_or(njs3::js_string("")); }
 
-    using HorizonRow = std::tuple<std::string, int, HorizonLevel>;
 
-    std::vector<HorizonRow> loadAllHorizons() const
+    // ---- Codecs (one JSON document <-> one resident collection) ----
+
+    static std::vector<Trade> decodeTrades(const njs3::json& j)
     {
-        std::vector<HorizonRow> out;
-        auto j = readJsonArr(horizonsPath());
+        std::vector<Trade> out;
         const auto* a = j.as_array();
         if (!a) return out;
+        out.reserve(a->size());
         for (const auto& item : *a)
         {
-            HorizonLevel lv;
-            lv.index         = gi(item, "index");
-            lv.takeProfit    = gd(item, "takeProfit");
-            lv.stopLoss      = gd(item, "stopLoss");
-            lv.stopLossActive = gb(item, "stopLossActive");
-            out.emplace_back(gs(item, "symbol"), gi(item, "tradeId"), lv);
+            Trade t;
+            t.symbol        = gs(item, "symbol");
+            t.tradeId       = gi(item, "tradeId");
+            t.type          = static_cast<TradeType>(gi(item, "type"));
+            t.value         = gd(item, "value");
+            t.quantity      = gd(item, "quantity");
+            t.parentTradeId = gi(item, "parentTradeId");
+            t.shortEnabled  = gb(item, "shortEnabled");
+            t.buyFee        = gd(item, "buyFee");
+            t.sellFee       = gd(item, "sellFee");
+            t.timestamp     = gll(item, "timestamp");
+            out.push_back(t);
         }
         return out;
     }
 
-    void saveAllHorizons(const std::vector<HorizonRow>& rows)
+    static njs3::json encodeTrades(const std::vector<Trade>& trades)
     {
         njs3::js_array arr;
-        for (const auto& [sym, tid, lv] : rows)
+        for (const auto& t : trades)
         {
             njs3::json j(njs3::js_object{});
-            j["symbol"] = JStr(sym);
-            j["tradeId"] = JI(tid);
-            j["index"] = JI(lv.index);
-            j["takeProfit"] = JD(lv.takeProfit);
-            j["stopLoss"] = JD(lv.stopLoss);
-            j["stopLossActive"] = JB(lv.stopLossActive);
+            j["symbol"] = JStr(t.symbol);
+            j["tradeId"] = JI(t.tradeId);
+            j["type"] = JI(static_cast<int>(t.type));
+            j["value"] = JD(t.value);
+            j["quantity"] = JD(t.quantity);
+            j["parentTradeId"] = JI(t.parentTradeId);
+            j["shortEnabled"] = JB(t.shortEnabled);
+            j["buyFee"] = JD(t.buyFee);
+            j["sellFee"] = JD(t.sellFee);
+            j["timestamp"] = JLL(t.timestamp);
+            arr.push_back(std::move(j));
+        }
+        return njs3::json(std::move(arr));
+    }
+
+    static std::vector<HorizonRow> decodeHorizons(const njs3::json& j)
+    {
+        std::vector<HorizonRow> out;
+        const auto* a = j.as_array();
+        if (!a) return out;
+        for (const auto& item : *a)
+        {
+            HorizonLevel lv;
+            lv.index         = gi(item, "index");
+            lv.takeProfit    = gd(item, "takeProfit");
+            lv.stopLoss      = gd(item, "stopLoss");
+            lv.stopLossActive = gb(item, "stopLossActive");
+            out.emplace_back(gs(item, "symbol"), gi(item, "tradeId"), lv);
+        }
+        return out;
+    }
+
+    static njs3::json encodeHorizons(const std::vector<HorizonRow>& rows)
+    {
+        njs3::js_array arr;
+        for (const auto& [sym, tid, lv] : rows)
+        {
+            njs3::json j(njs3::js_object{});
+            j["symbol"] = JStr(sym);
+            j["tradeId"] = JI(tid);
+            j["index"] = JI(lv.index);
+            j["takeProfit"] = JD(lv.takeProfit);
+            j["stopLoss"] = JD(lv.stopLoss);
+            j["stopLossActive"] = JB(lv.stopLossActive);
+            arr.push_back(std::move(j));
+        }
+        return njs3::json(std::move(arr));
+    }
+
+    static std::vector<ProfitRow> decodeProfits(const njs3::json& j)
+    {
+        std::vector<ProfitRow> out;
+        const auto* a = j.as_array();
+        if (!a) return out;
+        for (const auto& item : *a)
+        {
+            ProfitRow r;
+            r.symbol       = gs(item, "symbol");
+            r.tradeId      = gi(item, "tradeId");
+            r.currentPrice = gd(item, "currentPrice");
+            r.grossProfit  = gd(item, "grossProfit");
+            r.netProfit    = gd(item, "netProfit");
+            r.roi          = gd(item, "roi");
+            out.push_back(r);
+        }
+        return out;
+    }
+
+    static njs3::json encodeProfits(const std::vector<ProfitRow>& rows)
+    {
+        njs3::js_array arr;
+        for (const auto& r : rows)
+        {
+            njs3::json row(njs3::js_object{});
+            row["symbol"] = JStr(r.symbol);
+            row["tradeId"] = JI(r.tradeId);
+            row["currentPrice"] = JD(r.currentPrice);
+            row["grossProfit"] = JD(r.grossProfit);
+            row["netProfit"] = JD(r.netProfit);
+            row["roi"] = JD(r.roi);
+            arr.push_back(std::move(row));
+        }
+        return njs3::json(std::move(arr));
+    }
+
+    static std::vector<ParamsRow> decodeParams(const njs3::json& j)
+    {
+        std::vector<ParamsRow> out;
+        const auto* a = j.as_array();
+        if (!a) return out;
+        for (const auto& item : *a)
+        {
+            ParamsRow r;
+            r.calcType              = gs(item, "calcType");
+            r.symbol                = gs(item, "symbol");
+            r.tradeId               = gi(item, "tradeId");
+            r.currentPrice          = gd(item, "currentPrice");
+            r.quantity              = gd(item, "quantity");
+            r.buyFees               = gd(item, "buyFees");
+            r.sellFees              = gd(item, "sellFees");
+            r.feeHedgingCoefficient = gd(item, "feeHedgingCoefficient");
+            r.portfolioPump         = gd(item, "portfolioPump");
+            r.symbolCount           = gi(item, "symbolCount");
+            r.coefficientK          = gd(item, "coefficientK");
+            r.feeSpread             = gd(item, "feeSpread");
+            r.deltaTime             = gd(item, "deltaTime");
+            r.surplusRate           = gd(item, "surplusRate");
+            r.horizonCount          = gi(item, "horizonCount");
+            r.generateStopLosses    = gb(item, "generateStopLosses");
+            r.riskCoefficient       = gd(item, "riskCoefficient");
+            r.maxRisk               = gd(item, "maxRisk");
+            r.minRisk               = gd(item, "minRisk");
+            out.push_back(r);
+        }
+        return out;
+    }
+
+    static njs3::json encodeParams(const std::vector<ParamsRow>& rows)
+    {
+        njs3::js_array arr;
+        for (const auto& r : rows)
+        {
+            njs3::json row(njs3::js_object{});
+            row["calcType"] = JStr(r.calcType);
+            row["symbol"] = JStr(r.symbol);
+            row["tradeId"] = JI(r.tradeId);
+            row["currentPrice"] = JD(r.currentPrice);
+            row["quantity"] = JD(r.quantity);
+            row["buyFees"] = JD(r.buyFees);
+            row["sellFees"] = JD(r.sellFees);
+            row["feeHedgingCoefficient"] = JD(r.feeHedgingCoefficient);
+            row["portfolioPump"] = JD(r.portfolioPump);
+            row["symbolCount"] = JI(r.symbolCount);
+            row["coefficientK"] = JD(r.coefficientK);
+            row["feeSpread"] = JD(r.feeSpread);
+            row["deltaTime"] = JD(r.deltaTime);
+            row["surplusRate"] = JD(r.surplusRate);
+            row["horizonCount"] = JI(r.horizonCount);
+            row["generateStopLosses"] = JB(r.generateStopLosses);
+            row["riskCoefficient"] = JD(r.riskCoefficient);
+            row["maxRisk"] = JD(r.maxRisk);
+            row["minRisk"] = JD(r.minRisk);
+            arr.push_back(std::move(row));
+        }
+        return njs3::json(std::move(arr));
+    }
+
+    static double decodeWallet(const njs3::json& j)
+    {
+        return static_cast<double>(j["balance"]->get_number_or(0.0L));
+    }
+
+    static njs3::json encodeWallet(const double& balance)
+    {
+        njs3::json j(njs3::js_object{});
+        j["balance"] = JD(balance);
+        return j;
+    }
+
+    static std::vector<PendingExit> decodePendingExits(const njs3::json& j)
+    {
+        std::vector<PendingExit> out;
+        const auto* a = j.as_array();
+        if (!a) return out;
+        for (const auto& item : *a)
+        {
+            PendingExit o;
+            o.symbol       = gs(item, "symbol");
+            o.orderId      = gi(item, "orderId");
+            o.tradeId      = gi(item, "tradeId");
+            o.triggerPrice = gd(item, "triggerPrice");
+            o.sellQty      = gd(item, "sellQty");
+            o.levelIndex   = gi(item, "levelIndex");
+            out.push_back(o);
+        }
+        return out;
+    }
+
+    static njs3::json encodePendingExits(const std::vector<PendingExit>& orders)
+    {
+        njs3::js_array arr;
+        for (const auto& o : orders)
+        {
+            njs3::json j(njs3::js_object{});
+            j["symbol"] = JStr(o.symbol);
+            j["orderId"] = JI(o.orderId);
+            j["tradeId"] = JI(o.tradeId);
+            j["triggerPrice"] = JD(o.triggerPrice);
+            j["sellQty"] = JD(o.sellQty);
+            j["levelIndex"] = JI(o.levelIndex);
+            arr.push_back(std::move(j));
+        }
+        return njs3::json(std::move(arr));
+    }
+
+    static std::vector<EntryPoint> decodeEntryPoints(const njs3::json& j)
+    {
+        std::vector<EntryPoint> out;
+        const auto* a = j.as_array();
+        if (!a) return out;
+        for (const auto& item : *a)
+        {
+            EntryPoint ep;
+            ep.symbol            = gs(item, "symbol");
+            ep.entryId           = gi(item, "entryId");
+            ep.levelIndex        = gi(item, "levelIndex");
+            ep.entryPrice        = gd(item, "entryPrice");
+            ep.breakEven         = gd(item, "breakEven");
+            ep.funding           = gd(item, "funding");
+            ep.fundingQty        = gd(item, "fundingQty");
+            ep.effectiveOverhead = gd(item, "effectiveOverhead");
+            ep.isShort           = gb(item, "isShort");
+            ep.traded            = gb(item, "traded");
+            ep.linkedTradeId     = gi(item, "linkedTradeId");
+            ep.exitTakeProfit    = gd(item, "exitTakeProfit");
+            ep.exitStopLoss      = gd(item, "exitStopLoss");
+            ep.stopLossFraction  = gd(item, "stopLossFraction");
+            ep.stopLossActive    = (ep.stopLossFraction > 0.0);
+            out.push_back(ep);
+        }
+        return out;
+    }
+
+    static njs3::json encodeEntryPoints(const std::vector<EntryPoint>& points)
+    {
+        njs3::js_array arr;
+        for (const auto& ep : points)
+        {
+            njs3::json j(njs3::js_object{});
+            j["symbol"] = JStr(ep.symbol);
+            j["entryId"] = JI(ep.entryId);
+            j["levelIndex"] = JI(ep.levelIndex);
+            j["entryPrice"] = JD(ep.entryPrice);
+            j["breakEven"] = JD(ep.breakEven);
+            j["funding"] = JD(ep.funding);
+            j["fundingQty"] = JD(ep.fundingQty);
+            j["effectiveOverhead"] = JD(ep.effectiveOverhead);
+            j["isShort"] = JB(ep.isShort);
+            j["traded"] = JB(ep.traded);
+            j["linkedTradeId"] = JI(ep.linkedTradeId);
+            j["exitTakeProfit"] = JD(ep.exitTakeProfit);
+            j["exitStopLoss"] = JD(ep.exitStopLoss);
+            j["stopLossFraction"] = JD(ep.stopLossFraction);
+            j["stopLossActive"] = JB(ep.stopLossActive);
+            arr.push_back(std::move(j));
+        }
+        return njs3::json(std::move(arr));
+    }
+
+    static std::vector<ReleasedRow> decodeReleased(const njs3::json& j)
+    {
+        std::vector<ReleasedRow> out;
+        const auto* a = j.as_array();
+        if (!a) return out;
+        for (const auto& item : *a)
+        {
+            ReleasedRow r;
+            r.symbol  = gs(item, "symbol");
+            r.tradeId = gi(item, "tradeId");
+            r.qty     = gd(item, "qty");
+            out.push_back(r);
+        }
+        return out;
+    }
+
+    static njs3::json encodeReleased(const std::vector<ReleasedRow>& rows)
+    {
+        njs3::js_array arr;
+        for (const auto& r : rows)
+        {
+            njs3::json row(njs3::js_object{});
+            row["symbol"] = JStr(r.symbol);
+            row["tradeId"] = JI(r.tradeId);
+            row["qty"] = JD(r.qty);
+            arr.push_back(std::move(row));
+        }
+        return njs3::json(std::move(arr));
+    }
+
+    static std::vector<ParamModel> decodeParamModels(const njs3::json& j)
+    {
+        std::vector<ParamModel> out;
+        const auto* a = j.as_array();
+        if (!a) return out;
+        for (const auto& item : *a)
+        {
+            ParamModel m;
+            m.name                  = gs(item, "name");
+            m.levels                = gi(item, "levels");
+            m.risk                  = gd(item, "risk");
+            m.steepness             = gd(item, "steepness");
+            m.feeHedgingCoefficient = gd(item, "feeHedgingCoefficient");
+            m.portfolioPump         = gd(item, "portfolioPump");
+            m.symbolCount           = gi(item, "symbolCount");
+            m.coefficientK          = gd(item, "coefficientK");
+            m.feeSpread             = gd(item, "feeSpread");
+            m.deltaTime             = gd(item, "deltaTime");
+            m.surplusRate           = gd(item, "surplusRate");
+            m.maxRisk               = gd(item, "maxRisk");
+            m.minRisk               = gd(item, "minRisk");
+            m.isShort               = gb(item, "isShort");
+            m.fundMode              = gi(item, "fundMode");
+            m.generateStopLosses    = gb(item, "generateStopLosses");
+            m.rangeAbove            = gd(item, "rangeAbove");
+            m.rangeBelow            = gd(item, "rangeBelow");
+            m.rangeAbovePerDt       = gd(item, "rangeAbovePerDt");
+            m.rangeBelowPerDt       = gd(item, "rangeBelowPerDt");
+            m.futureTradeCount      = gi(item, "futureTradeCount");
+            m.stopLossFraction      = gd(item, "stopLossFraction");
+            m.stopLossHedgeCount    = gi(item, "stopLossHedgeCount");
+            out.push_back(m);
+        }
+        return out;
+    }
+
+    static njs3::json encodeParamModels(const std::vector<ParamModel>& models)
+    {
+        njs3::js_array arr;
+        for (const auto& m : models)
+        {
+            njs3::json j(njs3::js_object{});
+            j["name"] = JStr(m.name);
+            j["levels"] = JI(m.levels);
+            j["risk"] = JD(m.risk);
+            j["steepness"] = JD(m.steepness);
+            j["feeHedgingCoefficient"] = JD(m.feeHedgingCoefficient);
+            j["portfolioPump"] = JD(m.portfolioPump);
+            j["symbolCount"] = JI(m.symbolCount);
+            j["coefficientK"] = JD(m.coefficientK);
+            j["feeSpread"] = JD(m.feeSpread);
+            j["deltaTime"] = JD(m.deltaTime);
+            j["surplusRate"] = JD(m.surplusRate);
+            j["maxRisk"] = JD(m.maxRisk);
+            j["minRisk"] = JD(m.minRisk);
+            j["isShort"] = JB(m.isShort);
+            j["fundMode"] = JI(m.fundMode);
+            j["generateStopLosses"] = JB(m.generateStopLosses);
+            j["rangeAbove"] = JD(m.rangeAbove);
+            j["rangeBelow"] = JD(m.rangeBelow);
+            j["rangeAbovePerDt"] = JD(m.rangeAbovePerDt);
+            j["rangeBelowPerDt"] = JD(m.rangeBelowPerDt);
+            j["futureTradeCount"] = JI(m.futureTradeCount);
+            j["stopLossFraction"] = JD(m.stopLossFraction);
+            j["stopLossHedgeCount"] = JI(m.stopLossHedgeCount);
+            arr.push_back(std::move(j));
+        }
+        return njs3::json(std::move(arr));
+    }
+
+    static std::vector<PnlEntry> decodePnl(const njs3::json& j)
+    {
+        std::vector<PnlEntry> out;
+        const auto* a = j.as_array();
+        if (!a) return out;
+        for (const auto& item : *a)
+        {
+            PnlEntry e;
+            e.timestamp     = gll(item, "timestamp");
+            e.symbol        = gs(item, "symbol");
+            e.sellTradeId   = gi(item, "sellTradeId");
+            e.parentTradeId = gi(item, "parentTradeId");
+            e.entryPrice    = gd(item, "entryPrice");
+            e.sellPrice     = gd(item, "sellPrice");
+            e.quantity      = gd(item, "quantity");
+            e.grossProfit   = gd(item, "grossProfit");
+            e.netProfit     = gd(item, "netProfit");
+            e.cumProfit     = gd(item, "cumProfit");
+            out.push_back(e);
+        }
+        return out;
+    }
+
+    static njs3::json encodePnl(const std::vector<PnlEntry>& rows)
+    {
+        njs3::js_array arr;
+        for (const auto& e : rows)
+        {
+            njs3::json row(njs3::js_object{});
+            row["timestamp"] = JLL(e.timestamp);
+            row["symbol"] = JStr(e.symbol);
+            row["sellTradeId"] = JI(e.sellTradeId);
+            row["parentTradeId"] = JI(e.parentTradeId);
+            row["entryPrice"] = JD(e.entryPrice);
+            row["sellPrice"] = JD(e.sellPrice);
+            row["quantity"] = JD(e.quantity);
+            row["grossProfit"] = JD(e.grossProfit);
+            row["netProfit"] = JD(e.netProfit);
+            row["cumProfit"] = JD(e.cumProfit);
+            arr.push_back(std::move(row));
+        }
+        return njs3::json(std::move(arr));
+    }
+
+    static ChainState decodeChainState(const njs3::json& j)
+    {
+        ChainState state;
+        if (!j->is_object()) return state;
+        state.symbol       = gs(j, "symbol");
+        state.currentCycle = gi(j, "currentCycle");
+        state.totalSavings = gd(j, "totalSavings");
+        state.savingsRate  = gd(j, "savingsRate");
+        state.active       = gb(j, "active");
+        return state;
+    }
+
+    static njs3::json encodeChainState(const ChainState& state)
+    {
+        njs3::json j(njs3::js_object{});
+        j["symbol"] = JStr(state.symbol);
+        j["currentCycle"] = JI(state.currentCycle);
+        j["totalSavings"] = JD(state.totalSavings);
+        j["savingsRate"] = JD(state.savingsRate);
+        j["active"] = JB(state.active);
+        return j;
+    }
+
+    static std::vector<ChainMember> decodeChainMembers(const njs3::json& j)
+    {
+        std::vector<ChainMember> out;
+        const auto* a = j.as_array();
+        if (!a) return out;
+        for (const auto& item : *a)
+        {
+            ChainMember m;
+            m.cycle   = gi(item, "cycle");
+            m.entryId = gi(item, "entryId");
+            out.push_back(m);
+        }
+        return out;
+    }
+
+    static njs3::json encodeChainMembers(const std::vector<ChainMember>& members)
+    {
+        njs3::js_array arr;
+        for (const auto& m : members)
+        {
+            njs3::json j(njs3::js_object{});
+            j["cycle"] = JI(m.cycle);
+            j["entryId"] = JI(m.entryId);
+            arr.push_back(std::move(j));
+        }
+        return njs3::json(std::move(arr));
+    }
+
+    static std::vector<ExitPoint> decodeExitPoints(const njs3::json& j)
+    {
+        std::vector<ExitPoint> out;
+        const auto* a = j.as_array();
+        if (!a) return out;
+        for (const auto& item : *a)
+        {
+            ExitPoint ep;
+            ep.exitId        = gi(item, "exitId");
+            ep.tradeId       = gi(item, "tradeId");
+            ep.symbol        = gs(item, "symbol");
+            ep.levelIndex    = gi(item, "levelIndex");
+            ep.tpPrice       = gd(item, "tpPrice");
+            ep.slPrice       = gd(item, "slPrice");
+            ep.sellQty       = gd(item, "sellQty");
+            ep.sellFraction  = gd(item, "sellFraction");
+            ep.slActive      = gb(item, "slActive");
+            ep.executed      = gb(item, "executed");
+            ep.linkedSellId  = gi(item, "linkedSellId");
+            out.push_back(ep);
+        }
+        return out;
+    }
+
+    static njs3::json encodeExitPoints(const std::vector<ExitPoint>& points)
+    {
+        njs3::js_array arr;
+        for (const auto& ep : points)
+        {
+            njs3::json j(njs3::js_object{});
+            j["exitId"] = JI(ep.exitId);
+            j["tradeId"] = JI(ep.tradeId);
+            j["symbol"] = JStr(ep.symbol);
+            j["levelIndex"] = JI(ep.levelIndex);
+            j["tpPrice"] = JD(ep.tpPrice);
+            j["slPrice"] = JD(ep.slPrice);
+            j["sellQty"] = JD(ep.sellQty);
+            j["sellFraction"] = JD(ep.sellFraction);
+            j["slActive"] = JB(ep.slActive);
+            j["executed"] = JB(ep.executed);
+            j["linkedSellId"] = JI(ep.linkedSellId);
+            arr.push_back(std::move(j));
+        }
+        return njs3::json(std::move(arr));
+    }
+
+    static std::vector<ManagedChain> decodeManagedChains(const njs3::json& j)
+    {
+        std::vector<ManagedChain> out;
+        const auto* a = j.as_array();
+        if (!a) return out;
+        for (const auto& item : *a)
+        {
+            ManagedChain c;
+            c.chainId      = gi(item, "chainId");
+            c.name         = gs(item, "name");
+            c.symbol       = gs(item, "symbol");
+            c.active       = gb(item, "active");
+            c.theoretical  = gb(item, "theoretical");
+            c.currentCycle = gi(item, "currentCycle");
+            c.capital      = gd(item, "capital");
+            c.totalSavings = gd(item, "totalSavings");
+            c.savingsRate  = gd(item, "savingsRate");
+            c.createdAt    = gs(item, "createdAt");
+            c.notes        = gs(item, "notes");
+
+            const auto* cyArr = item["cycles"]->as_array();
+            if (cyArr)
+                for (const auto& cy : *cyArr)
+                {
+                    ManagedChain::CycleEntries ce;
+                    ce.cycle = gi(cy, "cycle");
+                    const auto* ids = cy["entryIds"]->as_array();
+                    if (ids)
+                        for (const auto& id : *ids)
+                            ce.entryIds.push_back(static_cast<int>(id.get_integer_or(0LL)));
+                    c.cycles.push_back(ce);
+                }
+            out.push_back(c);
+        }
+        return out;
+    }
+
+    static njs3::json encodeManagedChains(const std::vector<ManagedChain>& chains)
+    {
+        njs3::js_array arr;
+        for (const auto& c : chains)
+        {
+            njs3::json j(njs3::js_object{});
+            j["chainId"]      = JI(c.chainId);
+            j["name"]         = JStr(c.name);
+            j["symbol"]       = JStr(c.symbol);
+            j["active"]       = JB(c.active);
+            j["theoretical"]  = JB(c.theoretical);
+            j["currentCycle"] = JI(c.currentCycle);
+            j["capital"]      = JD(c.capital);
+            j["totalSavings"] = JD(c.totalSavings);
+            j["savingsRate"]  = JD(c.savingsRate);
+            j["createdAt"]    = JStr(c.createdAt);
+            j["notes"]        = JStr(c.notes);
+
+            njs3::js_array cyArr;
+            for (const auto& cy : c.cycles)
+            {
+                njs3::json cj(njs3::js_object{});
+                cj["cycle"] = JI(cy.cycle);
+                njs3::js_array ids;
+                for (int id : cy.entryIds)
+                    ids.push_back(JI(id));
+                cj["entryIds"] = njs3::json(std::move(ids));
+                cyArr.push_back(std::move(cj));
+            }
+            j["cycles"] = njs3::json(std::move(cyArr));
             arr.push_back(std::move(j));
         }
-        writeJson(horizonsPath(), njs3::json(std::move(arr)));
+        return njs3::json(std::move(arr));
     }
 };
 
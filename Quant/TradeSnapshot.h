@@ -0,0 +1,307 @@
+#pragma once
+
+// ============================================================
+// TradeSnapshot.h — binary columnar snapshot of the trade ledger
+//
+// Layout (host byte order, every section 8-byte aligned):
+//
+//   Header     magic "QTRDCOL1", u32 byteOrder (0x01020304),
+//              u32 version, u64 rows, u64 symbols, u64 symbolBytes
+//   Symbols    u32 offsets[symbols + 1], then the UTF-8 bytes
+//   Columns    f64 value, f64 quantity, f64 buyFee, f64 sellFee,
+//              i64 timestamp, i32 tradeId, i32 parentTradeId,
+//              u32 symbol (index into the table), u8 type,
+//              u8 shortEnabled — each `rows` entries long
+//
+// The columns hold exactly the fields trades.json persists, so
+// JSON <-> binary conversion is lossless.  View reads a mapped
+// (or in-memory) snapshot in place: columns are accessed by
+// index and symbols come back as string_views into the table.
+// ============================================================
+
+#include "Trade.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace TradeSnapshot {
+
+inline constexpr char          kMagic[8]  = {'Q','T','R','D','C','O','L','1'};
+inline constexpr std::uint32_t kByteOrder = 0x01020304u;
+inline constexpr std::uint32_t kVersion   = 1;
+
+struct Header
+{
+    char          magic[8];
+    std::uint32_t byteOrder;
+    std::uint32_t version;
+    std::uint64_t rows;
+    std::uint64_t symbols;
+    std::uint64_t symbolBytes;
+};
+static_assert(sizeof(Header) == 40, "snapshot header must stay packed");
+
+inline std::size_t align8(std::size_t n) { return (n + 7) & ~std::size_t(7); }
+
+inline bool isSnapshot(std::string_view bytes)
+{
+    return bytes.size() >= sizeof(Header) && std::memcmp(bytes.data(), kMagic, sizeof(kMagic)) == 0;
+}
+
+// Serialize the persisted fields of `trades`.
+inline std::string encode(const std::vector<Trade>& trades)
+{
+    std::vector<std::string_view> names;
+    std::unordered_map<std::string_view, std::uint32_t> index;
+    std::vector<std::uint32_t> symbolCol(trades.size());
+    for (std::size_t i = 0; i < trades.size(); ++i)
+    {
+        auto [it, added] = index.try_emplace(trades[i].symbol, static_cast<std::uint32_t>(names.size()));
+        if (added) names.push_back(trades[i].symbol);
+        symbolCol[i] = it->second;
+    }
+
+    std::vector<std::uint32_t> offsets(names.size() + 1, 0);
+    std::string symbolBytes;
+    for (std::size_t i = 0; i < names.size(); ++i)
+    {
+        symbolBytes.append(names[i]);
+        offsets[i + 1] = static_cast<std::uint32_t>(symbolBytes.size());
+    }
+
+    Header h{};
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.byteOrder   = kByteOrder;
+    h.version     = kVersion;
+    h.rows        = trades.size();
+    h.symbols     = names.size();
+    h.symbolBytes = symbolBytes.size();
+
+    std::string out;
+    auto put = [&out](const void* p, std::size_t n) {
+        out.append(static_cast<const char*>(p), n);
+        out.resize(align8(out.size()), '\0');
+    };
+    auto column = [&](auto field) {
+        using V = decltype(field(trades[0]));
+        std::vector<V> col;
+        col.reserve(trades.size());
+        for (const auto& t : trades) col.push_back(field(t));
+        put(col.data(), col.size() * sizeof(V));
+    };
+
+    put(&h, sizeof(h));
+    put(offsets.data(), offsets.size() * sizeof(std::uint32_t));
+    put(symbolBytes.data(), symbolBytes.size());
+    if (trades.empty()) return out;
+
+    column([](const Trade& t) { return t.value; });
+    column([](const Trade& t) { return t.quantity; });
+    column([](const Trade& t) { return t.buyFee; });
+    column([](const Trade& t) { return t.sellFee; });
+    column([](const Trade& t) { return static_cast<std::int64_t>(t.timestamp); });
+    column([](const Trade& t) { return static_cast<std::int32_t>(t.tradeId); });
+    column([](const Trade& t) { return static_cast<std::int32_t>(t.parentTradeId); });
+    put(symbolCol.data(), symbolCol.size() * sizeof(std::uint32_t));
+    column([](const Trade& t) { return static_cast<std::uint8_t>(t.type); });
+    column([](const Trade& t) { return static_cast<std::uint8_t>(t.shortEnabled ? 1 : 0); });
+    return out;
+}
+
+// Read-only view over snapshot bytes; the bytes must outlive it.
+class View
+{
+public:
+    explicit View(std::string_view bytes)
+    {
+        if (!isSnapshot(bytes)) throw std::runtime_error("not a trade snapshot");
+        std::memcpy(&m_h, bytes.data(), sizeof(m_h));
+        if (m_h.byteOrder != kByteOrder) throw std::runtime_error("trade snapshot has foreign byte order");
+        if (m_h.version != kVersion)     throw std::runtime_error("unsupported trade snapshot version");
+
+        std::size_t pos = align8(sizeof(Header));
+        auto take = [&](std::size_t n) {
+            if (n > bytes.size() || pos > bytes.size() - n) throw std::runtime_error("truncated trade snapshot");
+            const char* p = bytes.data() + pos;
+            pos = align8(pos + n);
+            return p;
+        };
+        std::size_t n = static_cast<std::size_t>(m_h.rows);
+        m_offsets  = take((m_h.symbols + 1) * sizeof(std::uint32_t));
+        m_names    = take(m_h.symbolBytes);
+        if (n == 0) return;
+        m_value    = take(n * 8);
+        m_quantity = take(n * 8);
+        m_buyFee   = take(n * 8);
+        m_sellFee  = take(n * 8);
+        m_time     = take(n * 8);
+        m_id       = take(n * 4);
+        m_parent   = take(n * 4);
+        m_symbol   = take(n * 4);
+        m_type     = take(n);
+        m_short    = take(n);
+        for (std::size_t i = 0; i < n; ++i)
+            if (at<std::uint32_t>(m_symbol, i) >= m_h.symbols) throw std::runtime_error("corrupt trade snapshot symbol index");
+    }
+
+    std::size_t size() const { return static_cast<std::size_t>(m_h.rows); }
+
+    int         tradeId(std::size_t i)       const { return at<std::int32_t>(m_id, i); }
+    int         parentTradeId(std::size_t i) const { return at<std::int32_t>(m_parent, i); }
+    TradeType   type(std::size_t i)          const { return static_cast<TradeType>(at<std::uint8_t>(m_type, i)); }
+    double      value(std::size_t i)         const { return at<double>(m_value, i); }
+    double      quantity(std::size_t i)      const { return at<double>(m_quantity, i); }
+    double      buyFee(std::size_t i)        const { return at<double>(m_buyFee, i); }
+    double      sellFee(std::size_t i)       const { return at<double>(m_sellFee, i); }
+    long long   timestamp(std::size_t i)     const { return at<std::int64_t>(m_time, i); }
+    bool        shortEnabled(std::size_t i)  const { return at<std::uint8_t>(m_short, i) != 0; }
+
+    std::string_view symbol(std::size_t i) const
+    {
+        std::uint32_t s = at<std::uint32_t>(m_symbol, i);
+        std::uint32_t b = at<std::uint32_t>(m_offsets, s), e = at<std::uint32_t>(m_offsets, s + 1);
+        if (b > e || e > m_h.symbolBytes) return {};
+        return std::string_view(m_names + b, e - b);
+    }
+
+    Trade row(std::size_t i) const
+    {
+        Trade t;
+        t.symbol        = std::string(symbol(i));
+        t.tradeId       = tradeId(i);
+        t.type          = type(i);
+        t.value         = value(i);
+        t.quantity      = quantity(i);
+        t.parentTradeId = parentTradeId(i);
+        t.shortEnabled  = shortEnabled(i);
+        t.buyFee        = buyFee(i);
+        t.sellFee       = sellFee(i);
+        t.timestamp     = timestamp(i);
+        return t;
+    }
+
+    std::vector<Trade> toTrades() const
+    {
+        std::vector<Trade> out;
+        out.reserve(size());
+        for (std::size_t i = 0; i < size(); ++i)
+            out.push_back(row(i));
+        return out;
+    }
+
+private:
+    template <typename V>
+    static V at(const char* col, std::size_t i)
+    {
+        V v;
+        std::memcpy(&v, col + i * sizeof(V), sizeof(V));
+        return v;
+    }
+
+    Header      m_h{};
+    const char* m_offsets  = nullptr;
+    const char* m_names    = nullptr;
+    const char* m_value    = nullptr;
+    const char* m_quantity = nullptr;
+    const char* m_buyFee   = nullptr;
+    const char* m_sellFee  = nullptr;
+    const char* m_time     = nullptr;
+    const char* m_id       = nullptr;
+    const char* m_parent   = nullptr;
+    const char* m_symbol   = nullptr;
+    const char* m_type     = nullptr;
+    const char* m_short    = nullptr;
+};
+
+inline std::vector<Trade> decode(std::string_view bytes)
+{
+    return View(bytes).toTrades();
+}
+
+// Read-only memory mapping of a whole file (empty if missing).
+class Mapping
+{
+public:
+    Mapping() = default;
+    explicit Mapping(const std::string& path) { open(path); }
+    ~Mapping() { close(); }
+    Mapping(const Mapping&) = delete;
+    Mapping& operator=(const Mapping&) = delete;
+
+    bool open(const std::string& path)
+    {
+        close();
+#ifdef _WIN32
+        HANDLE f = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                               nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (f == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER sz{};
+        if (GetFileSizeEx(f, &sz) && sz.QuadPart > 0)
+        {
+            HANDLE m = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (m)
+            {
+                m_data = static_cast<const char*>(MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0));
+                CloseHandle(m);
+                if (m_data) m_size = static_cast<std::size_t>(sz.QuadPart);
+            }
+        }
+        CloseHandle(f);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st{};
+        if (::fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void* p = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED)
+            {
+                m_data = static_cast<const char*>(p);
+                m_size = static_cast<std::size_t>(st.st_size);
+            }
+        }
+        ::close(fd);
+#endif
+        return m_data != nullptr;
+    }
+
+    void close()
+    {
+        if (!m_data) return;
+#ifdef _WIN32
+        UnmapViewOfFile(m_data);
+#else
+        ::munmap(const_cast<char*>(m_data), m_size);
+#endif
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    std::string_view bytes() const { return std::string_view(m_data ? m_data : "", m_size); }
+
+private:
+    const char* m_data = nullptr;
+    std::size_t m_size = 0;
+};
+
+} // namespace TradeSnapshot
@@ -0,0 +1,222 @@
+#pragma once
+
+// ============================================================
+// TriggerBook.h — per-symbol ladder of TP/SL/entry trigger prices
+//
+// Every live trigger is filed under its symbol on one of two
+// sides:
+//
+//   rising   fires when the market reaches or exceeds the price
+//            (take-profits, pending exits, short entries),
+//            ordered ascending
+//   falling  fires when the market drops to or below the price
+//            (stop-losses, long entries), ordered descending
+//
+// so the triggers crossed by a tick are a prefix of each side:
+// crossed() costs O(log n + k) for k hits.  Triggers are filed
+// under an owner (source, id) — a trade's horizon levels, one
+// exit point, pending exit or entry point — and are removed per
+// owner or per source as the rows change.  Ladders are indexed
+// by SymbolId, so a lookup is an array access.
+// ============================================================
+
+#include "SymbolRegistry.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <utility>
+#include <limits>
+#include <cstdint>
+
+// Values mirror QTriggerKind in the engine C API.
+enum class TriggerKind : std::uint8_t
+{
+    HorizonTP,
+    HorizonSL,
+    ExitTP,
+    ExitSL,
+    PendingExit,
+    EntryLong,
+    EntryShort
+};
+
+inline const char* triggerTag(TriggerKind k)
+{
+    switch (k)
+    {
+    case TriggerKind::HorizonTP:   return "H-TP";
+    case TriggerKind::HorizonSL:   return "H-SL";
+    case TriggerKind::ExitTP:      return "X-TP";
+    case TriggerKind::ExitSL:      return "X-SL";
+    case TriggerKind::PendingExit: return "PE";
+    case TriggerKind::EntryLong:
+    case TriggerKind::EntryShort:  return "ENTRY";
+    }
+    return "";
+}
+
+// Which table a trigger was derived from; together with the row id it
+// names the owner that removeOwner() drops.
+enum class TriggerSource : std::uint8_t
+{
+    Horizon,    // id = tradeId (all levels of the trade)
+    Exit,       // id = exitId
+    Pending,    // id = orderId
+    Entry       // id = entryId
+};
+
+struct Trigger
+{
+    TriggerKind kind    = TriggerKind::ExitTP;
+    std::string symbol;
+    int    id           = 0;    // exitId / orderId / entryId; tradeId for horizons
+    int    tradeId      = -1;   // parent Buy, -1 for entry points
+    int    levelIndex   = 0;
+    double price        = 0.0;  // per-unit trigger price
+    double qty          = 0.0;  // quantity sold or bought (0 for horizon levels)
+
+    bool rising() const
+    {
+        return kind == TriggerKind::HorizonTP || kind == TriggerKind::ExitTP
+            || kind == TriggerKind::PendingExit || kind == TriggerKind::EntryShort;
+    }
+
+    TriggerSource source() const
+    {
+        switch (kind)
+        {
+        case TriggerKind::HorizonTP:
+        case TriggerKind::HorizonSL:   return TriggerSource::Horizon;
+        case TriggerKind::ExitTP:
+        case TriggerKind::ExitSL:      return TriggerSource::Exit;
+        case TriggerKind::PendingExit: return TriggerSource::Pending;
+        default:                       return TriggerSource::Entry;
+        }
+    }
+
+    bool crossedBy(double market) const
+    {
+        return rising() ? market >= price : market <= price;
+    }
+};
+
+class TriggerBook
+{
+public:
+    TriggerBook() = default;
+    TriggerBook(TriggerBook&&) = default;
+    TriggerBook& operator=(TriggerBook&&) = default;
+
+    // Slots point into the ladders, so a copy re-files every trigger.
+    TriggerBook(const TriggerBook& o)
+    {
+        for (const auto& ld : o.m_ladders)
+        {
+            for (const auto& [key, t] : ld.rising)  add(t);
+            for (const auto& [key, t] : ld.falling) add(t);
+        }
+    }
+
+    TriggerBook& operator=(const TriggerBook& o)
+    {
+        if (this != &o) *this = TriggerBook(o);
+        return *this;
+    }
+
+    void clear()
+    {
+        m_ladders.clear();
+        m_owners.clear();
+    }
+
+    std::size_t size() const { return m_owners.size(); }
+
+    void add(const Trigger& t)
+    {
+        SymbolId sym = SymbolRegistry::intern(t.symbol);
+        if (sym >= m_ladders.size()) m_ladders.resize(sym + 1);
+        Ladder& ld = m_ladders[sym];
+        bool up = t.rising();
+        // The falling side is keyed by -price so both sides share one
+        // ascending map and a crossing is always a prefix.
+        auto it = (up ? ld.rising : ld.falling).emplace(up ? t.price : -t.price, t);
+        m_owners.emplace(Owner{t.source(), t.id}, Slot{&ld, up, it});
+    }
+
+    // Drop every trigger filed under (source, id).
+    void removeOwner(TriggerSource source, int id)
+    {
+        auto [b, e] = m_owners.equal_range(Owner{source, id});
+        for (auto it = b; it != e; ++it)
+            erase(it->second);
+        m_owners.erase(b, e);
+    }
+
+    // Drop every trigger derived from one table.
+    void removeSource(TriggerSource source)
+    {
+        auto b = m_owners.lower_bound(Owner{source, std::numeric_limits<int>::min()});
+        auto e = m_owners.upper_bound(Owner{source, std::numeric_limits<int>::max()});
+        for (auto it = b; it != e; ++it)
+            erase(it->second);
+        m_owners.erase(b, e);
+    }
+
+    bool hasOwner(TriggerSource source, int id) const
+    {
+        return m_owners.count(Owner{source, id}) > 0;
+    }
+
+    // Visit the triggers on `symbol` crossed by `market`: rising ones in
+    // ascending price order, then falling ones in descending price order.
+    template <typename F>
+    void crossed(SymbolId symbol, double market, F&& f) const
+    {
+        if (symbol >= m_ladders.size()) return;
+        const auto& up = m_ladders[symbol].rising;
+        for (auto it = up.begin(), end = up.upper_bound(market); it != end; ++it)
+            f(it->second);
+        const auto& down = m_ladders[symbol].falling;
+        for (auto it = down.begin(), end = down.upper_bound(-market); it != end; ++it)
+            f(it->second);
+    }
+
+    std::vector<Trigger> crossed(SymbolId symbol, double market) const
+    {
+        std::vector<Trigger> out;
+        crossed(symbol, market, [&out](const Trigger& t) { out.push_back(t); });
+        return out;
+    }
+
+    std::vector<Trigger> crossed(const std::string& symbol, double market) const
+    {
+        return crossed(SymbolRegistry::lookup(symbol), market);
+    }
+
+private:
+    using Side  = std::multimap<double, Trigger>;
+    using Owner = std::pair<TriggerSource, int>;
+
+    struct Ladder
+    {
+        Side rising;
+        Side falling;
+    };
+
+    struct Slot
+    {
+        Ladder*        ladder;  // deque growth never moves elements
+        bool           rising;
+        Side::iterator it;
+    };
+
+    static void erase(const Slot& s)
+    {
+        (s.rising ? s.ladder->rising : s.ladder->falling).erase(s.it);
+    }
+
+    std::deque<Ladder>         m_ladders;   // by SymbolId
+    std::multimap<Owner, Slot> m_owners;
+};
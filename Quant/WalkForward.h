@@ -0,0 +1,349 @@
+#pragma once
+// ============================================================
+// WalkForward.h - walk-forward optimisation over ChainOptimizer
+//
+// The price series is cut into consecutive out-of-sample test
+// windows of testTicks, each preceded by a training window of
+// trainTicks (or, anchored, by everything from the series'
+// start).  Each window optimises theta on its training slice
+// only, then runs once over its test slice with that theta:
+//
+//   |---- train 0 ----|- test 0 -|
+//              |---- train 1 ----|- test 1 -|
+//                         |---- train 2 ----|- test 2 -|
+//
+// Warm start seeds a window's optimisation with the previous
+// window's theta, which makes windows depend on each other.  To
+// still run them concurrently, the windows are dealt out in
+// `chains` contiguous runs: each run warm-starts down its own
+// windows and starts cold (from the caller's theta) at its
+// first, and the runs share CpuBatchSim::Pool.  chains = 1 is a
+// fully sequential warm-started walk; without warm start every
+// window is its own chain.  Results depend on `chains`, never on
+// the thread count.
+//
+// The test windows are then simulated in order, each starting
+// from the equity the previous one ended with (open positions
+// marked at its last price and carried over as cash, savings
+// banked), which gives one aggregate out-of-sample equity curve
+// with a point per test tick.
+// ============================================================
+
+#include "ChainOptimizer.h"
+#include "CpuBatchSim.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace WalkForward {
+
+struct Config
+{
+    int            trainTicks = 500;
+    int            testTicks  = 100;
+    bool           anchored   = false;  // train on [0, testBegin) instead of a rolling window
+    bool           warmStart  = true;
+    int            chains     = 4;      // concurrent warm-start chains (see above)
+    ChainObjective objective  = ChainObjective::MaxWealth;
+    int            maxSteps   = 50;
+    double         lr         = 0.001;
+};
+
+// Tick ranges [begin, end) into the series.
+struct Window
+{
+    int         index      = 0;
+    std::size_t trainBegin = 0, trainEnd = 0;
+    std::size_t testBegin  = 0, testEnd  = 0;
+};
+
+// The windows over a series of n ticks; a last test window shorter
+// than testTicks is kept if it has at least two ticks.
+inline std::vector<Window> windows(std::size_t n, const Config& c)
+{
+    if (c.trainTicks < 2) throw std::runtime_error("A training window needs at least 2 ticks");
+    if (c.testTicks < 2)  throw std::runtime_error("A test window needs at least 2 ticks");
+
+    std::vector<Window> out;
+    const std::size_t train = static_cast<std::size_t>(c.trainTicks);
+    const std::size_t test  = static_cast<std::size_t>(c.testTicks);
+    for (std::size_t b = train; b + 2 <= n; b += test)
+    {
+        Window w;
+        w.index      = static_cast<int>(out.size());
+        w.trainBegin = c.anchored ? 0 : b - train;
+        w.trainEnd   = b;
+        w.testBegin  = b;
+        w.testEnd    = std::min(b + test, n);
+        out.push_back(w);
+    }
+    if (out.empty())
+        throw std::runtime_error("The series is too short for one training and one test window");
+    return out;
+}
+
+// The parameters ChainOptimizer moves.
+struct Theta
+{
+    double surplus = 0, risk = 0, steepness = 0, feeHedging = 0, maxRisk = 0, savingsRate = 0;
+
+    static Theta of(const ChainParams& p)
+    {
+        return { p.surplus, p.risk, p.steepness, p.feeHedging, p.maxRisk, p.savingsRate };
+    }
+    void applyTo(ChainParams& p) const
+    {
+        p.surplus = surplus; p.risk = risk; p.steepness = steepness;
+        p.feeHedging = feeHedging; p.maxRisk = maxRisk; p.savingsRate = savingsRate;
+    }
+};
+
+struct WindowResult
+{
+    Window    window;
+    long long trainFrom = 0, trainTo = 0;   // first and last timestamps
+    long long testFrom  = 0, testTo  = 0;
+    bool      warmStarted = false;
+    int       steps       = 0;
+    Theta     theta;                        // fitted on the training slice
+    double    trainStartObjective = 0.0;    // J at the starting theta
+    double    trainObjective      = 0.0;    // J at the fitted theta
+    double    testObjective       = 0.0;    // J out of sample
+
+    // The out-of-sample run
+    double startCapital    = 0.0;
+    double finalCapital    = 0.0;
+    double totalRealized   = 0.0;
+    double totalFees       = 0.0;
+    double totalSavings    = 0.0;
+    double openValue       = 0.0;           // positions still held, at the last test price
+    int    cyclesCompleted = 0;
+    int    tradesOpened    = 0;
+    int    tradesClosed    = 0;
+
+    double equity() const { return finalCapital + totalSavings + openValue; }
+};
+
+struct EquityPoint
+{
+    long long timestamp = 0;
+    double    price     = 0.0;
+    double    equity    = 0.0;   // cash, savings and open positions at `price`
+    int       window    = 0;
+};
+
+struct Summary
+{
+    int    windows          = 0;
+    double startingCapital  = 0.0;
+    double finalEquity      = 0.0;
+    double meanTrainObjective = 0.0;
+    double meanTestObjective  = 0.0;
+    int    cyclesCompleted  = 0;
+    double seconds          = 0.0;
+    std::vector<EquityPoint> equity;   // aggregate out-of-sample curve
+};
+
+// Walk `base` (price-series mode; its theta is the cold start) over
+// its own series.  onWindow, if set, sees each window in order on
+// the calling thread once every window has been fitted; returning
+// false stops the out-of-sample pass there.
+inline Summary run(const ChainParams& base, const Config& cfg,
+                   const std::function<bool(const WindowResult&)>& onWindow = {})
+{
+    auto t0 = std::chrono::steady_clock::now();
+    if (!base.hasPriceSeries()) throw std::runtime_error("Walk-forward needs a price series");
+    if (base.capital <= 0)      throw std::runtime_error("Capital must be positive");
+
+    std::vector<PricePoint> pts;
+    for (const PricePoint& pt : base.prices.series(base.symbol)) pts.push_back(pt);
+    const std::vector<Window> wins = windows(pts.size(), cfg);
+    const int n = static_cast<int>(wins.size());
+
+    // Every window's ChainParams is this plus its own slice, so the
+    // full series is copied once rather than per optimiser step.
+    ChainParams proto = base;
+    proto.prices = PriceSeries();
+    auto withSlice = [&](std::size_t b, std::size_t e) {
+        ChainParams p = proto;
+        p.prices.setSeries(p.symbol, std::vector<PricePoint>(pts.begin() + b, pts.begin() + e));
+        return p;
+    };
+
+    std::vector<WindowResult> rows(n);
+    for (int i = 0; i < n; ++i)
+    {
+        WindowResult& r = rows[i];
+        r.window    = wins[i];
+        r.trainFrom = pts[wins[i].trainBegin].timestamp;
+        r.trainTo   = pts[wins[i].trainEnd - 1].timestamp;
+        r.testFrom  = pts[wins[i].testBegin].timestamp;
+        r.testTo    = pts[wins[i].testEnd - 1].timestamp;
+    }
+
+    // ---- Fit: chains of windows, concurrently ----
+    const int chains = cfg.warmStart ? std::max(1, std::min(cfg.chains, n)) : n;
+    // A fit running inside the pool can't hand its gradient probes
+    // to the same pool, so concurrent chains probe sequentially.
+    const BatchSim::Backend backend = chains > 1 ? BatchSim::Backend::Sequential
+                                                 : base.batchBackend;
+    auto fitChain = [&](int c) {
+        int lo = static_cast<int>(static_cast<long long>(n) * c / chains);
+        int hi = static_cast<int>(static_cast<long long>(n) * (c + 1) / chains);
+        Theta theta = Theta::of(base);
+        for (int i = lo; i < hi; ++i)
+        {
+            WindowResult& r = rows[i];
+            ChainParams p = withSlice(r.window.trainBegin, r.window.trainEnd);
+            p.batchBackend = backend;
+            r.warmStarted = cfg.warmStart && i > lo;
+            if (r.warmStarted) theta.applyTo(p);
+
+            OptimizationResult o = ChainOptimizer::optimize(p, cfg.objective, cfg.maxSteps, cfg.lr);
+            r.steps               = o.steps;
+            r.theta               = Theta::of(o.optimizedParams);
+            r.trainStartObjective = o.objectiveHistory.front();
+            r.trainObjective      = o.objectiveHistory.back();
+            theta = r.theta;
+        }
+    };
+    if (chains > 1) CpuBatchSim::Pool::instance().forEach(chains, fitChain);
+    else            fitChain(0);
+
+    // ---- Test: in order, carrying equity from window to window ----
+    Summary out;
+    out.startingCapital = base.capital;
+    double cash = base.capital, banked = 0.0;
+    out.equity.reserve(pts.size() - wins.front().testBegin);
+    for (int i = 0; i < n; ++i)
+    {
+        WindowResult& r = rows[i];
+        ChainParams p = withSlice(r.window.testBegin, r.window.testEnd);
+        r.theta.applyTo(p);
+        p.capital = cash;
+
+        SimResult sim;
+        r.testObjective   = ChainOptimizer::evaluate(p, cfg.objective, &sim);
+        r.startCapital    = cash;
+        r.finalCapital    = sim.finalCapital;
+        r.totalRealized   = sim.totalRealized;
+        r.totalFees       = sim.totalFees;
+        r.totalSavings    = sim.totalSavings;
+        r.cyclesCompleted = sim.cyclesCompleted;
+        r.tradesOpened    = sim.tradesOpened;
+        r.tradesClosed    = sim.tradesClosed;
+        const double last = pts[r.window.testEnd - 1].price;
+        for (const SimTrade& t : sim.trades) r.openValue += t.remaining * last;
+
+        // One snapshot per tick; the quantity held at each comes from
+        // the fills and sells up to it, both in time order.
+        std::size_t ti = 0, si = 0;
+        double held = 0.0;
+        for (std::size_t k = 0; k < sim.snapshots.size(); ++k)
+        {
+            const SimSnapshot& s = sim.snapshots[k];
+            const PricePoint& pt = pts[r.window.testBegin + k];
+            for (; ti < sim.trades.size() && sim.trades[ti].entryTime <= s.timestamp; ++ti)
+                held += sim.trades[ti].quantity;
+            for (; si < sim.sells.size() && sim.sells[si].sellTime <= s.timestamp; ++si)
+                held -= sim.sells[si].quantity;
+            out.equity.push_back({ s.timestamp, pt.price,
+                                   banked + s.capital + s.savings + std::max(0.0, held) * pt.price, i });
+        }
+
+        cash    = r.finalCapital + r.openValue;
+        banked += r.totalSavings;
+        out.windows++;
+        out.meanTrainObjective += r.trainObjective;
+        out.meanTestObjective  += r.testObjective;
+        out.cyclesCompleted    += r.cyclesCompleted;
+        if (onWindow && !onWindow(r)) break;
+    }
+
+    out.finalEquity = cash + banked;
+    if (out.windows > 0)
+    {
+        out.meanTrainObjective /= out.windows;
+        out.meanTestObjective  /= out.windows;
+    }
+    out.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return out;
+}
+
+// ---- Output ----
+
+inline std::string jsonWindow(const WindowResult& r)
+{
+    std::ostringstream s;
+    s << std::setprecision(17)
+      << "{\"window\":"               << r.window.index
+      << ",\"trainBegin\":"           << r.window.trainBegin
+      << ",\"trainEnd\":"             << r.window.trainEnd
+      << ",\"testBegin\":"            << r.window.testBegin
+      << ",\"testEnd\":"              << r.window.testEnd
+      << ",\"trainFrom\":"            << r.trainFrom
+      << ",\"trainTo\":"              << r.trainTo
+      << ",\"testFrom\":"             << r.testFrom
+      << ",\"testTo\":"               << r.testTo
+      << ",\"warmStarted\":"          << (r.warmStarted ? "true" : "false")
+      << ",\"steps\":"                << r.steps
+      << ",\"theta\":{\"surplus\":"   << r.theta.surplus
+      << ",\"risk\":"                 << r.theta.risk
+      << ",\"steepness\":"            << r.theta.steepness
+      << ",\"feeHedging\":"           << r.theta.feeHedging
+      << ",\"maxRisk\":"              << r.theta.maxRisk
+      << ",\"savingsRate\":"          << r.theta.savingsRate << '}'
+      << ",\"trainStartObjective\":"  << r.trainStartObjective
+      << ",\"trainObjective\":"       << r.trainObjective
+      << ",\"testObjective\":"        << r.testObjective
+      << ",\"startCapital\":"         << r.startCapital
+      << ",\"finalCapital\":"         << r.finalCapital
+      << ",\"equity\":"               << r.equity()
+      << ",\"totalRealized\":"        << r.totalRealized
+      << ",\"totalFees\":"            << r.totalFees
+      << ",\"totalSavings\":"         << r.totalSavings
+      << ",\"openValue\":"            << r.openValue
+      << ",\"cyclesCompleted\":"      << r.cyclesCompleted
+      << ",\"tradesOpened\":"         << r.tradesOpened
+      << ",\"tradesClosed\":"         << r.tradesClosed << '}';
+    return s.str();
+}
+
+// The summary; the equity curve as [[timestamp, price, equity, window], ...]
+// unless `curve` is false.
+inline std::string jsonSummary(const Summary& sum, bool curve = true)
+{
+    std::ostringstream s;
+    s << std::setprecision(17)
+      << "{\"windows\":"             << sum.windows
+      << ",\"startingCapital\":"     << sum.startingCapital
+      << ",\"finalEquity\":"         << sum.finalEquity
+      << ",\"return\":"              << (sum.startingCapital > 0
+                                         ? sum.finalEquity / sum.startingCapital - 1.0 : 0.0)
+      << ",\"meanTrainObjective\":"  << sum.meanTrainObjective
+      << ",\"meanTestObjective\":"   << sum.meanTestObjective
+      << ",\"cyclesCompleted\":"     << sum.cyclesCompleted
+      << ",\"seconds\":"             << sum.seconds;
+    if (curve)
+    {
+        s << ",\"equity\":[";
+        for (std::size_t i = 0; i < sum.equity.size(); ++i)
+        {
+            const EquityPoint& e = sum.equity[i];
+            s << (i ? "," : "") << '[' << e.timestamp << ',' << e.price << ','
+              << e.equity << ',' << e.window << ']';
+        }
+        s << ']';
+    }
+    s << '}';
+    return s.str();
+}
+
+} // namespace WalkForward
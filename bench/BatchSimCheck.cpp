@@ -0,0 +1,261 @@
+// ============================================================
+// BatchSimCheck.cpp — cross-check of Simulator::run against the
+// batched-simulation contract (cpuBatchSim, and cudaGpuBatchSim
+// when built with QUANT_CUDA and a GPU is present)
+//
+//   check-batchsim [configs] [seed]     (default 500, 1)
+//
+// Each config is drawn at random inside the kernel's capacity
+// limits, with a monthly trade cap and a capital pump on about
+// half of them, and run over its own random walk of daily or
+// hourly ticks spanning several months.  The objectives a
+// SimResult can express (realized, MaxProfit, MinSpread, MaxROI,
+// MaxWealth) must match the batch results to 1e-9 relative
+// (1e-6 for the GPU).  Runs that outgrow the kernel's position
+// or cycle arrays are skipped, and so are runs where roundoff
+// alone decides how a position's last dust is sold (see
+// knifeEdge).  Exits 1 on any mismatch.
+// ============================================================
+
+#include "Simulator.h"
+#include "CpuBatchSim.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+// The SimConfig ChainOptimizer builds for the same parameters.
+SimConfig toSimConfig(const GpuSimParams& g, const PriceSeries& prices)
+{
+    SimConfig cfg;
+    cfg.symbol              = "X";
+    cfg.prices              = &prices;
+    cfg.startingCapital     = g.capital;
+    cfg.entryRisk           = g.entryRisk;
+    cfg.entrySteepness      = g.entrySteepness;
+    cfg.entryRangeBelow     = g.rangeBelow;
+    cfg.entryRangeAbove     = g.rangeAbove;
+    cfg.exitRisk            = g.exitRisk;
+    cfg.exitFraction        = g.exitFraction;
+    cfg.exitSteepness       = g.exitSteepness;
+    cfg.buyFeeRate          = g.buyFeeRate;
+    cfg.sellFeeRate         = g.sellFeeRate;
+    cfg.downtrendCount      = g.downtrendCount;
+    cfg.chainCycles         = g.chainCycles != 0;
+    cfg.savingsRate         = g.savingsRate;
+    cfg.autoRange           = g.autoRange != 0;
+    cfg.entryLevels         = g.levels;
+    cfg.exitLevels          = g.exitLevels;
+    cfg.maxTradesPerMonth   = g.maxTradesPerMonth;
+    cfg.capitalPumpPerMonth = g.capitalPumpPerMonth;
+
+    HorizonParams& hp = cfg.horizonParams;
+    hp.feeSpread             = g.feeSpread;
+    hp.feeHedgingCoefficient = g.feeHedging;
+    hp.surplusRate           = g.surplus;
+    hp.symbolCount           = g.symbolCount;
+    hp.deltaTime             = g.deltaTime;
+    hp.coefficientK          = g.coefficientK;
+    hp.horizonCount          = g.levels;
+    hp.portfolioPump         = g.capital;
+    hp.maxRisk               = g.maxRisk;
+    hp.minRisk               = g.minRisk;
+    hp.futureTradeCount      = g.futureTradeCount;
+    hp.stopLossFraction      = g.stopLossFraction;
+    hp.stopLossHedgeCount    = g.stopLossHedgeCount;
+    return cfg;
+}
+
+// The kernel's objective, computed from a SimResult.
+double objective(const SimResult& r, const GpuSimParams& g, int obj)
+{
+    switch (obj)
+    {
+    case CpuBatchSim::OBJ_MIN_SPREAD:
+    {
+        double sum = 0;
+        for (const SimSell& s : r.sells)
+        {
+            double sp = (s.sellPrice - s.entryPrice) / std::fmax(s.entryPrice, 1e-15);
+            sum -= sp * sp;
+        }
+        return sum;
+    }
+    case CpuBatchSim::OBJ_MAX_ROI:
+        return g.capital > 1e-15 ? r.totalRealized / g.capital : 0;
+    case CpuBatchSim::OBJ_MAX_WEALTH:
+        return r.finalCapital + r.totalSavings;
+    default:   // realized, OBJ_MAX_PROFIT
+        return r.totalRealized;
+    }
+}
+
+// A position sold down to a roundoff-sized leftover is where the
+// simulator and the kernel can legitimately part ways: they size
+// entries and exits with the same formulas but different roundoff,
+// so one may sell a last ~1e-14 "dust" slice that the other never
+// holds, or keep a leftover just above the 1e-15 "closed" threshold
+// (which stops its cycle from chaining) where the other ends just
+// below.  The kernel side comes from a Lane stepped over the same
+// ticks; positions line up in fill order.
+bool knifeEdge(const SimResult& r, const GpuSimParams& g,
+               const std::vector<double>& ts, const std::vector<double>& px)
+{
+    auto lane = std::make_unique<CpuBatchSim::Lane>();
+    lane->start(g, px[0]);
+    int month = -1;
+    for (std::size_t i = 0; i < px.size(); ++i)
+    {
+        int m = ts[i] > 0.0 ? static_cast<int>(ts[i] / CpuBatchSim::kSecsPerMonth) : -1;
+        if (m != month && m >= 0) { month = m; lane->rollover(m); }
+        lane->step(px[i]);
+    }
+
+    std::vector<int> sold(r.trades.size() + 1, 0);
+    for (const SimSell& s : r.sells)
+        if (s.buyId > 0 && s.buyId <= static_cast<int>(r.trades.size())) ++sold[s.buyId];
+
+    int n = std::min(lane->positions(), static_cast<int>(r.trades.size()));
+    for (int i = 0; i < n; ++i)
+    {
+        double sim = r.trades[i].remaining, dev = lane->remaining(i);
+        if (sim < 1e-12 && dev < 1e-12
+            && ((sim > 1e-15) != (dev > 1e-15) || sold[r.trades[i].id] != lane->exitsFilled(i)))
+            return true;
+    }
+    return false;
+}
+
+bool close(double a, double b, double tol)
+{
+    return std::fabs(a - b) <= tol * (1.0 + std::max(std::fabs(a), std::fabs(b)));
+}
+
+GpuSimParams draw(std::mt19937_64& rng)
+{
+    std::uniform_real_distribution<double> u(0, 1);
+    auto chance = [&](double p) { return u(rng) < p; };
+
+    GpuSimParams g{};
+    g.capital            = 1000 + u(rng) * 20000;
+    g.surplus            = u(rng) * 0.05;
+    g.entryRisk          = g.risk = u(rng);
+    g.entrySteepness     = g.steepness = 0.5 + u(rng) * 8;
+    g.feeHedging         = 1 + u(rng);
+    g.maxRisk            = chance(0.5) ? 0 : u(rng) * 0.2;
+    g.minRisk            = u(rng) * 0.01;
+    g.savingsRate        = u(rng) * 0.3;
+    g.feeSpread          = u(rng) * 0.01;
+    g.deltaTime          = 1;
+    g.symbolCount        = 1;
+    g.coefficientK       = u(rng);
+    g.buyFeeRate         = u(rng) * 0.002;
+    g.sellFeeRate        = u(rng) * 0.002;
+    g.rangeAbove         = chance(0.3) ? u(rng) * 10 : 0;
+    g.rangeBelow         = chance(0.3) ? u(rng) * 30 : 0;
+    g.futureTradeCount   = static_cast<int>(u(rng) * 3);
+    g.stopLossFraction   = u(rng);
+    g.stopLossHedgeCount = static_cast<int>(u(rng) * 2);
+    g.downtrendCount     = static_cast<int>(u(rng) * 3);
+    g.exitRisk           = u(rng);
+    g.exitFraction       = chance(0.7) ? 1.0 : 0.5 + u(rng) * 0.5;
+    g.exitSteepness      = 0.1 + u(rng) * 6;
+    g.chainCycles        = chance(0.8) ? 1 : 0;
+    g.autoRange          = chance(0.3) ? 1 : 0;
+    g.maxTradesPerMonth  = chance(0.5) ? 1 + static_cast<int>(u(rng) * 5) : 0;
+    g.capitalPumpPerMonth = chance(0.5) ? u(rng) * 500 : 0;
+
+    // Inside the kernel's level arrays: entries <= 32, exits <= 16
+    // (exitLevels = 0 means one exit per entry level).
+    g.exitLevels = static_cast<int>(u(rng) * 17);
+    g.levels     = 1 + static_cast<int>(u(rng) * (g.exitLevels > 0 ? 32 : 16));
+    return g;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int configs = argc > 1 ? std::atoi(argv[1]) : 500;
+    unsigned long long seed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1;
+
+    bool gpu = false;
+#ifdef QUANT_CUDA
+    gpu = CudaAccelerator::init();
+#endif
+    std::printf("check-batchsim: %d configs, seed %llu, GPU %s\n",
+                configs, seed, gpu ? CudaAccelerator::deviceName().c_str() : "not used");
+
+    const int objectives[] = { 0, CpuBatchSim::OBJ_MAX_PROFIT, CpuBatchSim::OBJ_MIN_SPREAD,
+                               CpuBatchSim::OBJ_MAX_ROI, CpuBatchSim::OBJ_MAX_WEALTH };
+
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> u(0, 1);
+    int checked = 0, skipped = 0, edges = 0, capped = 0, pumped = 0, failures = 0;
+    for (int c = 0; c < configs; ++c)
+    {
+        GpuSimParams g = draw(rng);
+
+        // A walk of 200-3000 ticks, daily or hourly, from 2020-09-13.
+        int n = 200 + static_cast<int>(u(rng) * 2800);
+        long long step = u(rng) < 0.5 ? 86400 : 3600;
+        double vol = 0.01 + u(rng) * 0.05;
+        PriceSeries prices;
+        std::vector<PricePoint> pts(n);
+        std::vector<double> ts(n), px(n);
+        double p = 10 + u(rng) * 1000;
+        for (int i = 0; i < n; ++i)
+        {
+            p *= std::exp((u(rng) - 0.5) * vol);
+            pts[i] = { 1600000000LL + i * step, p };
+            ts[i]  = static_cast<double>(pts[i].timestamp);
+            px[i]  = p;
+        }
+        prices.setSeries("X", pts);
+        g.price = px[0];
+
+        SimResult r = Simulator::run(toSimConfig(g, prices));
+        if (r.tradesOpened > CpuBatchSim::kMaxPositions
+            || r.cyclesCompleted >= CpuBatchSim::kMaxCycles)
+        {
+            ++skipped;
+            continue;
+        }
+        if (knifeEdge(r, g, ts, px))
+        {
+            ++edges;
+            continue;
+        }
+        ++checked;
+        if (g.maxTradesPerMonth > 0)     ++capped;
+        if (r.totalPumped > 0)           ++pumped;
+
+        for (int obj : objectives)
+        {
+            double want = objective(r, g, obj);
+            double cpu = 0;
+            bool ok = cpuBatchSim(&g, 1, ts.data(), px.data(), n, obj, &cpu)
+                   && close(want, cpu, 1e-9);
+#ifdef QUANT_CUDA
+            double dev = 0;
+            if (gpu)
+                ok = ok && cudaGpuBatchSim(&g, 1, ts.data(), px.data(), n, obj, &dev)
+                        && close(want, dev, 1e-6);
+#endif
+            if (!ok && ++failures <= 10)
+                std::printf("  MISMATCH config %d objective %d: simulator %.17g  cpu batch %.17g\n",
+                            c, obj, want, cpu);
+        }
+    }
+
+    std::printf("  %d checked (%d with a monthly cap, %d pumped), %d skipped over capacity, "
+                "%d on a roundoff edge\n", checked, capped, pumped, skipped, edges);
+    std::printf("  %s\n", failures ? "FAILED" : "all objectives match");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,90 @@
+// ============================================================
+// IdGeneratorBench.cpp — acquire/commit throughput of IdGenerator
+//
+//   bench-idgen [ids]        (default 1,000,000)
+//
+// Phases: fill 1..N with acquire+commit, release every 10th ID
+// and re-acquire the gaps (lowest-free reuse), then a churn of
+// release/acquire pairs on a full generator.  The old linear
+// probe is timed on a smaller fill for comparison.
+// ============================================================
+
+#include "IdGenerator.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <set>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double seconds(Clock::time_point t0)
+{
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+void report(const char* phase, long long ops, double secs)
+{
+    std::printf("  %-28s %10lld ops  %8.3f s  %12.0f ops/s\n", phase, ops, secs, ops / secs);
+}
+
+// The pre-interval implementation: probe upward from 1 through two sets.
+struct LinearProbe
+{
+    std::set<int> used, locked;
+    int acquire()
+    {
+        int id = 1;
+        while (used.count(id) || locked.count(id)) ++id;
+        locked.insert(id);
+        return id;
+    }
+    void commit(int id) { locked.erase(id); used.insert(id); }
+};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int n = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    std::printf("IdGenerator, %d ids\n", n);
+
+    IdGenerator gen;
+    auto t0 = Clock::now();
+    for (int i = 0; i < n; ++i)
+        gen.commit(gen.acquire());
+    report("fill (acquire+commit)", n, seconds(t0));
+
+    t0 = Clock::now();
+    int gaps = 0;
+    for (int id = 10; id <= n; id += 10, ++gaps)
+        gen.release(id);
+    for (int i = 0; i < gaps; ++i)
+    {
+        int id = gen.acquire();
+        if (id != 10 * (i + 1)) { std::printf("  unexpected id %d\n", id); return 1; }
+        gen.commit(id);
+    }
+    report("refill every 10th gap", 2LL * gaps, seconds(t0));
+
+    std::mt19937 rng(42);
+    const int churn = n;
+    t0 = Clock::now();
+    for (int i = 0; i < churn; ++i)
+    {
+        gen.release(1 + static_cast<int>(rng() % n));
+        gen.commit(gen.acquire());
+    }
+    report("churn (release+acquire)", 2LL * churn, seconds(t0));
+
+    const int probeN = n < 5000 ? n : 5000;
+    LinearProbe old;
+    t0 = Clock::now();
+    for (int i = 0; i < probeN; ++i)
+        old.commit(old.acquire());
+    report("linear probe fill (old)", probeN, seconds(t0));
+    return 0;
+}
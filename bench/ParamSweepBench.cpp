@@ -0,0 +1,105 @@
+// ============================================================
+// ParamSweepBench.cpp — ParamSweep throughput against thread count
+//
+//   bench-paramsweep [configs] [points]   (default 10,000, 5,000)
+//
+// A grid of about `configs` points over entryRisk, exitSteepness,
+// surplusRate and downtrendCount is swept over one random walk
+// of `points` hourly ticks, once per thread count from 1 up to
+// the core count (doubling).  Each pass reports configs/s and
+// the speedup over one thread, and its rows are checked against
+// the single-thread pass: the grid must come out identical no
+// matter how the work was shared.
+// ============================================================
+
+#include "ParamSweep.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+    int configs = argc > 1 ? std::atoi(argv[1]) : 10000;
+    int points  = argc > 2 ? std::atoi(argv[2]) : 5000;
+
+    std::mt19937_64 rng(7);
+    std::normal_distribution<double> step(0.0, 0.01);
+    std::vector<PricePoint> pts(points);
+    double p = 100.0;
+    for (int i = 0; i < points; ++i)
+    {
+        p *= std::exp(step(rng));
+        pts[i] = { 1600000000LL + i * 3600LL, p };
+    }
+    PriceSeries prices;
+    prices.setSeries("BENCH", pts);
+
+    SimConfig base;
+    base.symbol          = "BENCH";
+    base.prices          = &prices;
+    base.startingCapital = 10000;
+    base.buyFeeRate      = 0.001;
+    base.sellFeeRate     = 0.001;
+    base.chainCycles     = true;
+    base.entryLevels     = 5;
+    base.horizonParams.horizonCount  = 5;
+    base.horizonParams.portfolioPump = base.startingCapital;
+    base.horizonParams.feeSpread     = 0.001;
+    base.horizonParams.surplusRate   = 0.02;
+
+    // Four axes of roughly equal length whose product is about `configs`.
+    int k = std::max(1, static_cast<int>(std::lround(std::pow(configs, 0.25))));
+    int d = std::min(k, 4);
+    int rest = std::max(1, configs / (k * k * d));
+    std::vector<ParamSweep::Axis> axes = {
+        ParamSweep::linspace("entryRisk",      0.05, 0.95, k),
+        ParamSweep::linspace("exitSteepness",  0.5,  8.0,  k),
+        ParamSweep::linspace("surplusRate",    0.0,  0.1,  rest),
+        ParamSweep::linspace("downtrendCount", 1,    d,    d),
+    };
+    ParamSweep::Sweep sweep(base, axes);
+
+    int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::printf("bench-paramsweep: %zu configs x %d ticks, %d cores\n", sweep.size(), points, cores);
+    std::printf("  %8s %12s %9s  %s\n", "threads", "configs/s", "speedup", "rows");
+
+    std::vector<ParamSweep::Row> reference;
+    double base1 = 0.0;
+    bool ok = true;
+    for (int t = 1; ; t = std::min(t * 2, cores))
+    {
+        BatchSim::setThreads(t);
+        std::vector<ParamSweep::Row> rows;
+        rows.reserve(sweep.size());
+        ParamSweep::Summary s = sweep.run({}, [&](const ParamSweep::Row& r) {
+            rows.push_back(r);
+            return true;
+        });
+
+        bool same = true;
+        if (reference.empty()) reference = rows;
+        else
+            for (std::size_t i = 0; i < rows.size() && same; ++i)
+                same = rows[i].index == reference[i].index
+                    && rows[i].finalCapital == reference[i].finalCapital
+                    && rows[i].cyclesCompleted == reference[i].cyclesCompleted;
+        ok = ok && same && rows.size() == sweep.size();
+
+        double rate = s.evaluated / s.seconds;
+        if (t == 1) base1 = rate;
+        std::printf("  %8d %12.0f %8.2fx  %s\n", t, rate, rate / base1, same ? "identical" : "DIFFER");
+        if (t == cores) break;
+    }
+
+    if (!reference.empty())
+    {
+        ParamSweep::Summary best = sweep.run({ ParamSweep::Metric::FinalCapital, 1 });
+        std::printf("  best finalCapital %.2f at %s", best.top[0].finalCapital,
+                    ParamSweep::csvRow(best.top[0]).c_str());
+    }
+    return ok ? 0 : 1;
+}
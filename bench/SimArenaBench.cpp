@@ -0,0 +1,199 @@
+// ============================================================
+// SimArenaBench.cpp — what a Simulator run allocates, and what
+// an arena and the snapshot policy save
+//
+//   bench-simarena [points] [runs]   (default 1,000,000, 5)
+//
+// One mean-reverting walk of `points` hourly ticks is run `runs`
+// times per mode: plain Simulator::run, then run(cfg, arena) with
+// snapshots every tick, every 1000th tick and none.  Each mode
+// reports ms/run and the heap allocations and bytes of its last
+// (warm) run; every mode must close the same books as run().
+// Then ChainOptimizer::evaluate is timed with a SimResult out
+// (the trace path) against the objective-only fast path, and
+// the two objectives must agree exactly.  Exits 1 on any
+// mismatch.
+// ============================================================
+
+#include "ChainOptimizer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+
+namespace {
+
+std::atomic<long long> g_allocs{ 0 };
+std::atomic<long long> g_bytes{ 0 };
+
+struct Counted
+{
+    long long allocs, bytes;
+    static Counted now() { return { g_allocs.load(), g_bytes.load() }; }
+    Counted operator-(const Counted& o) const { return { allocs - o.allocs, bytes - o.bytes }; }
+};
+
+bool sameBooks(const SimResult& a, const SimResult& b)
+{
+    return a.finalCapital == b.finalCapital && a.totalRealized == b.totalRealized
+        && a.totalFees == b.totalFees && a.totalSavings == b.totalSavings
+        && a.cyclesCompleted == b.cyclesCompleted && a.trades.size() == b.trades.size()
+        && a.sells.size() == b.sells.size() && a.entryLevels.size() == b.entryLevels.size();
+}
+
+} // namespace
+
+// Counting allocator.  The array forms forward here by default; the
+// aligned forms are left alone, no type in the run over-aligns.  GCC
+// sees free() on the result of a new-expression once the deletes are
+// inlined and warns, though both sides are replaced together.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void* operator new(std::size_t n)
+{
+    ++g_allocs;
+    g_bytes += static_cast<long long>(n);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+int main(int argc, char** argv)
+{
+    int points = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    int runs   = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+
+    // Log-price mean-reverting around 100, so cycles keep completing.
+    std::mt19937_64 rng(17);
+    std::normal_distribution<double> step(0.0, 0.01);
+    std::vector<PricePoint> pts(points);
+    double x = 0.0;
+    for (int i = 0; i < points; ++i)
+    {
+        x = 0.995 * x + step(rng);
+        pts[i] = { 1600000000LL + i * 3600LL, 100.0 * std::exp(x) };
+    }
+    PriceSeries prices;
+    prices.setSeries("BENCH", std::move(pts));
+
+    SimConfig cfg;
+    cfg.symbol          = "BENCH";
+    cfg.prices          = &prices;
+    cfg.startingCapital = 10000;
+    cfg.entryLevels     = 5;
+    cfg.exitLevels      = 1;    // whole-position exits, so cycles close
+    cfg.entryRangeBelow = 10;
+    cfg.buyFeeRate      = 0.001;
+    cfg.sellFeeRate     = 0.001;
+    cfg.chainCycles     = true;
+    cfg.savingsRate     = 0.1;
+    cfg.horizonParams.horizonCount  = 5;
+    cfg.horizonParams.portfolioPump = cfg.startingCapital;
+    cfg.horizonParams.feeSpread     = 0.001;
+    cfg.horizonParams.surplusRate   = 0.02;
+
+    bool ok = true;
+    SimResult reference = Simulator::run(cfg);
+    std::printf("bench-simarena: %d ticks, %d trades, %d cycles, %d runs per mode\n",
+                points, reference.tradesOpened, reference.cyclesCompleted, runs);
+    std::printf("  %-26s %10s %10s %14s %10s  %s\n",
+                "mode", "ms/run", "allocs", "bytes", "snapshots", "books");
+
+    auto report = [&](const char* mode, double secs, Counted c, const SimResult& r) {
+        bool same = sameBooks(r, reference);
+        ok = ok && same;
+        std::printf("  %-26s %10.2f %10lld %14lld %10zu  %s\n", mode, secs * 1e3 / runs,
+                    c.allocs, c.bytes, r.snapshots.size(), same ? "same" : "DIFFER");
+    };
+
+    {
+        SimResult r;
+        Counted c{};
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < runs; ++i)
+        {
+            Counted before = Counted::now();
+            r = Simulator::run(cfg);
+            c = Counted::now() - before;
+        }
+        report("run()", std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count(), c, r);
+    }
+
+    struct Mode { const char* name; SnapshotPolicy policy; int every; };
+    const Mode modes[] = {
+        { "arena, every tick",   SnapshotPolicy::EveryTick, 1 },
+        { "arena, every 1000th", SnapshotPolicy::EveryN,    1000 },
+        { "arena, no snapshots", SnapshotPolicy::None,      1 },
+    };
+    for (const Mode& m : modes)
+    {
+        SimConfig c = cfg;
+        c.snapshotPolicy = m.policy;
+        c.snapshotEvery  = m.every;
+        Simulator::Arena arena;
+        Simulator::run(c, arena);   // warm up
+        Counted counted{};
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < runs; ++i)
+        {
+            Counted before = Counted::now();
+            Simulator::run(c, arena);
+            counted = Counted::now() - before;
+        }
+        report(m.name, std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count(),
+               counted, arena.result);
+    }
+
+    // The optimizer's objective, through the trace and the fast path.
+    ChainParams cp;
+    cp.symbol      = "BENCH";
+    cp.prices      = prices;
+    cp.capital     = cfg.startingCapital;
+    cp.levels      = cfg.entryLevels;
+    cp.exitLevels  = cfg.exitLevels;
+    cp.rangeBelow  = cfg.entryRangeBelow;
+    cp.buyFeeRate  = cfg.buyFeeRate;
+    cp.sellFeeRate = cfg.sellFeeRate;
+    cp.savingsRate = cfg.savingsRate;
+    cp.feeSpread   = cfg.horizonParams.feeSpread;
+    cp.surplus     = cfg.horizonParams.surplusRate;
+
+    for (ChainObjective obj : { ChainObjective::MaxWealth, ChainObjective::MinSpread })
+    {
+        double jTrace = 0.0, jFast = 0.0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < runs; ++i)
+        {
+            SimResult out;
+            jTrace = ChainOptimizer::evaluate(cp, obj, &out);
+        }
+        double traceSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        ChainOptimizer::evaluate(cp, obj);   // warm up
+        Counted before = Counted::now();
+        t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < runs; ++i)
+            jFast = ChainOptimizer::evaluate(cp, obj);
+        double fastSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        Counted c = Counted::now() - before;
+
+        bool same = jTrace == jFast;
+        ok = ok && same;
+        std::printf("  objective %-9s trace %.2f ms, fast path %.2f ms (%.1fx), %lld allocs/run, %s\n",
+                    obj == ChainObjective::MaxWealth ? "MaxWealth" : "MinSpread",
+                    traceSecs * 1e3 / runs, fastSecs * 1e3 / runs,
+                    traceSecs / std::max(fastSecs, 1e-12), c.allocs / runs, same ? "identical" : "DIFFER");
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+// ============================================================
+// SimResumeBench.cpp — Simulator checkpoints: exactness and the
+// cost of extending a live series
+//
+//   bench-resume [configs] [points] [live]   (default 200, 20,000, 500)
+//
+// Exactness: `configs` random strategies, each over its own
+// random walk, are run once with Simulator::run and once as a
+// checkpoint advanced piece by piece, saved and loaded between
+// some pieces, with a what-if fork taken halfway.  The books
+// closed from the checkpoint and from the fork must match run()
+// field for field.
+//
+// Cost: one walk of `points` hourly ticks grows by `live` ticks
+// one at a time, as a dashboard sees them.  Re-running the whole
+// series per tick is timed against advancing a checkpoint, and
+// against resume() handing back a result every tick while the
+// checkpoint is kept.  Exits 1 on any mismatch.
+// ============================================================
+
+#include "Simulator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+bool sameResult(const SimResult& a, const SimResult& b)
+{
+    if (a.finalCapital != b.finalCapital || a.totalRealized != b.totalRealized
+        || a.totalFees != b.totalFees || a.feeHedgingAmount != b.feeHedgingAmount
+        || a.totalSavings != b.totalSavings || a.totalPumped != b.totalPumped
+        || a.cyclesCompleted != b.cyclesCompleted || a.tradesOpened != b.tradesOpened
+        || a.tradesClosed != b.tradesClosed || a.wins != b.wins || a.losses != b.losses
+        || a.trades.size() != b.trades.size() || a.sells.size() != b.sells.size()
+        || a.snapshots.size() != b.snapshots.size() || a.entryLevels.size() != b.entryLevels.size())
+        return false;
+    for (std::size_t i = 0; i < a.trades.size(); ++i)
+        if (a.trades[i].id != b.trades[i].id || a.trades[i].remaining != b.trades[i].remaining)
+            return false;
+    for (std::size_t i = 0; i < a.sells.size(); ++i)
+        if (a.sells[i].netProfit != b.sells[i].netProfit || a.sells[i].sellTime != b.sells[i].sellTime)
+            return false;
+    for (std::size_t i = 0; i < a.snapshots.size(); ++i)
+        if (a.snapshots[i].capital != b.snapshots[i].capital
+            || a.snapshots[i].deployed != b.snapshots[i].deployed)
+            return false;
+    for (std::size_t i = 0; i < a.entryLevels.size(); ++i)
+        if (a.entryLevels[i].filledAt != b.entryLevels[i].filledAt)
+            return false;
+    return true;
+}
+
+std::vector<PricePoint> walk(std::mt19937_64& rng, int n, double vol)
+{
+    std::normal_distribution<double> step(0.0, vol);
+    std::vector<PricePoint> pts(n);
+    double p = 100.0;
+    for (int i = 0; i < n; ++i)
+    {
+        p *= std::exp(step(rng));
+        pts[i] = { 1600000000LL + i * 3600LL, p };
+    }
+    return pts;
+}
+
+SimConfig draw(std::mt19937_64& rng)
+{
+    std::uniform_real_distribution<double> u(0, 1);
+    SimConfig cfg;
+    cfg.startingCapital     = 1000 + u(rng) * 20000;
+    cfg.entryLevels         = 1 + static_cast<int>(u(rng) * 8);
+    cfg.exitLevels          = static_cast<int>(u(rng) * 5);
+    cfg.entryRisk           = u(rng);
+    cfg.entryRangeBelow     = u(rng) < 0.7 ? 1 + u(rng) * 20 : 0.0;   // near the ~100 start
+    cfg.autoRange           = u(rng) < 0.3;
+    cfg.exitRisk            = u(rng);
+    cfg.exitFraction        = u(rng) < 0.5 ? 1.0 : 0.5 + u(rng) * 0.5;
+    cfg.buyFeeRate          = u(rng) * 0.002;
+    cfg.sellFeeRate         = u(rng) * 0.002;
+    cfg.chainCycles         = u(rng) < 0.8;
+    cfg.savingsRate         = u(rng) * 0.3;
+    cfg.maxTradesPerMonth   = u(rng) < 0.5 ? 1 + static_cast<int>(u(rng) * 4) : 0;
+    cfg.capitalPumpPerMonth = u(rng) < 0.5 ? u(rng) * 300 : 0.0;
+    cfg.horizonParams.horizonCount  = cfg.entryLevels;
+    cfg.horizonParams.portfolioPump = cfg.startingCapital;
+    cfg.horizonParams.surplusRate   = u(rng) * 0.05;
+    cfg.horizonParams.feeSpread     = u(rng) * 0.005;
+    return cfg;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int configs = argc > 1 ? std::atoi(argv[1]) : 200;
+    int points  = argc > 2 ? std::atoi(argv[2]) : 20000;
+    int live    = argc > 3 ? std::atoi(argv[3]) : 500;
+
+    std::mt19937_64 rng(11);
+    std::uniform_real_distribution<double> u(0, 1);
+    int failures = 0, trades = 0;
+    for (int c = 0; c < configs; ++c)
+    {
+        std::vector<PricePoint> pts = walk(rng, 300 + static_cast<int>(u(rng) * 3000), 0.005 + u(rng) * 0.02);
+        PriceSeries prices;
+        prices.setSeries("X", pts);
+        SimConfig cfg = draw(rng);
+        cfg.symbol = "X";
+        cfg.prices = &prices;
+
+        SimResult full = Simulator::run(cfg);
+        trades += full.tradesOpened;
+
+        Simulator::Checkpoint cp = Simulator::checkpoint(cfg), half;
+        bool forked = false;
+        for (std::size_t at = 0; at < pts.size(); )
+        {
+            std::size_t end = std::min(pts.size(), at + 1 + static_cast<std::size_t>(u(rng) * 400));
+            Simulator::advance(cp, std::vector<PricePoint>(pts.begin() + at, pts.begin() + end));
+            if (u(rng) < 0.3) cp = Simulator::Checkpoint::load(cp.save());
+            if (!forked && end >= pts.size() / 2) { half = cp; forked = true; }
+            at = end;
+        }
+
+        bool ok = sameResult(full, Simulator::result(cp))
+               && sameResult(full, Simulator::result(std::move(cp)))
+               && sameResult(full, Simulator::resume(half, prices.series("X")));
+        if (!ok && ++failures <= 10)
+            std::printf("  MISMATCH config %d (%zu ticks)\n", c, pts.size());
+    }
+    std::printf("bench-resume: %d configs, %d trades opened, %s\n",
+                configs, trades, failures ? "FAILED" : "checkpoints match run()");
+
+    // A series growing one tick at a time.
+    std::vector<PricePoint> pts = walk(rng, points + live, 0.01);
+    SimConfig cfg = draw(rng);
+    cfg.symbol = "X";
+
+    PriceSeries grown;
+    grown.setSeries("X", std::vector<PricePoint>(pts.begin(), pts.begin() + points));
+    cfg.prices = &grown;
+    auto t0 = std::chrono::steady_clock::now();
+    SimResult rerun;
+    for (int i = 0; i < live; ++i)
+    {
+        grown.set("X", pts[points + i].timestamp, pts[points + i].price);
+        rerun = Simulator::run(cfg);
+    }
+    double rerunSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    PriceSeries base;
+    base.setSeries("X", std::vector<PricePoint>(pts.begin(), pts.begin() + points));
+    Simulator::Checkpoint cp = Simulator::checkpoint(cfg);
+    Simulator::advance(cp, base.series("X"));
+    Simulator::Checkpoint kept = cp;
+    t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < live; ++i)
+        Simulator::advance(cp, std::vector<PricePoint>{ pts[points + i] });
+    double advanceSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    // The live checkpoint is kept and a result is wanted every tick.
+    t0 = std::chrono::steady_clock::now();
+    SimResult resumed;
+    for (int i = 0; i < live; ++i)
+        resumed = Simulator::resume(std::move(kept), std::vector<PricePoint>{ pts[points + i] }, &kept);
+    double resumeSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    bool same = sameResult(rerun, Simulator::result(std::move(cp))) && sameResult(rerun, resumed);
+    failures += same ? 0 : 1;
+    std::printf("  %d live ticks on %d: re-run %.3f ms/tick, advance %.4f ms/tick (%.0fx), "
+                "resume with result %.4f ms/tick (%.0fx), %s\n",
+                live, points, rerunSecs * 1e3 / live, advanceSecs * 1e3 / live,
+                rerunSecs / std::max(advanceSecs, 1e-12), resumeSecs * 1e3 / live,
+                rerunSecs / std::max(resumeSecs, 1e-12), same ? "identical" : "DIFFER");
+    return failures ? 1 : 0;
+}
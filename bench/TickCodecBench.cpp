@@ -0,0 +1,160 @@
+// ============================================================
+// TickCodecBench.cpp — compression ratio and decode throughput
+// of TickCodec
+//
+//   bench-tickcodec [prices.txt] [points]   (default 2,000,000)
+//
+// prices.txt holds "timestamp,price" lines and defaults to the
+// repo's backtest_prices.txt.  Its points are measured as given, then extended by
+// a random walk with the file's median interval and price
+// precision to `points`; the same walk is also run at minute
+// and second resolution.  Each data set reports the encoded
+// size against 16-byte PricePoints, encode and full-decode
+// rates, and a streaming price loop over a Cursor next to the
+// same loop over the uncompressed PriceSpan.  Exits 1 if any
+// data set does not round-trip exactly.
+// ============================================================
+
+#include "TickCodec.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifndef QUANT_BENCH_PRICES
+#define QUANT_BENCH_PRICES "backtest_prices.txt"
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double seconds(Clock::time_point t0)
+{
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+std::vector<PricePoint> loadFile(const std::string& path, int& decimals)
+{
+    std::vector<PricePoint> pts;
+    std::ifstream in(path);
+    std::string line;
+    decimals = 0;
+    while (std::getline(in, line))
+    {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        auto comma = line.find(',');
+        if (comma == std::string::npos) continue;
+        try
+        {
+            pts.push_back({ std::stoll(line.substr(0, comma)), std::stod(line.substr(comma + 1)) });
+            auto dot = line.find('.', comma);
+            if (dot != std::string::npos)
+                decimals = std::max(decimals, static_cast<int>(line.size() - dot - 1));
+        }
+        catch (...) {}
+    }
+    return pts;
+}
+
+// Random walk continuing `seed`, rounded to `decimals` places.
+std::vector<PricePoint> extend(std::vector<PricePoint> pts, std::size_t n,
+                               long long step, int decimals)
+{
+    std::mt19937_64 rng(42);
+    std::normal_distribution<double> ret(0.0, 0.002);
+    double scale = std::pow(10.0, decimals);
+    long long t = pts.empty() ? 1700000000 : pts.back().timestamp;
+    double    p = pts.empty() ? 1000.0     : pts.back().price;
+    while (pts.size() < n)
+    {
+        t += step;
+        p  = std::max(1.0 / scale, std::round(p * (1.0 + ret(rng)) * scale) / scale);
+        pts.push_back({ t, p });
+    }
+    return pts;
+}
+
+bool measure(const char* name, const std::vector<PricePoint>& pts)
+{
+    PriceSeries ps;
+    ps.setSeries("X", pts);
+    PriceSpan span = ps.series("X");
+    const std::size_t n = span.size();
+    if (n == 0) return true;
+
+    auto t0 = Clock::now();
+    TickCodec::Series enc = TickCodec::encode(span);
+    double encSecs = seconds(t0);
+
+    t0 = Clock::now();
+    std::vector<PricePoint> dec = enc.decode();
+    double decSecs = seconds(t0);
+    bool exact = dec.size() == n;
+    for (std::size_t i = 0; exact && i < n; ++i)
+        exact = dec[i].timestamp == span.timestamp(i) && dec[i].price == span.price(i);
+
+    // The shape of a simulation loop: one pass reading every tick.
+    t0 = Clock::now();
+    double sumSpan = 0;
+    long long lastSpan = 0;
+    for (std::size_t i = 0; i < n; ++i) { sumSpan += span.price(i); lastSpan = span.timestamp(i); }
+    double spanSecs = seconds(t0);
+
+    t0 = Clock::now();
+    double sumStream = 0;
+    long long lastStream = 0;
+    TickCodec::Cursor cur(enc);
+    PricePoint pt;
+    while (cur.next(pt)) { sumStream += pt.price; lastStream = pt.timestamp; }
+    double streamSecs = seconds(t0);
+    exact = exact && sumSpan == sumStream && lastSpan == lastStream;
+
+    double raw = static_cast<double>(n * sizeof(PricePoint));
+    std::printf("%s: %zu points%s\n", name, n, exact ? "" : "  ** ROUND-TRIP MISMATCH **");
+    std::printf("  size      %12.0f B raw  %12zu B encoded  ratio %6.2fx  %6.2f bits/point\n",
+                raw, enc.compressedBytes(), raw / enc.compressedBytes(),
+                8.0 * enc.compressedBytes() / n);
+    std::printf("  encode    %10.1f Mpoints/s\n", n / encSecs / 1e6);
+    std::printf("  decode    %10.1f Mpoints/s  (into a vector)\n", n / decSecs / 1e6);
+    std::printf("  stream    %10.1f Mpoints/s  (Cursor loop)   span loop %8.1f Mpoints/s\n",
+                n / streamSecs / 1e6, n / spanSecs / 1e6);
+    return exact;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::string path = argc > 1 ? argv[1] : QUANT_BENCH_PRICES;
+    std::size_t n    = argc > 2 ? static_cast<std::size_t>(std::atoll(argv[2])) : 2000000;
+
+    std::printf("TickCodec, %zu-point blocks\n", TickCodec::kBlockPoints);
+
+    int decimals = 3;
+    std::vector<PricePoint> file = loadFile(path, decimals);
+    long long step = 86400;
+    bool ok = true;
+    if (file.size() > 1)
+    {
+        std::vector<long long> gaps;
+        for (std::size_t i = 1; i < file.size(); ++i)
+            gaps.push_back(file[i].timestamp - file[i - 1].timestamp);
+        std::nth_element(gaps.begin(), gaps.begin() + gaps.size() / 2, gaps.end());
+        step = std::max(1LL, gaps[gaps.size() / 2]);
+        ok = measure(path.c_str(), file);
+    }
+    else
+        std::printf("%s: not found, using synthetic data only\n", path.c_str());
+
+    ok = measure("extended walk", extend(file, n, step, decimals)) && ok;
+    ok = measure("minute walk",   extend({}, n, 60, decimals)) && ok;
+    ok = measure("second walk",   extend({}, n, 1, decimals)) && ok;
+    return ok ? 0 : 1;
+}
@@ -32,6 +32,19 @@ typedef struct QEngine QEngine;
 QEngine*    qe_open(const char* dbDir);
 void        qe_close(QEngine* e);
 
+// ---- Transactions ----
+
+// Stage every following mutation on the handle in memory; commit
+// writes each touched file once, abort discards the staged changes.
+// A commit lands on disk whole or not at all: its files are renamed
+// into place behind a commit intent that qe_open() finishes after a
+// crash.  Calls nest.  qe_close() with an open transaction discards it.
+void        qe_txn_begin(QEngine* e);
+// Returns 1 when committed, 0 when rolled back (inner abort, or a write
+// failure before the commit intent landed, leaving the files untouched).
+int         qe_txn_commit(QEngine* e);
+void        qe_txn_abort(QEngine* e);
+
 // ---- Wallet ----
 
 QWalletInfo qe_wallet_info(QEngine* e);
@@ -139,6 +152,27 @@ int         qe_exitpt_add(QEngine* e, QExitPointData* ep);  // sets ep->exitId
 int         qe_exitpt_update(QEngine* e, const QExitPointData* ep);
 int         qe_exitpt_delete(QEngine* e, int exitId);
 
+// ---- Triggers ----
+
+// Fill `out` with the live triggers on `symbol` crossed by `price`
+// (rising TP/pending/short-entry levels first, ascending, then falling
+// SL/long-entry levels, descending).  Returns the total number crossed,
+// which may exceed maxCount (pass NULL, 0 to count).
+int         qe_trigger_check(QEngine* e, const char* symbol, double price,
+                             QTrigger* out, int maxCount);
+
+// ---- Monte Carlo (pure simulation, no DB) ----
+
+// Run the strategy in `strategy` (availableFunds = starting capital)
+// through Simulator over `mc->paths` synthetic price paths, spread
+// over the batch-simulation threads.  The first maxPaths per-path
+// results are written to `out` in path order.  Returns the number of
+// paths run; 0 with summary->error set if the path config is invalid.
+int         qe_montecarlo(const QSerialParams* strategy,
+                          const QMonteCarloParams* mc,
+                          QPathResult* out, int maxPaths,
+                          QMonteCarloSummary* summary);
+
 #ifdef __cplusplus
 }
 #endif
@@ -163,6 +163,89 @@ typedef struct {
     int         linkedSellId;   // trade ID of the sell, if executed
 } QExitPointData;
 
+// ---- Trigger (a TP/SL/entry level crossed by a price) ----
+
+enum QTriggerKind {
+    Q_TRIG_HORIZON_TP = 0, Q_TRIG_HORIZON_SL = 1,
+    Q_TRIG_EXIT_TP    = 2, Q_TRIG_EXIT_SL    = 3,
+    Q_TRIG_PENDING    = 4,
+    Q_TRIG_ENTRY_LONG = 5, Q_TRIG_ENTRY_SHORT = 6
+};
+
+typedef struct {
+    int         kind;           // QTriggerKind
+    char        symbol[64];
+    int         id;             // exitId / orderId / entryId; tradeId for horizon levels
+    int         tradeId;        // parent Buy, -1 for entry points
+    int         levelIndex;
+    double      price;          // per-unit trigger price
+    double      qty;            // quantity sold or bought (0 for horizon levels)
+} QTrigger;
+
+// ---- Monte Carlo (synthetic paths through the simulator) ----
+
+enum QPathModel {
+    Q_MC_GBM = 0, Q_MC_BOOTSTRAP = 1, Q_MC_REGIME = 2
+};
+
+typedef struct {
+    double      drift;          // log drift per tick
+    double      vol;            // log stdev per tick
+    double      stay;           // per-tick probability of staying in the regime
+} QRegime;
+
+typedef struct {
+    int         model;          // QPathModel
+    int         paths;
+    int         steps;          // ticks per path, including the start
+    double      startPrice;     // 0 = last history price
+    long long   startTime;      // unix seconds of the first tick, 0 = 2024-01-01
+    long long   interval;       // seconds between ticks, 0 = one day
+    double      drift;          // Gbm / calm regime; drift and vol both 0 =
+    double      vol;            //   estimated from the history
+    const double* history;      // historical prices, oldest first (bootstrap)
+    int         historyCount;
+    int         blockSize;      // bootstrap block length in ticks
+    const QRegime* regimes;     // NULL = calm / crash pair from drift, vol
+    int         regimeCount;
+    unsigned long long seed;
+    double      buyFeeRate;     // simulated fills
+    double      sellFeeRate;
+    int         chainCycles;
+    int         maxTradesPerMonth;
+    double      capitalPumpPerMonth;
+} QMonteCarloParams;
+
+typedef struct {
+    int         path;
+    double      finalPrice;
+    double      finalCapital;
+    double      totalRealized;
+    double      totalFees;
+    double      feeCoverage;    // hedging pool / fees paid
+    double      totalSavings;
+    double      openValue;      // positions still held, at finalPrice
+    int         cyclesCompleted;
+    int         tradesOpened;
+    int         tradesClosed;
+} QPathResult;
+
+typedef struct {
+    double      mean, stdev, min, p5, p25, p50, p75, p95, max;
+} QDistribution;
+
+typedef struct {
+    int           paths;
+    QDistribution finalCapital;
+    QDistribution equity;               // capital + savings + open value
+    QDistribution cyclesCompleted;
+    QDistribution feeCoverage;          // over paths that paid fees
+    double        lossProbability;      // equity below the starting capital
+    double        uncoveredProbability; // fees paid and coverage below 1
+    double        seconds;
+    char          error[256];           // set when paths == 0 from a bad config
+} QMonteCarloSummary;
+
 #ifdef __cplusplus
 }
 #endif
@@ -14,6 +14,7 @@
 #include "TradeDatabase.h"
 #include "ProfitCalculator.h"
 #include "QuantMath.h"
+#include "MonteCarlo.h"
 
 #include <cstring>
 #include <string>
@@ -159,6 +160,55 @@ static QuantMath::SerialParams fromCParams(const QSerialParams& p)
     return sp;
 }
 
+// The Simulator config for a serial plan's strategy; fills and the
+// monthly throttle come from the Monte Carlo params.
+static SimConfig simFromCParams(const QSerialParams& p, const QMonteCarloParams& mc)
+{
+    SimConfig c;
+    c.startingCapital     = p.availableFunds;
+    c.entryLevels         = p.levels;
+    c.exitLevels          = p.exitLevels;
+    c.entryRisk           = p.risk;
+    c.entrySteepness      = p.steepness;
+    c.entryRangeAbove     = p.rangeAbove;
+    c.entryRangeBelow     = p.rangeBelow;
+    c.autoRange           = (p.autoRange != 0);
+    c.exitRisk            = p.exitRisk;
+    c.exitFraction        = p.exitFraction;
+    c.exitSteepness       = p.exitSteepness;
+    c.downtrendCount      = p.downtrendCount;
+    c.savingsRate         = p.savingsRate;
+    c.buyFeeRate          = mc.buyFeeRate;
+    c.sellFeeRate         = mc.sellFeeRate;
+    c.chainCycles         = (mc.chainCycles != 0);
+    c.maxTradesPerMonth   = mc.maxTradesPerMonth;
+    c.capitalPumpPerMonth = mc.capitalPumpPerMonth;
+
+    HorizonParams& hp = c.horizonParams;
+    hp.horizonCount          = p.levels;
+    hp.portfolioPump         = p.availableFunds;
+    hp.feeSpread             = p.feeSpread;
+    hp.feeHedgingCoefficient = p.feeHedgingCoefficient;
+    hp.deltaTime             = p.deltaTime;
+    hp.symbolCount           = p.symbolCount;
+    hp.coefficientK          = p.coefficientK;
+    hp.surplusRate           = p.surplusRate;
+    hp.futureTradeCount      = p.futureTradeCount;
+    hp.maxRisk               = p.maxRisk;
+    hp.minRisk               = p.minRisk;
+    hp.stopLossFraction      = p.stopLossFraction;
+    hp.stopLossHedgeCount    = p.stopLossHedgeCount;
+    return c;
+}
+
+static QDistribution toCDistribution(const MonteCarlo::Distribution& d)
+{
+    QDistribution q{};
+    q.mean = d.mean; q.stdev = d.stdev; q.min = d.min; q.max = d.max;
+    q.p5 = d.p5; q.p25 = d.p25; q.p50 = d.p50; q.p75 = d.p75; q.p95 = d.p95;
+    return q;
+}
+
 // ============================================================
 // API implementation
 // ============================================================
@@ -177,6 +227,24 @@ void qe_close(QEngine* e)
     delete e;
 }
 
+// ---- Transactions ----
+
+void qe_txn_begin(QEngine* e)
+{
+    e->db.beginTransaction();
+}
+
+int qe_txn_commit(QEngine* e)
+{
+    try { return e->db.commitTransaction() ? 1 : 0; }
+    catch (...) { return 0; }
+}
+
+void qe_txn_abort(QEngine* e)
+{
+    e->db.abortTransaction();
+}
+
 // ---- Wallet ----
 
 QWalletInfo qe_wallet_info(QEngine* e)
@@ -695,4 +763,98 @@ int qe_exitpt_delete(QEngine* e, int exitId)
     return 1;
 }
 
+// ---- Triggers ----
+
+int qe_trigger_check(QEngine* e, const char* symbol, double price,
+                     QTrigger* out, int maxCount)
+{
+    int n = 0;
+    for (const auto& t : e->db.crossedTriggers(symbol ? symbol : "", price))
+    {
+        if (n < maxCount)
+        {
+            QTrigger& q  = out[n];
+            q = QTrigger{};
+            q.kind       = static_cast<int>(t.kind);
+            copyStr(q.symbol, sizeof(q.symbol), t.symbol);
+            q.id         = t.id;
+            q.tradeId    = t.tradeId;
+            q.levelIndex = t.levelIndex;
+            q.price      = t.price;
+            q.qty        = t.qty;
+        }
+        ++n;
+    }
+    return n;
+}
+
+// ---- Monte Carlo ----
+
+int qe_montecarlo(const QSerialParams* strategy, const QMonteCarloParams* mc,
+                  QPathResult* out, int maxPaths, QMonteCarloSummary* summary)
+{
+    QMonteCarloSummary s{};
+
+    MonteCarlo::PathConfig pc;
+    pc.model      = mc->model == Q_MC_BOOTSTRAP ? MonteCarlo::Model::Bootstrap
+                  : mc->model == Q_MC_REGIME    ? MonteCarlo::Model::Regime
+                                                : MonteCarlo::Model::Gbm;
+    pc.paths      = mc->paths;
+    pc.steps      = mc->steps;
+    pc.startPrice = mc->startPrice;
+    pc.drift      = mc->drift;
+    pc.vol        = mc->vol;
+    pc.seed       = mc->seed;
+    if (mc->startTime > 0) pc.startTime = mc->startTime;
+    if (mc->interval > 0)  pc.interval  = mc->interval;
+    if (mc->blockSize > 0) pc.blockSize = mc->blockSize;
+    if (mc->history && mc->historyCount > 0)
+        pc.history.assign(mc->history, mc->history + mc->historyCount);
+    MonteCarlo::applyHistory(pc);
+    if (pc.startPrice <= 0) pc.startPrice = strategy->currentPrice;
+    if (mc->regimes && mc->regimeCount > 0)
+        for (int i = 0; i < mc->regimeCount; ++i)
+            pc.regimes.push_back({ mc->regimes[i].drift, mc->regimes[i].vol, mc->regimes[i].stay });
+    else
+        pc.regimes = MonteCarlo::calmAndCrash(pc.drift, pc.vol);
+
+    try
+    {
+        MonteCarlo::Generator gen(pc);
+        MonteCarlo::Summary sum = MonteCarlo::run(simFromCParams(*strategy, *mc), gen,
+            [&](const MonteCarlo::PathResult& r) {
+                if (out && r.path < maxPaths)
+                {
+                    QPathResult& q    = out[r.path];
+                    q.path            = r.path;
+                    q.finalPrice      = r.finalPrice;
+                    q.finalCapital    = r.finalCapital;
+                    q.totalRealized   = r.totalRealized;
+                    q.totalFees       = r.totalFees;
+                    q.feeCoverage     = r.feeCoverage;
+                    q.totalSavings    = r.totalSavings;
+                    q.openValue       = r.openValue;
+                    q.cyclesCompleted = r.cyclesCompleted;
+                    q.tradesOpened    = r.tradesOpened;
+                    q.tradesClosed    = r.tradesClosed;
+                }
+                return true;
+            });
+        s.paths                = sum.paths;
+        s.finalCapital         = toCDistribution(sum.finalCapital);
+        s.equity               = toCDistribution(sum.equity);
+        s.cyclesCompleted      = toCDistribution(sum.cyclesCompleted);
+        s.feeCoverage          = toCDistribution(sum.feeCoverage);
+        s.lossProbability      = sum.lossProbability;
+        s.uncoveredProbability = sum.uncoveredProbability;
+        s.seconds              = sum.seconds;
+    }
+    catch (const std::exception& ex)
+    {
+        copyStr(s.error, sizeof(s.error), ex.what());
+    }
+    if (summary) *summary = s;
+    return s.paths;
+}
+
 } // extern "C"
@@ -34,6 +34,7 @@
 #include <algorithm>
 #include <iomanip>
 #include <fstream>
+#include <stdexcept>
 
 // ============================================================
 // Minimal JSON helpers (self-contained, no nanojson dependency)
@@ -600,6 +601,34 @@ static std::vector<ToolDef> buildToolDefs()
          {"quantity", "number", "Quantity (default 1)", false},
          {"feeSpread", "number", "Fee spread (default 0.001)", false}}});
 
+    tools.push_back({"monte_carlo",
+        "Distributional backtest: run a strategy through the simulator over many synthetic "
+        "price paths (GBM, block bootstrap of historical returns, or calm/crash regime "
+        "switching) and report the distributions of final capital, equity (capital, savings "
+        "and open positions at the last price), cycles completed and fee hedging coverage, "
+        "with the probability of ending below the starting capital and of fees outrunning "
+        "the hedge. Does not touch the database.",
+        {{"preset", "string", "Named preset for the strategy (see list_presets)", false},
+         {"model", "string", "gbm | bootstrap | regime (default gbm)", false},
+         {"paths", "integer", "Number of paths (default 500, max 20000)", false},
+         {"steps", "integer", "Ticks per path (default 365)", false},
+         {"interval", "integer", "Seconds between ticks (default 86400)", false},
+         {"startPrice", "number", "First price (default: last history price)", false},
+         {"drift", "number", "Log drift per tick (default: estimated from history, else 0)", false},
+         {"vol", "number", "Log volatility per tick (default: estimated from history, else 0.02)", false},
+         {"history", "string", "Historical prices, oldest first, comma-separated (bootstrap)", false},
+         {"blockSize", "integer", "Bootstrap block length in ticks (default 20)", false},
+         {"seed", "integer", "Random seed (default 1)", false},
+         {"availableFunds", "number", "Starting capital", true},
+         {"levels", "integer", "Entry levels (default 4)", false},
+         {"risk", "number", "Entry risk 0-1 (default 0.5)", false},
+         {"feeSpread", "number", "Fee spread (default 0.001)", false},
+         {"surplusRate", "number", "Surplus (default 0.02)", false},
+         {"buyFeeRate", "number", "Simulated buy fee rate (default 0.001)", false},
+         {"sellFeeRate", "number", "Simulated sell fee rate (default 0.001)", false},
+         {"chainCycles", "boolean", "Reinvest completed cycles (default true)", false},
+         {"detail", "integer", "Per-path rows to include (default 20)", false}}});
+
     tools.push_back({"execute_buy",
         "Request to execute a buy trade (debits wallet). Returns a confirmation token "
         "that must be passed to confirm_execution.",
@@ -867,53 +896,78 @@ static std::string toolPriceCheck(QEngine* e, const Args& a)
 
     QWalletInfo w = qe_wallet_info(e);
 
-    // Fillable entries
-    int nE = qe_entry_count(e);
-    std::vector<QEntryPoint> entries(nE > 0 ? nE : 1);
-    nE = qe_entry_list(e, entries.data(), nE);
+    // Crossed levels come from the engine's trigger book.
+    int nHit = qe_trigger_check(e, sym.c_str(), price, nullptr, 0);
+    std::vector<QTrigger> hits(nHit > 0 ? nHit : 1);
+    nHit = qe_trigger_check(e, sym.c_str(), price, hits.data(), nHit);
 
-    JArr fillable;
-    for (int i = 0; i < nE; ++i)
+    std::vector<int> entryIds, exitIds;
+    for (int i = 0; i < nHit; ++i)
     {
-        const auto& ep = entries[i];
-        if (ep.traded) continue;
-        if (std::string(ep.symbol) != sym) continue;
-        bool fill = ep.isShort ? (price >= ep.entryPrice) : (price <= ep.entryPrice);
-        if (!fill) continue;
-        double cost = ep.entryPrice * ep.fundingQty;
-        JObj o;
-        o.add("entryId", jInt(ep.entryId))
-         .add("entryPrice", jDbl(ep.entryPrice))
-         .add("qty", jDbl(ep.fundingQty))
-         .add("cost", jDbl(cost))
-         .add("canAfford", jBool(cost <= w.balance))
-         .add("tp", jDbl(ep.exitTakeProfit))
-         .add("sl", jDbl(ep.exitStopLoss));
-        fillable.add(o.str());
+        const auto& h = hits[i];
+        if (h.kind == Q_TRIG_ENTRY_LONG || h.kind == Q_TRIG_ENTRY_SHORT)
+            entryIds.push_back(h.id);
+        else if ((h.kind == Q_TRIG_EXIT_TP || h.kind == Q_TRIG_EXIT_SL)
+                 && std::find(exitIds.begin(), exitIds.end(), h.id) == exitIds.end())
+            exitIds.push_back(h.id);
     }
 
-    // Triggered exits
-    int nX = qe_exitpt_count(e);
-    std::vector<QExitPointData> exits(nX > 0 ? nX : 1);
-    nX = qe_exitpt_list(e, exits.data(), nX);
+    // Fillable entries
+    JArr fillable;
+    if (!entryIds.empty())
+    {
+        int nE = qe_entry_count(e);
+        std::vector<QEntryPoint> entries(nE > 0 ? nE : 1);
+        nE = qe_entry_list(e, entries.data(), nE);
+        std::map<int, int> entryAt;
+        for (int i = 0; i < nE; ++i) entryAt[entries[i].entryId] = i;
+
+        for (int id : entryIds)
+        {
+            auto it = entryAt.find(id);
+            if (it == entryAt.end()) continue;
+            const auto& ep = entries[it->second];
+            double cost = ep.entryPrice * ep.fundingQty;
+            JObj o;
+            o.add("entryId", jInt(ep.entryId))
+             .add("entryPrice", jDbl(ep.entryPrice))
+             .add("qty", jDbl(ep.fundingQty))
+             .add("cost", jDbl(cost))
+             .add("canAfford", jBool(cost <= w.balance))
+             .add("tp", jDbl(ep.exitTakeProfit))
+             .add("sl", jDbl(ep.exitStopLoss));
+            fillable.add(o.str());
+        }
+    }
 
     int nT = qe_trade_count(e);
     std::vector<QTrade> trades(nT > 0 ? nT : 1);
     nT = qe_trade_list(e, trades.data(), nT);
+    std::map<int, double> entryPriceOf;
+    for (int i = 0; i < nT; ++i) entryPriceOf[trades[i].tradeId] = trades[i].value;
+
+    // Triggered exits
+    std::vector<QExitPointData> exits;
+    if (!exitIds.empty())
+    {
+        int nX = qe_exitpt_count(e);
+        exits.resize(nX > 0 ? nX : 1);
+        exits.resize(qe_exitpt_list(e, exits.data(), nX));
+    }
+    std::map<int, int> exitAt;
+    for (int i = 0; i < static_cast<int>(exits.size()); ++i) exitAt[exits[i].exitId] = i;
 
     JArr triggered;
-    for (int i = 0; i < nX; ++i)
+    for (int id : exitIds)
     {
-        const auto& xp = exits[i];
-        if (xp.executed) continue;
-        if (std::string(xp.symbol) != sym) continue;
+        auto xit = exitAt.find(id);
+        if (xit == exitAt.end()) continue;
+        const auto& xp = exits[xit->second];
         bool tpHit = (xp.tpPrice > 0 && price >= xp.tpPrice);
         bool slHit = (xp.slActive && xp.slPrice > 0 && price <= xp.slPrice);
-        if (!tpHit && !slHit) continue;
 
-        double entryPrice = 0;
-        for (int ti = 0; ti < nT; ++ti)
-            if (trades[ti].tradeId == xp.tradeId) { entryPrice = trades[ti].value; break; }
+        auto pit = entryPriceOf.find(xp.tradeId);
+        double entryPrice = pit != entryPriceOf.end() ? pit->second : 0;
         double pnl = (price - entryPrice) * xp.sellQty;
 
         JObj o;
@@ -1322,6 +1376,122 @@ static std::string toolComparePlans(QEngine*, const Args& a)
     return result.str();
 }
 
+static std::string toolMonteCarlo(QEngine*, const Args& a)
+{
+    Args pa = applyPreset(a);
+    std::string usedPreset = getStr(a, "preset");
+
+    QSerialParams p{};
+    p.levels         = getInt(pa, "levels", 4);
+    p.exitLevels     = getInt(pa, "exitLevels", p.levels);
+    p.steepness      = getDbl(pa, "steepness", 6.0);
+    p.risk           = getDbl(pa, "risk", 0.5);
+    p.availableFunds = getDbl(pa, "availableFunds");
+    p.rangeAbove     = getDbl(pa, "rangeAbove", 0.0);
+    p.rangeBelow     = getDbl(pa, "rangeBelow", 0.0);
+    p.autoRange      = getBool(pa, "autoRange") ? 1 : 0;
+    p.feeSpread      = getDbl(pa, "feeSpread", 0.001);
+    p.feeHedgingCoefficient = getDbl(pa, "feeHedging", 1.0);
+    p.deltaTime      = getDbl(pa, "deltaTime", 1.0);
+    p.symbolCount    = getInt(pa, "symbolCount", 1);
+    p.coefficientK   = getDbl(pa, "coefficientK", 0.0);
+    p.surplusRate    = getDbl(pa, "surplusRate", 0.02);
+    p.maxRisk        = getDbl(pa, "maxRisk", 0.0);
+    p.minRisk        = getDbl(pa, "minRisk", 0.0);
+    p.exitRisk       = getDbl(pa, "exitRisk", 0.5);
+    p.exitFraction   = getDbl(pa, "exitFraction", 1.0);
+    p.exitSteepness  = getDbl(pa, "exitSteepness", 4.0);
+    p.stopLossFraction   = getDbl(pa, "stopLossFraction", 1.0);
+    p.stopLossHedgeCount = getInt(pa, "stopLossHedgeCount", 0);
+    p.downtrendCount = getInt(pa, "downtrendCount", 1);
+    p.savingsRate    = getDbl(pa, "savingsRate", 0.0);
+    if (p.availableFunds <= 0)
+        return "{\"error\":\"availableFunds must be positive\"}";
+
+    // History as a JSON array or a comma/space-separated string.
+    std::vector<double> history;
+    {
+        std::string h = getStr(pa, "history");
+        for (char& c : h)
+            if (c == '[' || c == ']' || c == ',' || c == ';' || c == '\n' || c == '\r' || c == '\t') c = ' ';
+        std::istringstream in(h);
+        for (double v; in >> v; ) history.push_back(v);
+    }
+
+    std::string modelName = getStr(pa, "model", "gbm");
+    QMonteCarloParams mc{};
+    mc.model        = modelName == "bootstrap" ? Q_MC_BOOTSTRAP
+                    : modelName == "regime"    ? Q_MC_REGIME
+                                               : Q_MC_GBM;
+    mc.paths        = std::max(1, std::min(20000, getInt(pa, "paths", 500)));
+    mc.steps        = std::max(2, std::min(100000, getInt(pa, "steps", 365)));
+    mc.interval     = getInt(pa, "interval", 86400);
+    mc.startPrice   = getDbl(pa, "startPrice", history.empty() ? 100.0 : 0.0);
+    mc.drift        = getDbl(pa, "drift", 0.0);
+    mc.vol          = getDbl(pa, "vol", history.empty() ? 0.02 : 0.0);
+    mc.history      = history.empty() ? nullptr : history.data();
+    mc.historyCount = static_cast<int>(history.size());
+    mc.blockSize    = getInt(pa, "blockSize", 20);
+    mc.seed         = static_cast<unsigned long long>(getInt(pa, "seed", 1));
+    mc.buyFeeRate   = getDbl(pa, "buyFeeRate", 0.001);
+    mc.sellFeeRate  = getDbl(pa, "sellFeeRate", 0.001);
+    mc.chainCycles  = getBool(pa, "chainCycles", true) ? 1 : 0;
+    mc.maxTradesPerMonth   = getInt(pa, "maxTradesPerMonth", 0);
+    mc.capitalPumpPerMonth = getDbl(pa, "capitalPumpPerMonth", 0.0);
+
+    int detail = std::max(0, std::min(mc.paths, getInt(pa, "detail", 20)));
+    std::vector<QPathResult> rows(detail > 0 ? detail : 1);
+    QMonteCarloSummary sum{};
+    if (qe_montecarlo(&p, &mc, rows.data(), detail, &sum) == 0)
+        return "{\"error\":\"" + jEsc(sum.error) + "\"}";
+
+    auto dist = [](const QDistribution& d) {
+        JObj o;
+        o.add("mean", jDbl(d.mean)).add("stdev", jDbl(d.stdev))
+         .add("min", jDbl(d.min)).add("p5", jDbl(d.p5)).add("p25", jDbl(d.p25))
+         .add("p50", jDbl(d.p50)).add("p75", jDbl(d.p75)).add("p95", jDbl(d.p95))
+         .add("max", jDbl(d.max));
+        return o.str();
+    };
+
+    JArr pathArr;
+    for (int i = 0; i < detail; ++i)
+    {
+        const auto& r = rows[i];
+        JObj o;
+        o.add("path", jInt(r.path))
+         .add("finalPrice", jDbl(r.finalPrice))
+         .add("finalCapital", jDbl(r.finalCapital))
+         .add("realized", jDbl(r.totalRealized))
+         .add("fees", jDbl(r.totalFees))
+         .add("feeCoverage", jDbl(r.feeCoverage))
+         .add("savings", jDbl(r.totalSavings))
+         .add("openValue", jDbl(r.openValue))
+         .add("cycles", jInt(r.cyclesCompleted))
+         .add("tradesOpened", jInt(r.tradesOpened))
+         .add("tradesClosed", jInt(r.tradesClosed));
+        pathArr.add(o.str());
+    }
+
+    JObj result;
+    if (!usedPreset.empty())
+        result.add("preset", jStr(usedPreset));
+    result.add("model", jStr(mc.model == Q_MC_BOOTSTRAP ? "bootstrap"
+                           : mc.model == Q_MC_REGIME ? "regime" : "gbm"))
+          .add("paths", jInt(sum.paths))
+          .add("steps", jInt(mc.steps))
+          .add("startingCapital", jDbl(p.availableFunds))
+          .add("finalCapital", dist(sum.finalCapital))
+          .add("equity", dist(sum.equity))
+          .add("cyclesCompleted", dist(sum.cyclesCompleted))
+          .add("feeCoverage", dist(sum.feeCoverage))
+          .add("lossProbability", jDbl(sum.lossProbability))
+          .add("uncoveredProbability", jDbl(sum.uncoveredProbability))
+          .add("seconds", jDbl(sum.seconds))
+          .add("pathDetail", pathArr.str());
+    return result.str();
+}
+
 static std::string toolExecuteBuy(QEngine* e, const Args& a)
 {
     std::string sym = getStr(a, "symbol");
@@ -1599,6 +1769,7 @@ static std::map<std::string, ToolFn> buildDispatch()
     d["what_if"]               = toolWhatIf;
     d["position_risk_summary"] = toolPositionRiskSummary;
     d["compare_plans"]         = toolComparePlans;
+    d["monte_carlo"]           = toolMonteCarlo;
     d["execute_buy"]           = toolExecuteBuy;
     d["execute_sell"]          = toolExecuteSell;
     d["fill_entry"]            = toolFillEntry;